@@ -1,6 +1,6 @@
 /*
     MANGO Multimedia Development Platform
-    Copyright (C) 2012-2024 Twilight Finland 3D Oy Ltd. All rights reserved.
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
 #include <mango/mango.hpp>
 
@@ -21,6 +21,7 @@ struct State
     FileIndex index;
 
     ConcurrentQueue queue;
+    AsyncReader reader;
     Trace trace { "", "batch image reading" };
 
     void decode(ConstMemory memory, const std::string& filename, bool multithread)
@@ -97,7 +98,7 @@ struct State
         }
     }
 
-    void process(bool mmap, bool multithread)
+    void process(bool mmap, bool async, bool multithread)
     {
         // sort files by size; the largest decoding tasks should start first
         std::sort(index.begin(), index.end(), [] (const FileInfo& a, const FileInfo& b)
@@ -109,7 +110,22 @@ struct State
         {
             const std::string& filename = node.name;
 
-            if (mmap)
+            if (async)
+            {
+                // the reader decodes the files in the ThreadPool as soon as they are read
+                reader.read(filename, [this, multithread] (const AsyncReader::Result& result)
+                {
+                    if (result)
+                    {
+                        decode(result.memory, result.filename, multithread);
+                    }
+                    else
+                    {
+                        printLine("  ERROR: {}", result.info);
+                    }
+                });
+            }
+            else if (mmap)
             {
                 queue.enqueue([this, filename, multithread]
                 {
@@ -132,14 +148,47 @@ struct State
         }
     }
 
+    void batch(bool multithread)
+    {
+        BatchDecodeOptions options;
+        options.multithread_pixels = multithread ? 1024 * 1024 : ~0ull;
+
+        // the BatchDecoder reads the headers and schedules the largest images first
+        BatchDecoder decoder(options);
+        decoder.add(index);
+
+        decoder.decode([this] (BatchDecoder::Result& result)
+        {
+            size_t input_bytes = 0;
+            size_t image_bytes = 0;
+
+            if (result.status)
+            {
+                input_bytes = index.files[result.index].size;
+                image_bytes = result.header.width * result.header.height * 4;
+            }
+            else
+            {
+                printLine("  ERROR: {}", result.status.info);
+            }
+
+            total_input_files ++;
+            total_input_bytes += input_bytes;
+            total_image_bytes += image_bytes;
+
+            printLine("Decoded: \"{}\" ({} KB -> {} KB).", result.name, input_bytes >> 10, image_bytes >> 10);
+        });
+    }
+
     void wait()
     {
+        reader.wait();
         queue.wait();
         trace.stop();
     }
 };
 
-void test(const std::string& folder, const std::string& format, bool mmap, bool multithread)
+void test(const std::string& folder, const std::string& format, bool mmap, bool async, bool multithread, bool batch)
 {
     u64 time0 = Time::ms();
 
@@ -152,7 +201,15 @@ void test(const std::string& folder, const std::string& format, bool mmap, bool
     printLine("Scanning: {} ms", time1 - time0);
     printLine("");
 
-    state.process(mmap, multithread);
+    if (batch)
+    {
+        state.batch(multithread);
+    }
+    else
+    {
+        state.process(mmap, async, multithread);
+    }
+
     state.wait();
 
     u64 time2 = Time::ms();
@@ -160,7 +217,9 @@ void test(const std::string& folder, const std::string& format, bool mmap, bool
     printLine("");
     printLine("{}", getSystemInfo());
     printLine("MMAP: {}", mmap);
+    printLine("ASYNC: {} ({})", async, state.reader.isAsync() ? "io_uring" : "ThreadPool");
     printLine("MT:   {}", multithread);
+    printLine("BATCH: {}", batch);
     printLine("");
 
     printLine("Decoded {} files in {} ms ({} MB -> {} MB).",
@@ -185,7 +244,9 @@ int main(int argc, const char* argv[])
         printLine("    --trace              : enable tracing");
         printLine("    --info               : enable decoding diagnostic information");
         printLine("    --mmap               : enable memory mapping");
+        printLine("    --async              : enable asynchronous reading (files must not be in containers)");
         printLine("    --mt                 : enable multi-threaded decoding");
+        printLine("    --batch              : decode with the BatchDecoder (ignores --mmap and --async)");
         return 1;
     }
 
@@ -194,7 +255,9 @@ int main(int argc, const char* argv[])
     // defaults
     std::string format;
     bool mmap = false;
+    bool async = false;
     bool multithread = false;
+    bool batch = false;
     bool tracing = false;
 
     for (int i = 2; i < argc; ++i)
@@ -203,10 +266,18 @@ int main(int argc, const char* argv[])
         {
             mmap = true;
         }
+        else if (!strcmp(argv[i], "--async"))
+        {
+            async = true;
+        }
         else if (!strcmp(argv[i], "--mt"))
         {
             multithread = true;
         }
+        else if (!strcmp(argv[i], "--batch"))
+        {
+            batch = true;
+        }
         else if (!strcmp(argv[i], "--info"))
         {
             printEnable(Print::Info, true);
@@ -238,7 +309,7 @@ int main(int argc, const char* argv[])
         startTrace(output.get());
     }
 
-    test(pathname, format, mmap, multithread);
+    test(pathname, format, mmap, async, multithread, batch);
 
     if (tracing)
     {
@@ -7,14 +7,14 @@
 using namespace mango;
 using namespace mango::image;
 
-void encode_indexed(const Surface& surface, const std::string& filename)
+void encode_indexed(const Surface& surface, const std::string& filename, QuantizeMethod method)
 {
     u64 time0 = Time::ms();
 
     printLine("{}", filename);
 
     printf("  Quantizing: ");
-    QuantizedBitmap temp(surface, 0.80f, true);
+    QuantizedBitmap temp(surface, 0.80f, true, method);
 
     u64 time1 = Time::ms();
     printf("%d ms\n", int(time1 - time0));
@@ -30,14 +30,21 @@ int main(int argc, const char* argv[])
 {
     if (argc < 2)
     {
-        printf("Too few arguments. usage: <image filename>\n");
+        printf("Too few arguments. usage: <image filename> [--mediancut]\n");
         exit(1);
     }
 
     const char* filename = argv[1];
 
+    QuantizeMethod method = QuantizeMethod::NeuQuant;
+
+    if (argc > 2 && !strcmp(argv[2], "--mediancut"))
+    {
+        method = QuantizeMethod::MedianCut;
+    }
+
     Bitmap bitmap(filename, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
 
-    encode_indexed(bitmap, "output-palette.gif");
-    encode_indexed(bitmap, "output-palette.png");
+    encode_indexed(bitmap, "output-palette.gif", method);
+    encode_indexed(bitmap, "output-palette.png", method);
 }
@@ -65,6 +65,60 @@ void test_compression(size_t size, int level)
     }
 }
 
+void test_parallel_compression(size_t size, int level)
+{
+    Buffer buffer(size);
+
+    int xd = rand();
+    for (size_t i = 0; i < size; ++i)
+    {
+        buffer[i] = ((i + 2) * 0x123456) & 0xff;
+        buffer[i] += xd;
+        if (!(i % 5)) xd = rand();
+    }
+
+    printLine("");
+    printLine("------------------------------------------------------------");
+    printLine("Parallel    Ratio        Compress       Decompress    Status");
+    printLine("------------------------------------------------------------");
+
+    const Compressor::Method methods[] =
+    {
+        Compressor::LZ4,
+        Compressor::LZAV,
+        Compressor::DEFLATE,
+        Compressor::ZSTD,
+    };
+
+    for (auto method : methods)
+    {
+        Compressor compressor = getCompressor(method);
+
+        Buffer compressed(boundParallel(method, size));
+
+        u64 time0 = Time::us();
+
+        CompressionStatus status = compressParallel(compressed, buffer, method, level);
+
+        u64 time1 = Time::us();
+
+        ConstMemory frame(compressed, status.size);
+        Buffer output(sizeParallel(frame));
+        decompressParallel(output, frame);
+
+        u64 time2 = Time::us();
+
+        bool correct = output.size() == size && std::memcmp(buffer, output, size) == 0;
+        const char* result = correct ? "PASSED" : "FAILED";
+
+        float ratio = status.size * 100.0f / size;
+        float rate0 = size / float(time1 - time0);
+        float rate1 = size / float(time2 - time1);
+
+        printLine("{:<9} {:>6.1f}% {:>10.1f} MB/s {:>11.1f} MB/s    {}", compressor.name, ratio, rate0, rate1, result);
+    }
+}
+
 int main(int argc, const char* argv[])
 {
     const size_t size = 1024 * 1024;
@@ -76,4 +130,5 @@ int main(int argc, const char* argv[])
     }
 
     test_compression(size, level);
+    test_parallel_compression(size * 32, level);
 }
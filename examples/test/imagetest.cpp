@@ -0,0 +1,901 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#include <mango/mango.hpp>
+
+using namespace mango;
+using namespace mango::image;
+
+static int g_count_failed = 0;
+
+void printLine()
+{
+    printf("------------------------------------------------------------------ \n");
+}
+
+void check(bool status, const std::string& name)
+{
+    g_count_failed += !status;
+    printf("  %-56s [%s]\n", name.c_str(), status ? "PASSED" : "FAILED");
+}
+
+// ----------------------------------------------------------------------------
+// ktx2
+// ----------------------------------------------------------------------------
+
+// KTX2 file with UASTC solid color blocks
+void createUASTC(MemoryStream& stream, int width, int height, Color color)
+{
+    const int xblocks = (width + 3) / 4;
+    const int yblocks = (height + 3) / 4;
+
+    const u32 dfd_size = 4 + 24 + 16;
+    const u32 dfd_offset = 12 + 9 * 4 + 4 * 4 + 2 * 8 + 3 * 8;
+    const u32 level_offset = dfd_offset + dfd_size;
+    const u32 level_size = xblocks * yblocks * 16;
+
+    LittleEndianStream s = stream;
+
+    const u8 identifier [] =
+    {
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32,
+        0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+    };
+
+    s.write(identifier, sizeof(identifier));
+    s.write32(0); // vkFormat: undefined
+    s.write32(1); // typeSize
+    s.write32(width);
+    s.write32(height);
+    s.write32(0); // depth
+    s.write32(0); // layers
+    s.write32(1); // faces
+    s.write32(1); // levels
+    s.write32(0); // supercompression
+
+    s.write32(dfd_offset);
+    s.write32(dfd_size);
+    s.write32(0); // kvd
+    s.write32(0);
+    s.write64(0); // sgd
+    s.write64(0);
+
+    s.write64(level_offset);
+    s.write64(level_size);
+    s.write64(level_size);
+
+    // data format descriptor: UASTC, RGB
+    s.write32(dfd_size);
+    s.write32(0);
+    s.write32(2 | ((24 + 16) << 16));
+    s.write8(166); // color model
+    s.write8(1);
+    s.write8(2);
+    s.write8(0);
+    s.write32(0x00000303); // block dimensions
+    s.write32(16); // bytes per plane
+    s.write32(0);
+    s.write32(0); // sample
+    s.write32(0);
+    s.write32(0);
+    s.write32(0xffffffff);
+
+    // mode 8 (solid color) is the 5 bit code 0x17 followed by the RGBA8 color
+    u8 block[16] = { 0 };
+    u64 bits = 0x17 | (u64(color.r) << 5) | (u64(color.g) << 13) | (u64(color.b) << 21) | (u64(color.a) << 29);
+    std::memcpy(block, &bits, 8);
+
+    for (int i = 0; i < xblocks * yblocks; ++i)
+    {
+        s.write(block, 16);
+    }
+}
+
+void test_ktx2_transcode()
+{
+    printf("ktx2 transcoding:\n");
+
+    const int width = 16;
+    const int height = 12;
+    const Color color(200, 100, 50, 255);
+
+    MemoryStream file;
+    createUASTC(file, width, height, color);
+
+    ImageDecoder decoder(file, ".ktx2");
+    ImageHeader header = decoder.header();
+
+    check(header.width == width && header.height == height, "UASTC header");
+
+    Bitmap bitmap(width, height, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
+    ImageDecodeStatus status = decoder.decode(bitmap);
+    check(status && bitmap.address<Color>(width - 1, height - 1)[0] == color, "UASTC -> RGBA");
+
+    TextureCompression info(TextureCompression::BC1_UNORM);
+
+    const int xblocks = info.getBlocksX(width);
+    const int yblocks = info.getBlocksY(height);
+    const size_t stride = xblocks * info.bytes;
+
+    ImageDecodeOptions options;
+    options.compression = TextureCompression::BC1_UNORM;
+
+    // the guard area after the rows of blocks must not be touched
+    const size_t guard = stride * 2;
+    std::vector<u8> blocks(stride * yblocks + guard, 0xcd);
+
+    Surface dest(width, yblocks, Format(), stride, blocks.data());
+    status = decoder.decode(dest, options);
+
+    bool guarded = std::all_of(blocks.end() - guard, blocks.end(), [] (u8 v) { return v == 0xcd; });
+    check(status && guarded, "UASTC -> BC1");
+
+    Bitmap decompressed(width, height, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
+    info.decompress(decompressed, ConstMemory(blocks.data(), stride * yblocks));
+
+    Color sample = decompressed.address<Color>(5, 5)[0];
+    bool similar = std::abs(sample.r - color.r) < 8 && std::abs(sample.g - color.g) < 8 && std::abs(sample.b - color.b) < 8;
+    check(similar, "UASTC -> BC1 color");
+
+    // destination is one row of blocks too short
+    std::fill(blocks.begin(), blocks.end(), 0xcd);
+
+    Surface small(width, yblocks - 1, Format(), stride, blocks.data());
+    status = decoder.decode(small, options);
+
+    guarded = std::all_of(blocks.begin() + stride * (yblocks - 1), blocks.end(), [] (u8 v) { return v == 0xcd; });
+    check(!status && guarded, "UASTC -> BC1 (too small destination)");
+
+    // stride is too small for a row of blocks
+    Surface narrow(width, yblocks, Format(), stride - info.bytes, blocks.data());
+    status = decoder.decode(narrow, options);
+    check(!status, "UASTC -> BC1 (too small stride)");
+}
+
+// ----------------------------------------------------------------------------
+// dds / ktx2 encoders
+// ----------------------------------------------------------------------------
+
+void test_mipmap()
+{
+    printf("mipmap:\n");
+
+    const Format rgba(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8);
+
+    // the center texel of 3x3 contributes one ninth of the 1x1 result
+    Bitmap source(3, 3, rgba);
+    std::memset(source.image, 0, source.stride * source.height);
+    source.address<Color>(1, 1)[0] = Color(255, 255, 255, 255);
+
+    Bitmap dest(1, 1, rgba);
+    mipmap(dest, source);
+
+    check(dest.address<Color>(0, 0)[0] == Color(28, 28, 28, 28), "odd dimensions (3 x 3)");
+
+    // the format must have four 8 bit components
+    const Format rgb10a2(32, Format::UNORM, Format::RGBA, 10, 10, 10, 2);
+
+    bool rejected = false;
+
+    try
+    {
+        Bitmap source(2, 2, rgb10a2);
+        Bitmap dest(1, 1, rgb10a2);
+        mipmap(dest, source);
+    }
+    catch (const Exception&)
+    {
+        rejected = true;
+    }
+
+    check(rejected, "10 bit components");
+}
+
+void test_texture_encode(const std::string& extension)
+{
+    printf("%s encoding:\n", extension.c_str());
+
+    const Format rgba(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8);
+
+    // odd dimensions and sizes which are not multiple of the block size
+    const int width = 37;
+    const int height = 21;
+
+    Bitmap bitmap(width, height, rgba);
+
+    for (int y = 0; y < height; ++y)
+    {
+        Color* scan = bitmap.address<Color>(0, y);
+        for (int x = 0; x < width; ++x)
+        {
+            scan[x] = Color(x * 255 / width, y * 255 / height, 128, 255);
+        }
+    }
+
+    // uncompressed: all levels must round-trip exactly
+    MemoryStream stream;
+
+    ImageEncodeOptions options;
+    options.mipmaps = true;
+    ImageEncodeStatus encode_status = bitmap.save(stream, extension, options);
+
+    ImageDecoder decoder(stream, extension);
+    ImageHeader header = decoder.header();
+
+    check(encode_status && header.width == width && header.height == height && header.levels == 6,
+        "mipmap chain (37 x 21, 6 levels)");
+
+    bool exact = true;
+
+    std::unique_ptr<Bitmap> expected = std::make_unique<Bitmap>(bitmap, rgba);
+
+    for (int level = 0; level < header.levels; ++level)
+    {
+        if (level > 0)
+        {
+            auto next = std::make_unique<Bitmap>(std::max(1, expected->width / 2), std::max(1, expected->height / 2), rgba);
+            mipmap(*next, *expected);
+            expected = std::move(next);
+        }
+
+        Bitmap decoded(expected->width, expected->height, rgba);
+        ImageDecodeStatus status = decoder.decode(decoded, ImageDecodeOptions(), level, 0, 0);
+
+        for (int y = 0; y < decoded.height && status; ++y)
+        {
+            exact &= !std::memcmp(decoded.address(0, y), expected->address(0, y), decoded.width * 4);
+        }
+
+        exact &= bool(status);
+    }
+
+    check(exact, "uncompressed levels");
+
+    // block compressed: the first level decodes close to the source
+    MemoryStream compressed;
+
+    options.block_compression = TextureCompression::BC1_UNORM;
+    encode_status = bitmap.save(compressed, extension, options);
+
+    ImageDecoder bc_decoder(compressed, extension);
+    header = bc_decoder.header();
+
+    Bitmap decoded(width, height, rgba);
+    ImageDecodeStatus status = bc_decoder.decode(decoded);
+
+    int error = 0;
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            Color a = bitmap.address<Color>(x, y)[0];
+            Color b = decoded.address<Color>(x, y)[0];
+            for (int c = 0; c < 3; ++c)
+            {
+                error = std::max(error, std::abs(a[c] - b[c]));
+            }
+        }
+    }
+
+    check(encode_status && status && header.compression == TextureCompression::BC1_UNORM && header.levels == 6,
+        "BC1 header");
+    check(error < 24, fmt::format("BC1 level 0 (maximum error: {})", error));
+}
+
+// ----------------------------------------------------------------------------
+// jpeg
+// ----------------------------------------------------------------------------
+
+// 48 x 16 pixels with 4:2:0 chroma in one row of MCUs: baseline with restart intervals and progressive
+static const u8 g_jpeg_baseline [] =
+{
+    0xFF, 0xD8, 0xFF, 0xEE, 0x00, 0x10, 0x4D, 0x61, 0x6E, 0x67, 0x6F, 0x31, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x00, 0x01, 0xB6, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x0B, 0x07, 0x08, 0x09, 0x08, 0x07, 0x0B,
+    0x09, 0x09, 0x09, 0x0C, 0x0B, 0x0B, 0x0D, 0x10, 0x1B, 0x12, 0x10, 0x0F, 0x0F, 0x10, 0x21, 0x18,
+    0x19, 0x14, 0x1B, 0x27, 0x22, 0x29, 0x28, 0x26, 0x22, 0x26, 0x25, 0x2B, 0x31, 0x3E, 0x35, 0x2B,
+    0x2E, 0x3B, 0x2F, 0x25, 0x26, 0x36, 0x4A, 0x37, 0x3B, 0x40, 0x42, 0x46, 0x46, 0x46, 0x2A, 0x34,
+    0x4C, 0x52, 0x4C, 0x43, 0x51, 0x3E, 0x44, 0x46, 0x43, 0xFF, 0xDB, 0x00, 0x43, 0x01, 0x0B, 0x0C,
+    0x0C, 0x10, 0x0E, 0x10, 0x20, 0x12, 0x12, 0x20, 0x43, 0x2D, 0x26, 0x2D, 0x43, 0x43, 0x43, 0x43,
+    0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43,
+    0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43,
+    0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0xFF, 0xC0,
+    0x00, 0x11, 0x08, 0x00, 0x10, 0x00, 0x30, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+    0x01, 0xFF, 0xC4, 0x00, 0x18, 0x00, 0x00, 0x02, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x06, 0x02, 0x03, 0x07, 0xFF, 0xC4, 0x00, 0x1F, 0x10,
+    0x00, 0x01, 0x04, 0x02, 0x03, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x02, 0x00, 0x03, 0x05, 0x21, 0x01, 0x31, 0x12, 0x22, 0x51, 0x61, 0x32, 0xFF, 0xC4, 0x00, 0x17,
+    0x01, 0x00, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x03, 0x04, 0x05, 0x06, 0xFF, 0xC4, 0x00, 0x1F, 0x11, 0x00, 0x01, 0x03, 0x05, 0x00, 0x03,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x01, 0x04, 0x05, 0x21,
+    0x41, 0x51, 0xC1, 0x12, 0x22, 0xF1, 0xFF, 0xDD, 0x00, 0x04, 0x00, 0x03, 0xFF, 0xDA, 0x00, 0x0C,
+    0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3F, 0x00, 0x9B, 0x12, 0x3A, 0xB4, 0x7B, 0x12,
+    0x3A, 0xB4, 0x80, 0x33, 0x0D, 0xB5, 0xFA, 0x3B, 0xF3, 0x1B, 0x56, 0x0C, 0xDB, 0x87, 0x42, 0x5C,
+    0x31, 0xF3, 0x36, 0x8E, 0x74, 0xC8, 0xD1, 0x2C, 0x57, 0x2D, 0x37, 0x74, 0xB3, 0x91, 0xE9, 0x6E,
+    0x58, 0x5A, 0x28, 0xCC, 0x36, 0xDF, 0xE8, 0xEF, 0xCC, 0x6D, 0x58, 0x33, 0x66, 0x74, 0x25, 0xC3,
+    0x1F, 0x33, 0x6B, 0x3E, 0x62, 0x47, 0x5D, 0x91, 0xCC, 0x48, 0xEB, 0xB2, 0x54, 0xE0, 0xC9, 0x93,
+    0xEA, 0x2D, 0xE2, 0x3A, 0x6E, 0xBF, 0xC5, 0x7E, 0x3D, 0x29, 0x9B, 0x09, 0xED, 0x89, 0x1D, 0x5A,
+    0x39, 0x89, 0x1D, 0x76, 0x48, 0x23, 0x30, 0xDB, 0x74, 0x47, 0x7E, 0x63, 0x6A, 0x63, 0x36, 0xE1,
+    0xD0, 0x97, 0x0C, 0x7C, 0xCD, 0xA5, 0x4E, 0x9B, 0x1A, 0x25, 0x8A, 0xE5, 0xA6, 0xEE, 0x95, 0xF8,
+    0xF4, 0xB7, 0x2C, 0x20, 0xFF, 0xD0, 0xFF, 0xD9,
+};
+
+static const u8 g_jpeg_progressive [] =
+{
+    0xFF, 0xD8, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x0B, 0x07, 0x08, 0x09, 0x08, 0x07, 0x0B, 0x09, 0x09,
+    0x09, 0x0C, 0x0B, 0x0B, 0x0D, 0x10, 0x1B, 0x12, 0x10, 0x0F, 0x0F, 0x10, 0x21, 0x18, 0x19, 0x14,
+    0x1B, 0x27, 0x22, 0x29, 0x28, 0x26, 0x22, 0x26, 0x25, 0x2B, 0x31, 0x3E, 0x35, 0x2B, 0x2E, 0x3B,
+    0x2F, 0x25, 0x26, 0x36, 0x4A, 0x37, 0x3B, 0x40, 0x42, 0x46, 0x46, 0x46, 0x2A, 0x34, 0x4C, 0x52,
+    0x4C, 0x43, 0x51, 0x3E, 0x44, 0x46, 0x43, 0xFF, 0xDB, 0x00, 0x43, 0x01, 0x0B, 0x0C, 0x0C, 0x10,
+    0x0E, 0x10, 0x20, 0x12, 0x12, 0x20, 0x43, 0x2D, 0x26, 0x2D, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43,
+    0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43,
+    0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43,
+    0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0xFF, 0xC2, 0x00, 0x11,
+    0x08, 0x00, 0x10, 0x00, 0x30, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01, 0xFF,
+    0xC4, 0x00, 0x19, 0x00, 0x00, 0x02, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x01, 0x06, 0x02, 0x03, 0x05, 0x04, 0xFF, 0xC4, 0x00, 0x17, 0x01, 0x00,
+    0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+    0x03, 0x05, 0x04, 0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x10, 0x03, 0x10, 0x00, 0x00,
+    0x01, 0x3D, 0x0B, 0xF2, 0x39, 0xAC, 0x72, 0x5E, 0xBD, 0x54, 0x37, 0xAF, 0xC0, 0x2A, 0xDF, 0xFF,
+    0xC4, 0x00, 0x17, 0x10, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x03, 0x13, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x01,
+    0x05, 0x02, 0x34, 0x8D, 0x2E, 0xC1, 0x76, 0x8D, 0x23, 0x4B, 0xB0, 0x5D, 0x98, 0xD2, 0x34, 0xBB,
+    0x05, 0xD9, 0xBF, 0xFF, 0xC4, 0x00, 0x17, 0x11, 0x00, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x04, 0x11, 0xFF, 0xDA, 0x00, 0x08,
+    0x01, 0x03, 0x01, 0x01, 0x3F, 0x01, 0x5C, 0xBA, 0x2E, 0x51, 0x72, 0xE9, 0xFF, 0xC4, 0x00, 0x19,
+    0x11, 0x00, 0x02, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x03, 0x00, 0x04, 0x31, 0x21, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x02, 0x01, 0x01, 0x3F,
+    0x01, 0x35, 0x96, 0xAD, 0xD8, 0x50, 0xC6, 0x70, 0x70, 0x43, 0x59, 0x6A, 0xDD, 0x9F, 0xFF, 0xC4,
+    0x00, 0x14, 0x10, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x30, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x06, 0x3F, 0x02, 0x4F, 0xFF,
+    0xC4, 0x00, 0x19, 0x10, 0x01, 0x00, 0x03, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x11, 0x31, 0x61, 0x10, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01,
+    0x00, 0x01, 0x3F, 0x21, 0xF2, 0x8D, 0x0C, 0x1B, 0x8D, 0x79, 0x76, 0x86, 0x86, 0x0D, 0x8D, 0x4E,
+    0xD3, 0xB4, 0x34, 0x30, 0x6C, 0x6A, 0x7F, 0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x10,
+    0x03, 0x10, 0x00, 0x00, 0x10, 0xBC, 0xE1, 0xFF, 0x00, 0xFF, 0xC4, 0x00, 0x16, 0x11, 0x01, 0x01,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+    0x41, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x03, 0x01, 0x01, 0x3F, 0x10, 0x4C, 0x42, 0x64, 0x98, 0xBF,
+    0xFF, 0xC4, 0x00, 0x1A, 0x11, 0x00, 0x02, 0x03, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x21, 0x00, 0x51, 0xC1, 0x61, 0xF1, 0xFF, 0xDA, 0x00, 0x08,
+    0x01, 0x02, 0x01, 0x01, 0x3F, 0x10, 0x5E, 0xD4, 0x1B, 0x51, 0x59, 0xC0, 0x69, 0xF2, 0x2B, 0x6A,
+    0x0D, 0xA9, 0xFF, 0xC4, 0x00, 0x1A, 0x10, 0x00, 0x02, 0x03, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x01, 0x31, 0x51, 0x11, 0x61, 0xFF, 0xDA,
+    0x00, 0x08, 0x01, 0x01, 0x00, 0x01, 0x3F, 0x10, 0xAD, 0x95, 0xB3, 0x41, 0xC8, 0xB1, 0x3F, 0x0F,
+    0x92, 0xCA, 0xD9, 0x58, 0xD1, 0x72, 0x2C, 0x4B, 0xC3, 0xE4, 0xB2, 0xB1, 0x58, 0x40, 0xDC, 0x8B,
+    0x12, 0xF0, 0xF9, 0x2C, 0xFF, 0xD9,
+};
+
+bool equalDecode(ConstMemory a, ConstMemory b, const ImageDecodeOptions& options)
+{
+    ImageDecoder decoder_a(a, ".jpg");
+    ImageDecoder decoder_b(b, ".jpg");
+
+    ImageHeader header = decoder_a.header();
+
+    const Format rgba(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8);
+
+    Bitmap bitmap_a(header.width, header.height, rgba);
+    Bitmap bitmap_b(header.width, header.height, rgba);
+
+    ImageDecodeStatus status_a = decoder_a.decode(bitmap_a, options);
+    ImageDecodeStatus status_b = decoder_b.decode(bitmap_b, options);
+
+    bool identical = status_a && status_b;
+
+    for (int y = 0; y < header.height && identical; ++y)
+    {
+        identical = !std::memcmp(bitmap_a.address(0, y), bitmap_b.address(0, y), header.width * 4);
+    }
+
+    return identical;
+}
+
+void test_jpeg_fancy_upsampling()
+{
+    printf("jpeg fancy upsampling:\n");
+
+    ConstMemory baseline(g_jpeg_baseline, sizeof(g_jpeg_baseline));
+    ConstMemory progressive(g_jpeg_progressive, sizeof(g_jpeg_progressive));
+
+    // the progressive decoder has all of the MCUs available; the sequential result must be identical
+    ImageDecodeOptions options;
+    options.fancy_upsampling = true;
+
+    for (bool multithread : { false, true })
+    {
+        options.multithread = multithread;
+        check(equalDecode(baseline, progressive, options),
+            multithread ? "restart intervals (multithread)" : "restart intervals");
+    }
+
+    // the sequential decoder processes bands of MCU rows; the height covers several bands
+    const int width = 333;
+    const int height = 517;
+
+    Bitmap bitmap(width, height, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
+
+    for (int y = 0; y < height; ++y)
+    {
+        Color* scan = bitmap.address<Color>(0, y);
+        for (int x = 0; x < width; ++x)
+        {
+            scan[x] = Color(x * 255 / width, (x ^ y) & 0xff, y * 255 / height, 255);
+        }
+    }
+
+    ImageEncodeOptions encode_options;
+    encode_options.subsampling = ChromaSubsampling::S420;
+
+    MemoryStream large_baseline;
+    bitmap.save(large_baseline, ".jpg", encode_options);
+
+    encode_options.progressive = true;
+
+    MemoryStream large_progressive;
+    bitmap.save(large_progressive, ".jpg", encode_options);
+
+    for (bool multithread : { false, true })
+    {
+        options.multithread = multithread;
+        check(equalDecode(large_baseline, large_progressive, options),
+            multithread ? "band edges (multithread)" : "band edges");
+    }
+}
+
+void test_jpeg_encode()
+{
+    printf("jpeg encoding:\n");
+
+    const Format rgba(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8);
+
+    // dimensions which clip the MCUs
+    const int width = 61;
+    const int height = 45;
+
+    Bitmap bitmap(width, height, rgba);
+
+    for (int y = 0; y < height; ++y)
+    {
+        Color* scan = bitmap.address<Color>(0, y);
+        for (int x = 0; x < width; ++x)
+        {
+            scan[x] = Color(x * 255 / width, y * 255 / height, (x + y) * 255 / (width + height), 255);
+        }
+    }
+
+    struct Mode
+    {
+        ChromaSubsampling subsampling;
+        const char* name;
+    };
+
+    const Mode modes [] =
+    {
+        { ChromaSubsampling::S444, "4:4:4" },
+        { ChromaSubsampling::S422, "4:2:2" },
+        { ChromaSubsampling::S420, "4:2:0" },
+    };
+
+    for (const Mode& mode : modes)
+    {
+        ImageEncodeOptions options;
+        options.subsampling = mode.subsampling;
+
+        MemoryStream standard;
+        bitmap.save(standard, ".jpg", options);
+
+        options.optimize_huffman = true;
+
+        MemoryStream optimized;
+        bitmap.save(optimized, ".jpg", options);
+
+        options.progressive = true;
+
+        MemoryStream progressive;
+        bitmap.save(progressive, ".jpg", options);
+
+        Bitmap decoded(width, height, rgba);
+        ImageDecodeStatus status = ImageDecoder(standard, ".jpg").decode(decoded);
+
+        int error = 0;
+
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                Color a = bitmap.address<Color>(x, y)[0];
+                Color b = decoded.address<Color>(x, y)[0];
+                for (int c = 0; c < 3; ++c)
+                {
+                    error = std::max(error, std::abs(a[c] - b[c]));
+                }
+            }
+        }
+
+        check(status && error < 16, fmt::format("{} (maximum error: {})", mode.name, error));
+
+        // the coefficients are the same; only the entropy coding is different
+        check(equalDecode(standard, optimized, ImageDecodeOptions()), fmt::format("{} optimized huffman", mode.name));
+        check(equalDecode(standard, progressive, ImageDecodeOptions()), fmt::format("{} progressive", mode.name));
+    }
+
+    // the markers and the scans are recorded in their own stages
+    MemoryStream stream;
+    bitmap.save(stream, ".jpg");
+
+    ImageCodecStats stats;
+
+    ImageDecodeOptions options;
+    options.stats = &stats;
+
+    Bitmap decoded(width, height, rgba);
+    ImageDecoder(stream, ".jpg").decode(decoded, options);
+
+    check(stats.count(ImageCodecStats::PARSE) > 0 && stats.count(ImageCodecStats::ENTROPY) > 0, "decode statistics");
+}
+
+// ----------------------------------------------------------------------------
+// jpeg transcoding
+// ----------------------------------------------------------------------------
+
+bool equalCoefficients(const JPEGCoefficients& a, const JPEGCoefficients& b)
+{
+    if (a.width != b.width || a.height != b.height || a.components != b.components)
+    {
+        return false;
+    }
+
+    for (int c = 0; c < a.components; ++c)
+    {
+        const int width = a.getBlockWidth(c);
+        const int height = a.getBlockHeight(c);
+
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                if (std::memcmp(a.component[c].block(x, y), b.component[c].block(x, y), 64 * sizeof(s16)))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void createJPEG(MemoryStream& stream, int width, int height)
+{
+    Bitmap bitmap(width, height, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
+
+    for (int y = 0; y < height; ++y)
+    {
+        Color* scan = bitmap.address<Color>(0, y);
+        for (int x = 0; x < width; ++x)
+        {
+            scan[x] = Color(x * 255 / width, (x * y) & 0xff, y * 255 / height, 255);
+        }
+    }
+
+    ImageEncodeOptions options;
+    options.subsampling = ChromaSubsampling::S420;
+
+    bitmap.save(stream, ".jpg", options);
+}
+
+void test_jpeg_transcode()
+{
+    printf("jpeg transcoding:\n");
+
+    // 4 x 3 MCUs of 16 x 16 pixels
+    MemoryStream file;
+    createJPEG(file, 64, 48);
+
+    JPEGCoefficients source;
+    check(decodeJPEGCoefficients(source, file), "decode coefficients");
+
+    // four rotations return to the source
+    JPEGTranscodeOptions options;
+    options.transform = JPEGTransform::ROTATE_90;
+
+    JPEGCoefficients temp[2];
+    bool status = transformJPEGCoefficients(temp[0], source, options);
+    check(status && temp[0].width == 48 && temp[0].height == 64, "rotate 90");
+
+    status &= bool(transformJPEGCoefficients(temp[1], temp[0], options));
+    status &= bool(transformJPEGCoefficients(temp[0], temp[1], options));
+    status &= bool(transformJPEGCoefficients(temp[1], temp[0], options));
+    check(status && equalCoefficients(temp[1], source), "rotate 90 (4x)");
+
+    // the cropped blocks are identical to the source blocks
+    options.transform = JPEGTransform::NONE;
+    options.crop_x = 16;
+    options.crop_y = 16;
+    options.crop_width = 32;
+    options.crop_height = 20;
+
+    JPEGCoefficients cropped;
+    status = transformJPEGCoefficients(cropped, source, options);
+
+    bool identical = status && cropped.width == 32 && cropped.height == 20;
+
+    for (int c = 0; c < cropped.components && identical; ++c)
+    {
+        const int scale = source.component[c].hsf == 2 ? 2 : 1;
+
+        for (int y = 0; y < cropped.getBlockHeight(c); ++y)
+        {
+            for (int x = 0; x < cropped.getBlockWidth(c); ++x)
+            {
+                const s16* a = cropped.component[c].block(x, y);
+                const s16* b = source.component[c].block(x + scale, y + scale);
+                identical &= !std::memcmp(a, b, 64 * sizeof(s16));
+            }
+        }
+    }
+
+    check(identical, "crop");
+
+    // the cropped coefficients survive the encoding
+    MemoryStream output;
+    encodeJPEGCoefficients(output, cropped, options);
+
+    JPEGCoefficients reloaded;
+    status = decodeJPEGCoefficients(reloaded, output);
+    check(status && equalCoefficients(reloaded, cropped), "crop (encode and decode)");
+
+    // the crop origin is outside of the image
+    MemoryStream small;
+    createJPEG(small, 17, 9);
+
+    JPEGCoefficients partial;
+    decodeJPEGCoefficients(partial, small);
+
+    options.crop_x = 20;
+    options.crop_y = 20;
+    options.crop_width = 50;
+    options.crop_height = 40;
+
+    status = transformJPEGCoefficients(temp[0], partial, options);
+    check(!status, "crop outside of the image");
+
+    // the height is less than one MCU: the partial MCU is not mirrored
+    options = JPEGTranscodeOptions();
+    options.transform = JPEGTransform::FLIP_VERTICAL;
+
+    status = transformJPEGCoefficients(temp[0], partial, options);
+    check(status && equalCoefficients(temp[0], partial), "flip vertical (partial MCU)");
+}
+
+// ----------------------------------------------------------------------------
+// srgb
+// ----------------------------------------------------------------------------
+
+void test_srgb()
+{
+    printf("srgb conversion:\n");
+
+    const Format rgba32f(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32);
+    const Format rgba8(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8);
+
+    // the conversions follow the transfer functions; alpha is not modified
+    const int count = 256;
+
+    Bitmap linear(count, 1, rgba32f);
+    float* pixels = linear.address<float>(0, 0);
+
+    for (int i = 0; i < count; ++i)
+    {
+        float value = i / float(count - 1);
+        pixels[i * 4 + 0] = value;
+        pixels[i * 4 + 1] = value;
+        pixels[i * 4 + 2] = value;
+        pixels[i * 4 + 3] = value;
+    }
+
+    Bitmap encoded(count, 1, rgba8);
+    linearToSRGB(encoded, linear);
+
+    Bitmap srgb(count, 1, rgba32f);
+    std::memcpy(srgb.image, linear.image, count * 16);
+    linearToSRGB(srgb);
+
+    float float_error = 0.0f;
+    int byte_error = 0;
+    bool alpha = true;
+
+    for (int i = 0; i < count; ++i)
+    {
+        double value = i / double(count - 1);
+        double expected = value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+
+        const float* pixel = srgb.address<float>(i, 0);
+        const u8* color = encoded.address(i, 0);
+
+        float_error = std::max(float_error, float(std::abs(pixel[0] - expected)));
+        byte_error = std::max(byte_error, std::abs(color[0] - int(expected * 255.0 + 0.5)));
+        alpha &= pixel[3] == float(value) && color[3] == i;
+    }
+
+    check(float_error < 0.0001f, "linear to srgb (float)");
+    check(byte_error <= 1, "linear to srgb (8 bit)");
+    check(alpha, "linear to srgb (alpha)");
+
+    srgbToLinear(srgb);
+
+    float_error = 0.0f;
+
+    for (int i = 0; i < count; ++i)
+    {
+        float_error = std::max(float_error, std::abs(srgb.address<float>(i, 0)[0] - pixels[i * 4]));
+    }
+
+    check(float_error < 0.0001f, "srgb to linear (float)");
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+
+    // the invalid and out of range values are clamped to [0, 1]
+    const float input [] = { nan, -nan, inf, -inf, 2.0f, -1.0f, 0.0f, 1.0f };
+    const float expected [] = { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f };
+
+    bool encode = true;
+    bool decode = true;
+    bool encode8 = true;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        Bitmap bitmap(1, 1, rgba32f);
+        float* pixel = bitmap.address<float>(0, 0);
+
+        pixel[0] = input[i];
+        pixel[1] = input[i];
+        pixel[2] = input[i];
+        pixel[3] = 1.0f;
+        linearToSRGB(bitmap);
+        encode &= pixel[0] == expected[i] && pixel[1] == expected[i] && pixel[2] == expected[i];
+
+        pixel[0] = input[i];
+        pixel[1] = input[i];
+        pixel[2] = input[i];
+        srgbToLinear(bitmap);
+        decode &= pixel[0] == expected[i] && pixel[1] == expected[i] && pixel[2] == expected[i];
+
+        // the 8 bit components, including alpha, are encoded from the float values
+        pixel[0] = input[i];
+        pixel[1] = input[i];
+        pixel[2] = input[i];
+        pixel[3] = input[i];
+
+        Bitmap target(1, 1, rgba8);
+        linearToSRGB(target, bitmap);
+
+        const u8* color = target.address(0, 0);
+        const u8 value = u8(expected[i] * 255.0f);
+        encode8 &= color[0] == value && color[1] == value && color[2] == value && color[3] == value;
+    }
+
+    check(encode, "linear to srgb (invalid float)");
+    check(decode, "srgb to linear (invalid float)");
+    check(encode8, "linear to srgb (invalid 8 bit)");
+}
+
+// ----------------------------------------------------------------------------
+// batch
+// ----------------------------------------------------------------------------
+
+void test_batch_decode()
+{
+    printf("batch decoding:\n");
+
+    const Format format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8);
+
+    MemoryStream streams[3];
+
+    for (int i = 0; i < 3; ++i)
+    {
+        Bitmap bitmap(16 << i, 16, format);
+        std::memset(bitmap.image, 0, bitmap.stride * bitmap.height);
+        bitmap.save(streams[i], ".bmp");
+    }
+
+    const u8 broken [] = { 0x42, 0x4d, 0x00, 0x00 };
+
+    BatchDecoder batch;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        batch.add(streams[i], fmt::format("image{}.bmp", i));
+    }
+
+    batch.add(ConstMemory(broken, sizeof(broken)), "broken.bmp");
+
+    int count = 0;
+    bool failed = false;
+
+    batch.decode([&] (BatchDecoder::Result& result)
+    {
+        if (result.index < 3)
+        {
+            count += result.status && result.bitmap->width == (16 << result.index);
+        }
+        else
+        {
+            failed = !result.status && !result.bitmap;
+        }
+    });
+
+    check(count == 3, "decode");
+    check(failed, "decode (invalid input)");
+
+    // decode() is called from a ThreadPool thread; it must not wait for the pool
+    Promise<int> promise;
+    Future<int> future = promise.getFuture();
+
+    ThreadPool::getInstance().enqueue([&]
+    {
+        BatchDecoder batch;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            batch.add(streams[i], fmt::format("image{}.bmp", i));
+        }
+
+        int count = 0;
+
+        batch.decode([&] (BatchDecoder::Result& result)
+        {
+            count += result.status && result.bitmap->width == (16 << result.index);
+        });
+
+        promise.set(count);
+    });
+
+    check(future.get() == 3, "decode in the ThreadPool");
+
+    // a cancel() before the decode() cancels it; the next decode() is not cancelled
+    batch.cancel();
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            batch.add(streams[i], fmt::format("image{}.bmp", i));
+        }
+
+        count = 0;
+
+        batch.decode([&] (BatchDecoder::Result& result)
+        {
+            count += bool(result.status);
+        });
+
+        check(count == (pass ? 3 : 0), pass ? "decode (after cancel)" : "decode (cancelled)");
+    }
+}
+
+int main()
+{
+    printLine();
+
+    test_ktx2_transcode();
+    test_mipmap();
+    test_texture_encode(".dds");
+    test_texture_encode(".ktx2");
+    test_jpeg_fancy_upsampling();
+    test_jpeg_encode();
+    test_jpeg_transcode();
+    test_srgb();
+    test_batch_decode();
+
+    printLine();
+    if (g_count_failed)
+        printf("  %d tests FAILED.                     \n", g_count_failed);
+    else
+        printf("  All tests PASSED.                    \n");
+    printLine();
+
+    return g_count_failed ? 1 : 0;
+}
@@ -385,6 +385,214 @@ bool test7()
     return true;
 }
 
+bool test8()
+{
+    bool success = true;
+
+    // value: the continuations are chained before and after the result is set
+    Promise<int> promise;
+    Future<int> future = promise.getFuture();
+
+    Future<float> half = future.then([] (int value)
+    {
+        return value * 0.5f;
+    });
+
+    promise.set(7);
+
+    Future<float> quarter = half.then([] (float value)
+    {
+        return value * 0.5f;
+    });
+
+    success &= half.get() == 3.5f && quarter.get() == 1.75f;
+    printf("value: %s\n", success ? "Success" : "FAILED");
+
+    // void: the continuation doesn't return a value; the result is forwarded
+    bool called = false;
+
+    Future<int> same = future.then([&] (int value)
+    {
+        called = value == 7;
+    });
+
+    bool forwarded = called && same.get() == 7;
+    printf("void: %s\n", forwarded ? "Success" : "FAILED");
+    success &= forwarded;
+
+    // exception: the continuations are skipped and get() throws
+    Promise<int> failing;
+    int calls = 0;
+
+    Future<int> chain = failing.getFuture().then([&] (int value)
+    {
+        ++calls;
+        return value + 1;
+    });
+
+    chain = chain.then([&] (int value)
+    {
+        ++calls;
+        return value + 1;
+    });
+
+    failing.setException(std::make_exception_ptr(std::runtime_error("failed")));
+
+    bool thrown = false;
+
+    try
+    {
+        chain.get();
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+
+    // an exception from a continuation is forwarded the same way
+    Future<int> throwing = future.then([] (int value) -> int
+    {
+        throw std::runtime_error("continuation");
+    });
+
+    try
+    {
+        throwing.then([&] (int value)
+        {
+            ++calls;
+        }).get();
+        thrown = false;
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+
+    bool forwarded_exception = thrown && !calls;
+    printf("exception: %s\n", forwarded_exception ? "Success" : "FAILED");
+    success &= forwarded_exception;
+
+    return success;
+}
+
+bool test9()
+{
+    bool success = true;
+
+    CancellationToken parent;
+    CancellationToken child;
+    CancellationToken grandchild;
+
+    child.reset(parent);
+    grandchild.reset(child);
+
+    // cancelling a child doesn't cancel the parent
+    child.cancel();
+    success &= child.isCancelled() && grandchild.isCancelled() && !parent.isCancelled();
+
+    // cancelling the parent cancels the descendants
+    child.reset(parent);
+    success &= !child.isCancelled() && !grandchild.isCancelled();
+
+    parent.cancel();
+    success &= child.isCancelled() && grandchild.isCancelled();
+
+    // the parent link is cleared by reset()
+    parent.reset();
+    child.reset();
+    grandchild.reset(child);
+    parent.cancel();
+    success &= !child.isCancelled() && !grandchild.isCancelled();
+
+    // a token cannot be linked to its descendant
+    parent.reset();
+    child.reset(parent);
+    parent.reset(child);
+    child.cancel();
+    success &= !parent.isCancelled();
+
+    printf("parent links: %s\n", success ? "Success" : "FAILED");
+    return success;
+}
+
+bool test10()
+{
+    using namespace mango::image;
+
+    bool success = true;
+
+    // the decodes waiting for their parallel work don't run the other decodes
+    static thread_local int depth = 0;
+    std::atomic<int> max_depth { 0 };
+
+    {
+        ImageDecodeScheduler scheduler(4);
+
+        for (int i = 0; i < 16; ++i)
+        {
+            scheduler.enqueue(i, [&]
+            {
+                int current = ++depth;
+                int previous = max_depth;
+                while (current > previous && !max_depth.compare_exchange_weak(previous, current))
+                {
+                }
+
+                ConcurrentQueue q;
+
+                for (int j = 0; j < 8; ++j)
+                {
+                    q.enqueue([]
+                    {
+                        Sleep::ms(1);
+                    });
+                }
+
+                q.wait();
+                --depth;
+            });
+        }
+
+        // the destructor waits until the jobs are complete
+    }
+
+    bool nested = max_depth == 1;
+    printf("nesting depth: %d [%s]\n", max_depth.load(), nested ? "Success" : "FAILED");
+    success &= nested;
+
+    // the decoding is cancelled before it is started
+    Bitmap bitmap(16, 16, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
+    std::memset(bitmap.image, 0, bitmap.stride * bitmap.height);
+
+    MemoryStream stream;
+    bitmap.save(stream, ".bmp");
+
+    ImageDecodeScheduler scheduler(1);
+
+    // the only worker is blocked until the decoding has been cancelled
+    Promise<int> gate;
+    Future<int> opened = gate.getFuture();
+
+    scheduler.enqueue(1, [opened]
+    {
+        opened.wait();
+    });
+
+    ImageDecoder decoder(stream, ".bmp");
+
+    ImageDecodeOptions options;
+    options.scheduler = &scheduler;
+
+    ImageDecodeFuture future = decoder.launch(nullptr, bitmap, options);
+    decoder.cancel();
+    gate.set(0);
+
+    bool cancelled = !future.get().success;
+    printf("cancel before start: %s\n", cancelled ? "Success" : "FAILED");
+    success &= cancelled;
+
+    return success;
+}
+
 int main(int argc, char* argv[])
 {
     int count = 1;
@@ -405,6 +613,9 @@ int main(int argc, char* argv[])
         test5,
         test6,
         test7,
+        test8,
+        test9,
+        test10,
     };
 
     for (int i = 0; i < count; ++i)
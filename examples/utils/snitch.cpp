@@ -1,6 +1,6 @@
 /*
     MANGO Multimedia Development Platform
-    Copyright (C) 2012-2024 Twilight Finland 3D Oy Ltd. All rights reserved.
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
 #include <cinttypes>
 #include <algorithm>
@@ -9,21 +9,14 @@
 using namespace mango;
 using namespace mango::filesystem;
 
-#define DISABLE_MMAP
-
 namespace
 {
 
     // unit helpers
-    constexpr u64 KB = 1 << 10;
     constexpr u64 MB = 1 << 20;
     constexpr u64 GB = 1 << 30;
 
     // configuration
-    constexpr u64 large_block_size = 4 * MB;
-    constexpr u64 small_file_max_size = 512 * KB;
-    constexpr u64 small_block_size = 2 * MB;
-
     constexpr size_t store_threshold_default = 95; // percent
 
 } // namespace
@@ -136,66 +129,6 @@ void enumerate(const Path& path, const std::string& prefix, State& state, int de
 // compression
 // ------------------------------------------------------------------------------------------
 
-struct Block
-{
-    struct Segment
-    {
-        std::string filename;
-        u64 offset;
-        u64 size;
-    };
-
-    u64 bytes { 0 };
-    std::vector<Segment> segments;
-
-    u64 offset;
-    u64 compressed;
-    u64 uncompressed;
-    u32 method;
-
-    void append(const Segment& segment)
-    {
-        segments.push_back(segment);
-        bytes += segment.size;
-    }
-};
-
-struct SegFile
-{
-    struct Segment
-    {
-        u32 block;
-        u32 offset;
-        u32 size;
-    };
-
-    std::string filename;
-    u64 size;
-    u32 checksum;
-    std::vector<Segment> segments;
-};
-
-struct BlockManager
-{
-    std::vector<Block> blocks;
-    std::vector<SegFile> files;
-
-    void flush(Block& block)
-    {
-        if (!block.segments.empty())
-        {
-            blocks.push_back(block);
-            block = Block();
-        }
-    }
-
-    void segment(u32 offset, u32 size)
-    {
-        const u32 block_index = u32(blocks.size());
-        files.back().segments.push_back({block_index, offset, size});
-    }
-};
-
 void compress(State& state, const std::string& folder, const std::string& archive, const std::string& compression, int level, size_t store_threshold)
 {
     Compressor compressor = getCompressor(compression);
@@ -225,204 +158,37 @@ void compress(State& state, const std::string& folder, const std::string& archiv
             return a.size > b.size;
         });
 
-    BlockManager manager;
-    Block block;
-
-    for (auto node : state.files)
-    {
-        // compute checksum
-        File file(path, node.name);
-        u32 checksum = crc32c(0, file);
-
-        manager.files.push_back({node.name, node.size, checksum});
-
-        if (node.size > small_file_max_size)
-        {
-            if (node.size > large_block_size * 2)
-            {
-                // split the file into multiple blocks
-                for (u64 offset = 0; offset < node.size; offset += large_block_size)
-                {
-                    u64 size = std::min(large_block_size, node.size - offset);
-                    manager.segment(0, size);
-                    block.append({node.name, offset, size});
-                    manager.flush(block);
-                }
-            }
-            else
-            {
-                // compress the file as one block
-                manager.segment(0, node.size);
-                block.append({node.name, 0, node.size});
-                manager.flush(block);
-            }
-        }
-        else
-        {
-            // merge small files into one block
-            if (block.bytes >= small_block_size)
-            {
-                manager.flush(block);
-            }
-
-            manager.segment(u32(block.bytes), node.size);
-            block.append({node.name, 0, node.size});
-        }
-    }
-
-    manager.flush(block);
-
-    // create output stream
+    u64 time0 = Time::ms();
 
     OutputFileStream output(archive);
-    LittleEndianStream str = output;
-
-    // write identifier
+    ArchiveWriterMGX writer(output, compressor.method, level);
+    writer.setStoreThreshold(u32(store_threshold));
 
-    str.write32(u32_mask('m', 'g', 'x', '0'));
-
-    // compress
-
-    ConcurrentQueue q; // compression queue
-    std::mutex mutex; // write serialization mutex
-
-    u64 time0 = Time::ms();
-
-    for (auto &block : manager.blocks)
+    for (auto node : state.files)
     {
-        q.enqueue([&] ()
-        {
-            Buffer source(block.bytes);
-            u8* ptr = source.data();
-
-            for (auto segment : block.segments)
-            {
-#ifdef DISABLE_MMAP
-                std::string filename = path.pathname() + segment.filename;
-                InputFileStream file(filename);
-                file.seek(segment.offset, Stream::SeekMode::Begin);
-                file.read(ptr, segment.size);
-                ptr += segment.size;
-#else
-                File file(path, segment.filename);
-                ConstMemory memory = ConstMemory(file).slice(segment.offset, segment.size);
-                std::memcpy(ptr, memory.address, memory.size);
-                ptr += memory.size;
-#endif
-            }
-
-            Memory uncompressed = source;
-
-            Memory compressed;
-            Buffer dest;
-
-            if (store_threshold > 0)
-            {
-                size_t bound = compressor.bound(uncompressed.size);
-                dest.reset(bound);
-
-                compressed.size = compressor.compress(dest, uncompressed, level);
-                compressed.address = dest.data();
-            }
-            else
-            {
-                compressed = source;
-            }
-
-            if (compressed.size > uncompressed.size * store_threshold / 100)
-            {
-                // doesn't compress -> store
-                compressed = uncompressed;
-
-                block.uncompressed = uncompressed.size;
-                block.compressed = compressed.size;
-                block.method = Compressor::NONE;
-
-                print("s");
-            }
-            else
-            {
-                block.uncompressed = uncompressed.size;
-                block.compressed = compressed.size;
-                block.method = compressor.method;
-
-                print(".");
-            }
-
-            fflush(stdout);
-
-            std::unique_lock<std::mutex> write_lock(mutex);
-
-            block.offset = output.offset();
-            output.write(compressed.address, compressed.size);
-
-            print("+");
-            fflush(stdout);
-        });
+        File file(path, node.name);
+        writer.addFile(node.name, file);
     }
 
-    // synchronize
-    q.wait();
-
     for (auto node : state.containers)
     {
         // container: store w/o compressing
-#ifdef DISABLE_MMAP
-        Buffer buffer(large_block_size);
-        std::string filename = path.pathname() + node.name;
-        InputFileStream file(filename);
-#else
         File file(path, node.name);
-#endif
-
-        block.method = Compressor::NONE;
-        block.offset = output.offset();
-        block.compressed = file.size();
-        block.uncompressed = file.size();
-
-        // write the file in multiple parts
-        for (u64 offset = 0; offset < file.size(); offset += large_block_size)
-        {
-            u64 size = std::min(large_block_size, file.size() - offset);
-#ifdef DISABLE_MMAP
-            file.read(buffer.data(), size);
-            output.write(buffer.data(), size);
-#else
-            output.write(file.data() + offset, size);
-#endif
-            print("s");
-            fflush(stdout);
-        }
-
-        u64 size = file.size();
-
-        manager.files.push_back({node.name, size});
-        manager.segment(0, size);
-        block.append({node.name, 0, size});
-
-        manager.flush(block);
+        writer.addFile(node.name, file, Compressor::NONE);
     }
 
-    block.method = Compressor::NONE;
-    block.offset = output.offset();
-    block.compressed = 0;
-    block.uncompressed = 0;
-
     for (auto node : state.folders)
     {
-        manager.files.push_back({node.name, 0});
-        block.append({node.name, 0, 0});
+        writer.addFolder(node.name);
     }
 
-    manager.flush(block);
+    writer.finish();
 
     u64 time1 = Time::ms();
     u64 dt = time1 - time0;
 
     u64 total_compressed_bytes = output.offset();
 
-    printLine("");
-    printLine("");
     printLine("Compressed: {:0.1f} MB --> {:0.1f} MB ({:0.1f}%) in {:0.2f} seconds ({}-{}, {} MB/s)",
         state.total_bytes / double(MB),
         total_compressed_bytes / double(MB),
@@ -431,127 +197,6 @@ void compress(State& state, const std::string& folder, const std::string& archiv
         compressor.name,
         level,
         state.total_bytes / (std::max(u64(1), dt) * 1024));
-
-    /*
-
-    --------------------------------------------------------------------------
-    File Format Types:
-    --------------------------------------------------------------------------
-
-    Type[]:
-        u32         count
-        Type        data[count]
-
-    Block:
-        u64         offset
-        u64         compressed
-        u64         uncompressed
-        u32         compression method
-
-    Segment:
-        u32         block_index
-        u32         offset
-        u32         size
-
-    File:
-        char[]      filename
-        u64         size
-        u32         checksum
-        Segment[]   segments
-
-    --------------------------------------------------------------------------
-    File Format Structure:
-    --------------------------------------------------------------------------
-
-    Compressed block data:
-        u32         magic: mgx0
-        u8[]        data     <-- written by the compressor, a raw binary blob w/o specific size or structure
-
-    Block Info Array:
-        u32         magic: mgx1
-        block[]     blocks
-
-    File Info Array:
-        u32         magic: mgx2
-        u64         compressed size (file array)
-        u64         uncmpressed size (file array)
-        File[]      files (compressed with zstd)
-
-    Header:
-        u32         magic: mgx3
-        u32         version
-        u64         offset to block info array
-        u64         offset to file info array
-    */
-
-    // write block data
-
-    u64 block_data_offset = output.offset();
-    u32 num_blocks = u32(manager.blocks.size());
-
-    str.write32(u32_mask('m', 'g', 'x', '1'));
-    str.write32(num_blocks);
-
-    for (auto &block : manager.blocks)
-    {
-        str.write64(block.offset);
-        str.write64(block.compressed);
-        str.write64(block.uncompressed);
-        str.write32(block.method);
-    }
-
-    // write file data
-
-    u64 file_data_offset = output.offset();
-
-    str.write32(u32_mask('m', 'g', 'x', '2'));
-
-    // write file data into temporary buffer
-
-    MemoryStream temp;
-    LittleEndianStream le = temp; // LE adaptor for writing into the stream
-
-    le.write32(u32(manager.files.size()));
-
-    for (auto &file : manager.files)
-    {
-        std::string filename = removePrefix(file.filename, folder);
-        u32 length = u32(filename.length());
-
-        le.write32(length);
-        le.write(filename.c_str(), length);
-
-        le.write64(file.size);
-        le.write32(file.checksum);
-        le.write32(u32(file.segments.size()));
-
-        for (auto &segment : file.segments)
-        {
-            le.write32(segment.block);
-            le.write32(segment.offset);
-            le.write32(segment.size);
-        }
-    }
-
-    // compress the temporary buffer
-
-    size_t bound = compressor.bound(temp.size());
-    Buffer compressed(bound);
-
-    CompressionStatus status = zstd::compress(compressed, temp, 10);
-
-    // write compressed buffer
-
-    str.write64(u64(status.size)); // compressed size
-    str.write64(u64(temp.size())); // uncompressed size
-    str.write(compressed, status.size);
-
-    // write header
-
-    str.write32(u32_mask('m', 'g', 'x', '3'));
-    str.write32(1);
-    str.write64(block_data_offset);
-    str.write64(file_data_offset);
 }
 
 void printHelp(const CommandLine& commands)
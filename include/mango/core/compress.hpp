@@ -1,6 +1,6 @@
 /*
     MANGO Multimedia Development Platform
-    Copyright (C) 2012-2024 Twilight Finland 3D Oy Ltd. All rights reserved.
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
 #pragma once
 
@@ -216,4 +216,104 @@ namespace mango
     Compressor getCompressor(Compressor::Method method);
     Compressor getCompressor(const std::string& name);
 
+    // -----------------------------------------------------------------------
+    // CompressionContext
+    // -----------------------------------------------------------------------
+
+    // Allocating and initializing the compressor state is expensive compared to
+    // compressing a small block. The CompressionContext keeps the state alive so that
+    // it can be reused across calls. The compression functions above use a per-thread
+    // context internally; an explicit context gives the caller control over the lifetime
+    // of the cached memory. The context is NOT thread-safe; use one context per thread.
+
+    class CompressionContext : private NonCopyable
+    {
+    public:
+        struct State;
+
+        CompressionContext();
+        ~CompressionContext();
+
+        // release the cached state
+        void reset();
+
+        CompressionStatus compress(Compressor::Method method, Memory dest, ConstMemory source, int level = 6);
+        CompressionStatus decompress(Compressor::Method method, Memory dest, ConstMemory source);
+
+    protected:
+        std::unique_ptr<State> m_state;
+    };
+
+    // -----------------------------------------------------------------------
+    // dictionary compression
+    // -----------------------------------------------------------------------
+
+    // Small records compress poorly because every record starts with an empty history.
+    // A dictionary trained from representative samples primes the history so that
+    // independent records can be compressed and decompressed in any order. The same
+    // dictionary MUST be used for compression and decompression. The dictionary is
+    // digested once when the encoder or decoder is created; they are thread-safe and
+    // can be shared between threads. The LZ4 dictionary encoder uses the fast mode.
+
+    class DictionaryEncoder
+    {
+    public:
+        DictionaryEncoder() {}
+        virtual ~DictionaryEncoder() {}
+        virtual size_t bound(size_t size) const = 0;
+        virtual CompressionStatus compress(Memory dest, ConstMemory source) const = 0;
+    };
+
+    class DictionaryDecoder
+    {
+    public:
+        DictionaryDecoder() {}
+        virtual ~DictionaryDecoder() {}
+        virtual CompressionStatus decompress(Memory dest, ConstMemory source) const = 0;
+    };
+
+    // The dictionary is written into dest; the size is a trade-off between compression
+    // ratio and memory use. Typical dictionary size is 100x smaller than the samples.
+    CompressionStatus trainDictionary(Memory dest, const std::vector<ConstMemory>& samples);
+
+    namespace lz4
+    {
+        std::shared_ptr<DictionaryEncoder> createDictionaryEncoder(ConstMemory dictionary, int level = 6);
+        std::shared_ptr<DictionaryDecoder> createDictionaryDecoder(ConstMemory dictionary);
+    }
+
+    namespace zstd
+    {
+        std::shared_ptr<DictionaryEncoder> createDictionaryEncoder(ConstMemory dictionary, int level = 6);
+        std::shared_ptr<DictionaryDecoder> createDictionaryDecoder(ConstMemory dictionary);
+    }
+
+    // Supported methods: LZ4, ZSTD
+    std::shared_ptr<DictionaryEncoder> createDictionaryEncoder(Compressor::Method method, ConstMemory dictionary, int level = 6);
+    std::shared_ptr<DictionaryDecoder> createDictionaryDecoder(Compressor::Method method, ConstMemory dictionary);
+
+    // -----------------------------------------------------------------------
+    // parallel block compression
+    // -----------------------------------------------------------------------
+
+    // The source is split into independent blocks which are compressed in the
+    // ThreadPool. The result is a self-contained frame with a block index so that
+    // the decompression can also run in parallel. The blocks which do not compress
+    // are stored. The memory allocation is caller's responsibility; use
+    // boundParallel() for the compressed and sizeParallel() for the decompressed size.
+
+    // Frame format (little-endian):
+    //     u32     magic: mcp0
+    //     u32     compression method
+    //     u64     uncompressed size
+    //     u32     block size
+    //     u32     number of blocks
+    //     Block[] compressed size (u32), compression method (u32) for each block
+    //     u8[]    compressed blocks
+
+    size_t boundParallel(Compressor::Method method, size_t size, size_t block_size = 1024 * 1024);
+    size_t sizeParallel(ConstMemory source);
+    CompressionStatus compressParallel(Memory dest, ConstMemory source, Compressor::Method method, int level = 6, size_t block_size = 1024 * 1024);
+    CompressionStatus decompressParallel(Memory dest, ConstMemory source);
+
 } // namespace mango
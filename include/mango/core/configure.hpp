@@ -681,6 +681,121 @@
 
 #endif
 
+// -----------------------------------------------------------------------
+// Runtime dispatch
+// -----------------------------------------------------------------------
+
+/*
+    The kernels for a more recent instruction set than the build target can be compiled
+    into the same binary and selected at runtime with getCPUFlags(). The code between
+    MANGO_TARGET_BEGIN_xxx and MANGO_TARGET_END is compiled for the named instruction set
+    and MANGO_DISPATCH_xxx is defined when the instruction set is available either way:
+
+        #if defined(MANGO_DISPATCH_AVX2)
+        MANGO_TARGET_BEGIN_AVX2
+
+            void foo_avx2(...) { ... }
+
+        MANGO_TARGET_END
+        #endif
+
+        if ((getCPUFlags() & TARGET_AVX2) == TARGET_AVX2)
+            foo = foo_avx2;
+
+    The TARGET_xxx masks in cpuinfo.hpp are the features each target is compiled with.
+
+    The target code must be written with raw intrinsics; the math and simd libraries are
+    configured for the build target and don't change between the macros. Templates and inline
+    functions defined outside of the target code are compiled for the build target and cannot
+    inline the target functions they call; a function which instantiates such a template is
+    declared MANGO_TARGET_FLATTEN to inline the whole call tree into it. The AVX2 target
+    includes the FMA3, F16C, BMI and LZCNT extensions which all AVX2 processors have and the
+    AVX-512 target is the F, BW, DQ and VL subset. The F16C instructions are available in the
+    AVX2 and AVX-512 targets only when MANGO_DISPATCH_F16C is also defined.
+
+    The MSVC compiler does not need the target macros since the intrinsics for all instruction
+    sets are always available. Define MANGO_NO_DISPATCH to use only the build target.
+*/
+
+#if defined(MANGO_ENABLE_SSE2) && !defined(MANGO_NO_DISPATCH)
+
+    #if defined(MANGO_COMPILER_GCC)
+
+        #define MANGO_ENABLE_DISPATCH
+        #include <immintrin.h>
+
+        #define MANGO_TARGET_PRAGMA(x) \
+            _Pragma("GCC push_options") \
+            _Pragma(#x)
+
+        #define MANGO_TARGET_BEGIN_SSE4_1 MANGO_TARGET_PRAGMA(GCC target("sse4.1,sse4.2,popcnt"))
+        #define MANGO_TARGET_BEGIN_F16C   MANGO_TARGET_PRAGMA(GCC target("sse4.1,sse4.2,popcnt,avx,f16c"))
+        #define MANGO_TARGET_BEGIN_AVX2   MANGO_TARGET_PRAGMA(GCC target("avx2,fma,f16c,bmi,bmi2,lzcnt,popcnt"))
+        #define MANGO_TARGET_BEGIN_AVX512 MANGO_TARGET_PRAGMA(GCC target("avx512f,avx512bw,avx512dq,avx512vl,avx2,fma,f16c,bmi,bmi2,lzcnt,popcnt"))
+        #define MANGO_TARGET_END          _Pragma("GCC pop_options")
+        #define MANGO_TARGET_FLATTEN      __attribute__((flatten))
+
+    #elif defined(MANGO_COMPILER_CLANG)
+
+        #define MANGO_ENABLE_DISPATCH
+        #include <immintrin.h>
+
+        #define MANGO_TARGET_PRAGMA(x) \
+            _Pragma(#x)
+
+        #define MANGO_TARGET_BEGIN_SSE4_1 MANGO_TARGET_PRAGMA(clang attribute push(__attribute__((target("sse4.1,sse4.2,popcnt"))), apply_to = function))
+        #define MANGO_TARGET_BEGIN_F16C   MANGO_TARGET_PRAGMA(clang attribute push(__attribute__((target("sse4.1,sse4.2,popcnt,avx,f16c"))), apply_to = function))
+        #define MANGO_TARGET_BEGIN_AVX2   MANGO_TARGET_PRAGMA(clang attribute push(__attribute__((target("avx2,fma,f16c,bmi,bmi2,lzcnt,popcnt"))), apply_to = function))
+        #define MANGO_TARGET_BEGIN_AVX512 MANGO_TARGET_PRAGMA(clang attribute push(__attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2,fma,f16c,bmi,bmi2,lzcnt,popcnt"))), apply_to = function))
+        #define MANGO_TARGET_END          _Pragma("clang attribute pop")
+        #define MANGO_TARGET_FLATTEN      __attribute__((flatten))
+
+    #elif defined(MANGO_COMPILER_MSVC) && defined(MANGO_CPU_64BIT)
+
+        // MSVC doesn't implement all of the AVX2 intrinsics in 32 bit target mode
+        #define MANGO_ENABLE_DISPATCH
+        #include <immintrin.h>
+
+    #endif
+
+#endif
+
+#if defined(MANGO_ENABLE_DISPATCH)
+
+    #define MANGO_DISPATCH_SSE4_1
+    #define MANGO_DISPATCH_F16C
+    #define MANGO_DISPATCH_AVX2
+    #define MANGO_DISPATCH_AVX512
+
+#else
+
+    #if defined(MANGO_ENABLE_SSE4_1)
+        #define MANGO_DISPATCH_SSE4_1
+    #endif
+
+    #if defined(MANGO_ENABLE_SSE4_1) && defined(__F16C__)
+        #define MANGO_DISPATCH_F16C
+    #endif
+
+    #if defined(MANGO_ENABLE_AVX2)
+        #define MANGO_DISPATCH_AVX2
+    #endif
+
+    #if defined(MANGO_ENABLE_AVX512) && defined(__AVX512BW__) && defined(__AVX512VL__)
+        #define MANGO_DISPATCH_AVX512
+    #endif
+
+#endif
+
+#if !defined(MANGO_TARGET_END)
+    #define MANGO_TARGET_BEGIN_SSE4_1
+    #define MANGO_TARGET_BEGIN_F16C
+    #define MANGO_TARGET_BEGIN_AVX2
+    #define MANGO_TARGET_BEGIN_AVX512
+    #define MANGO_TARGET_END
+    #define MANGO_TARGET_FLATTEN
+#endif
+
 // -----------------------------------------------------------------------
 // C++ standard version
 // -----------------------------------------------------------------------
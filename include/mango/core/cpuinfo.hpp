@@ -63,6 +63,15 @@ namespace mango
         ARM_PMULL         = 0x0040000000000000,
     };
 
+    // Features required by the MANGO_TARGET_BEGIN_xxx code (see configure.hpp)
+    enum : u64
+    {
+        TARGET_SSE4_1     = INTEL_SSE4_1 | INTEL_SSE4_2 | INTEL_POPCNT,
+        TARGET_F16C       = TARGET_SSE4_1 | INTEL_AVX | INTEL_F16C,
+        TARGET_AVX2       = TARGET_F16C | INTEL_AVX2 | INTEL_FMA3 | INTEL_BMI1 | INTEL_BMI2 | INTEL_LZCNT,
+        TARGET_AVX512     = TARGET_AVX2 | INTEL_AVX512F | INTEL_AVX512BW | INTEL_AVX512DQ | INTEL_AVX512VL,
+    };
+
     u64 getCPUFlags();
 
 } // namespace mango
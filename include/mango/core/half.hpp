@@ -138,6 +138,10 @@ namespace mango
         template <int Sign, int Exponent, int Mantissa>
         static u32 pack(float value)
         {
+            // the result is rounded to nearest even like in the hardware conversions (F16C, NEON)
+            constexpr int shift = Float::MANTISSA - Mantissa;
+            constexpr int bias = (1 << (Exponent - 1)) - 1;
+
             u32 result = 0;
 
             Float temp = value;
@@ -148,24 +152,27 @@ namespace mango
             {
                 // Inf / NaN
                 result = ((1 << Exponent) - 1) << Mantissa;
-                result |= temp.mantissa ? temp.mantissa >> (Float::MANTISSA - Mantissa) : 0; // Nan -> qNaN, Inf -> Inf
+                result |= temp.mantissa ? (1 << (Mantissa - 1)) | (temp.mantissa >> shift) : 0; // Nan -> qNaN, Inf -> Inf
+            }
+            else if (temp.u >= Float(0, Float::BIAS + bias + 1, 0).u)
+            {
+                // Clamp to signed Infinity
+                result = ((1 << Exponent) - 1) << Mantissa;
+            }
+            else if (temp.u < Float(0, Float::BIAS - bias + 1, 0).u)
+            {
+                // Denormalized number or zero; the float addition aligns the mantissa
+                // and rounds it to nearest even
+                const Float magic(0, Float::BIAS - bias + shift + 1, 0);
+                temp.f += magic.f;
+                result = temp.u - magic.u;
             }
             else
             {
-                // (De)Normalized number or zero
-                const Float magic(0, (1 << (Exponent - 1)) - 1, 0);
-                temp.u &= ~((1 << (Float::MANTISSA - Mantissa - 1)) - 1);
-                temp.f *= magic.f;
-                temp.u += (1 << (Float::MANTISSA - Mantissa - 1)); // Rounding bias
-
-                const Float infty(0, (1 << Exponent) - 1, 0);
-                if (temp.u > infty.u)
-                {
-                    // Clamp to signed Infinity
-                    temp.u = infty.u;
-                }
-
-                result = temp.u >> (Float::MANTISSA - Mantissa);
+                // Normalized number; the rounding bias is one less than half for even mantissa
+                const u32 odd = (temp.u >> shift) & 1;
+                temp.u += (u32(bias - Float::BIAS) << Float::MANTISSA) + (1 << (shift - 1)) - 1 + odd;
+                result = temp.u >> shift;
             }
 
             result |= ((vsign & Sign) << (Exponent + Mantissa));
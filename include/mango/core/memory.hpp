@@ -131,6 +131,15 @@ namespace mango
         }
     };
 
+    enum class MemoryAccess
+    {
+        Normal,      // default readahead
+        Sequential,  // the memory is read from start to end; aggressive readahead
+        Random,      // the memory is accessed in random order; no readahead
+        WillNeed,    // the whole memory will be read soon; start reading it in the background
+        HugePages,   // back the memory with huge pages when the system supports it
+    };
+
     class VirtualMemory : private NonCopyable
     {
     protected:
@@ -140,6 +149,13 @@ namespace mango
         VirtualMemory() = default;
         virtual ~VirtualMemory() {}
 
+        // The access hints are best effort and ignored when the system does not support them.
+        void advise(MemoryAccess access) const;
+
+        // Start reading the pages in range into memory. Decoders can call this ahead of the
+        // parsing cursor so that the page faults are resolved before the data is needed.
+        void prefetch(ConstMemory range) const;
+
         const ConstMemory* operator -> () const
         {
             return &m_memory;
@@ -17,6 +17,33 @@
 namespace mango
 {
 
+    // ----------------------------------------------------------------------------------
+    // Trace
+    // ----------------------------------------------------------------------------------
+
+    /*
+        Chrome trace event recording (chrome://tracing or ui.perfetto.dev).
+
+        The events are recorded between startTrace() and stopTrace(); when no trace is
+        active a Trace costs one relaxed atomic load and does not allocate. The events are
+        stored into per-thread lock-free ring buffers which are drained by a writer thread.
+
+        The names given as const char* must have static storage duration (string literals).
+        Other names are interned into the Tracer, which is done only when a trace is active.
+
+        Usage example:
+
+            {
+                Trace trace("Image", "decode");
+                ...
+            }
+
+            traceCounter("Image", "bytes", bytes);
+
+            traceFlowBegin("Image", "load", id); // in the producer trace
+            traceFlowEnd("Image", "load", id);   // in the consumer trace
+    */
+
     struct TraceThread
     {
         u32 tid;
@@ -29,34 +56,54 @@ namespace mango
     {
         struct Data
         {
+            enum Type : u32
+            {
+                COMPLETE,
+                COUNTER,
+                FLOW_BEGIN,
+                FLOW_END,
+            };
+
+            Type type;
             u32 tid;
             u64 time0;
             u64 time1;
-            std::string category;
-            std::string name;
+            s64 value; // counter value or flow id
+            const char* category;
+            const char* name;
         } data;
 
-        Trace(const std::string& category, const std::string& name);
+        Trace(const char* category, const char* name);
+        Trace(const char* category, std::string_view name);
         ~Trace();
 
         void stop();
     };
 
+    void traceCounter(const char* category, const char* name, s64 value);
+    void traceFlowBegin(const char* category, const char* name, u64 id);
+    void traceFlowEnd(const char* category, const char* name, u64 id);
+
     struct Tracer
     {
-        std::mutex mutex;
-        Stream* output { nullptr };
-        std::vector<TraceThread> threads;
-        std::vector<Trace::Data> traces;
-        std::vector<Trace::Data> traces_out;
-        SerialQueue writer;
-        bool comma;
-        u32 count;
+        struct State;
+        std::unique_ptr<State> m_state;
+
+        std::atomic<bool> enabled { false };
 
         Tracer();
         ~Tracer();
 
-        void append(const Trace& trace);
+        bool isEnabled() const
+        {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        // returns a pointer to a copy of the name which is valid for the lifetime of the Tracer
+        const char* intern(std::string_view name);
+
+        void append(const Trace::Data& data);
+        void registerThread(const TraceThread& thread);
 
         void start(Stream* stream);
         void stop();
@@ -12,6 +12,8 @@
 #include <functional>
 #include <condition_variable>
 #include <future>
+#include <exception>
+#include <type_traits>
 #include <mango/core/exception.hpp>
 #include <mango/core/memory.hpp>
 #include <mango/core/atomic.hpp>
@@ -58,11 +60,19 @@ namespace mango
 
         int size() const;
 
+        // approximate number of tasks waiting for a thread; a measure of the current load
+        size_t getQueueSize() const;
+
         void enqueue(std::function<void()>&& func)
         {
             enqueue(&m_static_queue, std::move(func));
         }
 
+        // Process the queued tasks in the calling thread until done() returns true. The thread
+        // sleeps while the pool has no tasks; the thread which makes done() true calls notify().
+        void help(const std::function<bool()>& done);
+        void notify();
+
     protected:
         struct Consumer;
 
@@ -400,4 +410,258 @@ namespace mango
         }
     };
 
+    // ----------------------------------------------------------------------------------
+    // CancellationToken
+    // ----------------------------------------------------------------------------------
+
+    /*
+        CancellationToken is a flag for cancelling asynchronous work; the copies share the
+        same flag. A token can be linked to a parent token: it is cancelled when the parent
+        is cancelled but cancelling it does not cancel the parent. This way one token can
+        cancel a group of tasks which each also have their own token.
+
+        Usage example:
+
+            CancellationToken token;
+
+            q.enqueue([token]
+            {
+                while (!token.isCancelled())
+                {
+                    // your stuff here..
+                }
+            });
+
+            token.cancel();
+
+    */
+
+    class CancellationToken
+    {
+    protected:
+        struct State
+        {
+            std::atomic<bool> cancelled { false };
+            std::shared_ptr<State> parent;
+        };
+
+        std::shared_ptr<State> m_state;
+
+    public:
+        CancellationToken();
+        ~CancellationToken();
+
+        void cancel();
+        bool isCancelled() const;
+
+        // Clear the cancellation and the parent link. NOTE: not safe while other threads
+        // are calling isCancelled().
+        void reset();
+        void reset(const CancellationToken& parent);
+
+        explicit operator bool () const
+        {
+            return isCancelled();
+        }
+    };
+
+    // ----------------------------------------------------------------------------------
+    // Future
+    // ----------------------------------------------------------------------------------
+
+    /*
+        Future is a lightweight handle to the result of an asynchronous task; the copies
+        share the same result. The result is set with a Promise. Continuations are chained
+        with then(); they are called in the thread which sets the result, or immediately
+        when the result is already available. An exception is forwarded through the chain
+        of continuations and thrown from get().
+
+        Usage example:
+
+            Promise<int> promise;
+            Future<int> future = promise.getFuture();
+
+            Future<float> half = future.then([] (int value)
+            {
+                return value * 0.5f;
+            });
+
+            ThreadPool::getInstance().enqueue([promise]
+            {
+                promise.set(7);
+            });
+
+            float x = half.get(); // 3.5f
+
+    */
+
+    template <typename T>
+    class Promise;
+
+    template <typename T>
+    class Future
+    {
+    protected:
+        friend class Promise<T>;
+
+        struct State
+        {
+            std::mutex mutex;
+            std::condition_variable condition;
+            bool ready = false;
+            T value {};
+            std::exception_ptr exception;
+            std::vector<std::function<void(const State&)>> continuations;
+        };
+
+        std::shared_ptr<State> m_state;
+
+        explicit Future(const std::shared_ptr<State>& state)
+            : m_state(state)
+        {
+        }
+
+    public:
+        Future() = default;
+        ~Future() = default;
+
+        bool valid() const
+        {
+            return m_state != nullptr;
+        }
+
+        bool isReady() const
+        {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            return m_state->ready;
+        }
+
+        void wait() const
+        {
+            std::unique_lock<std::mutex> lock(m_state->mutex);
+            m_state->condition.wait(lock, [this] { return m_state->ready; });
+        }
+
+        T get() const
+        {
+            wait();
+
+            if (m_state->exception)
+            {
+                std::rethrow_exception(m_state->exception);
+            }
+
+            return m_state->value;
+        }
+
+        // The continuation is called with the result. The returned future has the result of
+        // the continuation, or the same result when the continuation doesn't return a value.
+        template <typename F>
+        auto then(F&& func) const
+        {
+            using R = std::invoke_result_t<F, const T&>;
+            using U = std::conditional_t<std::is_void_v<R>, T, R>;
+
+            Promise<U> promise;
+            Future<U> future = promise.getFuture();
+
+            auto continuation = [promise, func = std::forward<F>(func)] (const State& state) mutable
+            {
+                if (state.exception)
+                {
+                    promise.setException(state.exception);
+                    return;
+                }
+
+                try
+                {
+                    if constexpr (std::is_void_v<R>)
+                    {
+                        func(state.value);
+                        promise.set(state.value);
+                    }
+                    else
+                    {
+                        promise.set(func(state.value));
+                    }
+                }
+                catch (...)
+                {
+                    promise.setException(std::current_exception());
+                }
+            };
+
+            std::unique_lock<std::mutex> lock(m_state->mutex);
+
+            if (m_state->ready)
+            {
+                lock.unlock();
+                continuation(*m_state);
+            }
+            else
+            {
+                m_state->continuations.emplace_back(std::move(continuation));
+            }
+
+            return future;
+        }
+    };
+
+    template <typename T>
+    class Promise
+    {
+    protected:
+        using State = typename Future<T>::State;
+
+        std::shared_ptr<State> m_state;
+
+        template <typename F>
+        void complete(F&& func) const
+        {
+            std::vector<std::function<void(const State&)>> continuations;
+
+            {
+                std::lock_guard<std::mutex> lock(m_state->mutex);
+                func(*m_state);
+                m_state->ready = true;
+                continuations.swap(m_state->continuations);
+            }
+
+            m_state->condition.notify_all();
+
+            for (auto& continuation : continuations)
+            {
+                continuation(*m_state);
+            }
+        }
+
+    public:
+        Promise()
+            : m_state(std::make_shared<State>())
+        {
+        }
+
+        Future<T> getFuture() const
+        {
+            return Future<T>(m_state);
+        }
+
+        // NOTE: the result can be set only once
+        void set(const T& value) const
+        {
+            complete([&] (State& state)
+            {
+                state.value = value;
+            });
+        }
+
+        void setException(std::exception_ptr exception) const
+        {
+            complete([&] (State& state)
+            {
+                state.exception = exception;
+            });
+        }
+    };
+
 } // namespace mango
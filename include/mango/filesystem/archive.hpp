@@ -0,0 +1,75 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mango/core/configure.hpp>
+#include <mango/core/memory.hpp>
+#include <mango/core/stream.hpp>
+#include <mango/core/compress.hpp>
+
+namespace mango::filesystem
+{
+
+    // -----------------------------------------------------------------------
+    // ArchiveWriterMGX
+    // -----------------------------------------------------------------------
+
+    /*
+        ArchiveWriterMGX creates .mgx (.snitch) archives which can be read with the Mapper.
+
+        The files are split into blocks which are compressed in the ThreadPool and written
+        in the order they were added. Small files are merged into shared blocks and large
+        files are split into multiple blocks. A block is stored without compression when
+        compression does not reduce the size at least by 5% (see setStoreThreshold()). Files
+        with identical contents are stored only once.
+
+        Usage example:
+
+            ArchiveWriterMGX archive("assets.mgx", Compressor::ZSTD, 6);
+
+            archive.addFile("textures/stone.ktx2", File("stone.ktx2"));
+            archive.addFile("textures/stone.jpg", File("stone.jpg"), Compressor::NONE);
+
+            archive.finish(); // optional; the destructor will finish the archive but it can only print the errors
+
+        The archive dictionary is optional and only supported with the LZ4 and ZSTD compressors.
+        When the dictionary is set small files are compressed individually with the dictionary
+        instead of merging them into shared blocks.
+    */
+
+    class ArchiveWriterMGX : protected NonCopyable
+    {
+    protected:
+        struct State;
+        std::unique_ptr<State> m_state;
+
+    public:
+        ArchiveWriterMGX(Stream& output, Compressor::Method method = Compressor::ZSTD, int level = 6);
+        ArchiveWriterMGX(const std::string& filename, Compressor::Method method = Compressor::ZSTD, int level = 6);
+        ~ArchiveWriterMGX();
+
+        // must be set before adding any files
+        void setDictionary(ConstMemory dictionary);
+
+        // A block is stored when the compressed size is larger than this percentage of
+        // the uncompressed size; zero stores all blocks without compressing them. The threshold
+        // should be set before adding any files.
+        void setStoreThreshold(u32 percent);
+
+        void addFile(const std::string& filename, ConstMemory memory);
+        void addFile(const std::string& filename, ConstMemory memory, Compressor::Method method);
+        void addFile(const std::string& filename, Stream& stream);
+        void addFile(const std::string& filename, Stream& stream, Compressor::Method method);
+
+        // parent folders are added automatically; this is required only for empty folders
+        void addFolder(const std::string& foldername);
+
+        // write the remaining blocks and the index; throws on failure
+        void finish();
+    };
+
+} // namespace mango::filesystem
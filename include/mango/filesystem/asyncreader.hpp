@@ -0,0 +1,85 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include <string>
+#include <memory>
+#include <functional>
+#include <mango/core/configure.hpp>
+#include <mango/core/memory.hpp>
+#include <mango/core/exception.hpp>
+
+namespace mango::filesystem
+{
+
+    // -----------------------------------------------------------------------
+    // AsyncReader
+    // -----------------------------------------------------------------------
+
+    /*
+        AsyncReader reads files in batches without blocking the ThreadPool workers.
+
+        On Linux the reads are submitted through io_uring by a dedicated I/O thread. On other
+        platforms, or when io_uring is not available, the files are read with blocking reads in
+        the ThreadPool into the same buffers. The completion callbacks are executed in the
+        ThreadPool so that decoding one file overlaps with reading the next ones.
+
+        Usage example:
+
+            AsyncReader reader;
+
+            for (const auto& filename : filenames)
+            {
+                reader.read(filename, [] (const AsyncReader::Result& result)
+                {
+                    if (result)
+                    {
+                        ImageDecoder decoder(result.memory, result.filename);
+                        ...
+                    }
+                });
+            }
+
+            reader.wait();
+
+        The memory in the result is valid only until the callback returns; the pooled
+        buffers are recycled for the next reads.
+    */
+
+    class AsyncReader : protected NonCopyable
+    {
+    public:
+        struct Result : Status
+        {
+            std::string filename;
+            ConstMemory memory;
+        };
+
+        using Callback = std::function<void(const Result& result)>;
+
+    protected:
+        struct State;
+        std::unique_ptr<State> m_state;
+
+    public:
+        AsyncReader(u32 queue_depth = 64);
+        ~AsyncReader();
+
+        // true when the reads are asynchronous (io_uring)
+        bool isAsync() const;
+
+        // read the whole file into a pooled buffer
+        void read(const std::string& filename, Callback callback);
+
+        // read into caller-provided memory starting from the offset in the file;
+        // the result memory is the part of dest that was read
+        void read(const std::string& filename, Memory dest, u64 offset, Callback callback);
+
+        // Wait until all reads and callbacks have completed. The first exception thrown from a
+        // callback is rethrown here; the other reads are completed normally.
+        void wait();
+    };
+
+} // namespace mango::filesystem
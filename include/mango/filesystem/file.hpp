@@ -27,12 +27,12 @@ namespace mango::filesystem
         std::unique_ptr<VirtualMemory> m_virtual_memory;
         ConstMemory m_memory;
 
-        void initMemory(Mapper& mapper);
+        void initMemory(Mapper& mapper, MemoryAccess access);
 
     public:
-        File(const std::string& filename);
-        File(const Path& path, const std::string& filename);
-        File(ConstMemory memory, const std::string& extension, const std::string& filename);
+        File(const std::string& filename, MemoryAccess access = MemoryAccess::Normal);
+        File(const Path& path, const std::string& filename, MemoryAccess access = MemoryAccess::Normal);
+        File(ConstMemory memory, const std::string& extension, const std::string& filename, MemoryAccess access = MemoryAccess::Normal);
         ~File();
 
         const Path& path() const;
@@ -44,6 +44,9 @@ namespace mango::filesystem
         operator const u8* () const;
         const u8* data() const;
         u64 size() const;
+
+        // start reading the pages in range into memory (see VirtualMemory::prefetch)
+        void prefetch(ConstMemory range) const;
     };
 
     u64 getFileSize(const std::string& filename);
@@ -55,27 +58,51 @@ namespace mango::filesystem
     class FileStream : public Stream
     {
     protected:
-        struct FileHandle* m_handle;
+        struct State;
+        std::unique_ptr<State> m_state;
 
     public:
-        FileStream(const std::string& filename, OpenMode mode);
+        static constexpr size_t DEFAULT_BUFFER_SIZE = 256 * 1024;
+
+        // The stream is buffered: small reads are served from a read-ahead buffer and small
+        // writes are combined in the buffer until it is full. Operations larger than the buffer
+        // go directly to the file with vectored I/O. The buffer_size of zero disables buffering.
+        FileStream(const std::string& filename, OpenMode mode, size_t buffer_size = DEFAULT_BUFFER_SIZE);
         ~FileStream();
 
         const std::string& filename() const;
 
+        // write the buffered data into the file; throws on failure. The destructor writes the
+        // remaining data but it can only print the errors.
+        void flush();
+
         // interface
         u64 size() const override;
         u64 offset() const override;
         u64 seek(s64 distance, SeekMode mode) override;
         u64 read(void* dest, u64 size) override;
         u64 write(const void* data, u64 size) override;
+
+        using Stream::write;
+
+        // write multiple buffers in order with one vectored write
+        u64 write(const ConstMemory* buffers, size_t count);
+
+#if MANGO_CPP_VERSION >= 20
+
+        u64 write(std::span<const ConstMemory> buffers)
+        {
+            return write(buffers.data(), buffers.size());
+        }
+
+#endif
     };
 
     class InputFileStream : public FileStream
     {
     public:
-        InputFileStream(const std::string& filename)
-            : FileStream(filename, Stream::OpenMode::Read)
+        InputFileStream(const std::string& filename, size_t buffer_size = DEFAULT_BUFFER_SIZE)
+            : FileStream(filename, Stream::OpenMode::Read, buffer_size)
         {
         }
     };
@@ -83,8 +110,8 @@ namespace mango::filesystem
     class OutputFileStream : public FileStream
     {
     public:
-        OutputFileStream(const std::string& filename)
-            : FileStream(filename, Stream::OpenMode::Write)
+        OutputFileStream(const std::string& filename, size_t buffer_size = DEFAULT_BUFFER_SIZE)
+            : FileStream(filename, Stream::OpenMode::Write, buffer_size)
         {
         }
     };
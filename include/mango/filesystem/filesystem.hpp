@@ -1,6 +1,6 @@
 /*
     MANGO Multimedia Development Platform
-    Copyright (C) 2012-2020 Twilight Finland 3D Oy Ltd. All rights reserved.
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
 #pragma once
 
@@ -8,3 +8,5 @@
 #include <mango/filesystem/path.hpp>
 #include <mango/filesystem/file.hpp>
 #include <mango/filesystem/fileobserver.hpp>
+#include <mango/filesystem/archive.hpp>
+#include <mango/filesystem/asyncreader.hpp>
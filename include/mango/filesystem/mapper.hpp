@@ -127,6 +127,12 @@ namespace mango::filesystem
 
         static bool isCustomMapper(const std::string& filename);
 
+        // Enable the persistent index cache for the container mappers (ZIP, ISO). The parsed
+        // index is saved into the folder and reused by the next process opening the same archive.
+        // The cache entries are validated with the archive size and hash of the archive directory.
+        // An empty folder disables the cache (default).
+        static void setIndexCache(const std::string& folder);
+
         const std::string& basepath() const;
         const std::string& pathname() const;
 
@@ -135,6 +141,9 @@ namespace mango::filesystem
         bool isFile(const std::string& filename) const override;
         void getIndex(FileIndex& index, const std::string& pathname) override;
         std::unique_ptr<VirtualMemory> map(const std::string& filename) override;
+
+        // map with access pattern hint applied to the memory
+        std::unique_ptr<VirtualMemory> map(const std::string& filename, MemoryAccess access);
     };
 
 } // namespace mango::filesystem
@@ -0,0 +1,112 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include <string>
+#include <memory>
+#include <functional>
+#include <mango/core/configure.hpp>
+#include <mango/core/memory.hpp>
+#include <mango/filesystem/path.hpp>
+#include <mango/image/decoder.hpp>
+#include <mango/image/surface.hpp>
+
+namespace mango::image
+{
+
+    /*
+        BatchDecoder decodes a large number of images in parallel.
+
+        The headers are read first so that the cost of every image is known before the decoding
+        starts. The largest images are started first and they use the multithreaded decoders
+        (JPEG restart intervals, EXR blocks, ...); the small images are decoded one image per
+        thread. The images and the parallel work inside them are tasks in the same ThreadPool;
+        an ImageDecodeScheduler starts at most concurrency images at a time. The largest images
+        don't remain as a long single-threaded tail at the end of the batch.
+
+        Usage example:
+
+            BatchDecoder batch;
+
+            batch.add(Path("images/")); // the files in the directory
+            batch.add(memory, "image.jpg");
+
+            batch.decode([] (BatchDecoder::Result& result)
+            {
+                if (!result.status)
+                {
+                    printLine("{}: {}", result.name, result.status.info);
+                    return;
+                }
+
+                // take the ownership of the bitmap or use it here
+                images.push_back(std::move(result.bitmap));
+            });
+
+    */
+
+    struct BatchDecodeOptions
+    {
+        // target format; the images are decoded into their preferred format when bits is zero
+        Format format;
+
+        // images with at least this many pixels are decoded with the multithreaded decoders
+        u64 multithread_pixels = 1024 * 1024;
+
+        // maximum number of images decoded at the same time; zero is the number of hardware threads
+        int concurrency = 0;
+
+        bool simd = true;
+    };
+
+    class BatchDecoder : protected NonCopyable
+    {
+    public:
+        struct Result
+        {
+            size_t index = 0; // the order in which the input was added; counts only the added files
+            std::string name;
+            ImageHeader header;
+            ImageDecodeStatus status;
+            std::unique_ptr<Bitmap> bitmap; // the callback can take the ownership
+        };
+
+        using Callback = std::function<void(Result& result)>;
+
+    protected:
+        struct State;
+        std::unique_ptr<State> m_state;
+
+    public:
+        BatchDecoder(const BatchDecodeOptions& options = BatchDecodeOptions());
+        ~BatchDecoder();
+
+        // The files are mapped only while their header is read and while they are decoded.
+        // A format with zero bits uses the target format from the options.
+        void add(const std::string& filename, const Format& format = Format());
+
+        // Add the files in the index; the names are appended to the pathname, which ends with a
+        // separator like Path::pathname(). An index with full pathnames uses an empty pathname.
+        // The directories and containers are skipped; they are not searched recursively. The
+        // files are opened by name so the Path cannot be one which was created from memory.
+        void add(const filesystem::FileIndex& index, const std::string& pathname = "");
+        void add(const filesystem::Path& path);
+
+        // NOTE: the memory must be valid until decode() returns
+        void add(ConstMemory memory, const std::string& name, const Format& format = Format());
+
+        // Decode the inputs added after the previous decode(). The callback is called once for
+        // each input in the order the decoding completes; the calls are serialized but they are
+        // made from the ThreadPool threads. Returns when all of the inputs are complete; the
+        // calling thread helps the ThreadPool while it waits so it can be a ThreadPool thread.
+        void decode(Callback callback);
+
+        // Cancel the decode() from another thread; the remaining inputs complete with an error.
+        // A cancel() before the decode() cancels it when it starts. The cancellation is cleared
+        // when the decode() returns.
+        void cancel();
+    };
+
+} // namespace mango::image
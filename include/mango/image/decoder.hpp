@@ -11,39 +11,50 @@
 #include <future>
 #include <mango/core/memory.hpp>
 #include <mango/core/exception.hpp>
+#include <mango/core/thread.hpp>
 #include <mango/image/format.hpp>
 #include <mango/image/compression.hpp>
 #include <mango/image/exif.hpp>
+#include <mango/image/stats.hpp>
 
 namespace mango::image
 {
     class Surface;
+    class ImageDecodeScheduler;
 
     /*
         These flags indicate when supercompressed blocks are stored in the image file.
         This kind of data can be extracted from the file by two mechanisms:
 
         1. decoded into Surface
-        2. the compressed memory block and TextureCompression format can be queried
+        2. transcoded into one of the block formats in the mask by setting the
+           ImageDecodeOptions::compression to the desired TextureCompression
 
     */
     enum : u32
     {
         SUPERCOMPRESS_ETC1_RGB         = 0x00000001,
-        SUPERCOMPRESS_BC1_UNORM        = 0x00000002,
-        SUPERCOMPRESS_BC4_UNORM        = 0x00000004,
-        SUPERCOMPRESS_BC7_UNORM        = 0x00000008,
-        SUPERCOMPRESS_PVRTC_RGB_4BPP   = 0x00000010,
-        SUPERCOMPRESS_PVRTC_RGBA_4BPP  = 0x00000020,
-        SUPERCOMPRESS_ASTC_RGBA_4x4    = 0x00000030,
-        SUPERCOMPRESS_ATC_RGB          = 0x00000040,
-        SUPERCOMPRESS_ATC_RGBA         = 0x00000100,
-        SUPERCOMPRESS_FXT1_RGB         = 0x00000200,
-        SUPERCOMPRESS_PVRTC2_RGBA_4BPP = 0x00000300,
-        SUPERCOMPRESS_EAC_R11          = 0x00000400,
-        SUPERCOMPRESS_EAC_RG11         = 0x00001000,
-        SUPERCOMPRESS_BASISU_ETC1S     = 0x00001fff,
-        SUPERCOMPRESS_BASISU_UASTC     = 0x00001fff,
+        SUPERCOMPRESS_ETC2_RGBA        = 0x00000002,
+        SUPERCOMPRESS_BC1_UNORM        = 0x00000004,
+        SUPERCOMPRESS_BC3_UNORM        = 0x00000008,
+        SUPERCOMPRESS_BC4_UNORM        = 0x00000010,
+        SUPERCOMPRESS_BC5_UNORM        = 0x00000020,
+        SUPERCOMPRESS_BC7_UNORM        = 0x00000040,
+        SUPERCOMPRESS_PVRTC_RGB_4BPP   = 0x00000080,
+        SUPERCOMPRESS_PVRTC_RGBA_4BPP  = 0x00000100,
+        SUPERCOMPRESS_ASTC_RGBA_4x4    = 0x00000200,
+        SUPERCOMPRESS_ATC_RGB          = 0x00000400,
+        SUPERCOMPRESS_ATC_RGBA         = 0x00000800,
+        SUPERCOMPRESS_FXT1_RGB         = 0x00001000,
+        SUPERCOMPRESS_PVRTC2_RGBA_4BPP = 0x00002000,
+        SUPERCOMPRESS_EAC_R11          = 0x00004000,
+        SUPERCOMPRESS_EAC_RG11         = 0x00008000,
+
+        // formats the Basis Universal transcoder can produce; the ImageHeader
+        // reports the formats which are enabled in the build
+        SUPERCOMPRESS_BASISU_ETC1S     = 0x0000ffff,
+        SUPERCOMPRESS_BASISU_UASTC     = 0x0000ffff & ~(SUPERCOMPRESS_ATC_RGB | SUPERCOMPRESS_ATC_RGBA |
+                                                        SUPERCOMPRESS_FXT1_RGB | SUPERCOMPRESS_PVRTC2_RGBA_4BPP),
     };
 
     struct ImageHeader : Status
@@ -80,6 +91,29 @@ namespace mango::image
     {
         bool simd = true;
         bool multithread = true;
+
+        // Smooth (triangle filter) chroma upsampling instead of replicating the samples; this
+        // is slower but matches libjpeg's default output better (jpeg 4:2:2 and 4:2:0).
+        bool fancy_upsampling = false;
+
+        // Transcode supercompressed data into this block format instead of decoding pixels (ktx2).
+        // The blocks are written into the destination surface image with surface stride bytes
+        // between the rows of blocks; the surface height must be at least the number of rows of
+        // blocks and the surface format is ignored.
+        u32 compression = TextureCompression::NONE;
+
+        // per-stage timings are accumulated here when not null
+        ImageCodecStats* stats = nullptr;
+
+        // The decoding is cancelled when this token is cancelled; one token can be shared by
+        // any number of decoders. ImageDecoder::cancel() cancels only the decoder's own decoding.
+        CancellationToken* cancellation = nullptr;
+
+        // ImageDecoder::launch() starts the decodes with higher priority first
+        int priority = 0;
+
+        // scheduler for ImageDecoder::launch(); the default scheduler is used when null
+        ImageDecodeScheduler* scheduler = nullptr;
     };
 
     struct ImageDecodeRect
@@ -92,14 +126,57 @@ namespace mango::image
     };
 
     using ImageDecodeCallback = std::function<void(const ImageDecodeRect& rect)>;
-    using ImageDecodeFuture = std::future<ImageDecodeStatus>;
+    using ImageDecodeFuture = Future<ImageDecodeStatus>;
+
+    /*
+        ImageDecodeScheduler starts the asynchronous decodes in the ThreadPool. The decodes are
+        started in priority order and the number of decodes running at the same time is limited
+        so that they don't oversubscribe the pool; the decoders submit their own parallel work
+        into the same pool. A decoder waiting for its work helps the pool but doesn't start
+        another decode on top of its own. A scheduler with a dedicated pool can be created for
+        decodes which must not wait behind the default scheduler. The destructor waits until
+        the queued decodes are complete.
+
+        Usage example:
+
+            ImageDecodeOptions options;
+            options.priority = 10;
+
+            ImageDecodeFuture future = decoder.launch(callback, bitmap, options);
+
+            future.then([] (const ImageDecodeStatus& status)
+            {
+                // called in the thread which completed the decoding
+            });
+
+    */
+
+    class ImageDecodeScheduler : protected NonCopyable
+    {
+    protected:
+        struct State;
+        std::unique_ptr<State> m_state;
+
+    public:
+        // concurrency is the maximum number of running decodes; zero is the pool size
+        ImageDecodeScheduler(int concurrency = 0);
+        ImageDecodeScheduler(ThreadPool& pool, int concurrency = 0);
+        ~ImageDecodeScheduler();
+
+        static ImageDecodeScheduler& getInstance();
+
+        void enqueue(int priority, std::function<void()>&& func);
+
+        // number of decodes waiting to be started
+        size_t getQueueSize() const;
+    };
 
     class ImageDecodeInterface : protected NonCopyable
     {
     public:
         bool async = false;
         ImageDecodeCallback callback;
-        std::atomic<bool> cancelled { false };
+        CancellationToken cancelled;
         std::string name;
         ImageHeader header;
         ConstMemory icc;
@@ -134,6 +211,9 @@ namespace mango::image
 
     protected:
         std::shared_ptr<ImageDecodeInterface> m_interface;
+        u64 m_memory_size = 0;
+
+        void resetCancellation(const ImageDecodeOptions& options);
     };
 
     void registerImageDecoder(ImageDecoder::CreateDecodeFunc func, const std::string& extension);
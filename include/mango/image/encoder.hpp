@@ -11,6 +11,7 @@
 #include <mango/image/format.hpp>
 #include <mango/image/compression.hpp>
 #include <mango/image/exif.hpp>
+#include <mango/image/stats.hpp>
 
 namespace mango::image
 {
@@ -21,21 +22,51 @@ namespace mango::image
         bool direct = false;
     };
 
+    // The color quantizer algorithm; used by the ColorQuantizer (quantize.hpp) and
+    // selected for the GIF encoding with the ImageEncodeOptions.
+    enum class QuantizeMethod
+    {
+        // NeuQuant neural network; good quality, slow on large images
+        NeuQuant,
+
+        // median cut of the color histogram refined with k-means; the quality
+        // parameter controls the number of k-means iterations
+        MedianCut,
+    };
+
+    enum class ChromaSubsampling
+    {
+        S444, // full resolution chroma
+        S422, // chroma halved horizontally
+        S420, // chroma halved horizontally and vertically
+    };
+
     struct ImageEncodeOptions
     {
         ConstMemory icc;          // jpg, png, jp2
 
         float quality = 0.90f;    // jpg, jp2, heif: [0.0, 1.0]
-        int compression = 5;      // png: [0, 10]
+        int compression = 5;      // png, ktx2: [0, 10]
         bool parallel = true;     // png
         bool dithering = true;    // gif
+        QuantizeMethod quantize = QuantizeMethod::NeuQuant; // gif
         bool lossless = false;    // webp, jp2, heif
 
+        ChromaSubsampling subsampling = ChromaSubsampling::S444; // jpg
+        bool optimize_huffman = false; // jpg: compute the huffman tables from the image in a separate pass
+        bool progressive = false;      // jpg: progressive scans; the huffman tables are always optimized
+
         int astc_block_width = 4;
         int astc_block_height = 4;
 
+        u32 block_compression = TextureCompression::NONE; // dds, ktx2
+        bool mipmaps = true;      // dds, ktx2
+
         bool simd = true;         // jpg
         bool multithread = true;  // jpg, jp2
+
+        // per-stage timings are accumulated here when not null
+        ImageCodecStats* stats = nullptr;
     };
 
     class ImageEncoder : protected NonCopyable
@@ -56,4 +87,53 @@ namespace mango::image
     void registerImageEncoder(ImageEncoder::EncodeFunc func, const std::string& extension);
     bool isImageEncoder(const std::string& extension);
 
+    /*
+        AnimationEncoder writes a sequence of frames into an animated image file.
+        The frames must have identical dimensions. The frame duration is given in
+        (numerator / denominator) seconds like in the ImageDecodeStatus.
+
+        Usage example:
+
+            OutputFileStream file("animation.gif");
+            AnimationEncoder encoder(file, ".gif");
+
+            for (const auto& frame : frames)
+            {
+                encoder.addFrame(frame, 1, 30);
+            }
+
+            encoder.finish();
+
+        The encoding of the frames is done in the ThreadPool while more frames are added.
+    */
+
+    class AnimationEncodeInterface : protected NonCopyable
+    {
+    public:
+        AnimationEncodeInterface() = default;
+        virtual ~AnimationEncodeInterface() = default;
+
+        virtual ImageEncodeStatus addFrame(const Surface& frame, int delay_numerator, int delay_denominator) = 0;
+        virtual ImageEncodeStatus finish() = 0;
+    };
+
+    class AnimationEncoder : protected NonCopyable
+    {
+    public:
+        AnimationEncoder(Stream& output, const std::string& extension, const ImageEncodeOptions& options = ImageEncodeOptions());
+        ~AnimationEncoder();
+
+        bool isEncoder() const;
+        ImageEncodeStatus addFrame(const Surface& frame, int delay_numerator = 1, int delay_denominator = 60);
+        ImageEncodeStatus finish();
+
+        using CreateEncodeFunc = AnimationEncodeInterface* (*)(Stream& output, const ImageEncodeOptions& options);
+
+    protected:
+        std::unique_ptr<AnimationEncodeInterface> m_interface;
+    };
+
+    void registerAnimationEncoder(AnimationEncoder::CreateEncodeFunc func, const std::string& extension);
+    bool isAnimationEncoder(const std::string& extension);
+
 } // namespace mango::image
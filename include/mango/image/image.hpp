@@ -11,7 +11,10 @@
 #include <mango/image/compression.hpp>
 #include <mango/image/decoder.hpp>
 #include <mango/image/encoder.hpp>
+#include <mango/image/stats.hpp>
+#include <mango/image/jpeg.hpp>
 #include <mango/image/blitter.hpp>
 #include <mango/image/surface.hpp>
 #include <mango/image/quantize.hpp>
 #include <mango/image/bicubic.hpp>
+#include <mango/image/batch.hpp>
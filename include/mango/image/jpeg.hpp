@@ -0,0 +1,112 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include <mango/core/configure.hpp>
+#include <mango/core/memory.hpp>
+#include <mango/core/buffer.hpp>
+#include <mango/core/stream.hpp>
+#include <mango/image/decoder.hpp>
+#include <mango/image/encoder.hpp>
+
+namespace mango::image
+{
+
+    /*
+        Lossless JPEG transcoding.
+
+        The quantized DCT coefficients are read from the entropy coded data and coded again
+        without the inverse DCT, color conversion and forward DCT; the image quality does not
+        change and the transcoding is much faster than decoding and encoding the pixels.
+
+        Usage example:
+
+            JPEGTranscodeOptions options;
+            options.transform = JPEGTransform::ROTATE_90;
+            options.progressive = true;
+
+            OutputFileStream output("rotated.jpg");
+            ImageEncodeStatus status = transcodeJPEG(output, file, options);
+
+        The lossless transforms work on whole blocks; an image edge which is mirrored by the
+        transform is trimmed to the MCU boundary (the partial MCU on the edge cannot be
+        moved losslessly). A dimension smaller than one MCU is left untouched instead of
+        mirrored. The crop origin is aligned down to the MCU boundary and must be inside
+        the image.
+    */
+
+    // Quantized DCT coefficients of a JPEG image
+    struct JPEGCoefficients : NonCopyable
+    {
+        struct Component
+        {
+            int id = 0;     // component identifier
+            int hsf = 1;    // horizontal sampling factor
+            int vsf = 1;    // vertical sampling factor
+            int tq = 0;     // quantization table
+            int width = 0;  // blocks in a row; padded to the MCU boundary
+            int height = 0; // rows of blocks; padded to the MCU boundary
+
+            // 64 coefficients in natural order for each block
+            AlignedStorage<s16> data;
+
+            s16* block(int x, int y) const
+            {
+                return data + (size_t(y) * width + x) * 64;
+            }
+        };
+
+        int width = 0;  // image width in pixels
+        int height = 0; // image height in pixels
+
+        int components = 0;
+        Component component[4];
+
+        u16 qtable[4][64]; // quantization tables in natural order
+
+        // APPn and COM marker segments in the original order, including the marker
+        Buffer metadata;
+
+        // number of blocks which cover the image, without the MCU padding
+        int getBlockWidth(int index) const;
+        int getBlockHeight(int index) const;
+    };
+
+    enum class JPEGTransform
+    {
+        NONE,
+        FLIP_HORIZONTAL,
+        FLIP_VERTICAL,
+        TRANSPOSE,      // mirror across the top-left to bottom-right diagonal
+        TRANSVERSE,     // mirror across the top-right to bottom-left diagonal
+        ROTATE_90,      // clockwise
+        ROTATE_180,
+        ROTATE_270
+    };
+
+    struct JPEGTranscodeOptions
+    {
+        JPEGTransform transform = JPEGTransform::NONE;
+
+        // crop rectangle in the source image; zero width or height keeps the whole image
+        int crop_x = 0;
+        int crop_y = 0;
+        int crop_width = 0;
+        int crop_height = 0;
+
+        bool progressive = false;
+        bool optimize_huffman = true; // progressive scans are always optimized
+        bool metadata = true;         // copy the APPn and COM markers (Adobe APP14 is always kept)
+        bool multithread = true;
+    };
+
+    ImageDecodeStatus decodeJPEGCoefficients(JPEGCoefficients& coefficients, ConstMemory memory);
+    ImageDecodeStatus transformJPEGCoefficients(JPEGCoefficients& dest, const JPEGCoefficients& source, const JPEGTranscodeOptions& options);
+    ImageEncodeStatus encodeJPEGCoefficients(Stream& stream, const JPEGCoefficients& coefficients, const JPEGTranscodeOptions& options);
+
+    // decode, transform and encode in one step
+    ImageEncodeStatus transcodeJPEG(Stream& stream, ConstMemory memory, const JPEGTranscodeOptions& options);
+
+} // namespace mango::image
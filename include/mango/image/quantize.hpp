@@ -5,6 +5,7 @@
 #pragma once
 
 #include <mango/image/surface.hpp>
+#include <mango/image/encoder.hpp> // QuantizeMethod
 
 namespace mango::image
 {
@@ -14,12 +15,13 @@ namespace mango::image
     protected:
         enum { NETSIZE = 256 };
 
+        QuantizeMethod m_method;
         Palette m_palette;
         int m_network[NETSIZE][4];
         int m_netindex[NETSIZE];
 
     public:
-        ColorQuantizer(const Surface& source, float quality = 0.90f);
+        ColorQuantizer(const Surface& source, float quality = 0.90f, QuantizeMethod method = QuantizeMethod::NeuQuant);
         ColorQuantizer(const Palette& palette);
         ~ColorQuantizer();
 
@@ -37,7 +39,7 @@ namespace mango::image
     class QuantizedBitmap : public Bitmap
     {
     public:
-        QuantizedBitmap(const Surface& source, float quality = 0.90f, bool dithering = true);
+        QuantizedBitmap(const Surface& source, float quality = 0.90f, bool dithering = true, QuantizeMethod method = QuantizeMethod::NeuQuant);
         QuantizedBitmap(const Surface& source, const Palette& palette, bool dithering = true);
         ~QuantizedBitmap();
     };
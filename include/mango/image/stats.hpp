@@ -0,0 +1,196 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include <atomic>
+#include <mango/core/configure.hpp>
+#include <mango/core/timer.hpp>
+
+namespace mango::image
+{
+
+    /*
+        Per-stage performance counters filled in by the image codecs.
+
+        The counters are collected when ImageDecodeOptions::stats or ImageEncodeOptions::stats
+        points to an ImageCodecStats object; when the pointer is null the codecs skip the
+        timing altogether. The object can be shared by multiple decoders and encoders running
+        concurrently to accumulate totals for a whole batch.
+
+        The times are in nanoseconds and summed over all threads working on the stage, so a
+        stage can report more time than the wall clock time of the whole operation. The TOTAL
+        stage is reported for every codec; the other stages only by the codecs which have them
+        as separate steps.
+
+        Usage example:
+
+            ImageCodecStats stats;
+
+            ImageDecodeOptions options;
+            options.stats = &stats;
+
+            decoder.decode(bitmap, options);
+
+            for (int i = 0; i < ImageCodecStats::COUNT; ++i)
+            {
+                auto stage = ImageCodecStats::Stage(i);
+                printLine("{}: {} ns, {} bytes", ImageCodecStats::getName(stage),
+                    stats.time(stage), stats.bytes(stage));
+            }
+    */
+
+    struct ImageCodecStats
+    {
+        enum Stage
+        {
+            TOTAL,      // decode() or encode(); bytes: compressed size
+            PARSE,      // headers, markers and chunks
+            ENTROPY,    // huffman or arithmetic coding; bytes: compressed size
+            IDCT,       // (inverse) DCT including color conversion when fused (jpeg); bytes: pixels
+            COLOR,      // color conversion and expansion into the target format; bytes: pixels
+            INFLATE,    // deflate, zlib and other lossless (de)compression; bytes: output size
+            UNFILTER,   // scanline filters and predictors (forward filters when encoding); bytes: scanlines
+            BLIT,       // copy from temporary storage into the target surface; bytes: pixels
+            COUNT
+        };
+
+        struct Counter
+        {
+            std::atomic<u64> time { 0 };
+            std::atomic<u64> bytes { 0 };
+            std::atomic<u64> count { 0 };
+        };
+
+        Counter counters[COUNT];
+
+        void add(Stage stage, u64 time, u64 bytes = 0)
+        {
+            Counter& counter = counters[stage];
+            counter.time.fetch_add(time, std::memory_order_relaxed);
+            counter.bytes.fetch_add(bytes, std::memory_order_relaxed);
+            counter.count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        u64 time(Stage stage) const
+        {
+            return counters[stage].time.load(std::memory_order_relaxed);
+        }
+
+        u64 bytes(Stage stage) const
+        {
+            return counters[stage].bytes.load(std::memory_order_relaxed);
+        }
+
+        // number of times the stage was recorded
+        u64 count(Stage stage) const
+        {
+            return counters[stage].count.load(std::memory_order_relaxed);
+        }
+
+        void reset()
+        {
+            for (Counter& counter : counters)
+            {
+                counter.time = 0;
+                counter.bytes = 0;
+                counter.count = 0;
+            }
+        }
+
+        static const char* getName(Stage stage)
+        {
+            static const char* names[] =
+            {
+                "total", "parse", "entropy", "idct", "color", "inflate", "unfilter", "blit"
+            };
+            return stage < COUNT ? names[stage] : "";
+        }
+
+        // Measures the lifetime of the scope into a stage; does nothing when stats is null.
+        class Scope
+        {
+        protected:
+            ImageCodecStats* m_stats;
+            Stage m_stage;
+            u64 m_bytes;
+            u64 m_time0;
+
+        public:
+            Scope(ImageCodecStats* stats, Stage stage, u64 bytes = 0)
+                : m_stats(stats)
+                , m_stage(stage)
+                , m_bytes(bytes)
+                , m_time0(stats ? Time::ns() : 0)
+            {
+            }
+
+            ~Scope()
+            {
+                if (m_stats)
+                {
+                    m_stats->add(m_stage, Time::ns() - m_time0, m_bytes);
+                }
+            }
+
+            void setBytes(u64 bytes)
+            {
+                m_bytes = bytes;
+            }
+        };
+
+        // Splits interleaved work between stages; lap() charges the time since the previous
+        // lap to the stage. The totals are added into the stats when the object is destroyed.
+        class Laps
+        {
+        protected:
+            ImageCodecStats* m_stats;
+            u64 m_time;
+            u64 m_times[COUNT] = {};
+            u64 m_bytes[COUNT] = {};
+
+        public:
+            Laps(ImageCodecStats* stats)
+                : m_stats(stats)
+                , m_time(stats ? Time::ns() : 0)
+            {
+            }
+
+            ~Laps()
+            {
+                if (m_stats)
+                {
+                    for (int i = 0; i < COUNT; ++i)
+                    {
+                        if (m_times[i] || m_bytes[i])
+                        {
+                            m_stats->add(Stage(i), m_times[i], m_bytes[i]);
+                        }
+                    }
+                }
+            }
+
+            void lap(Stage stage, u64 bytes = 0)
+            {
+                if (m_stats)
+                {
+                    u64 time = Time::ns();
+                    m_times[stage] += time - m_time;
+                    m_bytes[stage] += bytes;
+                    m_time = time;
+                }
+            }
+
+            // starts the next lap without charging the time since the previous lap to any stage
+            void skip()
+            {
+                if (m_stats)
+                {
+                    m_time = Time::ns();
+                }
+            }
+        };
+    };
+
+} // namespace mango::image
@@ -17,6 +17,25 @@
 namespace mango::image
 {
 
+    /*
+        Surface::blit() converts the pixels in the calling thread unless multithread is enabled.
+        A multithreaded blit is split into horizontal slices which are converted in the ThreadPool;
+        the blit still runs in the calling thread when it moves fewer bytes than the threshold or
+        when the pool is already busy (for example, blits issued from decoding tasks), so that
+        small blits don't wake up all the cores.
+    */
+
+    struct BlitOptions
+    {
+        bool multithread = false;
+
+        // minimum number of bytes read and written for the blit to be split
+        size_t threshold = 32 * 1024 * 1024;
+
+        // bytes read and written by one slice; the default fits the L2 cache of most CPUs
+        size_t slice = 256 * 1024;
+    };
+
     class Surface
     {
     public:
@@ -56,7 +75,7 @@ namespace mango::image
 
         void clear(float red, float green, float blue, float alpha) const;
         void clear(Color color) const;
-        void blit(int x, int y, const Surface& source) const;
+        void blit(int x, int y, const Surface& source, const BlitOptions& options = BlitOptions()) const;
         void xflip() const;
         void yflip() const;
     };
@@ -127,7 +146,22 @@ namespace mango::image
     // NOTE: The surface format must be 32 bit RGBA
     void resolve(const Surface& surface, const Surface& indexed);
     void transform(const Surface& surface, ConstMemory icc);
-    void srgbToLinear(const Surface& surface);
-    void linearToSRGB(const Surface& surface);
+
+    // Convert the color components between sRGB and linear; alpha is not modified. The 8 and 16 bit
+    // UNORM and 32 bit FLOAT components are converted in place, other formats through a float scanline.
+    // Large surfaces are converted in bands of rows with the thread pool when multithread is enabled.
+    void srgbToLinear(const Surface& surface, bool multithread = true);
+    void linearToSRGB(const Surface& surface, bool multithread = true);
+
+    // Convert into a surface of different format with the same dimensions, for example 8 bit sRGB
+    // into float linear for gamma-correct filtering and back. The surfaces may be the same.
+    void srgbToLinear(const Surface& dest, const Surface& source, bool multithread = true);
+    void linearToSRGB(const Surface& dest, const Surface& source, bool multithread = true);
+
+    // Generate the next mipmap level with a box filter. The destination is half the size of the
+    // source (minimum 1); odd dimensions are filtered with three weighted texels so that every
+    // source texel contributes to the result.
+    // NOTE: The surface formats must be 32 bit UNORM with 8 bit components or 128 bit FLOAT32 RGBA.
+    void mipmap(const Surface& dest, const Surface& source);
 
 } // namespace mango::image
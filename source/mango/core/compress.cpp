@@ -11,6 +11,7 @@
 #include <mango/core/bits.hpp>
 #include <mango/core/endian.hpp>
 #include <mango/core/pointer.hpp>
+#include <mango/core/thread.hpp>
 #include <mango/math/math.hpp>
 
 #include <lz4.h>
@@ -18,6 +19,7 @@
 
 #define ZSTD_DISABLE_DEPRECATE_WARNINGS
 #include <zstd.h>
+#include <zdict.h>
 
 #include "../../external/lzfse/lzfse.h"
 
@@ -46,6 +48,136 @@
 namespace mango
 {
 
+// ----------------------------------------------------------------------------
+// CompressionContext::State
+// ----------------------------------------------------------------------------
+
+struct CompressionContext::State
+{
+    // libdeflate compressors are level specific: [1, 12]
+    libdeflate_compressor* deflate_compressor[13] = { nullptr };
+    libdeflate_decompressor* deflate_decompressor = nullptr;
+
+    ZSTD_CCtx* zstd_compressor = nullptr;
+    ZSTD_DCtx* zstd_decompressor = nullptr;
+
+    CLzmaEncHandle lzma_encoder = nullptr;
+    CLzmaDec lzma_decoder;
+
+    Buffer lz4_state;
+    Buffer lz4_state_hc;
+    Buffer lz4_stream;
+    Buffer lzfse_encode_scratch;
+    Buffer lzfse_decode_scratch;
+
+    State()
+    {
+        LzmaDec_Construct(&lzma_decoder);
+    }
+
+    ~State()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        for (auto& compressor : deflate_compressor)
+        {
+            libdeflate_free_compressor(compressor);
+            compressor = nullptr;
+        }
+
+        libdeflate_free_decompressor(deflate_decompressor);
+        deflate_decompressor = nullptr;
+
+        ZSTD_freeCCtx(zstd_compressor);
+        zstd_compressor = nullptr;
+
+        ZSTD_freeDCtx(zstd_decompressor);
+        zstd_decompressor = nullptr;
+
+        if (lzma_encoder)
+        {
+            LzmaEnc_Destroy(lzma_encoder, &g_Alloc, &g_Alloc);
+            lzma_encoder = nullptr;
+        }
+
+        LzmaDec_FreeProbs(&lzma_decoder, &g_Alloc);
+
+        lz4_state.reset();
+        lz4_state_hc.reset();
+        lz4_stream.reset();
+        lzfse_encode_scratch.reset();
+        lzfse_decode_scratch.reset();
+    }
+
+    libdeflate_compressor* getDeflateCompressor(int level)
+    {
+        libdeflate_compressor*& compressor = deflate_compressor[level];
+        if (!compressor)
+        {
+            compressor = libdeflate_alloc_compressor(level);
+        }
+        return compressor;
+    }
+
+    libdeflate_decompressor* getDeflateDecompressor()
+    {
+        if (!deflate_decompressor)
+        {
+            deflate_decompressor = libdeflate_alloc_decompressor();
+        }
+        return deflate_decompressor;
+    }
+
+    ZSTD_CCtx* getZstdCompressor()
+    {
+        if (!zstd_compressor)
+        {
+            zstd_compressor = ZSTD_createCCtx();
+        }
+        return zstd_compressor;
+    }
+
+    ZSTD_DCtx* getZstdDecompressor()
+    {
+        if (!zstd_decompressor)
+        {
+            zstd_decompressor = ZSTD_createDCtx();
+        }
+        return zstd_decompressor;
+    }
+
+    CLzmaEncHandle getLzmaEncoder()
+    {
+        if (!lzma_encoder)
+        {
+            lzma_encoder = LzmaEnc_Create(&g_Alloc);
+        }
+        return lzma_encoder;
+    }
+
+    static
+    u8* getBuffer(Buffer& buffer, size_t size)
+    {
+        if (buffer.size() < size)
+        {
+            buffer.reset(size);
+        }
+        return buffer.data();
+    }
+};
+
+static
+CompressionContext::State& getThreadState()
+{
+    // each thread has it's own state so that compressors called from the
+    // ThreadPool do not have to allocate and initialize state for every block
+    thread_local CompressionContext::State state;
+    return state;
+}
+
 // ----------------------------------------------------------------------------
 // nocompress
 // ----------------------------------------------------------------------------
@@ -93,7 +225,8 @@ namespace lz4
         return LZ4_compressBound(s);
     }
 
-    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    static
+    CompressionStatus compress(CompressionContext::State& state, Memory dest, ConstMemory source, int level)
     {
         const int source_size = int(source.size);
         const int dest_size = int(dest.size);
@@ -105,12 +238,14 @@ namespace lz4
         if (level > 6)
         {
             const int compression_level = 1 + (level - 7) * 5;
-            status.size = LZ4_compress_HC(source.cast<const char>(), dest.cast<char>(), source_size, dest_size, compression_level);
+            void* temp = state.getBuffer(state.lz4_state_hc, LZ4_sizeofStateHC());
+            status.size = LZ4_compress_HC_extStateHC(temp, source.cast<const char>(), dest.cast<char>(), source_size, dest_size, compression_level);
         }
         else
         {
             const int acceleration = 19 - level * 3;
-            status.size = LZ4_compress_fast(source.cast<const char>(), dest.cast<char>(), source_size, dest_size, acceleration);
+            void* temp = state.getBuffer(state.lz4_state, LZ4_sizeofState());
+            status.size = LZ4_compress_fast_extState(temp, source.cast<const char>(), dest.cast<char>(), source_size, dest_size, acceleration);
         }
 
 	    if (status.size > dest.size)
@@ -121,6 +256,11 @@ namespace lz4
         return status;
     }
 
+    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    {
+        return compress(getThreadState(), dest, source, level);
+    }
+
     CompressionStatus decompress(Memory dest, ConstMemory source)
     {
         CompressionStatus status;
@@ -259,6 +399,108 @@ namespace lz4
         return std::make_shared<StreamDecoderLZ4>();
     }
 
+    // dictionary
+
+    // LZ4 only uses the last 64 KB of the dictionary
+    static constexpr size_t max_dictionary_size = 1024 * 64;
+
+    static
+    ConstMemory getDictionary(ConstMemory dictionary)
+    {
+        const size_t size = std::min(dictionary.size, max_dictionary_size);
+        return ConstMemory(dictionary.end() - size, size);
+    }
+
+    class DictionaryEncoderLZ4 : public DictionaryEncoder
+    {
+    protected:
+        Buffer m_dictionary;
+        LZ4_stream_t m_stream;
+        int m_acceleration;
+
+    public:
+        DictionaryEncoderLZ4(ConstMemory dictionary, int level)
+            : m_dictionary(getDictionary(dictionary))
+        {
+            level = math::clamp(level, 0, 6);
+            m_acceleration = 19 - level * 3;
+
+            LZ4_initStream(&m_stream, sizeof(m_stream));
+            LZ4_loadDict(&m_stream, reinterpret_cast<const char*>(m_dictionary.data()), int(m_dictionary.size()));
+        }
+
+        ~DictionaryEncoderLZ4()
+        {
+        }
+
+        size_t bound(size_t size) const override
+        {
+            return lz4::bound(size);
+        }
+
+        CompressionStatus compress(Memory dest, ConstMemory source) const override
+        {
+            // copy of the stream which has the dictionary loaded is equivalent to loading
+            // the dictionary into the copy; the dictionary is hashed only once
+            CompressionContext::State& state = getThreadState();
+            LZ4_stream_t* stream = reinterpret_cast<LZ4_stream_t*>(state.getBuffer(state.lz4_stream, sizeof(LZ4_stream_t)));
+            std::memcpy(stream, &m_stream, sizeof(LZ4_stream_t));
+
+            CompressionStatus status;
+
+            int bytes = LZ4_compress_fast_continue(stream, source.cast<const char>(), dest.cast<char>(),
+                int(source.size), int(dest.size), m_acceleration);
+            if (bytes <= 0 && source.size > 0)
+            {
+                status.setError("[lz4] dictionary compression failed.");
+            }
+
+            status.size = size_t(std::max(0, bytes));
+            return status;
+        }
+    };
+
+    class DictionaryDecoderLZ4 : public DictionaryDecoder
+    {
+    protected:
+        Buffer m_dictionary;
+
+    public:
+        DictionaryDecoderLZ4(ConstMemory dictionary)
+            : m_dictionary(getDictionary(dictionary))
+        {
+        }
+
+        ~DictionaryDecoderLZ4()
+        {
+        }
+
+        CompressionStatus decompress(Memory dest, ConstMemory source) const override
+        {
+            CompressionStatus status;
+
+            int bytes = LZ4_decompress_safe_usingDict(source.cast<const char>(), dest.cast<char>(),
+                int(source.size), int(dest.size), reinterpret_cast<const char*>(m_dictionary.data()), int(m_dictionary.size()));
+            if (bytes < 0)
+            {
+                status.setError("[lz4] dictionary decompression failed.");
+            }
+
+            status.size = size_t(std::max(0, bytes));
+            return status;
+        }
+    };
+
+    std::shared_ptr<DictionaryEncoder> createDictionaryEncoder(ConstMemory dictionary, int level)
+    {
+        return std::make_shared<DictionaryEncoderLZ4>(dictionary, level);
+    }
+
+    std::shared_ptr<DictionaryDecoder> createDictionaryDecoder(ConstMemory dictionary)
+    {
+        return std::make_shared<DictionaryDecoderLZ4>(dictionary);
+    }
+
 } // namespace lz4
 
 // ----------------------------------------------------------------------------
@@ -275,7 +517,8 @@ namespace zstd
         return ZSTD_compressBound(size) + turbo;
     }
 
-    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    static
+    CompressionStatus compress(CompressionContext::State& state, Memory dest, ConstMemory source, int level)
     {
         CompressionStatus status;
 
@@ -284,8 +527,8 @@ namespace zstd
         {
             level = math::clamp(level * 2, 1, 20);
 
-            const size_t x = ZSTD_compress(dest.address, dest.size,
-                                        source.address, source.size, level);
+            const size_t x = ZSTD_compressCCtx(state.getZstdCompressor(), dest.address, dest.size,
+                                               source.address, source.size, level);
 
             if (ZSTD_isError(x))
             {
@@ -298,10 +541,11 @@ namespace zstd
         return status;
     }
 
-    CompressionStatus decompress(Memory dest, ConstMemory source)
+    static
+    CompressionStatus decompress(CompressionContext::State& state, Memory dest, ConstMemory source)
     {
-        size_t x = ZSTD_decompress((void*)dest.address, dest.size,
-                                   source.address, source.size);
+        size_t x = ZSTD_decompressDCtx(state.getZstdDecompressor(), dest.address, dest.size,
+                                       source.address, source.size);
 
         CompressionStatus status;
 
@@ -314,6 +558,16 @@ namespace zstd
         return status;
     }
 
+    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    {
+        return compress(getThreadState(), dest, source, level);
+    }
+
+    CompressionStatus decompress(Memory dest, ConstMemory source)
+    {
+        return decompress(getThreadState(), dest, source);
+    }
+
     // stream
 
     class StreamEncoderZSTD : public StreamEncoder
@@ -416,6 +670,108 @@ namespace zstd
         return std::make_shared<StreamDecoderZSTD>();
     }
 
+    // dictionary
+
+    class DictionaryEncoderZSTD : public DictionaryEncoder
+    {
+    protected:
+        ZSTD_CDict* m_dictionary;
+
+    public:
+        DictionaryEncoderZSTD(ConstMemory dictionary, int level)
+        {
+            level = math::clamp(level * 2, 1, 20);
+            m_dictionary = ZSTD_createCDict(dictionary.address, dictionary.size, level);
+            if (!m_dictionary)
+            {
+                MANGO_EXCEPTION("[zstd] Failed to create dictionary.");
+            }
+        }
+
+        ~DictionaryEncoderZSTD()
+        {
+            ZSTD_freeCDict(m_dictionary);
+        }
+
+        size_t bound(size_t size) const override
+        {
+            return zstd::bound(size);
+        }
+
+        CompressionStatus compress(Memory dest, ConstMemory source) const override
+        {
+            ZSTD_CCtx* context = getThreadState().getZstdCompressor();
+
+            size_t x = ZSTD_compress_usingCDict(context, dest.address, dest.size,
+                                                source.address, source.size, m_dictionary);
+
+            CompressionStatus status;
+
+            if (ZSTD_isError(x))
+            {
+                status.setError("[zstd] {}", ZSTD_getErrorName(x));
+            }
+            else
+            {
+                status.size = x;
+            }
+
+            return status;
+        }
+    };
+
+    class DictionaryDecoderZSTD : public DictionaryDecoder
+    {
+    protected:
+        ZSTD_DDict* m_dictionary;
+
+    public:
+        DictionaryDecoderZSTD(ConstMemory dictionary)
+        {
+            m_dictionary = ZSTD_createDDict(dictionary.address, dictionary.size);
+            if (!m_dictionary)
+            {
+                MANGO_EXCEPTION("[zstd] Failed to create dictionary.");
+            }
+        }
+
+        ~DictionaryDecoderZSTD()
+        {
+            ZSTD_freeDDict(m_dictionary);
+        }
+
+        CompressionStatus decompress(Memory dest, ConstMemory source) const override
+        {
+            ZSTD_DCtx* context = getThreadState().getZstdDecompressor();
+
+            size_t x = ZSTD_decompress_usingDDict(context, dest.address, dest.size,
+                                                  source.address, source.size, m_dictionary);
+
+            CompressionStatus status;
+
+            if (ZSTD_isError(x))
+            {
+                status.setError("[zstd] {}", ZSTD_getErrorName(x));
+            }
+            else
+            {
+                status.size = x;
+            }
+
+            return status;
+        }
+    };
+
+    std::shared_ptr<DictionaryEncoder> createDictionaryEncoder(ConstMemory dictionary, int level)
+    {
+        return std::make_shared<DictionaryEncoderZSTD>(dictionary, level);
+    }
+
+    std::shared_ptr<DictionaryDecoder> createDictionaryDecoder(ConstMemory dictionary)
+    {
+        return std::make_shared<DictionaryDecoderZSTD>(dictionary);
+    }
+
 } // namespace zstd
 
 // ----------------------------------------------------------------------------
@@ -614,12 +970,12 @@ namespace lzfse
         return 1024 + size;
     }
 
-    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    static
+    CompressionStatus compress(CompressionContext::State& state, Memory dest, ConstMemory source, int level)
     {
         MANGO_UNREFERENCED(level);
 
-        const size_t scratch_size = lzfse_encode_scratch_size();
-        Buffer scratch(scratch_size);
+        u8* scratch = state.getBuffer(state.lzfse_encode_scratch, lzfse_encode_scratch_size());
         size_t written = lzfse_encode_buffer(dest.address, dest.size, source, source.size, scratch);
 
         CompressionStatus status;
@@ -627,10 +983,10 @@ namespace lzfse
         return status;
     }
 
-    CompressionStatus decompress(Memory dest, ConstMemory source)
+    static
+    CompressionStatus decompress(CompressionContext::State& state, Memory dest, ConstMemory source)
     {
-        const size_t scratch_size = lzfse_decode_scratch_size();
-        Buffer scratch(scratch_size);
+        u8* scratch = state.getBuffer(state.lzfse_decode_scratch, lzfse_decode_scratch_size());
         size_t written = lzfse_decode_buffer(dest.address, dest.size, source, source.size, scratch);
 
         CompressionStatus status;
@@ -638,6 +994,16 @@ namespace lzfse
         return status;
     }
 
+    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    {
+        return compress(getThreadState(), dest, source, level);
+    }
+
+    CompressionStatus decompress(Memory dest, ConstMemory source)
+    {
+        return decompress(getThreadState(), dest, source);
+    }
+
 } // namespace lzfse
 
 // ----------------------------------------------------------------------------
@@ -671,7 +1037,8 @@ namespace lzma
         return (size * 3) / 2 + 1024 * 16;
     }
 
-    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    static
+    CompressionStatus compress(CompressionContext::State& state, Memory dest, ConstMemory source, int level)
     {
         CLzmaEncProps props;
         LzmaEncProps_Init(&props);
@@ -697,10 +1064,20 @@ namespace lzma
         SizeT dest_length = dest.size;
         SizeT source_length = source.size;
 
-        SRes result = LzmaEncode(
-            dest.address, &dest_length, source.address, source_length,
-            &props, props_output, &props_output_size, 0,
-            nullptr, &g_Alloc, &g_Alloc);
+        // the encoder keeps the match finder allocated between calls
+        CLzmaEncHandle encoder = state.getLzmaEncoder();
+
+        SRes result = LzmaEnc_SetProps(encoder, &props);
+        if (result == SZ_OK)
+        {
+            result = LzmaEnc_WriteProperties(encoder, props_output, &props_output_size);
+        }
+
+        if (result == SZ_OK)
+        {
+            result = LzmaEnc_MemEncode(encoder, dest.address, &dest_length, source.address, source_length,
+                0, nullptr, &g_Alloc, &g_Alloc);
+        }
 
         CompressionStatus status;
 
@@ -714,19 +1091,42 @@ namespace lzma
         return status;
     }
 
-    CompressionStatus decompress(Memory dest, ConstMemory source)
+    static
+    CompressionStatus decompress(CompressionContext::State& state, Memory dest, ConstMemory source)
     {
         // read props header
         const u8* prop = source.address;
         source.address += LZMA_PROPS_SIZE;
         source.size -= LZMA_PROPS_SIZE;
 
-        SizeT destLen = dest.size;
         SizeT srcLen = source.size;
 
-        ELzmaStatus st;
-        SRes result = LzmaDecode(dest.address, &destLen, source.address, &srcLen,
-            prop, LZMA_PROPS_SIZE, LZMA_FINISH_ANY, &st, &g_Alloc);
+        ELzmaStatus st = LZMA_STATUS_NOT_SPECIFIED;
+        SRes result = SZ_ERROR_INPUT_EOF;
+
+        // the range coder needs at least 5 bytes of input to initialize
+        if (srcLen >= 5)
+        {
+            // same as LzmaDecode() but the probability model is kept allocated between calls
+            CLzmaDec& decoder = state.lzma_decoder;
+
+            result = LzmaDec_AllocateProbs(&decoder, prop, LZMA_PROPS_SIZE, &g_Alloc);
+            if (result == SZ_OK)
+            {
+                decoder.dic = dest.address;
+                decoder.dicBufSize = dest.size;
+                LzmaDec_Init(&decoder);
+
+                result = LzmaDec_DecodeToDic(&decoder, dest.size, source.address, &srcLen, LZMA_FINISH_ANY, &st);
+                if (result == SZ_OK && st == LZMA_STATUS_NEEDS_MORE_INPUT)
+                {
+                    result = SZ_ERROR_INPUT_EOF;
+                }
+
+                // the dictionary is caller's memory
+                decoder.dic = nullptr;
+            }
+        }
 
         CompressionStatus status;
 
@@ -740,6 +1140,16 @@ namespace lzma
         return status;
     }
 
+    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    {
+        return compress(getThreadState(), dest, source, level);
+    }
+
+    CompressionStatus decompress(Memory dest, ConstMemory source)
+    {
+        return decompress(getThreadState(), dest, source);
+    }
+
 } // namespace lzma
 
 // ----------------------------------------------------------------------------
@@ -1007,27 +1417,27 @@ namespace deflate
         return libdeflate_deflate_compress_bound(nullptr, size);
     }
 
-    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    static
+    CompressionStatus compress(CompressionContext::State& state, Memory dest, ConstMemory source, int level)
     {
         level = math::clamp(level, 1, 10);
         if (level >= 8) level = (level * 12) / 10;
 
-        libdeflate_compressor* compressor = libdeflate_alloc_compressor(level);
+        libdeflate_compressor* compressor = state.getDeflateCompressor(level);
         size_t bytes_out = libdeflate_deflate_compress(compressor, source, source.size, dest, dest.size);
-        libdeflate_free_compressor(compressor);
 
         CompressionStatus status;
         status.size = bytes_out;
         return status;
     }
 
-    CompressionStatus decompress(Memory dest, ConstMemory source)
+    static
+    CompressionStatus decompress(CompressionContext::State& state, Memory dest, ConstMemory source)
     {
-        libdeflate_decompressor* decompressor = libdeflate_alloc_decompressor();
+        libdeflate_decompressor* decompressor = state.getDeflateDecompressor();
 
         size_t bytes_out = 0;
         libdeflate_result result = libdeflate_deflate_decompress(decompressor, source, source.size, dest, dest.size, &bytes_out);
-        libdeflate_free_decompressor(decompressor);
 
         CompressionStatus status;
 
@@ -1041,6 +1451,16 @@ namespace deflate
         return status;
     }
 
+    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    {
+        return compress(getThreadState(), dest, source, level);
+    }
+
+    CompressionStatus decompress(Memory dest, ConstMemory source)
+    {
+        return decompress(getThreadState(), dest, source);
+    }
+
 } // namespace deflate
 
 // ----------------------------------------------------------------------------
@@ -1055,27 +1475,27 @@ namespace deflate_zlib
         return libdeflate_zlib_compress_bound(nullptr, size);
     }
 
-    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    static
+    CompressionStatus compress(CompressionContext::State& state, Memory dest, ConstMemory source, int level)
     {
         level = math::clamp(level, 1, 10);
         if (level >= 8) level = (level * 12) / 10;
 
-        libdeflate_compressor* compressor = libdeflate_alloc_compressor(level);
+        libdeflate_compressor* compressor = state.getDeflateCompressor(level);
         size_t bytes_out = libdeflate_zlib_compress(compressor, source, source.size, dest, dest.size);
-        libdeflate_free_compressor(compressor);
 
         CompressionStatus status;
         status.size = bytes_out;
         return status;
     }
 
-    CompressionStatus decompress(Memory dest, ConstMemory source)
+    static
+    CompressionStatus decompress(CompressionContext::State& state, Memory dest, ConstMemory source)
     {
-        libdeflate_decompressor* decompressor = libdeflate_alloc_decompressor();
+        libdeflate_decompressor* decompressor = state.getDeflateDecompressor();
 
         size_t bytes_out = 0;
         libdeflate_result result = libdeflate_zlib_decompress(decompressor, source, source.size, dest, dest.size, &bytes_out);
-        libdeflate_free_decompressor(decompressor);
 
         CompressionStatus status;
 
@@ -1089,6 +1509,16 @@ namespace deflate_zlib
         return status;
     }
 
+    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    {
+        return compress(getThreadState(), dest, source, level);
+    }
+
+    CompressionStatus decompress(Memory dest, ConstMemory source)
+    {
+        return decompress(getThreadState(), dest, source);
+    }
+
 } // namespace deflate_zlib
 
 // ----------------------------------------------------------------------------
@@ -1103,27 +1533,27 @@ namespace deflate_gzip
         return libdeflate_gzip_compress_bound(nullptr, size);
     }
 
-    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    static
+    CompressionStatus compress(CompressionContext::State& state, Memory dest, ConstMemory source, int level)
     {
         level = math::clamp(level, 1, 10);
         if (level >= 8) level = (level * 12) / 10;
 
-        libdeflate_compressor* compressor = libdeflate_alloc_compressor(level);
+        libdeflate_compressor* compressor = state.getDeflateCompressor(level);
         size_t bytes_out = libdeflate_gzip_compress(compressor, source, source.size, dest, dest.size);
-        libdeflate_free_compressor(compressor);
 
         CompressionStatus status;
         status.size = bytes_out;
         return status;
     }
 
-    CompressionStatus decompress(Memory dest, ConstMemory source)
+    static
+    CompressionStatus decompress(CompressionContext::State& state, Memory dest, ConstMemory source)
     {
-        libdeflate_decompressor* decompressor = libdeflate_alloc_decompressor();
+        libdeflate_decompressor* decompressor = state.getDeflateDecompressor();
 
         size_t bytes_out = 0;
         libdeflate_result result = libdeflate_gzip_decompress(decompressor, source, source.size, dest, dest.size, &bytes_out);
-        libdeflate_free_decompressor(decompressor);
 
         CompressionStatus status;
 
@@ -1137,6 +1567,16 @@ namespace deflate_gzip
         return status;
     }
 
+    CompressionStatus compress(Memory dest, ConstMemory source, int level)
+    {
+        return compress(getThreadState(), dest, source, level);
+    }
+
+    CompressionStatus decompress(Memory dest, ConstMemory source)
+    {
+        return decompress(getThreadState(), dest, source);
+    }
+
 } // namespace deflate_gzip
 
 // ----------------------------------------------------------------------------
@@ -1414,4 +1854,378 @@ namespace isal
         return compressor;
     }
 
+    // ----------------------------------------------------------------------------
+    // CompressionContext
+    // ----------------------------------------------------------------------------
+
+    CompressionContext::CompressionContext()
+        : m_state(std::make_unique<State>())
+    {
+    }
+
+    CompressionContext::~CompressionContext()
+    {
+    }
+
+    void CompressionContext::reset()
+    {
+        m_state->reset();
+    }
+
+    CompressionStatus CompressionContext::compress(Compressor::Method method, Memory dest, ConstMemory source, int level)
+    {
+        State& state = *m_state;
+
+        switch (method)
+        {
+            case Compressor::LZ4:
+                return lz4::compress(state, dest, source, level);
+            case Compressor::ZSTD:
+                return zstd::compress(state, dest, source, level);
+            case Compressor::LZFSE:
+                return lzfse::compress(state, dest, source, level);
+            case Compressor::LZMA:
+                return lzma::compress(state, dest, source, level);
+            case Compressor::DEFLATE:
+                return deflate::compress(state, dest, source, level);
+            case Compressor::DEFLATE_ZLIB:
+                return deflate_zlib::compress(state, dest, source, level);
+            case Compressor::DEFLATE_GZIP:
+                return deflate_gzip::compress(state, dest, source, level);
+            default:
+                // stateless compressor
+                return getCompressor(method).compress(dest, source, level);
+        }
+    }
+
+    CompressionStatus CompressionContext::decompress(Compressor::Method method, Memory dest, ConstMemory source)
+    {
+        State& state = *m_state;
+
+        switch (method)
+        {
+            case Compressor::ZSTD:
+                return zstd::decompress(state, dest, source);
+            case Compressor::LZFSE:
+                return lzfse::decompress(state, dest, source);
+            case Compressor::LZMA:
+                return lzma::decompress(state, dest, source);
+            case Compressor::DEFLATE:
+                return deflate::decompress(state, dest, source);
+            case Compressor::DEFLATE_ZLIB:
+                return deflate_zlib::decompress(state, dest, source);
+            case Compressor::DEFLATE_GZIP:
+                return deflate_gzip::decompress(state, dest, source);
+            default:
+                // stateless decompressor
+                return getCompressor(method).decompress(dest, source);
+        }
+    }
+
+    // ----------------------------------------------------------------------------
+    // dictionary compression
+    // ----------------------------------------------------------------------------
+
+    CompressionStatus trainDictionary(Memory dest, const std::vector<ConstMemory>& samples)
+    {
+        CompressionStatus status;
+
+        // the trainer wants the samples in one contiguous buffer
+        Buffer buffer;
+        std::vector<size_t> sizes;
+
+        for (const auto& sample : samples)
+        {
+            buffer.append(sample);
+            sizes.push_back(sample.size);
+        }
+
+        size_t x = ZDICT_trainFromBuffer(dest.address, dest.size, buffer.data(), sizes.data(), unsigned(sizes.size()));
+        if (ZDICT_isError(x))
+        {
+            status.setError("[trainDictionary] {}", ZDICT_getErrorName(x));
+        }
+        else
+        {
+            status.size = x;
+        }
+
+        return status;
+    }
+
+    std::shared_ptr<DictionaryEncoder> createDictionaryEncoder(Compressor::Method method, ConstMemory dictionary, int level)
+    {
+        switch (method)
+        {
+            case Compressor::LZ4:
+                return lz4::createDictionaryEncoder(dictionary, level);
+            case Compressor::ZSTD:
+                return zstd::createDictionaryEncoder(dictionary, level);
+            default:
+                MANGO_EXCEPTION("[createDictionaryEncoder] Unsupported compressor (\"{}\").", int(method));
+        }
+    }
+
+    std::shared_ptr<DictionaryDecoder> createDictionaryDecoder(Compressor::Method method, ConstMemory dictionary)
+    {
+        switch (method)
+        {
+            case Compressor::LZ4:
+                return lz4::createDictionaryDecoder(dictionary);
+            case Compressor::ZSTD:
+                return zstd::createDictionaryDecoder(dictionary);
+            default:
+                MANGO_EXCEPTION("[createDictionaryDecoder] Unsupported compressor (\"{}\").", int(method));
+        }
+    }
+
+    // ----------------------------------------------------------------------------
+    // parallel block compression
+    // ----------------------------------------------------------------------------
+
+    static constexpr size_t parallel_header_size = 24;
+    static constexpr size_t parallel_block_info_size = 8;
+
+    static
+    size_t getParallelBlockSize(size_t block_size)
+    {
+        return math::clamp(block_size, size_t(1024 * 4), size_t(1024 * 1024 * 1024));
+    }
+
+    static
+    size_t getParallelBlockCount(u64 size, size_t block_size)
+    {
+        return size_t((size + block_size - 1) / block_size);
+    }
+
+    size_t boundParallel(Compressor::Method method, size_t size, size_t block_size)
+    {
+        block_size = getParallelBlockSize(block_size);
+
+        Compressor compressor = getCompressor(method);
+
+        const size_t num_blocks = getParallelBlockCount(size, block_size);
+        const size_t block_bound = compressor.bound(std::min(size, block_size));
+
+        return parallel_header_size + num_blocks * (parallel_block_info_size + block_bound);
+    }
+
+    size_t sizeParallel(ConstMemory source)
+    {
+        if (source.size < parallel_header_size)
+        {
+            return 0;
+        }
+
+        LittleEndianConstPointer p = source.address;
+
+        u32 magic = p.read32();
+        if (magic != u32_mask('m', 'c', 'p', '0'))
+        {
+            return 0;
+        }
+
+        p += 4; // method
+        return size_t(p.read64());
+    }
+
+    CompressionStatus compressParallel(Memory dest, ConstMemory source, Compressor::Method method, int level, size_t block_size)
+    {
+        block_size = getParallelBlockSize(block_size);
+
+        Compressor compressor = getCompressor(method);
+
+        const size_t num_blocks = getParallelBlockCount(source.size, block_size);
+        const size_t block_bound = compressor.bound(std::min(source.size, block_size));
+        const size_t data_offset = parallel_header_size + num_blocks * parallel_block_info_size;
+
+        CompressionStatus status;
+
+        if (dest.size < data_offset + num_blocks * block_bound)
+        {
+            status.setError("[compressParallel] Insufficient destination size.");
+            return status;
+        }
+
+        struct BlockInfo
+        {
+            size_t size;
+            u32 method;
+        };
+
+        std::vector<BlockInfo> blocks(num_blocks);
+
+        ConcurrentQueue q("parallel.compressor");
+
+        for (size_t i = 0; i < num_blocks; ++i)
+        {
+            q.enqueue([=, &blocks, &compressor]
+            {
+                const size_t offset = i * block_size;
+                ConstMemory input(source.address + offset, std::min(block_size, source.size - offset));
+
+                // each block is compressed into it's own slot and packed later
+                Memory output(dest.address + data_offset + i * block_bound, block_bound);
+
+                BlockInfo& info = blocks[i];
+
+                CompressionStatus result = compressor.compress(output, input, level);
+                if (result && result.size > 0 && result.size < input.size)
+                {
+                    info.size = result.size;
+                    info.method = compressor.method;
+                }
+                else
+                {
+                    // doesn't compress -> store
+                    std::memcpy(output.address, input.address, input.size);
+                    info.size = input.size;
+                    info.method = Compressor::NONE;
+                }
+            });
+        }
+
+        q.wait();
+
+        LittleEndianPointer p = dest.address;
+
+        p.write32(u32_mask('m', 'c', 'p', '0'));
+        p.write32(u32(method));
+        p.write64(u64(source.size));
+        p.write32(u32(block_size));
+        p.write32(u32(num_blocks));
+
+        // the packed offset never passes the slot offset so the blocks can be
+        // moved in-place in the same order they are stored
+        u8* packed = dest.address + data_offset;
+
+        for (size_t i = 0; i < num_blocks; ++i)
+        {
+            const BlockInfo& info = blocks[i];
+
+            p.write32(u32(info.size));
+            p.write32(info.method);
+
+            std::memmove(packed, dest.address + data_offset + i * block_bound, info.size);
+            packed += info.size;
+        }
+
+        status.size = packed - dest.address;
+        return status;
+    }
+
+    CompressionStatus decompressParallel(Memory dest, ConstMemory source)
+    {
+        CompressionStatus status;
+
+        if (source.size < parallel_header_size)
+        {
+            status.setError("[decompressParallel] Incorrect frame header.");
+            return status;
+        }
+
+        LittleEndianConstPointer p = source.address;
+
+        const u32 magic = p.read32();
+        if (magic != u32_mask('m', 'c', 'p', '0'))
+        {
+            status.setError("[decompressParallel] Incorrect frame identifier ({:#x}).", magic);
+            return status;
+        }
+
+        p += 4; // method
+
+        const u64 uncompressed = p.read64();
+        const size_t block_size = p.read32();
+        const size_t num_blocks = p.read32();
+
+        if (uncompressed > dest.size)
+        {
+            status.setError("[decompressParallel] Insufficient destination size.");
+            return status;
+        }
+
+        const size_t data_offset = parallel_header_size + num_blocks * parallel_block_info_size;
+        if (data_offset > source.size || !block_size || getParallelBlockCount(uncompressed, block_size) != num_blocks)
+        {
+            status.setError("[decompressParallel] Incorrect block index.");
+            return status;
+        }
+
+        std::vector<CompressionStatus> results(num_blocks);
+
+        ConcurrentQueue q("parallel.decompressor");
+
+        size_t offset = data_offset;
+
+        for (size_t i = 0; i < num_blocks; ++i)
+        {
+            const size_t compressed = p.read32();
+            const u32 method = p.read32();
+
+            if (offset + compressed > source.size)
+            {
+                status.setError("[decompressParallel] Incorrect block size.");
+                break;
+            }
+
+            ConstMemory input(source.address + offset, compressed);
+            Memory output(dest.address + i * block_size, std::min(block_size, size_t(uncompressed - i * block_size)));
+
+            q.enqueue([=, &results]
+            {
+                CompressionStatus& result = results[i];
+
+                if (method == Compressor::NONE)
+                {
+                    if (input.size == output.size)
+                    {
+                        std::memcpy(output.address, input.address, input.size);
+                    }
+                    else
+                    {
+                        result.setError("[decompressParallel] Incorrect stored block size.");
+                    }
+                }
+                else
+                {
+                    try
+                    {
+                        Compressor compressor = getCompressor(Compressor::Method(method));
+                        result = compressor.decompress(output, input);
+
+                        if (result && result.size != output.size)
+                        {
+                            result.setError("[decompressParallel] Incorrect decompressed block size.");
+                        }
+                    }
+                    catch (const Exception& e)
+                    {
+                        result.setError(e.what());
+                    }
+                }
+            });
+
+            offset += compressed;
+        }
+
+        q.wait();
+
+        if (!status)
+        {
+            return status;
+        }
+
+        for (const auto& result : results)
+        {
+            if (!result)
+            {
+                return result;
+            }
+        }
+
+        status.size = size_t(uncompressed);
+        return status;
+    }
+
 } // namespace mango
@@ -6,6 +6,11 @@
 #include <mango/core/bits.hpp>
 #include <mango/core/memory.hpp>
 
+#if defined(MANGO_PLATFORM_UNIX)
+    #include <unistd.h>
+    #include <sys/mman.h>
+#endif
+
 namespace mango
 {
 
@@ -26,6 +31,107 @@ namespace mango
     {
     }
 
+    // -----------------------------------------------------------------------
+    // VirtualMemory
+    // -----------------------------------------------------------------------
+
+#if defined(MANGO_PLATFORM_UNIX)
+
+    static
+    void advise_range(ConstMemory memory, MemoryAccess access)
+    {
+        static const uintptr_t page_size = uintptr_t(::sysconf(_SC_PAGESIZE));
+
+        if (!memory.size)
+        {
+            return;
+        }
+
+        uintptr_t start = reinterpret_cast<uintptr_t>(memory.address);
+        uintptr_t end = start + memory.size;
+
+        int advice;
+
+        switch (access)
+        {
+            case MemoryAccess::Sequential:
+                advice = MADV_SEQUENTIAL;
+                break;
+            case MemoryAccess::Random:
+                advice = MADV_RANDOM;
+                break;
+            case MemoryAccess::WillNeed:
+                advice = MADV_WILLNEED;
+                break;
+            case MemoryAccess::HugePages:
+#if defined(MADV_HUGEPAGE)
+                // shrink to whole pages so that neighbouring allocations are not affected
+                start = (start + page_size - 1) & ~(page_size - 1);
+                end = end & ~(page_size - 1);
+                advice = MADV_HUGEPAGE;
+                break;
+#else
+                return;
+#endif
+            case MemoryAccess::Normal:
+            default:
+                advice = MADV_NORMAL;
+                break;
+        }
+
+        // madvise() requires page aligned address
+        start = start & ~(page_size - 1);
+
+        if (start < end)
+        {
+            // the advice is only a hint; failure is not an error
+            ::madvise(reinterpret_cast<void*>(start), size_t(end - start), advice);
+        }
+    }
+
+#elif defined(MANGO_PLATFORM_WINDOWS) && defined(_WIN32_WINNT) && (_WIN32_WINNT >= 0x0602)
+
+    static
+    void advise_range(ConstMemory memory, MemoryAccess access)
+    {
+        // Windows only has the prefetch hint for mapped memory
+        if (access == MemoryAccess::WillNeed && memory.size > 0)
+        {
+            WIN32_MEMORY_RANGE_ENTRY entry;
+            entry.VirtualAddress = const_cast<u8*>(memory.address);
+            entry.NumberOfBytes = memory.size;
+            ::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &entry, 0);
+        }
+    }
+
+#else
+
+    static
+    void advise_range(ConstMemory memory, MemoryAccess access)
+    {
+        MANGO_UNREFERENCED(memory);
+        MANGO_UNREFERENCED(access);
+    }
+
+#endif
+
+    void VirtualMemory::advise(MemoryAccess access) const
+    {
+        advise_range(m_memory, access);
+    }
+
+    void VirtualMemory::prefetch(ConstMemory range) const
+    {
+        // clip the range to the virtual memory
+        const u8* start = std::max(range.address, m_memory.address);
+        const u8* end = std::min(range.address + range.size, m_memory.address + m_memory.size);
+
+        if (start < end)
+        {
+            advise_range(ConstMemory(start, size_t(end - start)), MemoryAccess::WillNeed);
+        }
+    }
+
     // -----------------------------------------------------------------------
     // aligned malloc/free
     // -----------------------------------------------------------------------
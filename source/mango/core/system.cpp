@@ -8,6 +8,8 @@
 #include <mango/core/timer.hpp>
 #include <mango/simd/simd.hpp>
 #include <sstream>
+#include <set>
+#include <shared_mutex>
 
 #if defined(WIN32)
 
@@ -70,6 +72,33 @@ namespace
         return id;
     }
 
+    // Single producer, single consumer ring buffer of trace events; the producer is
+    // the thread which owns the buffer and the consumer is the trace writer thread.
+    struct TraceBuffer
+    {
+        static constexpr u32 capacity = 1024;
+
+        Trace::Data events[capacity];
+
+        alignas(64) std::atomic<u32> head { 0 };
+        alignas(64) std::atomic<u32> tail { 0 };
+        std::atomic<bool> retired { false };
+    };
+
+    struct TraceBufferOwner
+    {
+        std::shared_ptr<TraceBuffer> buffer;
+
+        ~TraceBufferOwner()
+        {
+            if (buffer)
+            {
+                // the writer releases the buffer after it has been drained
+                buffer->retired.store(true, std::memory_order_release);
+            }
+        }
+    };
+
 } // namespace
 
 namespace mango
@@ -351,40 +380,150 @@ namespace mango
     constexpr u32 trace_pool_offset = 0x10000;
 
     static
-    void write(Stream& output, const std::vector<Trace::Data>& traces, bool& comma)
+    void format(fmt::memory_buffer& buffer, const Trace::Data& event, bool& comma)
     {
-        fmt::memory_buffer buffer;
+        const char* prefix = comma ? "," : "";
+        comma = true;
 
-        for (const auto& trace : traces)
+        switch (event.type)
         {
-            u32 offset = 0;
-            if (trace.category == "Task")
-                offset = trace_pool_offset;
+            case Trace::Data::COMPLETE:
+            {
+                u32 offset = 0;
+                if (std::string_view(event.category) == "Task")
+                    offset = trace_pool_offset;
 
-            fmt::format_to(std::back_inserter(buffer),
-                "{}\n{{ \"cat\":\"{}\", \"pid\":1, \"tid\":{}, \"ts\":{}, \"dur\":{}, \"ph\":\"X\", \"name\":\"{}\" }}",
-                    comma ? "," : "", trace.category, trace.tid + offset, trace.time0, trace.time1 - trace.time0, trace.name);
+                fmt::format_to(std::back_inserter(buffer),
+                    "{}\n{{ \"cat\":\"{}\", \"pid\":1, \"tid\":{}, \"ts\":{}, \"dur\":{}, \"ph\":\"X\", \"name\":\"{}\" }}",
+                        prefix, event.category, event.tid + offset, event.time0, event.time1 - event.time0, event.name);
+                break;
+            }
 
-            comma = true;
-        }
+            case Trace::Data::COUNTER:
+                fmt::format_to(std::back_inserter(buffer),
+                    "{}\n{{ \"cat\":\"{}\", \"pid\":1, \"tid\":{}, \"ts\":{}, \"ph\":\"C\", \"name\":\"{}\", \"args\": {{\"value\":{} }} }}",
+                        prefix, event.category, event.tid, event.time0, event.name, event.value);
+                break;
+
+            case Trace::Data::FLOW_BEGIN:
+                fmt::format_to(std::back_inserter(buffer),
+                    "{}\n{{ \"cat\":\"{}\", \"pid\":1, \"tid\":{}, \"ts\":{}, \"ph\":\"s\", \"id\":{}, \"name\":\"{}\" }}",
+                        prefix, event.category, event.tid, event.time0, u64(event.value), event.name);
+                break;
 
-        output.write(buffer.data(), buffer.size());
+            case Trace::Data::FLOW_END:
+                fmt::format_to(std::back_inserter(buffer),
+                    "{}\n{{ \"cat\":\"{}\", \"pid\":1, \"tid\":{}, \"ts\":{}, \"ph\":\"f\", \"bp\":\"e\", \"id\":{}, \"name\":\"{}\" }}",
+                        prefix, event.category, event.tid, event.time0, u64(event.value), event.name);
+                break;
+        }
     }
 
+    struct Tracer::State
+    {
+        // protects buffers, threads, output and the writer wakeup
+        std::mutex mutex;
+        std::condition_variable condition;
+
+        std::vector<std::shared_ptr<TraceBuffer>> buffers;
+        std::vector<TraceThread> threads;
+
+        std::shared_mutex names_mutex;
+        std::set<std::string, std::less<>> names;
+
+        Stream* output { nullptr };
+        std::thread writer;
+        bool running { false };
+        bool comma { false };
+
+        void drain()
+        {
+            std::vector<std::shared_ptr<TraceBuffer>> current;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                // release the buffers of the terminated threads once they are empty
+                std::erase_if(buffers, [] (const std::shared_ptr<TraceBuffer>& buffer)
+                {
+                    return buffer->retired.load(std::memory_order_acquire) &&
+                           buffer->head.load(std::memory_order_acquire) == buffer->tail.load(std::memory_order_relaxed);
+                });
+
+                current = buffers;
+            }
+
+            fmt::memory_buffer buffer;
+
+            for (auto& ring : current)
+            {
+                u32 tail = ring->tail.load(std::memory_order_relaxed);
+                u32 head = ring->head.load(std::memory_order_acquire);
+
+                for ( ; tail != head; ++tail)
+                {
+                    format(buffer, ring->events[tail % TraceBuffer::capacity], comma);
+                }
+
+                ring->tail.store(tail, std::memory_order_release);
+            }
+
+            if (buffer.size())
+            {
+                output->write(buffer.data(), buffer.size());
+            }
+        }
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            while (running)
+            {
+                condition.wait_for(lock, std::chrono::milliseconds(20));
+
+                lock.unlock();
+                drain();
+                lock.lock();
+            }
+        }
+    };
+
     TraceThread::TraceThread(const std::string& name)
         : tid(getThreadID())
         , name(name)
     {
-        std::lock_guard<std::mutex> lock(g_context.tracer.mutex);
-        g_context.tracer.threads.push_back(*this);
+        g_context.tracer.registerThread(*this);
     }
 
-    Trace::Trace(const std::string& category, const std::string& name)
+    Trace::Trace(const char* category, const char* name)
     {
-        data.tid = getThreadID();
-        data.time0 = Time::us();
-        data.category = category;
-        data.name = name;
+        data.category = nullptr;
+
+        if (g_context.tracer.isEnabled())
+        {
+            data.type = Data::COMPLETE;
+            data.tid = getThreadID();
+            data.time0 = Time::us();
+            data.value = 0;
+            data.category = category;
+            data.name = name;
+        }
+    }
+
+    Trace::Trace(const char* category, std::string_view name)
+    {
+        data.category = nullptr;
+
+        if (g_context.tracer.isEnabled())
+        {
+            data.type = Data::COMPLETE;
+            data.tid = getThreadID();
+            data.value = 0;
+            data.category = category;
+            data.name = g_context.tracer.intern(name);
+            data.time0 = Time::us();
+        }
     }
 
     Trace::~Trace()
@@ -394,11 +533,50 @@ namespace mango
 
     void Trace::stop()
     {
-        data.time1 = Time::us();
-        g_context.tracer.append(*this);
+        if (data.category)
+        {
+            data.time1 = Time::us();
+            g_context.tracer.append(data);
+            data.category = nullptr;
+        }
+    }
+
+    static
+    void traceEvent(Trace::Data::Type type, const char* category, const char* name, s64 value)
+    {
+        if (g_context.tracer.isEnabled())
+        {
+            Trace::Data data;
+
+            data.type = type;
+            data.tid = getThreadID();
+            data.time0 = Time::us();
+            data.time1 = data.time0;
+            data.value = value;
+            data.category = category;
+            data.name = name;
+
+            g_context.tracer.append(data);
+        }
+    }
+
+    void traceCounter(const char* category, const char* name, s64 value)
+    {
+        traceEvent(Trace::Data::COUNTER, category, name, value);
+    }
+
+    void traceFlowBegin(const char* category, const char* name, u64 id)
+    {
+        traceEvent(Trace::Data::FLOW_BEGIN, category, name, s64(id));
+    }
+
+    void traceFlowEnd(const char* category, const char* name, u64 id)
+    {
+        traceEvent(Trace::Data::FLOW_END, category, name, s64(id));
     }
 
     Tracer::Tracer()
+        : m_state(std::make_unique<State>())
     {
     }
 
@@ -407,43 +585,85 @@ namespace mango
         stop();
     }
 
+    const char* Tracer::intern(std::string_view name)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(m_state->names_mutex);
+            auto it = m_state->names.find(name);
+            if (it != m_state->names.end())
+                return it->c_str();
+        }
+
+        std::unique_lock<std::shared_mutex> lock(m_state->names_mutex);
+        auto it = m_state->names.emplace(name).first;
+        return it->c_str();
+    }
+
+    void Tracer::registerThread(const TraceThread& thread)
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->threads.push_back(thread);
+    }
+
     void Tracer::start(Stream* stream)
     {
-        std::lock_guard<std::mutex> lock(mutex);
+        std::lock_guard<std::mutex> lock(m_state->mutex);
 
-        if (output)
+        if (m_state->output)
         {
             // already running a trace
             return;
         }
 
-        output = stream;
-
-        traces.clear();
+        m_state->output = stream;
+        m_state->comma = false;
 
-        comma = false;
-        count = 0;
+        // discard events which were recorded after the previous trace was stopped
+        for (auto& buffer : m_state->buffers)
+        {
+            buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_release);
+        }
 
         // write header
         std::string s = fmt::format("{{\n\"traceEvents\": [");
-        output->write(s.data(), s.length());
+        stream->write(s.data(), s.length());
+
+        m_state->running = true;
+        m_state->writer = std::thread([this]
+        {
+            m_state->run();
+        });
+
+        enabled.store(true, std::memory_order_release);
     }
 
     void Tracer::stop()
     {
-        std::lock_guard<std::mutex> lock(mutex);
-
-        if (!output)
         {
-            // not running a trace
-            return;
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+
+            if (!m_state->output || !m_state->running)
+            {
+                // not running a trace
+                return;
+            }
+
+            enabled.store(false, std::memory_order_release);
+            m_state->running = false;
         }
 
-        writer.wait();
+        m_state->condition.notify_one();
+        m_state->writer.join();
+
+        // write the remaining events
+        m_state->drain();
+
+        std::lock_guard<std::mutex> lock(m_state->mutex);
 
         fmt::memory_buffer buffer;
+        bool& comma = m_state->comma;
 
-        for (const auto& th : threads)
+        for (const auto& th : m_state->threads)
         {
             fmt::format_to(std::back_inserter(buffer),
                 "{}\n{{ \"name\":\"thread_name\", \"ph\":\"M\", \"pid\":1, \"tid\":{}, \"args\": {{\"name\":\"{}\" }} }}",
@@ -456,38 +676,47 @@ namespace mango
                     comma ? "," : "", th.tid + trace_pool_offset, th.name + " tasks:");
         }
 
-        threads.clear();
-        output->write(buffer.data(), buffer.size());
-
-        write(*output, traces, comma);
-        traces.clear();
-
         // write footer
-        std::string s = fmt::format("\n]\n}}\n");
-        output->write(s.data(), s.length());
+        fmt::format_to(std::back_inserter(buffer), "\n]\n}}\n");
+        m_state->output->write(buffer.data(), buffer.size());
 
-        output = nullptr;
+        m_state->output = nullptr;
     }
 
-    void Tracer::append(const Trace& trace)
+    void Tracer::append(const Trace::Data& data)
     {
-        std::lock_guard<std::mutex> lock(mutex);
-        if (output)
+        thread_local TraceBufferOwner owner;
+
+        if (!owner.buffer)
         {
-            traces.push_back(trace.data);
+            owner.buffer = std::make_shared<TraceBuffer>();
 
-            if (traces.size() >= 1024)
-            {
-                writer.wait();
-                std::swap(traces_out, traces);
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            m_state->buffers.push_back(owner.buffer);
+        }
 
-                writer.enqueue([&]
-                {
-                    write(*output, traces_out, comma);
-                    traces_out.clear();
-                });
-            }
+        TraceBuffer& ring = *owner.buffer;
+
+        u32 head = ring.head.load(std::memory_order_relaxed);
+
+        while (head - ring.tail.load(std::memory_order_acquire) >= TraceBuffer::capacity)
+        {
+            // the buffer is full; wake up the writer and wait until it has made room
+            if (!isEnabled())
+                return;
+
+            m_state->condition.notify_one();
+            std::this_thread::yield();
         }
+
+        if (!isEnabled())
+        {
+            // the trace was stopped while the event was being recorded
+            return;
+        }
+
+        ring.events[head % TraceBuffer::capacity] = data;
+        ring.head.store(head + 1, std::memory_order_release);
     }
 
     void startTrace(Stream* stream)
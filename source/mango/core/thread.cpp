@@ -181,6 +181,11 @@ namespace mango
         return int(m_threads.size());
     }
 
+    size_t ThreadPool::getQueueSize() const
+    {
+        return m_queue->tasks.size_approx();
+    }
+
     void ThreadPool::thread(size_t threadID)
     {
         std::string name = fmt::format("TP#{:03}", threadID + 1);
@@ -227,9 +232,16 @@ namespace mango
 
         ++queue->task_counter;
 
-        thread_local moodycamel::ProducerToken token(m_queue->tasks);
-        m_queue->tasks.enqueue(token, std::move(task));
-        //m_queue->tasks.enqueue(std::move(task));
+        if (this == &getInstance())
+        {
+            // the token is bound to the queue it was created for; only the global pool has one
+            thread_local moodycamel::ProducerToken token(m_queue->tasks);
+            m_queue->tasks.enqueue(token, std::move(task));
+        }
+        else
+        {
+            m_queue->tasks.enqueue(std::move(task));
+        }
 
         m_condition.notify_one();
     }
@@ -275,6 +287,29 @@ namespace mango
         }
     }
 
+    void ThreadPool::help(const std::function<bool()>& done)
+    {
+        while (!done())
+        {
+            if (!dequeue_and_process())
+            {
+                // the done() is checked under the lock so that the notify() cannot be missed;
+                // the timeout covers the enqueue() which notifies without the lock
+                std::unique_lock<std::mutex> lock(m_queue_mutex);
+                m_condition.wait_for(lock, milliseconds(60), [&]
+                {
+                    return done() || getQueueSize() > 0;
+                });
+            }
+        }
+    }
+
+    void ThreadPool::notify()
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_condition.notify_all();
+    }
+
     void ThreadPool::cancel(Queue* queue)
     {
         queue->cancelled = true;
@@ -523,4 +558,58 @@ namespace mango
         m_wait_condition.wait(wait_lock, [this] { return !m_ticket_counter.load(std::memory_order_relaxed); });
     }
 
+    // ------------------------------------------------------------
+    // CancellationToken
+    // ------------------------------------------------------------
+
+    CancellationToken::CancellationToken()
+        : m_state(std::make_shared<State>())
+    {
+    }
+
+    CancellationToken::~CancellationToken()
+    {
+    }
+
+    void CancellationToken::cancel()
+    {
+        m_state->cancelled = true;
+    }
+
+    bool CancellationToken::isCancelled() const
+    {
+        for (const State* state = m_state.get(); state; state = state->parent.get())
+        {
+            if (state->cancelled.load(std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void CancellationToken::reset()
+    {
+        m_state->cancelled = false;
+        m_state->parent.reset();
+    }
+
+    void CancellationToken::reset(const CancellationToken& parent)
+    {
+        m_state->cancelled = false;
+
+        // a token cannot be it's own ancestor
+        for (const State* state = parent.m_state.get(); state; state = state->parent.get())
+        {
+            if (state == m_state.get())
+            {
+                m_state->parent.reset();
+                return;
+            }
+        }
+
+        m_state->parent = parent.m_state;
+    }
+
 } // namespace mango
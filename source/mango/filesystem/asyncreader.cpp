@@ -0,0 +1,709 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <mango/core/buffer.hpp>
+#include <mango/core/thread.hpp>
+#include <mango/filesystem/asyncreader.hpp>
+#include "file_handle.hpp"
+
+#if defined(MANGO_PLATFORM_LINUX) && __has_include(<linux/io_uring.h>)
+    #define MANGO_ENABLE_IO_URING
+#endif
+
+#ifdef MANGO_ENABLE_IO_URING
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
+    #include <sys/syscall.h>
+    #include <linux/io_uring.h>
+#endif
+
+namespace
+{
+    using namespace mango;
+    using mango::filesystem::AsyncReader;
+
+    struct Request
+    {
+        std::string filename;
+        AsyncReader::Callback callback;
+
+        Memory dest;                // caller-provided memory
+        bool pooled = false;        // read into a pooled buffer instead of dest
+        Buffer* buffer = nullptr;
+        u64 offset;
+        u64 size = 0;
+        u64 bytes = 0;       // bytes read so far
+
+#ifdef MANGO_ENABLE_IO_URING
+        int fd = -1;
+        struct iovec iov;
+#endif
+
+        u8* data() const
+        {
+            return buffer ? buffer->data() : dest.address;
+        }
+    };
+
+    // -----------------------------------------------------------------
+    // BufferPool
+    // -----------------------------------------------------------------
+
+    class BufferPool
+    {
+    protected:
+        std::mutex m_mutex;
+        std::vector<std::unique_ptr<Buffer>> m_buffers;
+        size_t m_limit;
+
+    public:
+        BufferPool(size_t limit)
+            : m_limit(limit)
+        {
+        }
+
+        Buffer* acquire(size_t size)
+        {
+            std::unique_ptr<Buffer> buffer;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                // smallest buffer which is large enough, otherwise the largest one
+                size_t best = m_buffers.size();
+                for (size_t i = 0; i < m_buffers.size(); ++i)
+                {
+                    if (best == m_buffers.size())
+                    {
+                        best = i;
+                        continue;
+                    }
+
+                    size_t capacity = m_buffers[i]->capacity();
+                    size_t current = m_buffers[best]->capacity();
+
+                    if (current < size ? capacity > current : capacity >= size && capacity < current)
+                    {
+                        best = i;
+                    }
+                }
+
+                if (best < m_buffers.size())
+                {
+                    buffer = std::move(m_buffers[best]);
+                    m_buffers.erase(m_buffers.begin() + best);
+                }
+            }
+
+            if (!buffer)
+            {
+                buffer = std::make_unique<Buffer>();
+            }
+
+            buffer->resize(size);
+            return buffer.release();
+        }
+
+        void release(Buffer* buffer)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (m_buffers.size() < m_limit)
+            {
+                m_buffers.emplace_back(buffer);
+            }
+            else
+            {
+                delete buffer;
+            }
+        }
+    };
+
+#ifdef MANGO_ENABLE_IO_URING
+
+    // -----------------------------------------------------------------
+    // Ring
+    // -----------------------------------------------------------------
+
+    // minimal io_uring interface using the raw system calls (liburing is not required)
+
+    class Ring
+    {
+    protected:
+        int m_fd = -1;
+
+        u8* m_sq_ptr = nullptr;
+        u8* m_cq_ptr = nullptr;
+        size_t m_sq_size = 0;
+        size_t m_cq_size = 0;
+
+        io_uring_sqe* m_sqes = nullptr;
+        size_t m_sqes_size = 0;
+
+        u32* m_sq_head;
+        u32* m_sq_tail;
+        u32* m_sq_mask;
+        u32* m_sq_array;
+        u32* m_cq_head;
+        u32* m_cq_tail;
+        u32* m_cq_mask;
+        io_uring_cqe* m_cqes;
+
+        u32 m_pending = 0; // prepared but not submitted entries
+
+    public:
+        Ring(u32 entries)
+        {
+            io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+
+            int fd = int(syscall(__NR_io_uring_setup, entries, &params));
+            if (fd < 0)
+            {
+                // not supported by the kernel or blocked by the security policy
+                return;
+            }
+
+            m_sq_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+            m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+            bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (single_mmap)
+            {
+                m_sq_size = std::max(m_sq_size, m_cq_size);
+                m_cq_size = m_sq_size;
+            }
+
+            void* sq = ::mmap(nullptr, m_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            void* cq = single_mmap ? sq : ::mmap(nullptr, m_cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+
+            m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            void* sqes = ::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+            if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED)
+            {
+                if (sq != MAP_FAILED) ::munmap(sq, m_sq_size);
+                if (cq != MAP_FAILED && !single_mmap) ::munmap(cq, m_cq_size);
+                if (sqes != MAP_FAILED) ::munmap(sqes, m_sqes_size);
+                ::close(fd);
+                return;
+            }
+
+            m_fd = fd;
+            m_sq_ptr = reinterpret_cast<u8*>(sq);
+            m_cq_ptr = reinterpret_cast<u8*>(cq);
+            m_sqes = reinterpret_cast<io_uring_sqe*>(sqes);
+
+            m_sq_head = reinterpret_cast<u32*>(m_sq_ptr + params.sq_off.head);
+            m_sq_tail = reinterpret_cast<u32*>(m_sq_ptr + params.sq_off.tail);
+            m_sq_mask = reinterpret_cast<u32*>(m_sq_ptr + params.sq_off.ring_mask);
+            m_sq_array = reinterpret_cast<u32*>(m_sq_ptr + params.sq_off.array);
+            m_cq_head = reinterpret_cast<u32*>(m_cq_ptr + params.cq_off.head);
+            m_cq_tail = reinterpret_cast<u32*>(m_cq_ptr + params.cq_off.tail);
+            m_cq_mask = reinterpret_cast<u32*>(m_cq_ptr + params.cq_off.ring_mask);
+            m_cqes = reinterpret_cast<io_uring_cqe*>(m_cq_ptr + params.cq_off.cqes);
+        }
+
+        ~Ring()
+        {
+            if (m_fd >= 0)
+            {
+                ::munmap(m_sqes, m_sqes_size);
+                if (m_cq_ptr != m_sq_ptr)
+                {
+                    ::munmap(m_cq_ptr, m_cq_size);
+                }
+                ::munmap(m_sq_ptr, m_sq_size);
+                ::close(m_fd);
+            }
+        }
+
+        bool isEnabled() const
+        {
+            return m_fd >= 0;
+        }
+
+        void read(Request* request)
+        {
+            u64 remain = request->size - request->bytes;
+
+            // limit a single read to what the kernel will transfer in one call
+            request->iov.iov_base = request->data() + request->bytes;
+            request->iov.iov_len = size_t(std::min(remain, u64(0x40000000)));
+
+            u32 tail = *m_sq_tail;
+            u32 index = tail & *m_sq_mask;
+
+            io_uring_sqe* sqe = m_sqes + index;
+            std::memset(sqe, 0, sizeof(io_uring_sqe));
+
+            sqe->opcode = IORING_OP_READV;
+            sqe->fd = request->fd;
+            sqe->addr = reinterpret_cast<u64>(&request->iov);
+            sqe->len = 1;
+            sqe->off = request->offset + request->bytes;
+            sqe->user_data = reinterpret_cast<u64>(request);
+
+            m_sq_array[index] = index;
+            __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+            ++m_pending;
+        }
+
+        // submit the prepared reads and wait for at least one completion
+        void submit(bool wait)
+        {
+            u32 flags = wait ? IORING_ENTER_GETEVENTS : 0;
+
+            for (;;)
+            {
+                int result = int(syscall(__NR_io_uring_enter, m_fd, m_pending, wait ? 1 : 0, flags, nullptr, 0));
+                if (result >= 0)
+                {
+                    m_pending -= std::min(m_pending, u32(result));
+                    break;
+                }
+
+                if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                {
+                    break;
+                }
+            }
+        }
+
+        template <typename Func>
+        void reap(Func func)
+        {
+            u32 head = *m_cq_head;
+            u32 tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+
+            for ( ; head != tail; ++head)
+            {
+                const io_uring_cqe& cqe = m_cqes[head & *m_cq_mask];
+                func(reinterpret_cast<Request*>(cqe.user_data), cqe.res);
+            }
+
+            __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+        }
+    };
+
+#endif // MANGO_ENABLE_IO_URING
+
+} // namespace
+
+namespace mango::filesystem
+{
+
+    // -----------------------------------------------------------------
+    // AsyncReader
+    // -----------------------------------------------------------------
+
+    struct AsyncReader::State
+    {
+        u32 m_depth;
+        BufferPool m_pool;
+
+        // callbacks and the fallback reads
+        ConcurrentQueue m_queue { "async.reader" };
+
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::condition_variable m_complete;
+        std::deque<Request*> m_requests;
+        size_t m_reading = 0; // requests submitted but not completed
+        bool m_stop = false;
+
+        // the first exception thrown from a callback; rethrown from wait()
+        std::exception_ptr m_exception;
+
+#ifdef MANGO_ENABLE_IO_URING
+        std::unique_ptr<Ring> m_ring;
+        std::thread m_thread;
+#endif
+
+        State(u32 depth)
+            : m_depth(std::max(depth, 1u))
+            , m_pool(m_depth)
+        {
+#ifdef MANGO_ENABLE_IO_URING
+            m_ring = std::make_unique<Ring>(m_depth);
+            if (m_ring->isEnabled())
+            {
+                m_thread = std::thread([this]
+                {
+                    run();
+                });
+            }
+            else
+            {
+                m_ring.reset();
+            }
+#endif
+        }
+
+        ~State()
+        {
+            wait();
+
+#ifdef MANGO_ENABLE_IO_URING
+            if (m_ring)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_stop = true;
+                }
+
+                m_condition.notify_one();
+                m_thread.join();
+            }
+#endif
+        }
+
+        bool isAsync() const
+        {
+#ifdef MANGO_ENABLE_IO_URING
+            return m_ring != nullptr;
+#else
+            return false;
+#endif
+        }
+
+        void submit(Request* request)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_reading;
+            }
+
+            if (isAsync())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_requests.push_back(request);
+                }
+
+                m_condition.notify_one();
+            }
+            else
+            {
+                m_queue.enqueue([this, request]
+                {
+                    readBlocking(request);
+                });
+            }
+        }
+
+        void readBlocking(Request* request)
+        {
+            Result result;
+            result.filename = request->filename;
+
+            try
+            {
+                FileHandle handle(request->filename, Stream::OpenMode::Read);
+                if (!handle.isOpen())
+                {
+                    MANGO_EXCEPTION("[AsyncReader] File \"{}\" cannot be opened.", request->filename);
+                }
+
+                u64 size = handle.size();
+                u64 offset = std::min(request->offset, size);
+
+                if (request->pooled)
+                {
+                    request->buffer = m_pool.acquire(size_t(size - offset));
+                    request->size = request->buffer->size();
+                }
+                else
+                {
+                    request->size = std::min(u64(request->dest.size), size - offset);
+                }
+
+                if (request->size)
+                {
+                    if (!handle.seek(offset))
+                    {
+                        MANGO_EXCEPTION("[AsyncReader] File \"{}\" read failed.", request->filename);
+                    }
+
+                    Memory memory(request->data(), size_t(request->size));
+                    request->bytes = handle.read(&memory, 1);
+                }
+            }
+            catch (Exception& e)
+            {
+                result.setError(e.what());
+            }
+
+            complete(request, result);
+        }
+
+        void release(Request* request)
+        {
+            if (request->buffer)
+            {
+                m_pool.release(request->buffer);
+            }
+
+            delete request;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_reading == 0)
+            {
+                m_complete.notify_all();
+            }
+        }
+
+        // invoke the callback and release the request
+        void complete(Request* request, Result& result)
+        {
+            if (result)
+            {
+                result.memory = ConstMemory(request->data(), size_t(request->bytes));
+            }
+
+            try
+            {
+                request->callback(result);
+            }
+            catch (...)
+            {
+                // the request is released and the other reads continue
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_exception)
+                {
+                    m_exception = std::current_exception();
+                }
+            }
+
+            release(request);
+        }
+
+#ifdef MANGO_ENABLE_IO_URING
+
+        void fail(Request* request, const std::string& info)
+        {
+            if (request->fd >= 0)
+            {
+                ::close(request->fd);
+                request->fd = -1;
+            }
+
+            m_queue.enqueue([this, request, info]
+            {
+                Result result;
+                result.filename = request->filename;
+                result.setError(info);
+                complete(request, result);
+            });
+        }
+
+        void finish(Request* request)
+        {
+            ::close(request->fd);
+            request->fd = -1;
+
+            m_queue.enqueue([this, request]
+            {
+                Result result;
+                result.filename = request->filename;
+                complete(request, result);
+            });
+        }
+
+        bool open(Request* request)
+        {
+            request->fd = ::open(request->filename.c_str(), O_RDONLY | O_CLOEXEC);
+            if (request->fd < 0)
+            {
+                fail(request, fmt::format("[AsyncReader] File \"{}\" cannot be opened.", request->filename));
+                return false;
+            }
+
+            struct stat s;
+            if (::fstat(request->fd, &s) < 0)
+            {
+                fail(request, fmt::format("[AsyncReader] File \"{}\" cannot be accessed.", request->filename));
+                return false;
+            }
+
+            u64 size = u64(s.st_size);
+            u64 offset = std::min(request->offset, size);
+            request->offset = offset;
+
+            if (request->pooled)
+            {
+                request->buffer = m_pool.acquire(size_t(size - offset));
+                request->size = request->buffer->size();
+            }
+            else
+            {
+                request->size = std::min(u64(request->dest.size), size - offset);
+            }
+
+            if (!request->size)
+            {
+                finish(request);
+                return false;
+            }
+
+            return true;
+        }
+
+        void run()
+        {
+            u32 active = 0;
+
+            for (;;)
+            {
+                std::vector<Request*> requests;
+
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+
+                    m_condition.wait(lock, [&]
+                    {
+                        return m_stop || active > 0 || !m_requests.empty();
+                    });
+
+                    if (m_stop && !active && m_requests.empty())
+                    {
+                        break;
+                    }
+
+                    while (!m_requests.empty() && active + requests.size() < m_depth)
+                    {
+                        requests.push_back(m_requests.front());
+                        m_requests.pop_front();
+                    }
+                }
+
+                for (Request* request : requests)
+                {
+                    if (open(request))
+                    {
+                        m_ring->read(request);
+                        ++active;
+                    }
+                }
+
+                if (!active)
+                {
+                    continue;
+                }
+
+                m_ring->submit(true);
+                m_ring->reap([&] (Request* request, int result)
+                {
+                    if (result < 0)
+                    {
+                        if (result == -EINTR || result == -EAGAIN)
+                        {
+                            m_ring->read(request);
+                            return;
+                        }
+
+                        --active;
+                        fail(request, fmt::format("[AsyncReader] File \"{}\" read failed ({}).", request->filename, -result));
+                        return;
+                    }
+
+                    request->bytes += u64(result);
+
+                    if (result > 0 && request->bytes < request->size)
+                    {
+                        // short read; continue from where it stopped
+                        m_ring->read(request);
+                        return;
+                    }
+
+                    --active;
+                    finish(request);
+                });
+            }
+        }
+
+#endif // MANGO_ENABLE_IO_URING
+
+        void wait()
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_complete.wait(lock, [this]
+                {
+                    return m_reading == 0;
+                });
+            }
+
+            m_queue.wait();
+        }
+
+        void rethrow()
+        {
+            std::exception_ptr exception;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                std::swap(exception, m_exception);
+            }
+
+            if (exception)
+            {
+                std::rethrow_exception(exception);
+            }
+        }
+    };
+
+    AsyncReader::AsyncReader(u32 queue_depth)
+        : m_state(std::make_unique<State>(queue_depth))
+    {
+    }
+
+    AsyncReader::~AsyncReader()
+    {
+    }
+
+    bool AsyncReader::isAsync() const
+    {
+        return m_state->isAsync();
+    }
+
+    void AsyncReader::read(const std::string& filename, Callback callback)
+    {
+        Request* request = new Request;
+
+        request->filename = filename;
+        request->callback = std::move(callback);
+        request->pooled = true;
+        request->offset = 0;
+
+        m_state->submit(request);
+    }
+
+    void AsyncReader::read(const std::string& filename, Memory dest, u64 offset, Callback callback)
+    {
+        Request* request = new Request;
+
+        request->filename = filename;
+        request->callback = std::move(callback);
+        request->dest = dest;
+        request->offset = offset;
+
+        m_state->submit(request);
+    }
+
+    void AsyncReader::wait()
+    {
+        m_state->wait();
+        m_state->rethrow();
+    }
+
+} // namespace mango::filesystem
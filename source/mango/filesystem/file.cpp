@@ -2,9 +2,12 @@
     MANGO Multimedia Development Platform
     Copyright (C) 2012-2021 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
+#include <cstring>
 #include <mango/core/string.hpp>
 #include <mango/core/exception.hpp>
+#include <mango/core/print.hpp>
 #include <mango/filesystem/file.hpp>
+#include "file_handle.hpp"
 
 namespace mango::filesystem
 {
@@ -13,7 +16,7 @@ namespace mango::filesystem
     // File
     // -----------------------------------------------------------------
 
-    File::File(const std::string& s)
+    File::File(const std::string& s, MemoryAccess access)
     {
         // split s into pathname + filename
         size_t n = getPathSeparatorIndex(s);
@@ -24,10 +27,10 @@ namespace mango::filesystem
 
         // create a internal path
         m_path = std::make_unique<Path>(filepath);
-        initMemory(*m_path);
+        initMemory(*m_path, access);
     }
 
-    File::File(const Path& path, const std::string& s)
+    File::File(const Path& path, const std::string& s, MemoryAccess access)
     {
         // split s into pathname + filename
         size_t n = getPathSeparatorIndex(s);
@@ -38,10 +41,10 @@ namespace mango::filesystem
 
         // create a internal path
         m_path = std::make_unique<Path>(path, filepath);
-        initMemory(*m_path);
+        initMemory(*m_path, access);
     }
 
-    File::File(ConstMemory memory, const std::string& extension, const std::string& s)
+    File::File(ConstMemory memory, const std::string& extension, const std::string& s, MemoryAccess access)
     {
         // use memory mapped path as parent
         // NOTE: the path goes out of scope but the mapper object is shared_ptr so it remains alive :)
@@ -56,16 +59,16 @@ namespace mango::filesystem
 
         // create a internal path
         m_path = std::make_unique<Path>(path, filepath);
-        initMemory(*m_path);
+        initMemory(*m_path, access);
     }
 
     File::~File()
     {
     }
 
-    void File::initMemory(Mapper& mapper)
+    void File::initMemory(Mapper& mapper, MemoryAccess access)
     {
-        m_virtual_memory = mapper.map(m_filename);
+        m_virtual_memory = mapper.map(m_filename, access);
         if (m_virtual_memory)
         {
             m_memory = *m_virtual_memory;
@@ -107,6 +110,14 @@ namespace mango::filesystem
         return m_memory.size;
     }
 
+    void File::prefetch(ConstMemory range) const
+    {
+        if (m_virtual_memory)
+        {
+            m_virtual_memory->prefetch(range);
+        }
+    }
+
     u64 getFileSize(const std::string& filename)
     {
         // Calls stat() to get the file size for raw files
@@ -115,4 +126,282 @@ namespace mango::filesystem
         return path.getSize(filename);
     }
 
+    // -----------------------------------------------------------------
+    // FileStream
+    // -----------------------------------------------------------------
+
+    struct FileStream::State
+    {
+        FileHandle handle;
+        OpenMode mode;
+
+        std::unique_ptr<u8[]> buffer;
+        size_t capacity;
+
+        u64 offset = 0;         // stream position
+        u64 handle_offset = 0;  // file handle position
+
+        // read mode: buffered file range [buffer_offset, buffer_offset + buffer_size)
+        u64 buffer_offset = 0;
+        size_t buffer_size = 0;
+
+        // write mode: bytes in buffer for file range [offset - pending, offset)
+        size_t pending = 0;
+
+        State(const std::string& filename, OpenMode mode, size_t buffer_size)
+            : handle(filename, mode)
+            , mode(mode)
+            , buffer(buffer_size ? new u8[buffer_size] : nullptr)
+            , capacity(buffer_size)
+        {
+        }
+
+        ~State()
+        {
+            // exceptions cannot be thrown from the destructor; use flush() to handle the errors
+            u64 position = offset;
+            writeBuffers(nullptr, 0);
+
+            if (offset != position)
+            {
+                printLine(Print::Error, "[FileStream] Writing \"{}\" failed.", handle.filename());
+            }
+        }
+
+        void setHandleOffset(u64 position)
+        {
+            if (handle_offset != position)
+            {
+                handle.seek(position);
+                handle_offset = position;
+            }
+        }
+
+        u64 size() const
+        {
+            u64 bytes = handle.size();
+            if (mode == OpenMode::Write)
+            {
+                // include the data which is not yet written
+                bytes = std::max(bytes, offset);
+            }
+            return bytes;
+        }
+
+        u64 read(void* dest, u64 bytes)
+        {
+            if (mode != OpenMode::Read)
+            {
+                return 0;
+            }
+
+            u8* output = reinterpret_cast<u8*>(dest);
+            u64 total = 0;
+
+            // copy from the read-ahead buffer
+            if (offset >= buffer_offset && offset < buffer_offset + buffer_size)
+            {
+                u64 available = buffer_offset + buffer_size - offset;
+                u64 n = std::min(bytes, available);
+                std::memcpy(output, buffer.get() + (offset - buffer_offset), size_t(n));
+                output += n;
+                bytes -= n;
+                offset += n;
+                total += n;
+            }
+
+            if (bytes > 0)
+            {
+                // read the remaining data directly into the destination and refill the
+                // read-ahead buffer with the same call
+                Memory buffers[] =
+                {
+                    Memory(output, size_t(bytes)),
+                    Memory(buffer.get(), capacity),
+                };
+
+                setHandleOffset(offset);
+                u64 n = handle.read(buffers, 2);
+                handle_offset += n;
+
+                if (n > bytes)
+                {
+                    buffer_offset = offset + bytes;
+                    buffer_size = size_t(n - bytes);
+                    n = bytes;
+                }
+                else
+                {
+                    buffer_size = 0;
+                }
+
+                offset += n;
+                total += n;
+            }
+
+            return total;
+        }
+
+        // write the pending data followed by the buffers; returns the number of bytes
+        // written from the buffers
+        u64 writeBuffers(const ConstMemory* buffers, size_t count)
+        {
+            if (!pending && !count)
+            {
+                return 0;
+            }
+
+            std::vector<ConstMemory> temp;
+            temp.reserve(count + 1);
+
+            if (pending)
+            {
+                temp.emplace_back(buffer.get(), pending);
+            }
+
+            u64 total = 0;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                temp.push_back(buffers[i]);
+                total += buffers[i].size;
+            }
+
+            u64 position = offset - pending;
+            setHandleOffset(position);
+
+            u64 written = handle.write(temp.data(), temp.size());
+            handle_offset += written;
+
+            u64 expected = pending + total;
+            u64 result = written > pending ? written - pending : 0;
+
+            // on failure the stream position is where the writing stopped
+            offset = written == expected ? offset + total : position + written;
+            pending = 0;
+
+            return result;
+        }
+
+        u64 write(const ConstMemory* buffers, size_t count)
+        {
+            if (mode != OpenMode::Write)
+            {
+                return 0;
+            }
+
+            u64 total = 0;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                total += buffers[i].size;
+            }
+
+            if (pending + total <= capacity)
+            {
+                // combine small writes in the buffer
+                for (size_t i = 0; i < count; ++i)
+                {
+                    std::memcpy(buffer.get() + pending, buffers[i].address, buffers[i].size);
+                    pending += buffers[i].size;
+                }
+
+                offset += total;
+                return total;
+            }
+
+            return writeBuffers(buffers, count);
+        }
+
+        u64 seek(s64 distance, SeekMode seekmode)
+        {
+            s64 position = 0;
+
+            switch (seekmode)
+            {
+                case SeekMode::Begin:
+                    position = distance;
+                    break;
+
+                case SeekMode::Current:
+                    position = s64(offset) + distance;
+                    break;
+
+                case SeekMode::End:
+                    position = s64(size()) + distance;
+                    break;
+            }
+
+            if (position < 0)
+            {
+                return 0;
+            }
+
+            if (u64(position) != offset)
+            {
+                // the pending data is written at the current position
+                writeBuffers(nullptr, 0);
+                offset = u64(position);
+            }
+
+            return offset;
+        }
+    };
+
+    FileStream::FileStream(const std::string& filename, OpenMode mode, size_t buffer_size)
+        : m_state(std::make_unique<State>(filename, mode, buffer_size))
+    {
+    }
+
+    FileStream::~FileStream()
+    {
+    }
+
+    const std::string& FileStream::filename() const
+    {
+        return m_state->handle.filename();
+    }
+
+    void FileStream::flush()
+    {
+        u64 position = m_state->offset;
+        m_state->writeBuffers(nullptr, 0);
+
+        if (m_state->offset != position)
+        {
+            MANGO_EXCEPTION("[FileStream] Writing \"{}\" failed.", filename());
+        }
+    }
+
+    u64 FileStream::size() const
+    {
+        return m_state->size();
+    }
+
+    u64 FileStream::offset() const
+    {
+        return m_state->offset;
+    }
+
+    u64 FileStream::seek(s64 distance, SeekMode mode)
+    {
+        return m_state->seek(distance, mode);
+    }
+
+    u64 FileStream::read(void* dest, u64 bytes)
+    {
+        return m_state->read(dest, bytes);
+    }
+
+    u64 FileStream::write(const void* data, u64 bytes)
+    {
+        ConstMemory memory(reinterpret_cast<const u8*>(data), size_t(bytes));
+        return m_state->write(&memory, 1);
+    }
+
+    u64 FileStream::write(const ConstMemory* buffers, size_t count)
+    {
+        return m_state->write(buffers, count);
+    }
+
 } // namespace mango::filesystem
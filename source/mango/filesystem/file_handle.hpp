@@ -0,0 +1,61 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include <string>
+#include <mango/core/configure.hpp>
+#include <mango/core/memory.hpp>
+#include <mango/core/stream.hpp>
+
+namespace mango::filesystem
+{
+
+    // -----------------------------------------------------------------
+    // FileHandle
+    // -----------------------------------------------------------------
+
+    // Unbuffered file I/O primitives for the FileStream; the implementation is
+    // platform specific. The buffering is done in the FileStream.
+
+    struct FileHandle : protected NonCopyable
+    {
+#if defined(MANGO_PLATFORM_WINDOWS)
+        HANDLE m_handle;
+#else
+        int m_file;
+#endif
+        std::string m_filename;
+
+        FileHandle(const std::string& filename, Stream::OpenMode mode);
+        ~FileHandle();
+
+        const std::string& filename() const
+        {
+            return m_filename;
+        }
+
+        bool isOpen() const
+        {
+#if defined(MANGO_PLATFORM_WINDOWS)
+            return m_handle != INVALID_HANDLE_VALUE;
+#else
+            return m_file != -1;
+#endif
+        }
+
+        u64 size() const;
+
+        // set absolute position
+        bool seek(u64 offset);
+
+        // scatter read into the buffers in order; returns number of bytes read which is
+        // less than the total size of the buffers only at the end of file or error
+        u64 read(const Memory* buffers, size_t count);
+
+        // gather write from the buffers in order; returns number of bytes written
+        u64 write(const ConstMemory* buffers, size_t count);
+    };
+
+} // namespace mango::filesystem
@@ -1,60 +1,443 @@
 /*
     MANGO Multimedia Development Platform
-    Copyright (C) 2012-2021 Twilight Finland 3D Oy Ltd. All rights reserved.
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
 #pragma once
 
 #include <string>
-#include <map>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <type_traits>
+#include <mango/core/configure.hpp>
+#include <mango/core/memory.hpp>
+#include <mango/core/bits.hpp>
+#include <mango/core/buffer.hpp>
+#include <mango/core/hash.hpp>
+#include <mango/core/stream.hpp>
+#include <mango/core/pointer.hpp>
 
 namespace mango::filesystem
 {
 
+    // persistent index cache (see Mapper::setIndexCache); the key must identify the archive contents
+    bool isIndexCacheEnabled();
+    std::unique_ptr<VirtualMemory> loadIndexCache(const XX3H128& key);
+    void saveIndexCache(const XX3H128& key, ConstMemory memory);
+
+    /*
+        Indexer is a compact, read-only path index for the archive mappers.
+
+        The folder names are interned and the file names are stored once into a single
+        string arena; a full path is never stored. The entries are sorted by (folder, name)
+        into flat arrays so that the files in a folder are a contiguous range and a lookup
+        is two binary searches without memory allocations.
+
+        The index is built in two phases: insert() all entries, then call build() once
+        before any lookups. When the same path is inserted multiple times the last header wins.
+
+        When the Header is trivially copyable the built index can be saved into the index cache
+        and later loaded from it; the loaded index is used in place from the memory mapped
+        cache file without parsing the archive.
+    */
+
     template <typename Header>
     class Indexer
     {
     public:
         struct Folder
         {
-            std::map<std::string, Header *> headers;
+            u32 name_offset;
+            u32 name_length;
+            u32 first; // index of the first entry in the folder
+            u32 last;  // one past the last entry in the folder
         };
 
     protected:
-        std::map<std::string, Folder> folders;
-        std::map<std::string, Header> headers;
+        struct Entry
+        {
+            u32 folder;
+            u32 name_offset;
+            u32 name_length;
+        };
+
+        static constexpr u32 cache_version = 1;
+        static constexpr size_t cache_header_size = 40;
+
+        std::string m_names; // string arena
+        std::vector<Folder> m_folders;
+        std::vector<Entry> m_entries;
+        std::vector<Header> m_headers;
+
+        // only used while inserting
+        std::unordered_map<std::string, u32> m_folder_map;
+
+        // the index is used through these; they point to the arrays above or into the cache
+        const char* m_name_data = nullptr;
+        const Folder* m_folder_data = nullptr;
+        const Entry* m_entry_data = nullptr;
+        const Header* m_header_data = nullptr;
+        size_t m_name_size = 0;
+        size_t m_folder_count = 0;
+        size_t m_entry_count = 0;
+
+        std::unique_ptr<VirtualMemory> m_cache;
+
+        std::string_view getString(u32 offset, u32 length) const
+        {
+            return std::string_view(m_name_data + offset, length);
+        }
+
+        static size_t align8(size_t offset)
+        {
+            return (offset + 7) & ~size_t(7);
+        }
+
+        void computeLayout(size_t* offsets) const
+        {
+            // cache file layout: header, folders, entries, headers, names
+            offsets[0] = cache_header_size;
+            offsets[1] = align8(offsets[0] + m_folder_count * sizeof(Folder));
+            offsets[2] = align8(offsets[1] + m_entry_count * sizeof(Entry));
+            offsets[3] = align8(offsets[2] + m_entry_count * sizeof(Header));
+            offsets[4] = offsets[3] + m_name_size;
+        }
+
+        u32 intern(std::string_view name)
+        {
+            u32 offset = u32(m_names.size());
+            m_names.append(name);
+            return offset;
+        }
+
+        static void split(std::string_view filename, std::string_view& folder, std::string_view& name)
+        {
+            // "foo/bar/" -> "foo/" + "bar/", "foo/bar.txt" -> "foo/" + "bar.txt"
+            size_t n = filename.length();
+            size_t index = n > 1 ? filename.find_last_of('/', n - 2) : std::string_view::npos;
+            size_t length = index != std::string_view::npos ? index + 1 : 0;
+            folder = filename.substr(0, length);
+            name = filename.substr(length);
+        }
+
+        const Folder* findFolder(std::string_view pathname) const
+        {
+            const Folder* begin = m_folder_data;
+            const Folder* end = m_folder_data + m_folder_count;
+
+            auto i = std::lower_bound(begin, end, pathname,
+                [this] (const Folder& folder, std::string_view value)
+                {
+                    return getString(folder.name_offset, folder.name_length) < value;
+                });
+
+            if (i != end && getString(i->name_offset, i->name_length) == pathname)
+            {
+                return i;
+            }
+
+            return nullptr;
+        }
 
     public:
+        // true when the folder already has entries; valid only before build()
+        bool hasFolder(const std::string& foldername) const
+        {
+            return m_folder_map.find(foldername) != m_folder_map.end();
+        }
+
         void insert(const std::string& foldername, const std::string& filename, const Header& header)
         {
-            Header* ptr = &headers[filename];
-            *ptr = header;
-            folders[foldername].headers.emplace(filename, ptr);
+            auto i = m_folder_map.find(foldername);
+            if (i == m_folder_map.end())
+            {
+                Folder folder;
+                folder.name_offset = intern(foldername);
+                folder.name_length = u32(foldername.length());
+                folder.first = 0;
+                folder.last = 0;
+
+                i = m_folder_map.emplace(foldername, u32(m_folders.size())).first;
+                m_folders.push_back(folder);
+            }
+
+            std::string_view name = std::string_view(filename).substr(foldername.length());
+
+            Entry entry;
+            entry.folder = i->second;
+            entry.name_offset = intern(name);
+            entry.name_length = u32(name.length());
+
+            m_entries.push_back(entry);
+            m_headers.push_back(header);
+        }
+
+        void build()
+        {
+            m_folder_map = std::unordered_map<std::string, u32>();
+            m_name_data = m_names.data();
+
+            // sort the folders by name and remap the entries to the sorted order
+            std::vector<u32> order(m_folders.size());
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                order[i] = u32(i);
+            }
+
+            std::sort(order.begin(), order.end(), [this] (u32 a, u32 b)
+            {
+                const Folder& fa = m_folders[a];
+                const Folder& fb = m_folders[b];
+                return getString(fa.name_offset, fa.name_length) < getString(fb.name_offset, fb.name_length);
+            });
+
+            std::vector<Folder> folders(m_folders.size());
+            std::vector<u32> remap(m_folders.size());
+
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                folders[i] = m_folders[order[i]];
+                remap[order[i]] = u32(i);
+            }
+
+            m_folders.swap(folders);
+
+            for (auto& entry : m_entries)
+            {
+                entry.folder = remap[entry.folder];
+            }
+
+            // sort the entries by (folder, name); stable so that the last duplicate is the newest
+            std::vector<u32> sorted(m_entries.size());
+            for (size_t i = 0; i < sorted.size(); ++i)
+            {
+                sorted[i] = u32(i);
+            }
+
+            auto less = [this] (u32 a, u32 b)
+            {
+                const Entry& ea = m_entries[a];
+                const Entry& eb = m_entries[b];
+                if (ea.folder != eb.folder)
+                {
+                    return ea.folder < eb.folder;
+                }
+                return getString(ea.name_offset, ea.name_length) < getString(eb.name_offset, eb.name_length);
+            };
+
+            std::stable_sort(sorted.begin(), sorted.end(), less);
+
+            std::vector<Entry> entries;
+            std::vector<Header> headers;
+
+            entries.reserve(sorted.size());
+            headers.reserve(sorted.size());
+
+            for (size_t i = 0; i < sorted.size(); ++i)
+            {
+                if (i + 1 < sorted.size() && !less(sorted[i], sorted[i + 1]))
+                {
+                    // duplicate path; keep the last one
+                    continue;
+                }
+
+                entries.push_back(m_entries[sorted[i]]);
+                headers.push_back(std::move(m_headers[sorted[i]]));
+            }
+
+            m_entries.swap(entries);
+            m_headers.swap(headers);
+
+            m_entries.shrink_to_fit();
+            m_headers.shrink_to_fit();
+            m_names.shrink_to_fit();
+
+            // compute the folder ranges
+            for (auto& folder : m_folders)
+            {
+                folder.first = 0;
+                folder.last = 0;
+            }
+
+            for (size_t i = 0; i < m_entries.size(); ++i)
+            {
+                Folder& folder = m_folders[m_entries[i].folder];
+                if (folder.first == folder.last)
+                {
+                    folder.first = u32(i);
+                }
+                folder.last = u32(i + 1);
+            }
+
+            m_name_data = m_names.data();
+            m_folder_data = m_folders.data();
+            m_entry_data = m_entries.data();
+            m_header_data = m_headers.data();
+            m_name_size = m_names.size();
+            m_folder_count = m_folders.size();
+            m_entry_count = m_entries.size();
         }
 
-        const Folder* getFolder(const std::string& pathname) const
+        // load a previously saved index from the cache; returns false when there is no valid cache
+        bool load(const XX3H128& key)
         {
-            const Folder* result = nullptr; // default: not found
+            static_assert(std::is_trivially_copyable_v<Header>, "Header must be trivially copyable.");
+            static_assert(alignof(Header) <= 8, "Header alignment must be 8 bytes or less.");
 
-            auto i = folders.find(pathname);
-            if (i != folders.end())
+            std::unique_ptr<VirtualMemory> cache = loadIndexCache(key);
+            if (!cache)
             {
-                result = &i->second;
+                return false;
             }
 
-            return result;
+            ConstMemory memory = *cache;
+            if (memory.size < cache_header_size)
+            {
+                return false;
+            }
+
+            LittleEndianConstPointer p = memory.address;
+
+            u32 magic = p.read32();
+            u32 version = p.read32();
+            u32 header_size = p.read32();
+            u32 folder_count = p.read32();
+            u32 entry_count = p.read32();
+            u32 name_size = p.read32();
+            u64 key0 = p.read64();
+            u64 key1 = p.read64();
+
+            if (magic != u32_mask('m', 'i', 'd', 'x') || version != cache_version ||
+                header_size != sizeof(Header) || key0 != key[0] || key1 != key[1])
+            {
+                return false;
+            }
+
+            m_name_size = name_size;
+            m_folder_count = folder_count;
+            m_entry_count = entry_count;
+
+            size_t offsets[5];
+            computeLayout(offsets);
+
+            if (offsets[4] > memory.size)
+            {
+                m_name_size = 0;
+                m_folder_count = 0;
+                m_entry_count = 0;
+                return false;
+            }
+
+            const Folder* folders = reinterpret_cast<const Folder*>(memory.address + offsets[0]);
+            const Entry* entries = reinterpret_cast<const Entry*>(memory.address + offsets[1]);
+
+            // validate the ranges so that a damaged cache file cannot cause out of bounds access
+            bool valid = true;
+
+            for (size_t i = 0; i < folder_count; ++i)
+            {
+                const Folder& folder = folders[i];
+                valid &= folder.first <= folder.last && folder.last <= entry_count;
+                valid &= u64(folder.name_offset) + folder.name_length <= name_size;
+            }
+
+            for (size_t i = 0; i < entry_count; ++i)
+            {
+                const Entry& entry = entries[i];
+                valid &= entry.folder < folder_count;
+                valid &= u64(entry.name_offset) + entry.name_length <= name_size;
+            }
+
+            if (!valid)
+            {
+                m_name_size = 0;
+                m_folder_count = 0;
+                m_entry_count = 0;
+                return false;
+            }
+
+            m_folder_data = folders;
+            m_entry_data = entries;
+            m_header_data = reinterpret_cast<const Header*>(memory.address + offsets[2]);
+            m_name_data = reinterpret_cast<const char*>(memory.address + offsets[3]);
+            m_cache = std::move(cache);
+
+            return true;
+        }
+
+        // save the built index into the cache
+        void save(const XX3H128& key) const
+        {
+            static_assert(std::is_trivially_copyable_v<Header>, "Header must be trivially copyable.");
+
+            size_t offsets[5];
+            computeLayout(offsets);
+
+            Buffer buffer(offsets[4], 0);
+            LittleEndianPointer p = buffer.data();
+
+            p.write32(u32_mask('m', 'i', 'd', 'x'));
+            p.write32(cache_version);
+            p.write32(u32(sizeof(Header)));
+            p.write32(u32(m_folder_count));
+            p.write32(u32(m_entry_count));
+            p.write32(u32(m_name_size));
+            p.write64(key[0]);
+            p.write64(key[1]);
+
+            std::memcpy(buffer.data() + offsets[0], m_folder_data, m_folder_count * sizeof(Folder));
+            std::memcpy(buffer.data() + offsets[1], m_entry_data, m_entry_count * sizeof(Entry));
+            std::memcpy(buffer.data() + offsets[2], m_header_data, m_entry_count * sizeof(Header));
+            std::memcpy(buffer.data() + offsets[3], m_name_data, m_name_size);
+
+            saveIndexCache(key, buffer);
         }
 
-        const Header* getHeader(const std::string& filename) const
+        const Folder* getFolder(std::string_view pathname) const
         {
-            const Header* result = nullptr; // default: not found
+            return findFolder(pathname);
+        }
+
+        const Header* getHeader(std::string_view filename) const
+        {
+            std::string_view foldername;
+            std::string_view name;
+            split(filename, foldername, name);
+
+            const Folder* folder = findFolder(foldername);
+            if (!folder)
+            {
+                return nullptr;
+            }
+
+            const Entry* begin = m_entry_data + folder->first;
+            const Entry* end = m_entry_data + folder->last;
+
+            auto i = std::lower_bound(begin, end, name, [this] (const Entry& entry, std::string_view value)
+            {
+                return getString(entry.name_offset, entry.name_length) < value;
+            });
 
-            auto i = headers.find(filename);
-            if (i != headers.end())
+            if (i != end && getString(i->name_offset, i->name_length) == name)
             {
-                result = &i->second;
+                return m_header_data + (i - m_entry_data);
             }
 
-            return result;
+            return nullptr;
+        }
+
+        // folder entries are in the range [folder.first, folder.last)
+
+        std::string_view getName(u32 index) const
+        {
+            const Entry& entry = m_entry_data[index];
+            return getString(entry.name_offset, entry.name_length);
+        }
+
+        const Header& getHeader(u32 index) const
+        {
+            return m_header_data[index];
         }
     };
 
@@ -2,12 +2,18 @@
     MANGO Multimedia Development Platform
     Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
+#include <cstdio>
 #include <vector>
+#include <mutex>
 #include <algorithm>
 #include <string_view>
 #include <mango/core/string.hpp>
+#include <mango/core/timer.hpp>
+#include <mango/core/exception.hpp>
 #include <mango/filesystem/mapper.hpp>
 #include <mango/filesystem/path.hpp>
+#include <mango/filesystem/file.hpp>
+#include "indexer.hpp"
 
 namespace mango::filesystem
 {
@@ -69,6 +75,88 @@ namespace mango::filesystem
         return nullptr;
     }
 
+    // -----------------------------------------------------------------
+    // index cache
+    // -----------------------------------------------------------------
+
+    static std::mutex g_index_cache_mutex;
+    static std::string g_index_cache_folder;
+
+    static
+    std::string getIndexCacheFolder()
+    {
+        std::lock_guard<std::mutex> lock(g_index_cache_mutex);
+        return g_index_cache_folder;
+    }
+
+    static
+    std::string getIndexCacheFilename(const XX3H128& key)
+    {
+        return fmt::format("{:016x}{:016x}.index", key[0], key[1]);
+    }
+
+    bool isIndexCacheEnabled()
+    {
+        std::lock_guard<std::mutex> lock(g_index_cache_mutex);
+        return !g_index_cache_folder.empty();
+    }
+
+    std::unique_ptr<VirtualMemory> loadIndexCache(const XX3H128& key)
+    {
+        std::string folder = getIndexCacheFolder();
+        if (folder.empty())
+        {
+            return nullptr;
+        }
+
+        std::string filename = getIndexCacheFilename(key);
+
+        try
+        {
+            Mapper mapper(folder, "");
+            if (mapper.isFile(folder + filename))
+            {
+                return mapper.map(filename);
+            }
+        }
+        catch (Exception&)
+        {
+            // cache is not available; the caller will parse the archive
+        }
+
+        return nullptr;
+    }
+
+    void saveIndexCache(const XX3H128& key, ConstMemory memory)
+    {
+        std::string folder = getIndexCacheFolder();
+        if (folder.empty())
+        {
+            return;
+        }
+
+        // write into a temporary file first so that readers never see a partial cache file
+        std::string filename = folder + getIndexCacheFilename(key);
+        std::string temp = fmt::format("{}.{}.tmp", filename, Time::us());
+
+        try
+        {
+            OutputFileStream file(temp);
+            file.write(memory.address, memory.size);
+            file.flush();
+        }
+        catch (Exception&)
+        {
+            std::remove(temp.c_str());
+            return;
+        }
+
+        if (std::rename(temp.c_str(), filename.c_str()) != 0)
+        {
+            std::remove(temp.c_str());
+        }
+    }
+
     // -----------------------------------------------------------------
     // FileInfo
     // -----------------------------------------------------------------
@@ -258,6 +346,17 @@ namespace mango::filesystem
         return node != nullptr;
     }
 
+    void Mapper::setIndexCache(const std::string& folder)
+    {
+        std::lock_guard<std::mutex> lock(g_index_cache_mutex);
+
+        g_index_cache_folder = folder;
+        if (!folder.empty() && folder.back() != '/')
+        {
+            g_index_cache_folder += '/';
+        }
+    }
+
     const std::string& Mapper::basepath() const
     {
         return m_basepath;
@@ -300,4 +399,16 @@ namespace mango::filesystem
         return m_current_mapper->map(m_basepath + filename);
     }
 
+    std::unique_ptr<VirtualMemory> Mapper::map(const std::string& filename, MemoryAccess access)
+    {
+        std::unique_ptr<VirtualMemory> memory = map(filename);
+
+        if (memory && access != MemoryAccess::Normal)
+        {
+            memory->advise(access);
+        }
+
+        return memory;
+    }
+
 } // namespace mango::filesystem
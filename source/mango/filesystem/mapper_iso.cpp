@@ -2,14 +2,16 @@
     MANGO Multimedia Development Platform
     Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
-#include <map>
+#include <set>
 #include <algorithm>
 #include <mango/core/string.hpp>
 #include <mango/core/system.hpp>
 #include <mango/core/exception.hpp>
 #include <mango/core/pointer.hpp>
+#include <mango/core/hash.hpp>
 #include <mango/filesystem/mapper.hpp>
 #include <mango/filesystem/path.hpp>
+#include "indexer.hpp"
 
 // TODO: Check record flags why .img files in [BOOT] directory are not visible
 // TODO: Check that we add containers (.zip, rar, etc.) as files AND containers into the index
@@ -28,6 +30,12 @@ namespace
     using mango::u32;
     using mango::u64;
 
+    using mango::filesystem::Indexer;
+    using mango::filesystem::isIndexCacheEnabled;
+
+    // guard against malformed images with cyclic directory records
+    constexpr int max_directory_depth = 64;
+
     // -----------------------------------------------------------------
     // ISO 9660 structures
     // -----------------------------------------------------------------
@@ -325,13 +333,11 @@ namespace
     {
         u32 extent_location;
         u32 data_length;
-        std::string filename;
         bool is_directory;
 
-        FileEntry(u32 location, u32 length, const std::string& name, bool directory)
+        FileEntry(u32 location, u32 length, bool directory)
             : extent_location(location)
             , data_length(length)
-            , filename(name)
             , is_directory(directory)
         {
         }
@@ -377,7 +383,7 @@ namespace
         u32 m_joliet_root_extent;
         u32 m_joliet_root_length;
 
-        mutable std::map<std::string, std::vector<FileEntry>> m_directory_cache;
+        Indexer<FileEntry> m_folders;
 
         bool checkForRockRidge(const u8* dir_data, u32 data_length) const
         {
@@ -497,9 +503,30 @@ namespace
 #endif
         }
 
-        std::vector<FileEntry> parseDirectoryContents(const u8* dir_data, u32 data_length, bool use_joliet = false) const
+        ConstMemory getVolumeDescriptors() const
+        {
+            // volume descriptors start at sector 16 and end with the terminator
+            const u8* start = m_parent_memory.address + 0x8000;
+            const u8* end = m_parent_memory.end();
+            const u8* ptr = start;
+
+            for (int i = 0; i < 100 && ptr + 2048 <= end; ++i)
+            {
+                u8 type = ptr[0];
+                ptr += 2048;
+
+                if (type == VOLUME_DESCRIPTOR_SET_TERMINATOR)
+                {
+                    break;
+                }
+            }
+
+            return ConstMemory(start, ptr - start);
+        }
+
+        void parseDirectoryContents(const std::string& pathname, const u8* dir_data, u32 data_length,
+                                    std::set<u32>& visited, int depth, bool use_joliet = false)
         {
-            std::vector<FileEntry> entries;
             const u8* ptr = dir_data;
             const u8* end = dir_data + data_length;
 
@@ -567,125 +594,23 @@ namespace
                     filename += "/";
                 }
 
-                entries.emplace_back(extent_location, data_length, filename, is_directory);
-                ptr += record_length;
-            }
-
-            return entries;
-        }
-
-        std::vector<FileEntry> getDirectoryEntries(const std::string& pathname) const
-        {
-            // Check cache first
-            auto it = m_directory_cache.find(pathname);
-            if (it != m_directory_cache.end())
-            {
-                return it->second;
-            }
-
-            // Safety check to prevent infinite recursion
-            static int recursion_count = 0;
-            recursion_count++;
-            if (recursion_count > 100)  // Back to normal limit
-            {
-                recursion_count = 0;
-                return std::vector<FileEntry>();
-            }
-
-            std::vector<FileEntry> entries;
+                filename = pathname + filename;
+                m_folders.insert(pathname, filename, FileEntry(extent_location, data_length, is_directory));
 
-            if (pathname.empty() || pathname == "/" || pathname == "\\")
-            {
-                // Root directory - use standard ISO 9660 for now
-                const u8* root_dir_data = m_parent_memory.address + (m_root_extent * m_logical_block_size);
-                entries = parseDirectoryContents(root_dir_data, m_root_length, false);
-            }
-            else
-            {
-                // Handle path parsing for virtual filesystem
-                // For "POOL/MAIN/", we want to find "MAIN" in the "POOL/" directory
-                // Custom path parsing for container paths that end with slashes
-                std::string parent_path;
-                std::string dir_name;
-                
-                if (pathname.empty())
+                // a directory extent is parsed only once; malformed images can have records
+                // pointing back to their own or a parent extent
+                if (is_directory && depth < max_directory_depth && visited.insert(extent_location).second)
                 {
-                    parent_path = "";
-                    dir_name = "";
-                }
-                else if (pathname == "/" || pathname == "\\")
-                {
-                    parent_path = "";
-                    dir_name = "";
-                }
-                else
-                {
-                    // Find the second-to-last slash for multi-level paths
-                    size_t last_slash = pathname.find_last_of("/\\");
-                    if (last_slash != std::string::npos && last_slash > 0)
-                    {
-                        // Look for the previous slash
-                        size_t prev_slash = pathname.find_last_of("/\\", last_slash - 1);
-                        if (prev_slash != std::string::npos)
-                        {
-                            // Multi-level path: "POOL/MAIN/" -> parent="POOL/", dir="MAIN/"
-                            parent_path = pathname.substr(0, prev_slash + 1);
-                            dir_name = pathname.substr(prev_slash + 1);
-                        }
-                        else
-                        {
-                            // Single-level path: "POOL/" -> parent="", dir="POOL/"
-                            parent_path = "";
-                            dir_name = pathname;
-                        }
-                    }
-                    else
+                    u64 offset = u64(extent_location) * m_logical_block_size;
+                    if (offset + data_length <= m_parent_memory.size)
                     {
-                        // No slashes or only trailing slash
-                        parent_path = "";
-                        dir_name = pathname;
+                        const u8* data = m_parent_memory.address + offset;
+                        parseDirectoryContents(filename, data, data_length, visited, depth + 1, use_joliet);
                     }
                 }
 
-                // Remove trailing slash from dir_name for lookup
-                if (!dir_name.empty() && dir_name.back() == '/')
-                {
-                    dir_name.pop_back();
-                }
-
-                // Get parent directory entries
-                auto parent_entries = getDirectoryEntries(parent_path);
-
-                // Find the requested directory
-                bool found = false;
-                for (const auto& entry : parent_entries)
-                {
-                    // Remove trailing slash from entry name for comparison
-                    std::string entry_name = entry.filename;
-                    if (!entry_name.empty() && entry_name.back() == '/')
-                    {
-                        entry_name.pop_back();
-                    }
-
-                    if (entry_name == dir_name)
-                    {
-                        if (entry.is_directory)
-                        {
-                            const u8* dir_data = m_parent_memory.address + (entry.extent_location * m_logical_block_size);
-                            
-                            // Use standard ISO 9660 parsing
-                            entries = parseDirectoryContents(dir_data, entry.data_length, false);
-                            found = true;
-                        }
-                        break;
-                    }
-                }
+                ptr += record_length;
             }
-
-            // Cache the results
-            m_directory_cache[pathname] = entries;
-            recursion_count--;
-            return entries;
         }
 
     public:
@@ -712,6 +637,34 @@ namespace
                     {
                         printLine(Print::Info, "[ISO] Valid ISO 9660 image detected");
                         parseVolumeDescriptors();
+
+                        // the volume descriptors identify the image contents for the index cache
+                        bool cache = isIndexCacheEnabled();
+
+                        XX3H128 key;
+                        if (cache)
+                        {
+                            key = xx3hash128(parent.size, getVolumeDescriptors());
+                            cache = !m_folders.load(key);
+                        }
+
+                        if (!m_folders.getFolder(""))
+                        {
+                            // index the whole directory tree up front so that lookups don't parse directories
+                            u64 offset = u64(m_root_extent) * m_logical_block_size;
+                            if (offset + m_root_length <= parent.size)
+                            {
+                                std::set<u32> visited { m_root_extent };
+                                parseDirectoryContents("", parent.address + offset, m_root_length, visited, 0);
+                            }
+
+                            m_folders.build();
+
+                            if (cache)
+                            {
+                                m_folders.save(key);
+                            }
+                        }
                         
                         if (m_has_joliet)
                         {
@@ -736,74 +689,68 @@ namespace
 
         u64 getSize(const std::string& filename) const override
         {
-            std::string pathname = mango::filesystem::getPath(filename);
-            std::string name = filename.substr(pathname.length());
-            
-            auto entries = getDirectoryEntries(pathname);
-            for (const auto& entry : entries)
+            const FileEntry* entry = m_folders.getHeader(filename);
+            if (entry)
             {
-                if (entry.filename == name)
-                {
-                    return entry.data_length;
-                }
+                return entry->data_length;
             }
             return 0;
         }
 
         bool isFile(const std::string& filename) const override
         {
-            std::string pathname = mango::filesystem::getPath(filename);
-            std::string name = filename.substr(pathname.length());
-            
-            auto entries = getDirectoryEntries(pathname);
-            for (const auto& entry : entries)
+            const FileEntry* entry = m_folders.getHeader(filename);
+            if (entry)
             {
-                if (entry.filename == name)
-                {
-                    return !entry.is_directory;
-                }
+                return !entry->is_directory;
             }
             return false;
         }
 
         void getIndex(mango::filesystem::FileIndex& index, const std::string& pathname) override
         {
-            auto entries = getDirectoryEntries(pathname);
-
-            for (const auto& entry : entries)
+            // the root folder can also be referred to as "/" or "\\"
+            std::string_view folder_name = pathname;
+            if (pathname == "/" || pathname == "\\")
             {
-                u32 flags = 0;
-                u64 size = entry.data_length;
+                folder_name = "";
+            }
 
-                if (entry.is_directory)
+            const Indexer<FileEntry>::Folder* folder = m_folders.getFolder(folder_name);
+            if (folder)
+            {
+                for (u32 i = folder->first; i < folder->last; ++i)
                 {
-                    flags |= mango::filesystem::FileInfo::Directory;
-                    size = 0;
-                }
+                    const FileEntry& entry = m_folders.getHeader(i);
+
+                    u32 flags = 0;
+                    u64 size = entry.data_length;
 
-                index.emplace(entry.filename, size, flags);
+                    if (entry.is_directory)
+                    {
+                        flags |= mango::filesystem::FileInfo::Directory;
+                        size = 0;
+                    }
+
+                    index.emplace(std::string(m_folders.getName(i)), size, flags);
+                }
             }
         }
 
         std::unique_ptr<mango::VirtualMemory> map(const std::string& filename) override
         {
-            std::string pathname = mango::filesystem::getPath(filename);
-            std::string name = filename.substr(pathname.length());
-            
-            auto entries = getDirectoryEntries(pathname);
-            for (const auto& entry : entries)
+            const FileEntry* entry = m_folders.getHeader(filename);
+            if (!entry)
             {
-                if (entry.filename == name)
-                {
-                    if (entry.is_directory)
-                    {
-                        MANGO_EXCEPTION("[mapper.iso] Cannot map directory \"{}\".", filename);
-                    }
-                    return entry.map(m_parent_memory.address, m_logical_block_size);
-                }
+                MANGO_EXCEPTION("[mapper.iso] File \"{}\" not found.", filename);
+            }
+
+            if (entry->is_directory)
+            {
+                MANGO_EXCEPTION("[mapper.iso] Cannot map directory \"{}\".", filename);
             }
 
-            MANGO_EXCEPTION("[mapper.iso] File \"{}\" not found.", filename);
+            return entry->map(m_parent_memory.address, m_logical_block_size);
         }
     };
 
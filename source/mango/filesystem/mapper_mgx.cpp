@@ -2,11 +2,70 @@
     MANGO Multimedia Development Platform
     Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
+#include <map>
+#include <set>
+#include <deque>
 #include <mango/core/core.hpp>
 #include <mango/filesystem/filesystem.hpp>
 #include <mango/image/fourcc.hpp>
 #include "indexer.hpp"
 
+/*
+
+    --------------------------------------------------------------------------
+    File Format Types:
+    --------------------------------------------------------------------------
+
+    Type[]:
+        u32         count
+        Type        data[count]
+
+    Block:
+        u64         offset
+        u64         compressed
+        u64         uncompressed
+        u32         compression method (version 2: bit 16 is set when compressed with the dictionary)
+
+    Segment:
+        u32         block_index
+        u32         offset
+        u32         size
+
+    File:
+        char[]      filename
+        u64         size
+        u32         checksum
+        Segment[]   segments
+
+    --------------------------------------------------------------------------
+    File Format Structure:
+    --------------------------------------------------------------------------
+
+    Compressed block data:
+        u32         magic: mgx0
+        u8[]        data     <-- written by the compressor, a raw binary blob w/o specific size or structure
+
+    Block Info Array:
+        u32         magic: mgx1
+        block[]     blocks
+        u32         dictionary compression method (version 2: 0 means no dictionary)
+        u32         dictionary size (version 2)
+        u8[]        dictionary (version 2)
+
+    File Info Array:
+        u32         magic: mgx2
+        u64         compressed size (file array)
+        u64         uncmpressed size (file array)
+        File[]      files (compressed with zstd)
+
+    Header:
+        u32         magic: mgx3
+        u32         version
+        u64         offset to block info array
+        u64         offset to file info array
+
+*/
+
 namespace
 {
     using namespace mango;
@@ -14,6 +73,9 @@ namespace
 
     static constexpr u64 mgx_header_size = 24;
 
+    // block is compressed with the archive dictionary (version 2)
+    static constexpr u32 mgx_block_dictionary = 0x10000;
+
     struct Segment
     {
         u32 block;
@@ -26,12 +88,20 @@ namespace
         ConstMemory compressed;
         u64 uncompressed;
         u32 method;
+        const DictionaryDecoder* dictionary = nullptr;
 
         void decompress(Memory dest) const
         {
             assert(dest.size == uncompressed);
-            Compressor compressor = getCompressor(Compressor::Method(method));
-            compressor.decompress(dest, compressed);
+            if (dictionary)
+            {
+                dictionary->decompress(dest, compressed);
+            }
+            else
+            {
+                Compressor compressor = getCompressor(Compressor::Method(method));
+                compressor.decompress(dest, compressed);
+            }
         }
     };
 
@@ -41,7 +111,6 @@ namespace
         u32 checksum;
         bool is_compressed;
         std::vector<Segment> segments;
-        std::string filename;
 
         bool isCompressed() const
         {
@@ -64,6 +133,7 @@ namespace
         ConstMemory m_memory;
         fs::Indexer<FileHeader> m_folders;
         std::vector<Block> m_blocks;
+        std::shared_ptr<DictionaryDecoder> m_dictionary;
 
         HeaderMGX(ConstMemory memory)
             : m_memory(memory)
@@ -96,17 +166,15 @@ namespace
             u64 block_offset = p.read64();
             u64 file_offset = p.read64();
 
-            parseBlocks(memory.address + block_offset);
+            parseBlocks(memory.address + block_offset, version);
             parseFiles(memory.address + file_offset);
-
-            MANGO_UNREFERENCED(version);
         }
 
         ~HeaderMGX()
         {
         }
 
-        void parseBlocks(LittleEndianConstPointer p)
+        void parseBlocks(LittleEndianConstPointer p, u32 version)
         {
             u32 magic1 = p.read32();
             if (magic1 != u32_mask('m', 'g', 'x', '1'))
@@ -128,6 +196,30 @@ namespace
                 m_blocks.push_back(block);
             }
 
+            if (version >= 2)
+            {
+                // optional archive dictionary
+                u32 method = p.read32();
+                u32 size = p.read32();
+
+                if (method)
+                {
+                    ConstMemory dictionary(p, size);
+                    m_dictionary = createDictionaryDecoder(Compressor::Method(method), dictionary);
+
+                    for (auto& block : m_blocks)
+                    {
+                        if (block.method & mgx_block_dictionary)
+                        {
+                            block.method &= ~mgx_block_dictionary;
+                            block.dictionary = m_dictionary.get();
+                        }
+                    }
+                }
+
+                p += size;
+            }
+
             u32 magic2 = p.read32();
             if (magic2 != u32_mask('m', 'g', 'x', '2'))
             {
@@ -203,9 +295,10 @@ namespace
                     fs::getPath(filename.substr(0, length - 1)) :
                     fs::getPath(filename);
 
-                header.filename = filename.substr(folder.length());
                 m_folders.insert(folder, filename, header);
             }
+
+            m_folders.build();
         }
     };
 
@@ -286,9 +379,9 @@ namespace mango::filesystem
             const fs::Indexer<FileHeader>::Folder* folder = m_header.m_folders.getFolder(pathname);
             if (folder)
             {
-                for (auto i : folder->headers)
+                for (u32 i = folder->first; i < folder->last; ++i)
                 {
-                    const FileHeader& header = *i.second;
+                    const FileHeader& header = m_header.m_folders.getHeader(i);
 
                     u32 flags = 0;
 
@@ -302,7 +395,7 @@ namespace mango::filesystem
                         flags |= FileInfo::Compressed;
                     }
 
-                    index.emplace(header.filename, header.size, flags, header.checksum);
+                    index.emplace(std::string(m_header.m_folders.getName(i)), header.size, flags, header.checksum);
                 }
             }
         }
@@ -428,4 +521,474 @@ namespace mango::filesystem
         return mapper;
     }
 
+    // -----------------------------------------------------------------
+    // ArchiveWriterMGX
+    // -----------------------------------------------------------------
+
+    struct ArchiveWriterMGX::State
+    {
+        static constexpr u64 KB = 1 << 10;
+        static constexpr u64 MB = 1 << 20;
+
+        // block policy
+        static constexpr u64 large_block_size = 4 * MB;
+        static constexpr u64 small_file_max_size = 512 * KB;
+        static constexpr u64 small_block_size = 2 * MB;
+
+        struct BlockInfo
+        {
+            u64 offset = 0;
+            u64 compressed = 0;
+            u64 uncompressed = 0;
+            u32 method = 0;
+        };
+
+        struct FileInfo
+        {
+            std::string filename;
+            u64 size;
+            u32 checksum;
+            std::vector<Segment> segments;
+        };
+
+        struct SmallBlock
+        {
+            u32 index;
+            std::shared_ptr<Buffer> buffer;
+        };
+
+        std::unique_ptr<Stream> m_file;
+        Stream& m_output;
+
+        Compressor::Method m_method;
+        int m_level;
+        u64 m_store_threshold = 95; // percent
+
+        Buffer m_dictionary;
+        Compressor::Method m_dictionary_method = Compressor::NONE;
+        std::shared_ptr<DictionaryEncoder> m_encoder;
+
+        // the blocks are referenced by the compression tasks so they must not move in memory
+        std::deque<BlockInfo> m_blocks;
+        std::vector<FileInfo> m_files;
+        std::map<u32, SmallBlock> m_small_blocks; // pending small block for each method
+        std::map<std::pair<u64, u64>, size_t> m_contents; // content hash -> file index
+        std::set<std::string> m_folders;
+
+        ConcurrentQueue m_queue { "mgx.compressor" };
+        TicketQueue m_tickets;
+
+        std::atomic<u64> m_pending_bytes { 0 };
+        u64 m_pending_limit;
+
+        bool m_finished = false;
+
+        State(std::unique_ptr<Stream> file, Stream& output, Compressor::Method method, int level)
+            : m_file(std::move(file))
+            , m_output(output)
+            , m_method(method)
+            , m_level(level)
+        {
+            // limit the memory used by the blocks waiting to be compressed and written
+            m_pending_limit = std::max(u64(64 * MB), ThreadPool::getHardwareConcurrency() * large_block_size * 2);
+
+            LittleEndianStream s = m_output;
+            s.write32(u32_mask('m', 'g', 'x', '0'));
+        }
+
+        ~State()
+        {
+        }
+
+        void setDictionary(ConstMemory dictionary)
+        {
+            if (!m_files.empty())
+            {
+                MANGO_EXCEPTION("[ArchiveWriterMGX] The dictionary must be set before adding files.");
+            }
+
+            m_encoder = createDictionaryEncoder(m_method, dictionary, m_level);
+            m_dictionary.reset(dictionary.size);
+            std::memcpy(m_dictionary.data(), dictionary.address, dictionary.size);
+            m_dictionary_method = m_method;
+        }
+
+        u32 createBlock()
+        {
+            u32 index = u32(m_blocks.size());
+            m_blocks.emplace_back();
+            return index;
+        }
+
+        void submit(u32 index, std::shared_ptr<Buffer> buffer, Compressor::Method method, bool dictionary)
+        {
+            // back-pressure: help the compressors until there is room for more blocks
+            while (m_pending_bytes > m_pending_limit)
+            {
+                m_queue.steal();
+                std::this_thread::yield();
+            }
+
+            m_pending_bytes += buffer->size();
+
+            BlockInfo* block = &m_blocks[index];
+            auto ticket = m_tickets.acquire();
+
+            m_queue.enqueue([this, block, buffer, method, dictionary, ticket]
+            {
+                ConstMemory uncompressed = *buffer;
+                std::shared_ptr<Buffer> output;
+                u32 block_method = Compressor::NONE;
+
+                if (method != Compressor::NONE && uncompressed.size > 0 && m_store_threshold > 0)
+                {
+                    CompressionStatus status;
+
+                    if (dictionary)
+                    {
+                        output = std::make_shared<Buffer>(m_encoder->bound(uncompressed.size));
+                        status = m_encoder->compress(*output, uncompressed);
+                        block_method = method | mgx_block_dictionary;
+                    }
+                    else
+                    {
+                        Compressor compressor = getCompressor(method);
+                        output = std::make_shared<Buffer>(compressor.bound(uncompressed.size));
+                        status = compressor.compress(*output, uncompressed, m_level);
+                        block_method = method;
+                    }
+
+                    if (!status || status.size > uncompressed.size * m_store_threshold / 100)
+                    {
+                        // doesn't compress -> store
+                        output.reset();
+                    }
+                    else
+                    {
+                        output->resize(status.size);
+                    }
+                }
+
+                if (!output)
+                {
+                    output = buffer;
+                    block_method = Compressor::NONE;
+                }
+
+                ticket.consume([this, block, buffer, output, block_method]
+                {
+                    block->offset = m_output.offset();
+                    block->compressed = output->size();
+                    block->uncompressed = buffer->size();
+                    block->method = block_method;
+
+                    m_output.write(output->data(), output->size());
+                    m_pending_bytes -= buffer->size();
+                });
+            });
+        }
+
+        void flushSmallBlock(u32 method)
+        {
+            auto i = m_small_blocks.find(method);
+            if (i != m_small_blocks.end())
+            {
+                SmallBlock block = i->second;
+                m_small_blocks.erase(i);
+                submit(block.index, block.buffer, Compressor::Method(method), false);
+            }
+        }
+
+        void addFile(const std::string& filename, ConstMemory memory, Compressor::Method method)
+        {
+            if (m_finished)
+            {
+                MANGO_EXCEPTION("[ArchiveWriterMGX] The archive is finished.");
+            }
+
+            XX3H128 hash = xx3hash128(0, memory);
+            auto key = std::make_pair(hash[0] ^ memory.size, hash[1]);
+
+            auto content = m_contents.find(key);
+            if (content != m_contents.end())
+            {
+                // identical file contents -> reference the existing segments
+                FileInfo file = m_files[content->second];
+                file.filename = filename;
+                m_files.push_back(file);
+                return;
+            }
+
+            m_contents[key] = m_files.size();
+
+            FileInfo file;
+            file.filename = filename;
+            file.size = memory.size;
+            file.checksum = crc32c(0, memory);
+
+            if (memory.size > small_file_max_size || method == Compressor::NONE)
+            {
+                // split the file into multiple blocks
+                for (u64 offset = 0; offset < memory.size; offset += large_block_size)
+                {
+                    u64 size = std::min(large_block_size, memory.size - offset);
+
+                    u32 index = createBlock();
+                    file.segments.push_back({ index, 0, u32(size) });
+
+                    auto buffer = std::make_shared<Buffer>(memory.slice(offset, size));
+                    submit(index, buffer, method, false);
+                }
+
+                if (!memory.size)
+                {
+                    // empty file must have a segment to not be confused with a folder
+                    u32 index = createBlock();
+                    file.segments.push_back({ index, 0, 0 });
+                    submit(index, std::make_shared<Buffer>(), Compressor::NONE, false);
+                }
+            }
+            else if (m_encoder && method == m_dictionary_method)
+            {
+                // compress the file as one block with the archive dictionary
+                u32 index = createBlock();
+                file.segments.push_back({ index, 0, u32(memory.size) });
+
+                auto buffer = std::make_shared<Buffer>(memory);
+                submit(index, buffer, method, true);
+            }
+            else
+            {
+                // merge small files into one block
+                auto i = m_small_blocks.find(method);
+                if (i != m_small_blocks.end() && i->second.buffer->size() + memory.size > small_block_size)
+                {
+                    flushSmallBlock(method);
+                    i = m_small_blocks.end();
+                }
+
+                if (i == m_small_blocks.end())
+                {
+                    SmallBlock block;
+                    block.index = createBlock();
+                    block.buffer = std::make_shared<Buffer>();
+                    block.buffer->reserve(small_block_size);
+                    i = m_small_blocks.emplace(method, block).first;
+                }
+
+                SmallBlock& block = i->second;
+
+                file.segments.push_back({ block.index, u32(block.buffer->size()), u32(memory.size) });
+                block.buffer->append(memory);
+            }
+
+            m_files.push_back(file);
+        }
+
+        void addFolder(const std::string& foldername)
+        {
+            if (m_finished)
+            {
+                MANGO_EXCEPTION("[ArchiveWriterMGX] The archive is finished.");
+            }
+
+            std::string folder = foldername;
+            if (!folder.empty() && folder.back() != '/')
+            {
+                folder += '/';
+            }
+
+            if (!folder.empty())
+            {
+                m_folders.insert(folder);
+            }
+        }
+
+        static void addParentFolders(std::set<std::string>& folders, const std::string& filename)
+        {
+            std::string folder = getPath(filename);
+            while (!folder.empty() && folders.insert(folder).second)
+            {
+                folder = getPath(folder.substr(0, folder.length() - 1));
+            }
+        }
+
+        void finish()
+        {
+            if (m_finished)
+            {
+                return;
+            }
+
+            m_finished = true;
+
+            while (!m_small_blocks.empty())
+            {
+                flushSmallBlock(m_small_blocks.begin()->first);
+            }
+
+            // synchronize
+            m_queue.wait();
+            m_tickets.wait();
+
+            // folders are files without segments; every parent folder must have an entry
+            std::set<std::string> folders = m_folders;
+
+            for (const auto& file : m_files)
+            {
+                addParentFolders(folders, file.filename);
+            }
+
+            for (const auto& folder : m_folders)
+            {
+                addParentFolders(folders, folder.substr(0, folder.length() - 1));
+            }
+
+            for (const auto& folder : folders)
+            {
+                FileInfo file;
+                file.filename = folder;
+                file.size = 0;
+                file.checksum = 0;
+                m_files.push_back(file);
+            }
+
+            LittleEndianStream s = m_output;
+
+            // write block data
+
+            u64 block_data_offset = m_output.offset();
+
+            s.write32(u32_mask('m', 'g', 'x', '1'));
+            s.write32(u32(m_blocks.size()));
+
+            for (const auto& block : m_blocks)
+            {
+                s.write64(block.offset);
+                s.write64(block.compressed);
+                s.write64(block.uncompressed);
+                s.write32(block.method);
+            }
+
+            const bool dictionary = m_encoder != nullptr;
+            if (dictionary)
+            {
+                s.write32(m_dictionary_method);
+                s.write32(u32(m_dictionary.size()));
+                s.write(m_dictionary.data(), m_dictionary.size());
+            }
+
+            // write file data
+
+            u64 file_data_offset = m_output.offset();
+
+            s.write32(u32_mask('m', 'g', 'x', '2'));
+
+            MemoryStream temp;
+            LittleEndianStream le = temp;
+
+            le.write32(u32(m_files.size()));
+
+            for (const auto& file : m_files)
+            {
+                u32 length = u32(file.filename.length());
+
+                le.write32(length);
+                le.write(file.filename.c_str(), length);
+
+                le.write64(file.size);
+                le.write32(file.checksum);
+                le.write32(u32(file.segments.size()));
+
+                for (const auto& segment : file.segments)
+                {
+                    le.write32(segment.block);
+                    le.write32(segment.offset);
+                    le.write32(segment.size);
+                }
+            }
+
+            Buffer compressed(zstd::bound(temp.size()));
+            CompressionStatus status = zstd::compress(compressed, temp, 10);
+
+            s.write64(u64(status.size));
+            s.write64(u64(temp.size()));
+            s.write(compressed, status.size);
+
+            // write header
+
+            s.write32(u32_mask('m', 'g', 'x', '3'));
+            s.write32(dictionary ? 2 : 1);
+            s.write64(block_data_offset);
+            s.write64(file_data_offset);
+        }
+    };
+
+    ArchiveWriterMGX::ArchiveWriterMGX(Stream& output, Compressor::Method method, int level)
+        : m_state(std::make_unique<State>(nullptr, output, method, level))
+    {
+    }
+
+    ArchiveWriterMGX::ArchiveWriterMGX(const std::string& filename, Compressor::Method method, int level)
+    {
+        auto file = std::make_unique<OutputFileStream>(filename);
+        Stream& output = *file;
+        m_state = std::make_unique<State>(std::move(file), output, method, level);
+    }
+
+    ArchiveWriterMGX::~ArchiveWriterMGX()
+    {
+        // exceptions cannot be thrown from the destructor; use finish() to handle the errors
+        try
+        {
+            m_state->finish();
+        }
+        catch (const std::exception& e)
+        {
+            printLine(Print::Error, "{}", e.what());
+        }
+    }
+
+    void ArchiveWriterMGX::setDictionary(ConstMemory dictionary)
+    {
+        m_state->setDictionary(dictionary);
+    }
+
+    void ArchiveWriterMGX::setStoreThreshold(u32 percent)
+    {
+        m_state->m_store_threshold = percent;
+    }
+
+    void ArchiveWriterMGX::addFile(const std::string& filename, ConstMemory memory)
+    {
+        m_state->addFile(filename, memory, m_state->m_method);
+    }
+
+    void ArchiveWriterMGX::addFile(const std::string& filename, ConstMemory memory, Compressor::Method method)
+    {
+        m_state->addFile(filename, memory, method);
+    }
+
+    void ArchiveWriterMGX::addFile(const std::string& filename, Stream& stream)
+    {
+        Buffer buffer(stream);
+        m_state->addFile(filename, buffer, m_state->m_method);
+    }
+
+    void ArchiveWriterMGX::addFile(const std::string& filename, Stream& stream, Compressor::Method method)
+    {
+        Buffer buffer(stream);
+        m_state->addFile(filename, buffer, method);
+    }
+
+    void ArchiveWriterMGX::addFolder(const std::string& foldername)
+    {
+        m_state->addFolder(foldername);
+    }
+
+    void ArchiveWriterMGX::finish()
+    {
+        m_state->finish();
+    }
+
 } // namespace mango::filesystem
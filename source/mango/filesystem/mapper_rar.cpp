@@ -455,19 +455,33 @@ namespace mango::filesystem
                     printLine(Print::Info, "[RAR] Incorrect signature.");
                 }
 
-                for (auto& header : m_files)
+                for (auto& file : m_files)
                 {
-                    std::string filename = header.filename;
+                    // the name is stored in the index
+                    FileHeader header = file;
+                    std::string filename = std::move(header.filename);
+                    header.filename = std::string();
+
                     while (!filename.empty())
                     {
                         std::string folder = getPath(filename.substr(0, filename.length() - 1));
 
-                        header.filename = filename.substr(folder.length());
+                        // existing folder already has its parent folders in the index
+                        bool exists = m_folders.hasFolder(folder);
+
                         m_folders.insert(folder, filename, header);
+                        if (exists)
+                        {
+                            break;
+                        }
+
                         header.folder = true;
                         filename = folder;
                     }
                 }
+
+                m_folders.build();
+                m_files = std::vector<FileHeader>();
             }
         }
 
@@ -723,9 +737,9 @@ namespace mango::filesystem
             const Indexer<FileHeader>::Folder* ptrFolder = m_folders.getFolder(pathname);
             if (ptrFolder)
             {
-                for (auto i : ptrFolder->headers)
+                for (u32 i = ptrFolder->first; i < ptrFolder->last; ++i)
                 {
-                    const FileHeader& header = *i.second;
+                    const FileHeader& header = m_folders.getHeader(i);
 
                     u32 flags = 0;
                     u64 size = header.unpacked_size;
@@ -746,7 +760,7 @@ namespace mango::filesystem
                         flags |= FileInfo::Encrypted;
                     }
 
-                    index.emplace(header.filename, size, flags);
+                    index.emplace(std::string(m_folders.getName(i)), size, flags);
                 }
             }
         }
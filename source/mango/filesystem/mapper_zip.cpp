@@ -235,11 +235,11 @@ namespace
         u32	external;          // external file attributes
         u64	localOffset;       // relative offset of the local file header, ZIP64: 0xffffffff
 
-        std::string filename;      // filename is stored after the header
+        // NOTE: the filename is not stored in the header to keep it trivially copyable (index cache)
         bool        is_folder;     // if the last character of filename is "/", it is a folder
         Encryption  encryption;
 
-        bool read(LittleEndianConstPointer& p)
+        bool read(LittleEndianConstPointer& p, std::string& filename)
         {
             signature = p.read32();
             if (signature != 0x02014b50)
@@ -672,6 +672,19 @@ namespace mango::filesystem
                 DirEndRecord record(parent);
                 if (record.status())
                 {
+                    // the central directory identifies the archive contents for the index cache
+                    bool cache = isIndexCacheEnabled() && record.dirStartOffset + record.dirSize <= parent.size;
+
+                    XX3H128 key;
+                    if (cache)
+                    {
+                        key = xx3hash128(parent.size, parent.slice(size_t(record.dirStartOffset), size_t(record.dirSize)));
+                        if (m_folders.load(key))
+                        {
+                            return;
+                        }
+                    }
+
                     const int numFiles = int(record.numEntriesTotal);
 
                     // read file headers
@@ -680,24 +693,39 @@ namespace mango::filesystem
                     for (int i = 0; i < numFiles; ++i)
                     {
                         FileHeader header;
-                        if (header.read(p))
+                        std::string filename;
+
+                        if (header.read(p, filename))
                         {
                             // NOTE: Don't index files that can't be decompressed
                             if (isCompressionSupported(header.compression))
                             {
-                                std::string filename = header.filename;
                                 while (!filename.empty())
                                 {
                                     std::string folder = getPath(filename.substr(0, filename.length() - 1));
 
-                                    header.filename = filename.substr(folder.length());
+                                    // existing folder already has its parent folders in the index
+                                    bool exists = m_folders.hasFolder(folder);
+
                                     m_folders.insert(folder, filename, header);
+                                    if (exists)
+                                    {
+                                        break;
+                                    }
+
                                     header.is_folder = true;
                                     filename = folder;
                                 }
                             }
                         }
                     }
+
+                    m_folders.build();
+
+                    if (cache)
+                    {
+                        m_folders.save(key);
+                    }
                 }
             }
         }
@@ -961,9 +989,9 @@ namespace mango::filesystem
             const Indexer<FileHeader>::Folder* ptrFolder = m_folders.getFolder(pathname);
             if (ptrFolder)
             {
-                for (auto i : ptrFolder->headers)
+                for (u32 i = ptrFolder->first; i < ptrFolder->last; ++i)
                 {
-                    const FileHeader& header = *i.second;
+                    const FileHeader& header = m_folders.getHeader(i);
 
                     u32 flags = 0;
                     u64 size = header.uncompressedSize;
@@ -984,7 +1012,7 @@ namespace mango::filesystem
                         flags |= FileInfo::Encrypted;
                     }
 
-                    index.emplace(header.filename, size, flags);
+                    index.emplace(std::string(m_folders.getName(i)), size, flags);
                 }
             }
         }
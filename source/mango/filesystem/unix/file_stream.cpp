@@ -8,157 +8,151 @@
 #endif
 
 #include <cstdio>
+#include <cerrno>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 
 #include <mango/core/string.hpp>
 #include <mango/core/exception.hpp>
 #include <mango/filesystem/file.hpp>
+#include "../file_handle.hpp"
 
-namespace mango::filesystem
+namespace
 {
+    using namespace mango;
 
-    // -----------------------------------------------------------------
-    // FileHandle
-    // -----------------------------------------------------------------
+    // number of iovec entries submitted in one readv() / writev() call
+    constexpr int max_iovec_count = 64;
 
-    struct FileHandle
+    template <typename MemoryType, typename Function>
+    u64 vectored_io(const MemoryType* buffers, size_t count, Function&& func)
     {
-        int m_file;
-        std::string m_filename;
-
-        FileHandle(const std::string& filename, int flags)
-            : m_file(::open(filename.c_str(), flags, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH))
-            , m_filename(filename)
-        {
-        }
-
-        ~FileHandle()
-        {
-            ::close(m_file);
-        }
-
-        const std::string& filename() const
-        {
-            return m_filename;
-        }
+        u64 total = 0;
 
-        u64 size() const
-        {
-            struct stat sb;
-            int status = ::fstat(m_file, &sb);
-            if (status < 0)
-                return 0;
-            return s64(sb.st_size);
-        }
+        size_t index = 0;
+        size_t skip = 0; // bytes already transferred from buffers[index]
 
-        u64 offset() const
+        while (index < count)
         {
-            auto offset = ::lseek(m_file, 0, SEEK_CUR);
-            if (offset < 0)
-                return 0;
-            return u64(offset);
+            iovec iov[max_iovec_count];
+            int n = 0;
+
+            for (size_t i = index; i < count && n < max_iovec_count; ++i)
+            {
+                size_t offset = (i == index) ? skip : 0;
+                iov[n].iov_base = const_cast<u8*>(buffers[i].address + offset);
+                iov[n].iov_len = buffers[i].size - offset;
+                ++n;
+            }
+
+            ssize_t bytes = func(iov, n);
+            if (bytes < 0 && errno == EINTR)
+            {
+                // interrupted by a signal before anything was transferred
+                continue;
+            }
+
+            if (bytes <= 0)
+            {
+                // error or end of file
+                break;
+            }
+
+            total += u64(bytes);
+
+            // advance the buffers by the number of bytes transferred
+            size_t left = size_t(bytes);
+
+            while (index < count)
+            {
+                size_t available = buffers[index].size - skip;
+                if (left < available)
+                {
+                    skip += left;
+                    break;
+                }
+
+                left -= available;
+                skip = 0;
+                ++index;
+            }
         }
 
-        u64 seek(s64 distance, int method)
-        {
-            auto offset = ::lseek(m_file, distance, method);
-            if (offset < 0)
-                return 0;
-            return u64(offset);
-        }
+        return total;
+    }
 
-        u64 read(void* dest, u64 size)
-        {
-            ssize_t bytes_read = ::read(m_file, dest, size_t(size));
-            if (bytes_read < 0)
-                return 0;
-            return u64(bytes_read);
-        }
+} // namespace
 
-        u64 write(const void* data, u64 size)
-        {
-            ssize_t bytes_written = ::write(m_file, data, size_t(size));
-            if (bytes_written < 0)
-                return 0;
-            return u64(bytes_written);
-        }
-    };
+namespace mango::filesystem
+{
 
     // -----------------------------------------------------------------
-    // FileStream
+    // FileHandle
     // -----------------------------------------------------------------
 
-    FileStream::FileStream(const std::string& filename, OpenMode openmode)
-        : m_handle(nullptr)
+    FileHandle::FileHandle(const std::string& filename, Stream::OpenMode mode)
+        : m_file(-1)
+        , m_filename(filename)
     {
-       	switch (openmode)
+        int flags = 0;
+
+        switch (mode)
         {
-            case OpenMode::Read:
-                m_handle = new FileHandle(filename, O_RDONLY);
+            case Stream::OpenMode::Read:
+                flags = O_RDONLY;
                 break;
 
-            case OpenMode::Write:
-                m_handle = new FileHandle(filename, O_WRONLY | O_CREAT | O_TRUNC);
+            case Stream::OpenMode::Write:
+                flags = O_WRONLY | O_CREAT | O_TRUNC;
                 break;
 
             default:
                 MANGO_EXCEPTION("[FileStream] Incorrect OpenMode.");
                 break;
         }
-    }
 
-    FileStream::~FileStream()
-    {
-        delete m_handle;
+        m_file = ::open(filename.c_str(), flags, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
     }
 
-    const std::string& FileStream::filename() const
+    FileHandle::~FileHandle()
     {
-        return m_handle->filename();
+        if (m_file != -1)
+        {
+            ::close(m_file);
+        }
     }
 
-    u64 FileStream::size() const
+    u64 FileHandle::size() const
     {
-        return m_handle->size();
+        struct stat sb;
+        int status = ::fstat(m_file, &sb);
+        if (status < 0)
+            return 0;
+        return s64(sb.st_size);
     }
 
-    u64 FileStream::offset() const
+    bool FileHandle::seek(u64 offset)
     {
-        return m_handle->offset();
+        auto result = ::lseek(m_file, off_t(offset), SEEK_SET);
+        return result >= 0;
     }
 
-    u64 FileStream::seek(s64 distance, SeekMode mode)
+    u64 FileHandle::read(const Memory* buffers, size_t count)
     {
-        int method = 0;
-
-        switch (mode)
+        return vectored_io(buffers, count, [this] (const iovec* iov, int n)
         {
-            case SeekMode::Begin:
-                method = SEEK_SET;
-                break;
-
-            case SeekMode::Current:
-                method = SEEK_CUR;
-                break;
-
-            case SeekMode::End:
-                method = SEEK_END;
-                break;
-        }
-
-        return m_handle->seek(distance, method);
+            return ::readv(m_file, iov, n);
+        });
     }
 
-    u64 FileStream::read(void* dest, u64 bytes)
+    u64 FileHandle::write(const ConstMemory* buffers, size_t count)
     {
-        return m_handle->read(dest, bytes);
-    }
-
-    u64 FileStream::write(const void* data, u64 bytes)
-    {
-        return m_handle->write(data, bytes);
+        return vectored_io(buffers, count, [this] (const iovec* iov, int n)
+        {
+            return ::writev(m_file, iov, n);
+        });
     }
 
 } // namespace mango::filesystem
@@ -6,102 +6,34 @@
 #include <mango/core/print.hpp>
 #include <mango/core/exception.hpp>
 #include <mango/filesystem/file.hpp>
+#include "../file_handle.hpp"
 
 namespace mango::filesystem
 {
 
-    // -----------------------------------------------------------------
-    // FileHandle
-    // -----------------------------------------------------------------
-
-    struct FileHandle
-    {
-        std::string m_filename;
-        HANDLE m_handle;
-
-        FileHandle(const std::string& filename, HANDLE handle)
-            : m_filename(filename)
-            , m_handle(handle)
-        {
-        }
-
-        ~FileHandle()
-        {
-            CloseHandle(m_handle);
-        }
-
-        const std::string& filename() const
-        {
-            return m_filename;
-        }
-
-        u64 size() const
-        {
-            LARGE_INTEGER result = {};
-            BOOL status = GetFileSizeEx(m_handle, &result);
-            if (!status)
-                return 0;
-            return u64(result.QuadPart);
-        }
-
-        u64 offset() const
-        {
-            LARGE_INTEGER dist = {};
-            LARGE_INTEGER result = {};
-            BOOL status = SetFilePointerEx(m_handle, dist, &result, FILE_CURRENT);
-            if (!status)
-                return 0;
-            return u64(result.QuadPart);
-        }
-
-        u64 seek(s64 distance, DWORD method)
-        {
-            LARGE_INTEGER dist = {};
-            dist.QuadPart = distance;
-            LARGE_INTEGER result = {};
-            BOOL status = SetFilePointerEx(m_handle, dist, &result, method);
-            if (!status)
-                return 0;
-            return u64(result.QuadPart);
-        }
-
-        s64 read(void* dest, u32 size)
-        {
-            DWORD bytes_read = 0;
-            BOOL status = ReadFile(m_handle, dest, DWORD(size), &bytes_read, NULL);
-            if (!status)
-                return -1ll;
-            return s64(bytes_read);
-        }
-
-        s64 write(const void* data, u32 size)
-        {
-            DWORD bytes_written = 0;
-            BOOL status = WriteFile(m_handle, data, DWORD(size), &bytes_written, NULL);
-            if (!status)
-                return -1ll;
-            return s64(bytes_written);
-        }
-    };
+    // NOTE: WIN32 ReadFile and WriteFile are limited to 4 GB maximum read and write
+    //       so we split larger operations into smaller chunks.
+    static constexpr u64 max_chunk_size = 0xffffffffull;
 
     // -----------------------------------------------------------------
-    // FileStream
+    // FileHandle
     // -----------------------------------------------------------------
 
-    FileStream::FileStream(const std::string& filename, OpenMode mode)
-        : m_handle(nullptr)
+    FileHandle::FileHandle(const std::string& filename, Stream::OpenMode mode)
+        : m_handle(INVALID_HANDLE_VALUE)
+        , m_filename(filename)
     {
         DWORD access;
         DWORD disposition;
 
         switch (mode)
         {
-            case OpenMode::Read:
+            case Stream::OpenMode::Read:
                 access = GENERIC_READ;
                 disposition = OPEN_EXISTING;
                 break;
 
-            case OpenMode::Write:
+            case Stream::OpenMode::Write:
                 access = GENERIC_WRITE;
                 disposition = CREATE_ALWAYS;
                 break;
@@ -111,104 +43,87 @@ namespace mango::filesystem
                 break;
         }
 
-        HANDLE handle = CreateFileW(u16_fromBytes(filename).c_str(), access, FILE_SHARE_READ, NULL, disposition, FILE_ATTRIBUTE_NORMAL, NULL);
-        if (handle == INVALID_HANDLE_VALUE)
+        m_handle = CreateFileW(u16_fromBytes(filename).c_str(), access, FILE_SHARE_READ, NULL, disposition, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m_handle == INVALID_HANDLE_VALUE)
         {
             MANGO_EXCEPTION("[FileStream] CreateFileW(\"{}\") failed.", filename);
         }
-
-        m_handle = new FileHandle(filename, handle);
     }
 
-    FileStream::~FileStream()
+    FileHandle::~FileHandle()
     {
-        delete m_handle;
+        CloseHandle(m_handle);
     }
 
-    const std::string& FileStream::filename() const
+    u64 FileHandle::size() const
     {
-        return m_handle->filename();
+        LARGE_INTEGER result = {};
+        BOOL status = GetFileSizeEx(m_handle, &result);
+        if (!status)
+            return 0;
+        return u64(result.QuadPart);
     }
 
-    u64 FileStream::size() const
+    bool FileHandle::seek(u64 offset)
     {
-        return m_handle->size();
-    }
-
-    u64 FileStream::offset() const
-    {
-        return m_handle->offset();
-    }
-
-    u64 FileStream::seek(s64 distance, SeekMode mode)
-    {
-        DWORD method = 0;
-
-        switch (mode)
-        {
-            case SeekMode::Begin:
-                method = FILE_BEGIN;
-                break;
-
-            case SeekMode::Current:
-                method = FILE_CURRENT;
-                break;
-
-            case SeekMode::End:
-                method = FILE_END;
-                break;
-        }
-
-        return m_handle->seek(distance, method);
+        LARGE_INTEGER dist = {};
+        dist.QuadPart = LONGLONG(offset);
+        BOOL status = SetFilePointerEx(m_handle, dist, NULL, FILE_BEGIN);
+        return status != 0;
     }
 
-    // NOTE: WIN32 ReadFile and WriteFile are limited to 4 GB maximum read and write
-    //       so we split larger operations into smaller chunks.
-    static constexpr u64 max_chunk_size = 0xffffffffull;
-
-    u64 FileStream::read(void* dest, u64 bytes)
+    u64 FileHandle::read(const Memory* buffers, size_t count)
     {
         u64 total = 0;
 
-        s64 bytes_left = bytes;
-        u8* output = reinterpret_cast<u8*>(dest);
-
-        while (bytes_left > 0)
+        for (size_t i = 0; i < count; ++i)
         {
-            u64 commit = std::min(u64(bytes_left), max_chunk_size);
-            s64 result = m_handle->read(output, u32(commit));
-            if (result < 0)
+            u8* output = buffers[i].address;
+            u64 bytes_left = buffers[i].size;
+
+            while (bytes_left > 0)
             {
-                return 0;
+                DWORD commit = DWORD(std::min(bytes_left, max_chunk_size));
+                DWORD bytes_read = 0;
+                BOOL status = ReadFile(m_handle, output, commit, &bytes_read, NULL);
+                if (!status || !bytes_read)
+                {
+                    // error or end of file
+                    return total;
+                }
+
+                bytes_left -= bytes_read;
+                output += bytes_read;
+                total += bytes_read;
             }
-
-            bytes_left -= result;
-            output += result;
-            total += result;
         }
 
         return total;
     }
 
-    u64 FileStream::write(const void* data, u64 bytes)
+    u64 FileHandle::write(const ConstMemory* buffers, size_t count)
     {
         u64 total = 0;
 
-        s64 bytes_left = bytes;
-        const u8* input = reinterpret_cast<const u8*>(data);
-
-        while (bytes_left > 0)
+        for (size_t i = 0; i < count; ++i)
         {
-            u64 commit = std::min(u64(bytes_left), max_chunk_size);
-            s64 result = m_handle->write(input, u32(commit));
-            if (result < 0)
+            const u8* input = buffers[i].address;
+            u64 bytes_left = buffers[i].size;
+
+            while (bytes_left > 0)
             {
-                return 0;
+                DWORD commit = DWORD(std::min(bytes_left, max_chunk_size));
+                DWORD bytes_written = 0;
+                BOOL status = WriteFile(m_handle, input, commit, &bytes_written, NULL);
+                if (!status || !bytes_written)
+                {
+                    return total;
+                }
+
+                bytes_left -= bytes_written;
+                input += bytes_written;
+                total += bytes_written;
             }
-
-            bytes_left -= result;
-            input += result;
-            total += result;
         }
 
         return total;
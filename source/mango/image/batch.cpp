@@ -0,0 +1,269 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#include <algorithm>
+#include <mango/core/thread.hpp>
+#include <mango/core/system.hpp>
+#include <mango/filesystem/file.hpp>
+#include <mango/image/image.hpp>
+#include <mango/image/batch.hpp>
+
+namespace mango::image
+{
+
+    // ----------------------------------------------------------------------------
+    // BatchDecoder
+    // ----------------------------------------------------------------------------
+
+    struct BatchDecoder::State
+    {
+        struct Input
+        {
+            size_t index;
+            std::string name;
+            ConstMemory memory; // the files are mapped when they are accessed
+            bool file;
+            Format format;
+            ImageHeader header;
+            u64 cost = 0;
+        };
+
+        BatchDecodeOptions options;
+        ImageDecodeScheduler scheduler;
+        CancellationToken cancellation;
+        std::vector<Input> inputs;
+        size_t counter = 0;
+
+        State(const BatchDecodeOptions& options)
+            : options(options)
+            , scheduler(options.concurrency)
+        {
+        }
+
+        void add(ConstMemory memory, const std::string& name, bool file, const Format& format)
+        {
+            Input input;
+
+            input.index = counter++;
+            input.name = name;
+            input.memory = memory;
+            input.file = file;
+            input.format = format;
+
+            inputs.push_back(input);
+        }
+
+        template <typename Func>
+        void access(const Input& input, Func func) const
+        {
+            if (input.file)
+            {
+                filesystem::File file(input.name);
+                func(ConstMemory(file));
+            }
+            else
+            {
+                func(input.memory);
+            }
+        }
+
+        void readHeader(Input& input) const
+        {
+            try
+            {
+                access(input, [&] (ConstMemory memory)
+                {
+                    ImageDecoder decoder(memory, input.name);
+                    input.header = decoder.header();
+                });
+            }
+            catch (const std::exception& e)
+            {
+                input.header.setError(e.what());
+            }
+
+            if (input.header)
+            {
+                input.cost = u64(input.header.width) * u64(input.header.height);
+            }
+        }
+
+        Result decode(const Input& input)
+        {
+            Result result;
+
+            result.index = input.index;
+            result.name = input.name;
+            result.header = input.header;
+
+            if (!input.header)
+            {
+                result.status.setError(input.header.info);
+                return result;
+            }
+
+            if (cancellation)
+            {
+                result.status.setError("[BatchDecoder] Decoding was cancelled.");
+                return result;
+            }
+
+            const Format& format = input.format.bits ? input.format :
+                                   options.format.bits ? options.format : input.header.format;
+
+            ImageDecodeOptions decode_options;
+
+            decode_options.simd = options.simd;
+            decode_options.multithread = input.cost >= options.multithread_pixels;
+            decode_options.cancellation = &cancellation;
+
+            try
+            {
+                access(input, [&] (ConstMemory memory)
+                {
+                    ImageDecoder decoder(memory, input.name);
+                    result.bitmap = std::make_unique<Bitmap>(input.header.width, input.header.height, format);
+                    result.status = decoder.decode(*result.bitmap, decode_options);
+                });
+            }
+            catch (const std::exception& e)
+            {
+                result.status.setError(e.what());
+            }
+
+            if (!result.status)
+            {
+                result.bitmap.reset();
+            }
+
+            return result;
+        }
+    };
+
+    BatchDecoder::BatchDecoder(const BatchDecodeOptions& options)
+        : m_state(std::make_unique<State>(options))
+    {
+    }
+
+    BatchDecoder::~BatchDecoder()
+    {
+    }
+
+    void BatchDecoder::add(const filesystem::FileIndex& index, const std::string& pathname)
+    {
+        for (const filesystem::FileInfo& info : index.files)
+        {
+            if (!info.isDirectory())
+            {
+                m_state->add(ConstMemory(), pathname + info.name, true, Format());
+            }
+        }
+    }
+
+    void BatchDecoder::add(const filesystem::Path& path)
+    {
+        add(path.getIndex(), path.pathname());
+    }
+
+    void BatchDecoder::add(const std::string& filename, const Format& format)
+    {
+        m_state->add(ConstMemory(), filename, true, format);
+    }
+
+    void BatchDecoder::add(ConstMemory memory, const std::string& name, const Format& format)
+    {
+        m_state->add(memory, name, false, format);
+    }
+
+    void BatchDecoder::decode(Callback callback)
+    {
+        State& state = *m_state;
+
+        std::vector<State::Input> inputs;
+        std::swap(inputs, state.inputs);
+
+        // read the headers first to know the cost of the images
+        ConcurrentQueue queue("batch.header");
+
+        for (State::Input& input : inputs)
+        {
+            queue.enqueue([&state, &input]
+            {
+                state.readHeader(input);
+            });
+        }
+
+        queue.wait();
+
+        // the most expensive images are started first so that they don't remain as the tail
+        std::vector<const State::Input*> order;
+
+        for (const State::Input& input : inputs)
+        {
+            order.push_back(&input);
+        }
+
+        std::stable_sort(order.begin(), order.end(), [] (const State::Input* a, const State::Input* b)
+        {
+            return a->cost > b->cost;
+        });
+
+        std::mutex callback_mutex;
+        std::exception_ptr exception;
+
+        std::atomic<size_t> remaining { order.size() };
+
+        for (const State::Input* input : order)
+        {
+            state.scheduler.enqueue(0, [&, input]
+            {
+                Result result = state.decode(*input);
+
+                {
+                    std::lock_guard<std::mutex> lock(callback_mutex);
+
+                    // the remaining results are dropped after the callback has thrown
+                    if (callback && !exception)
+                    {
+                        try
+                        {
+                            callback(result);
+                        }
+                        catch (...)
+                        {
+                            exception = std::current_exception();
+                            state.cancellation.cancel();
+                        }
+                    }
+                }
+
+                // the locals of decode() are not used after the last decrement
+                if (!--remaining)
+                {
+                    ThreadPool::getInstance().notify();
+                }
+            });
+        }
+
+        // the calling thread decodes images with the pool so that it can be a pool thread
+        ThreadPool::getInstance().help([&]
+        {
+            return !remaining;
+        });
+
+        // a cancel() during the decode() doesn't remain to cancel the next one
+        state.cancellation.reset();
+
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    void BatchDecoder::cancel()
+    {
+        m_state->cancellation.cancel();
+    }
+
+} // namespace mango::image
@@ -1945,7 +1945,8 @@ namespace
         }
     }
 
-#if defined(MANGO_ENABLE_SSE4_1)
+#if defined(MANGO_DISPATCH_SSE4_1)
+MANGO_TARGET_BEGIN_SSE4_1
 
     // ----------------------------------------------------------------------------
     // SSE4.1
@@ -2008,9 +2009,223 @@ namespace
         }
     }
 
-#endif // defined(MANGO_ENABLE_SSE4_1)
+    // rgba.f32 -> rgba.u8
 
-#if defined(MANGO_ENABLE_AVX2)
+    static inline
+    __m128i sse4_pack_unorm8(__m128 v0, __m128 v1, __m128 v2, __m128 v3)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set1_ps(255.0f);
+
+        v0 = _mm_mul_ps(_mm_min_ps(_mm_max_ps(v0, zero), one), scale);
+        v1 = _mm_mul_ps(_mm_min_ps(_mm_max_ps(v1, zero), one), scale);
+        v2 = _mm_mul_ps(_mm_min_ps(_mm_max_ps(v2, zero), one), scale);
+        v3 = _mm_mul_ps(_mm_min_ps(_mm_max_ps(v3, zero), one), scale);
+
+        __m128i a = _mm_packs_epi32(_mm_cvtps_epi32(v0), _mm_cvtps_epi32(v1));
+        __m128i b = _mm_packs_epi32(_mm_cvtps_epi32(v2), _mm_cvtps_epi32(v3));
+        return _mm_packus_epi16(a, b);
+    }
+
+    static inline
+    __m128i sse4_swap_rb(__m128i color)
+    {
+        return _mm_shuffle_epi8(color, _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15));
+    }
+
+    // rgba.u8 -> rgba.f32
+
+    static inline
+    __m128 sse4_unpack_unorm8(__m128i color)
+    {
+        // division instead of reciprocal multiply to match the scalar conversion
+        return _mm_div_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(color)), _mm_set1_ps(255.0f));
+    }
+
+    template <bool swap>
+    void sse4_rgba_u8_from_rgba_f32(u8* dest, const u8* src, int count)
+    {
+        const float* s = reinterpret_cast<const float*>(src);
+
+        while (count >= 4)
+        {
+            __m128 v0 = _mm_loadu_ps(s + 0);
+            __m128 v1 = _mm_loadu_ps(s + 4);
+            __m128 v2 = _mm_loadu_ps(s + 8);
+            __m128 v3 = _mm_loadu_ps(s + 12);
+            __m128i color = sse4_pack_unorm8(v0, v1, v2, v3);
+            if (swap)
+            {
+                color = sse4_swap_rb(color);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), color);
+            s += 16;
+            dest += 16;
+            count -= 4;
+        }
+
+        while (count-- > 0)
+        {
+            __m128 v = _mm_loadu_ps(s);
+            __m128i color = sse4_pack_unorm8(v, v, v, v);
+            if (swap)
+            {
+                color = sse4_swap_rb(color);
+            }
+            ustore32(dest, _mm_cvtsi128_si32(color));
+            s += 4;
+            dest += 4;
+        }
+    }
+
+    void sse4_rgba_f32_from_rgba_u8(u8* dest, const u8* src, int count)
+    {
+        float* d = reinterpret_cast<float*>(dest);
+
+        while (count >= 4)
+        {
+            __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+            _mm_storeu_ps(d +  0, sse4_unpack_unorm8(color));
+            _mm_storeu_ps(d +  4, sse4_unpack_unorm8(_mm_srli_si128(color, 4)));
+            _mm_storeu_ps(d +  8, sse4_unpack_unorm8(_mm_srli_si128(color, 8)));
+            _mm_storeu_ps(d + 12, sse4_unpack_unorm8(_mm_srli_si128(color, 12)));
+            src += 16;
+            d += 16;
+            count -= 4;
+        }
+
+        while (count-- > 0)
+        {
+            __m128i color = _mm_cvtsi32_si128(uload32(src));
+            _mm_storeu_ps(d, sse4_unpack_unorm8(color));
+            src += 4;
+            d += 4;
+        }
+    }
+
+MANGO_TARGET_END
+#endif // defined(MANGO_DISPATCH_SSE4_1)
+
+#if defined(MANGO_DISPATCH_F16C)
+MANGO_TARGET_BEGIN_F16C
+
+    // ----------------------------------------------------------------------------
+    // SSE4.1 + F16C
+    // ----------------------------------------------------------------------------
+
+    template <bool swap>
+    void sse4_rgba_u8_from_rgba_f16(u8* dest, const u8* src, int count)
+    {
+        while (count >= 4)
+        {
+            __m128i h0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 0));
+            __m128i h1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 16));
+            __m128 v0 = _mm_cvtph_ps(h0);
+            __m128 v1 = _mm_cvtph_ps(_mm_unpackhi_epi64(h0, h0));
+            __m128 v2 = _mm_cvtph_ps(h1);
+            __m128 v3 = _mm_cvtph_ps(_mm_unpackhi_epi64(h1, h1));
+            __m128i color = sse4_pack_unorm8(v0, v1, v2, v3);
+            if (swap)
+            {
+                color = sse4_swap_rb(color);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), color);
+            src += 32;
+            dest += 16;
+            count -= 4;
+        }
+
+        while (count-- > 0)
+        {
+            __m128 v = _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src)));
+            __m128i color = sse4_pack_unorm8(v, v, v, v);
+            if (swap)
+            {
+                color = sse4_swap_rb(color);
+            }
+            ustore32(dest, _mm_cvtsi128_si32(color));
+            src += 8;
+            dest += 4;
+        }
+    }
+
+    void sse4_rgba_f16_from_rgba_u8(u8* dest, const u8* src, int count)
+    {
+        constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+
+        while (count >= 4)
+        {
+            __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+            __m128i h0 = _mm_cvtps_ph(sse4_unpack_unorm8(color), rounding);
+            __m128i h1 = _mm_cvtps_ph(sse4_unpack_unorm8(_mm_srli_si128(color, 4)), rounding);
+            __m128i h2 = _mm_cvtps_ph(sse4_unpack_unorm8(_mm_srli_si128(color, 8)), rounding);
+            __m128i h3 = _mm_cvtps_ph(sse4_unpack_unorm8(_mm_srli_si128(color, 12)), rounding);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 0), _mm_unpacklo_epi64(h0, h1));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 16), _mm_unpacklo_epi64(h2, h3));
+            src += 16;
+            dest += 32;
+            count -= 4;
+        }
+
+        while (count-- > 0)
+        {
+            __m128i color = _mm_cvtsi32_si128(uload32(src));
+            __m128i h = _mm_cvtps_ph(sse4_unpack_unorm8(color), rounding);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dest), h);
+            src += 4;
+            dest += 8;
+        }
+    }
+
+    void sse4_rgba_f16_from_rgba_f32(u8* dest, const u8* src, int count)
+    {
+        constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+        const float* s = reinterpret_cast<const float*>(src);
+
+        while (count >= 2)
+        {
+            __m128i h0 = _mm_cvtps_ph(_mm_loadu_ps(s + 0), rounding);
+            __m128i h1 = _mm_cvtps_ph(_mm_loadu_ps(s + 4), rounding);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm_unpacklo_epi64(h0, h1));
+            s += 8;
+            dest += 16;
+            count -= 2;
+        }
+
+        if (count > 0)
+        {
+            __m128i h = _mm_cvtps_ph(_mm_loadu_ps(s), rounding);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dest), h);
+        }
+    }
+
+    void sse4_rgba_f32_from_rgba_f16(u8* dest, const u8* src, int count)
+    {
+        float* d = reinterpret_cast<float*>(dest);
+
+        while (count >= 2)
+        {
+            __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+            _mm_storeu_ps(d + 0, _mm_cvtph_ps(h));
+            _mm_storeu_ps(d + 4, _mm_cvtph_ps(_mm_unpackhi_epi64(h, h)));
+            src += 16;
+            d += 8;
+            count -= 2;
+        }
+
+        if (count > 0)
+        {
+            __m128i h = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src));
+            _mm_storeu_ps(d, _mm_cvtph_ps(h));
+        }
+    }
+
+MANGO_TARGET_END
+#endif // defined(MANGO_DISPATCH_F16C)
+
+#if defined(MANGO_DISPATCH_AVX2)
+MANGO_TARGET_BEGIN_AVX2
 
     // ----------------------------------------------------------------------------
     // AVX2
@@ -2032,75 +2247,609 @@ namespace
 
         while (count-- > 0)
         {
-            d[0] = s[2];
-            d[1] = s[1];
-            d[2] = s[0];
-            d[3] = s[3];
-            s += 4;
+            d[0] = s[2];
+            d[1] = s[1];
+            d[2] = s[0];
+            d[3] = s[3];
+            s += 4;
+            d += 4;
+        }
+    }
+
+    // The 256 bit pack instructions work within 128 bit lanes; the permute restores the pixel order.
+
+    static inline
+    __m256i avx2_pack_unorm8(__m256 v0, __m256 v1, __m256 v2, __m256 v3)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 scale = _mm256_set1_ps(255.0f);
+
+        v0 = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(v0, zero), one), scale);
+        v1 = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(v1, zero), one), scale);
+        v2 = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(v2, zero), one), scale);
+        v3 = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(v3, zero), one), scale);
+
+        __m256i a = _mm256_packs_epi32(_mm256_cvtps_epi32(v0), _mm256_cvtps_epi32(v1));
+        __m256i b = _mm256_packs_epi32(_mm256_cvtps_epi32(v2), _mm256_cvtps_epi32(v3));
+        __m256i color = _mm256_packus_epi16(a, b);
+        return _mm256_permutevar8x32_epi32(color, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+    }
+
+    static inline
+    __m256i avx2_swap_rb(__m256i color)
+    {
+        return _mm256_shuffle_epi8(color, _mm256_setr_epi8(
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15));
+    }
+
+    static inline
+    __m256 avx2_unpack_unorm8(__m128i color)
+    {
+        return _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(color)), _mm256_set1_ps(255.0f));
+    }
+
+    template <bool swap>
+    void avx2_rgba_u8_from_rgba_f32(u8* dest, const u8* src, int count)
+    {
+        const float* s = reinterpret_cast<const float*>(src);
+
+        while (count >= 8)
+        {
+            __m256 v0 = _mm256_loadu_ps(s + 0);
+            __m256 v1 = _mm256_loadu_ps(s + 8);
+            __m256 v2 = _mm256_loadu_ps(s + 16);
+            __m256 v3 = _mm256_loadu_ps(s + 24);
+            __m256i color = avx2_pack_unorm8(v0, v1, v2, v3);
+            if (swap)
+            {
+                color = avx2_swap_rb(color);
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest), color);
+            s += 32;
+            dest += 32;
+            count -= 8;
+        }
+
+        sse4_rgba_u8_from_rgba_f32<swap>(dest, reinterpret_cast<const u8*>(s), count);
+    }
+
+    void avx2_rgba_f32_from_rgba_u8(u8* dest, const u8* src, int count)
+    {
+        float* d = reinterpret_cast<float*>(dest);
+
+        while (count >= 8)
+        {
+            __m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 0));
+            __m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 16));
+            _mm256_storeu_ps(d +  0, avx2_unpack_unorm8(c0));
+            _mm256_storeu_ps(d +  8, avx2_unpack_unorm8(_mm_unpackhi_epi64(c0, c0)));
+            _mm256_storeu_ps(d + 16, avx2_unpack_unorm8(c1));
+            _mm256_storeu_ps(d + 24, avx2_unpack_unorm8(_mm_unpackhi_epi64(c1, c1)));
+            src += 32;
+            d += 32;
+            count -= 8;
+        }
+
+        sse4_rgba_f32_from_rgba_u8(reinterpret_cast<u8*>(d), src, count);
+    }
+
+#if defined(MANGO_DISPATCH_F16C)
+
+    template <bool swap>
+    void avx2_rgba_u8_from_rgba_f16(u8* dest, const u8* src, int count)
+    {
+        while (count >= 8)
+        {
+            __m256 v0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 0)));
+            __m256 v1 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 16)));
+            __m256 v2 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 32)));
+            __m256 v3 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 48)));
+            __m256i color = avx2_pack_unorm8(v0, v1, v2, v3);
+            if (swap)
+            {
+                color = avx2_swap_rb(color);
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest), color);
+            src += 64;
+            dest += 32;
+            count -= 8;
+        }
+
+        sse4_rgba_u8_from_rgba_f16<swap>(dest, src, count);
+    }
+
+    void avx2_rgba_f16_from_rgba_u8(u8* dest, const u8* src, int count)
+    {
+        constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+
+        while (count >= 8)
+        {
+            __m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 0));
+            __m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 16));
+            __m128i h0 = _mm256_cvtps_ph(avx2_unpack_unorm8(c0), rounding);
+            __m128i h1 = _mm256_cvtps_ph(avx2_unpack_unorm8(_mm_unpackhi_epi64(c0, c0)), rounding);
+            __m128i h2 = _mm256_cvtps_ph(avx2_unpack_unorm8(c1), rounding);
+            __m128i h3 = _mm256_cvtps_ph(avx2_unpack_unorm8(_mm_unpackhi_epi64(c1, c1)), rounding);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + 0), _mm256_setr_m128i(h0, h1));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + 32), _mm256_setr_m128i(h2, h3));
+            src += 32;
+            dest += 64;
+            count -= 8;
+        }
+
+        sse4_rgba_f16_from_rgba_u8(dest, src, count);
+    }
+
+    void avx2_rgba_f16_from_rgba_f32(u8* dest, const u8* src, int count)
+    {
+        constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+        const float* s = reinterpret_cast<const float*>(src);
+
+        while (count >= 4)
+        {
+            __m128i h0 = _mm256_cvtps_ph(_mm256_loadu_ps(s + 0), rounding);
+            __m128i h1 = _mm256_cvtps_ph(_mm256_loadu_ps(s + 8), rounding);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest), _mm256_setr_m128i(h0, h1));
+            s += 16;
+            dest += 32;
+            count -= 4;
+        }
+
+        sse4_rgba_f16_from_rgba_f32(dest, reinterpret_cast<const u8*>(s), count);
+    }
+
+    void avx2_rgba_f32_from_rgba_f16(u8* dest, const u8* src, int count)
+    {
+        float* d = reinterpret_cast<float*>(dest);
+
+        while (count >= 4)
+        {
+            _mm256_storeu_ps(d + 0, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 0))));
+            _mm256_storeu_ps(d + 8, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 16))));
+            src += 32;
+            d += 16;
+            count -= 4;
+        }
+
+        sse4_rgba_f32_from_rgba_f16(reinterpret_cast<u8*>(d), src, count);
+    }
+
+#endif // defined(MANGO_DISPATCH_F16C)
+
+MANGO_TARGET_END
+#endif // defined(MANGO_DISPATCH_AVX2)
+
+#if defined(MANGO_DISPATCH_AVX512)
+MANGO_TARGET_BEGIN_AVX512
+
+    // ----------------------------------------------------------------------------
+    // AVX-512
+    // ----------------------------------------------------------------------------
+
+    // The pixels are converted 16 at a time; the narrowing conversion keeps the pixel order.
+
+    // The unmasked forms of these intrinsics pass an uninitialized vector as the merge source
+    // in the GCC 12 headers which trips -Wuninitialized; the zero-masking forms with all lanes
+    // enabled compile to the same instructions.
+    constexpr __mmask16 avx512_all = 0xffff;
+
+    static inline
+    __m128i avx512_pack_unorm8(__m512 v)
+    {
+        v = _mm512_maskz_max_ps(avx512_all, v, _mm512_setzero_ps());
+        v = _mm512_maskz_min_ps(avx512_all, v, _mm512_set1_ps(1.0f));
+        v = _mm512_mul_ps(v, _mm512_set1_ps(255.0f));
+        return _mm512_maskz_cvtepi32_epi8(avx512_all, _mm512_maskz_cvtps_epi32(avx512_all, v));
+    }
+
+    static inline
+    __m512 avx512_unpack_unorm8(__m128i color)
+    {
+        __m512 v = _mm512_maskz_cvtepi32_ps(avx512_all, _mm512_maskz_cvtepu8_epi32(avx512_all, color));
+        return _mm512_div_ps(v, _mm512_set1_ps(255.0f));
+    }
+
+    template <bool swap>
+    void avx512_rgba_u8_from_rgba_f32(u8* dest, const u8* src, int count)
+    {
+        const float* s = reinterpret_cast<const float*>(src);
+
+        while (count >= 16)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                __m128i color = avx512_pack_unorm8(_mm512_loadu_ps(s + i * 16));
+                if (swap)
+                {
+                    color = sse4_swap_rb(color);
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i * 16), color);
+            }
+            s += 64;
+            dest += 64;
+            count -= 16;
+        }
+
+        sse4_rgba_u8_from_rgba_f32<swap>(dest, reinterpret_cast<const u8*>(s), count);
+    }
+
+    void avx512_rgba_f32_from_rgba_u8(u8* dest, const u8* src, int count)
+    {
+        float* d = reinterpret_cast<float*>(dest);
+
+        while (count >= 16)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 16));
+                _mm512_storeu_ps(d + i * 16, avx512_unpack_unorm8(color));
+            }
+            src += 64;
+            d += 64;
+            count -= 16;
+        }
+
+        sse4_rgba_f32_from_rgba_u8(reinterpret_cast<u8*>(d), src, count);
+    }
+
+#if defined(MANGO_DISPATCH_F16C)
+
+    template <bool swap>
+    void avx512_rgba_u8_from_rgba_f16(u8* dest, const u8* src, int count)
+    {
+        while (count >= 16)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 32));
+                __m128i color = avx512_pack_unorm8(_mm512_maskz_cvtph_ps(avx512_all, h));
+                if (swap)
+                {
+                    color = sse4_swap_rb(color);
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i * 16), color);
+            }
+            src += 128;
+            dest += 64;
+            count -= 16;
+        }
+
+        sse4_rgba_u8_from_rgba_f16<swap>(dest, src, count);
+    }
+
+    void avx512_rgba_f16_from_rgba_u8(u8* dest, const u8* src, int count)
+    {
+        constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+
+        while (count >= 16)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 16));
+                __m256i h = _mm512_maskz_cvtps_ph(avx512_all, avx512_unpack_unorm8(color), rounding);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + i * 32), h);
+            }
+            src += 64;
+            dest += 128;
+            count -= 16;
+        }
+
+        sse4_rgba_f16_from_rgba_u8(dest, src, count);
+    }
+
+    void avx512_rgba_f16_from_rgba_f32(u8* dest, const u8* src, int count)
+    {
+        constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+        const float* s = reinterpret_cast<const float*>(src);
+
+        while (count >= 8)
+        {
+            __m256i h0 = _mm512_maskz_cvtps_ph(avx512_all, _mm512_loadu_ps(s + 0), rounding);
+            __m256i h1 = _mm512_maskz_cvtps_ph(avx512_all, _mm512_loadu_ps(s + 16), rounding);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + 0), h0);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + 32), h1);
+            s += 32;
+            dest += 64;
+            count -= 8;
+        }
+
+        sse4_rgba_f16_from_rgba_f32(dest, reinterpret_cast<const u8*>(s), count);
+    }
+
+    void avx512_rgba_f32_from_rgba_f16(u8* dest, const u8* src, int count)
+    {
+        float* d = reinterpret_cast<float*>(dest);
+
+        while (count >= 8)
+        {
+            __m256i h0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 0));
+            __m256i h1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 32));
+            _mm512_storeu_ps(d + 0, _mm512_maskz_cvtph_ps(avx512_all, h0));
+            _mm512_storeu_ps(d + 16, _mm512_maskz_cvtph_ps(avx512_all, h1));
+            src += 64;
+            d += 32;
+            count -= 8;
+        }
+
+        sse4_rgba_f32_from_rgba_f16(reinterpret_cast<u8*>(d), src, count);
+    }
+
+#endif // defined(MANGO_DISPATCH_F16C)
+
+MANGO_TARGET_END
+#endif // defined(MANGO_DISPATCH_AVX512)
+
+#if defined(MANGO_ENABLE_NEON)
+
+    // ----------------------------------------------------------------------------
+    // NEON
+    // ----------------------------------------------------------------------------
+
+    void neon_32bit_swap_rg(u8* d, const u8* s, int count)
+    {
+        while (count >= 16)
+        {
+            const uint8x16x4_t a = vld4q_u8(s);
+            uint8x16x4_t b;
+            b.val[0] = a.val[2];
+            b.val[1] = a.val[1];
+            b.val[2] = a.val[0];
+            b.val[3] = a.val[3];
+            vst4q_u8(d, b);
+            s += 64;
+            d += 64;
+            count -= 16;
+        }
+
+        while (count-- > 0)
+        {
+            d[0] = s[2];
+            d[1] = s[1];
+            d[2] = s[0];
+            d[3] = s[3];
+            s += 4;
+            d += 4;
+        }
+    }
+
+    void neon_24bit_swap_rg(u8* d, const u8* s, int count)
+    {
+        while (count >= 16)
+        {
+            const uint8x16x3_t a = vld3q_u8(s);
+            uint8x16x3_t b;
+            b.val[0] = a.val[2];
+            b.val[1] = a.val[1];
+            b.val[2] = a.val[0];
+            vst3q_u8(d, b);
+            s += 48;
+            d += 48;
+            count -= 16;
+        }
+
+        while (count-- > 0)
+        {
+            d[0] = s[2];
+            d[1] = s[1];
+            d[2] = s[0];
+            s += 3;
+            d += 3;
+        }
+    }
+
+#if defined(MANGO_ENABLE_NEON64)
+
+    // The channels are deinterleaved with the structure loads and stores; swapping
+    // red and blue is free.
+
+    static inline
+    uint8x8_t neon_pack_unorm8(float32x4_t v0, float32x4_t v1)
+    {
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        const float32x4_t scale = vdupq_n_f32(255.0f);
+
+        v0 = vmulq_f32(vminq_f32(vmaxq_f32(v0, zero), one), scale);
+        v1 = vmulq_f32(vminq_f32(vmaxq_f32(v1, zero), one), scale);
+
+        uint16x8_t i = vcombine_u16(vmovn_u32(vcvtnq_u32_f32(v0)), vmovn_u32(vcvtnq_u32_f32(v1)));
+        return vmovn_u16(i);
+    }
+
+    static inline
+    float32x4_t neon_unpack_unorm8(uint16x4_t color)
+    {
+        // division instead of reciprocal multiply to match the scalar conversion
+        return vdivq_f32(vcvtq_f32_u32(vmovl_u16(color)), vdupq_n_f32(255.0f));
+    }
+
+    static inline
+    u32 neon_pack_pixel(float32x4_t v)
+    {
+        uint8x8_t color = neon_pack_unorm8(v, v);
+        return vget_lane_u32(vreinterpret_u32_u8(color), 0);
+    }
+
+    template <bool swap>
+    void neon_rgba_u8_from_rgba_f32(u8* dest, const u8* src, int count)
+    {
+        const float* s = reinterpret_cast<const float*>(src);
+
+        while (count >= 8)
+        {
+            const float32x4x4_t a = vld4q_f32(s + 0);
+            const float32x4x4_t b = vld4q_f32(s + 16);
+            uint8x8x4_t color;
+            color.val[swap ? 2 : 0] = neon_pack_unorm8(a.val[0], b.val[0]);
+            color.val[1] = neon_pack_unorm8(a.val[1], b.val[1]);
+            color.val[swap ? 0 : 2] = neon_pack_unorm8(a.val[2], b.val[2]);
+            color.val[3] = neon_pack_unorm8(a.val[3], b.val[3]);
+            vst4_u8(dest, color);
+            s += 32;
+            dest += 32;
+            count -= 8;
+        }
+
+        while (count-- > 0)
+        {
+            float32x4_t v = vld1q_f32(s);
+            if (swap)
+            {
+                v = vcopyq_laneq_f32(vcopyq_laneq_f32(v, 0, v, 2), 2, v, 0);
+            }
+            ustore32(dest, neon_pack_pixel(v));
+            s += 4;
+            dest += 4;
+        }
+    }
+
+    void neon_rgba_f32_from_rgba_u8(u8* dest, const u8* src, int count)
+    {
+        float* d = reinterpret_cast<float*>(dest);
+
+        while (count >= 8)
+        {
+            const uint8x8x4_t color = vld4_u8(src);
+            float32x4x4_t a;
+            float32x4x4_t b;
+            for (int i = 0; i < 4; ++i)
+            {
+                uint16x8_t c = vmovl_u8(color.val[i]);
+                a.val[i] = neon_unpack_unorm8(vget_low_u16(c));
+                b.val[i] = neon_unpack_unorm8(vget_high_u16(c));
+            }
+            vst4q_f32(d + 0, a);
+            vst4q_f32(d + 16, b);
+            src += 32;
+            d += 32;
+            count -= 8;
+        }
+
+        while (count-- > 0)
+        {
+            uint8x8_t color = vreinterpret_u8_u32(vdup_n_u32(uload32(src)));
+            vst1q_f32(d, neon_unpack_unorm8(vget_low_u16(vmovl_u8(color))));
+            src += 4;
+            d += 4;
+        }
+    }
+
+#if defined(MANGO_ENABLE_ARM_FP16)
+
+    template <bool swap>
+    void neon_rgba_u8_from_rgba_f16(u8* dest, const u8* src, int count)
+    {
+        const u16* s = reinterpret_cast<const u16*>(src);
+
+        while (count >= 8)
+        {
+            const uint16x4x4_t a = vld4_u16(s + 0);
+            const uint16x4x4_t b = vld4_u16(s + 16);
+            uint8x8x4_t color;
+            for (int i = 0; i < 4; ++i)
+            {
+                float32x4_t v0 = vcvt_f32_f16(vreinterpret_f16_u16(a.val[i]));
+                float32x4_t v1 = vcvt_f32_f16(vreinterpret_f16_u16(b.val[i]));
+                const int j = swap && i != 1 && i != 3 ? 2 - i : i;
+                color.val[j] = neon_pack_unorm8(v0, v1);
+            }
+            vst4_u8(dest, color);
+            s += 32;
+            dest += 32;
+            count -= 8;
+        }
+
+        while (count-- > 0)
+        {
+            float32x4_t v = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(s)));
+            if (swap)
+            {
+                v = vcopyq_laneq_f32(vcopyq_laneq_f32(v, 0, v, 2), 2, v, 0);
+            }
+            ustore32(dest, neon_pack_pixel(v));
+            s += 4;
+            dest += 4;
+        }
+    }
+
+    void neon_rgba_f16_from_rgba_u8(u8* dest, const u8* src, int count)
+    {
+        u16* d = reinterpret_cast<u16*>(dest);
+
+        while (count >= 4)
+        {
+            uint8x16_t color = vld1q_u8(src);
+            uint16x8_t c0 = vmovl_u8(vget_low_u8(color));
+            uint16x8_t c1 = vmovl_u8(vget_high_u8(color));
+            float16x4_t h0 = vcvt_f16_f32(neon_unpack_unorm8(vget_low_u16(c0)));
+            float16x4_t h1 = vcvt_f16_f32(neon_unpack_unorm8(vget_high_u16(c0)));
+            float16x4_t h2 = vcvt_f16_f32(neon_unpack_unorm8(vget_low_u16(c1)));
+            float16x4_t h3 = vcvt_f16_f32(neon_unpack_unorm8(vget_high_u16(c1)));
+            vst1q_u16(d + 0, vreinterpretq_u16_f16(vcombine_f16(h0, h1)));
+            vst1q_u16(d + 8, vreinterpretq_u16_f16(vcombine_f16(h2, h3)));
+            src += 16;
+            d += 16;
+            count -= 4;
+        }
+
+        while (count-- > 0)
+        {
+            uint8x8_t color = vreinterpret_u8_u32(vdup_n_u32(uload32(src)));
+            float16x4_t h = vcvt_f16_f32(neon_unpack_unorm8(vget_low_u16(vmovl_u8(color))));
+            vst1_u16(d, vreinterpret_u16_f16(h));
+            src += 4;
             d += 4;
         }
     }
 
-#endif // defined(MANGO_ENABLE_AVX2)
-
-#if defined(MANGO_ENABLE_NEON)
-
-    // ----------------------------------------------------------------------------
-    // NEON
-    // ----------------------------------------------------------------------------
-
-    void neon_32bit_swap_rg(u8* d, const u8* s, int count)
+    void neon_rgba_f16_from_rgba_f32(u8* dest, const u8* src, int count)
     {
-        while (count >= 16)
+        u16* d = reinterpret_cast<u16*>(dest);
+        const float* s = reinterpret_cast<const float*>(src);
+
+        while (count >= 2)
         {
-            const uint8x16x4_t a = vld4q_u8(s);
-            uint8x16x4_t b;
-            b.val[0] = a.val[2];
-            b.val[1] = a.val[1];
-            b.val[2] = a.val[0];
-            b.val[3] = a.val[3];
-            vst4q_u8(d, b);
-            s += 64;
-            d += 64;
-            count -= 16;
+            float16x4_t h0 = vcvt_f16_f32(vld1q_f32(s + 0));
+            float16x4_t h1 = vcvt_f16_f32(vld1q_f32(s + 4));
+            vst1q_u16(d, vreinterpretq_u16_f16(vcombine_f16(h0, h1)));
+            s += 8;
+            d += 8;
+            count -= 2;
         }
 
-        while (count-- > 0)
+        if (count > 0)
         {
-            d[0] = s[2];
-            d[1] = s[1];
-            d[2] = s[0];
-            d[3] = s[3];
-            s += 4;
-            d += 4;
+            vst1_u16(d, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(s))));
         }
     }
 
-    void neon_24bit_swap_rg(u8* d, const u8* s, int count)
+    void neon_rgba_f32_from_rgba_f16(u8* dest, const u8* src, int count)
     {
-        while (count >= 16)
+        float* d = reinterpret_cast<float*>(dest);
+        const u16* s = reinterpret_cast<const u16*>(src);
+
+        while (count >= 2)
         {
-            const uint8x16x3_t a = vld3q_u8(s);
-            uint8x16x3_t b;
-            b.val[0] = a.val[2];
-            b.val[1] = a.val[1];
-            b.val[2] = a.val[0];
-            vst3q_u8(d, b);
-            s += 48;
-            d += 48;
-            count -= 16;
+            float16x8_t h = vreinterpretq_f16_u16(vld1q_u16(s));
+            vst1q_f32(d + 0, vcvt_f32_f16(vget_low_f16(h)));
+            vst1q_f32(d + 4, vcvt_f32_f16(vget_high_f16(h)));
+            s += 8;
+            d += 8;
+            count -= 2;
         }
 
-        while (count-- > 0)
+        if (count > 0)
         {
-            d[0] = s[2];
-            d[1] = s[1];
-            d[2] = s[0];
-            s += 3;
-            d += 3;
+            vst1q_f32(d, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(s))));
         }
     }
 
+#endif // defined(MANGO_ENABLE_ARM_FP16)
+
+#endif // defined(MANGO_ENABLE_NEON64)
+
 #endif // defined(MANGO_ENABLE_NEON)
 
     // ----------------------------------------------------------------------------
@@ -2749,7 +3498,7 @@ namespace
             {
                 float32x4 f = convert<float32x4>(s[x]);
                 f = clamp(f, 0.0f, 1.0f);
-                f = f * 255.0f + 0.5f;
+                f = f * 255.0f;
                 int32x4 i = convert<int32x4>(f);
                 d[x] = i.pack();
             }
@@ -2770,7 +3519,7 @@ namespace
                 float32x4 f = convert<float32x4>(s[x]);
                 f = f.zyxw;
                 f = clamp(f, 0.0f, 1.0f);
-                f = f * 255.0f + 0.5f;
+                f = f * 255.0f;
                 int32x4 i = convert<int32x4>(f);
                 d[x] = i.pack();
             }
@@ -2872,7 +3621,7 @@ namespace
 
             while (count-- > 0)
             {
-                float32x4 v = clamp(float32x4::uload(s), 0.0f, 1.0f) * 255.0f;// + 0.5f;
+                float32x4 v = clamp(float32x4::uload(s), 0.0f, 1.0f) * 255.0f;
                 int32x4 color = convert<int32x4>(v);
                 *d++ = color.pack();
                 ++s;
@@ -2894,7 +3643,7 @@ namespace
                 float32x4 f = s[x];
                 f = f.zyxw;
                 f = clamp(f, 0.0f, 1.0f);
-                f = f * 255.0f + 0.5f;
+                f = f * 255.0f;
                 int32x4 i = convert<int32x4>(f);
                 d[x] = i.pack();
             }
@@ -3003,7 +3752,7 @@ namespace
 
 #endif // MANGO_ENABLE_SSE2
 
-#if defined(MANGO_ENABLE_SSE4_1)
+#if defined(MANGO_DISPATCH_SSE4_1)
 
     // ----------------------------------------------------------------------------
     // SSE4.1
@@ -3012,46 +3761,111 @@ namespace
     {
         Format(32, Format::UNORM, Format::RGB, 8, 8, 8),
         Format(32, Format::UNORM, Format::BGR, 8, 8, 8),
-        INTEL_SSE4_1,
+        TARGET_SSE4_1,
         sse4_32bit_swap_rg
     },
 
     {
         Format(32, Format::UNORM, Format::BGR, 8, 8, 8),
         Format(32, Format::UNORM, Format::RGB, 8, 8, 8),
-        INTEL_SSE4_1,
+        TARGET_SSE4_1,
         sse4_32bit_swap_rg
     },
 
     {
         Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
         Format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8),
-        INTEL_SSE4_1,
+        TARGET_SSE4_1,
         sse4_32bit_swap_rg
     },
 
     {
         Format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8),
         Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
-        INTEL_SSE4_1,
+        TARGET_SSE4_1,
         sse4_32bit_swap_rg
     },
 
     {
         Format(24, Format::UNORM, Format::RGB, 8, 8, 8),
         Format(24, Format::UNORM, Format::BGR, 8, 8, 8),
-        INTEL_SSE4_1,
+        TARGET_SSE4_1,
         sse4_24bit_swap_rg
     },
 
     {
         Format(24, Format::UNORM, Format::BGR, 8, 8, 8),
         Format(24, Format::UNORM, Format::RGB, 8, 8, 8),
-        INTEL_SSE4_1,
+        TARGET_SSE4_1,
         sse4_24bit_swap_rg
     },
 
-#endif // MANGO_ENABLE_SSE4_1
+    // rgba.u8 <-> rgba.f32
+
+    {
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        TARGET_SSE4_1,
+        sse4_rgba_u8_from_rgba_f32<false>
+    },
+
+    {
+        Format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8),
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        TARGET_SSE4_1,
+        sse4_rgba_u8_from_rgba_f32<true>
+    },
+
+    {
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        TARGET_SSE4_1,
+        sse4_rgba_f32_from_rgba_u8
+    },
+
+#if defined(MANGO_DISPATCH_F16C)
+
+    // rgba.u8 <-> rgba.f16
+    // rgba.f16 <-> rgba.f32
+
+    {
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        TARGET_F16C,
+        sse4_rgba_u8_from_rgba_f16<false>
+    },
+
+    {
+        Format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8),
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        TARGET_F16C,
+        sse4_rgba_u8_from_rgba_f16<true>
+    },
+
+    {
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        TARGET_F16C,
+        sse4_rgba_f16_from_rgba_u8
+    },
+
+    {
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        TARGET_F16C,
+        sse4_rgba_f16_from_rgba_f32
+    },
+
+    {
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        TARGET_F16C,
+        sse4_rgba_f32_from_rgba_f16
+    },
+
+#endif // MANGO_DISPATCH_F16C
+
+#endif // MANGO_DISPATCH_SSE4_1
 
 #if defined(MANGO_ENABLE_AVX)
 
@@ -3072,7 +3886,7 @@ namespace
 
 #endif // MANGO_ENABLE_AVX
 
-#if defined(MANGO_ENABLE_AVX2)
+#if defined(MANGO_DISPATCH_AVX2)
 
     // ----------------------------------------------------------------------------
     // AVX2
@@ -3081,32 +3895,170 @@ namespace
     {
         Format(32, Format::UNORM, Format::RGB, 8, 8, 8),
         Format(32, Format::UNORM, Format::BGR, 8, 8, 8),
-        INTEL_AVX2,
+        TARGET_AVX2,
         avx2_32bit_swap_rg
     },
 
     {
         Format(32, Format::UNORM, Format::BGR, 8, 8, 8),
         Format(32, Format::UNORM, Format::RGB, 8, 8, 8),
-        INTEL_AVX2,
+        TARGET_AVX2,
         avx2_32bit_swap_rg
     },
 
     {
         Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
         Format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8),
-        INTEL_AVX2,
+        TARGET_AVX2,
         avx2_32bit_swap_rg
     },
 
     {
         Format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8),
         Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
-        INTEL_AVX2,
+        TARGET_AVX2,
         avx2_32bit_swap_rg
     },
 
-#endif // MANGO_ENABLE_AVX2
+    // rgba.u8 <-> rgba.f32
+
+    {
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        TARGET_AVX2,
+        avx2_rgba_u8_from_rgba_f32<false>
+    },
+
+    {
+        Format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8),
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        TARGET_AVX2,
+        avx2_rgba_u8_from_rgba_f32<true>
+    },
+
+    {
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        TARGET_AVX2,
+        avx2_rgba_f32_from_rgba_u8
+    },
+
+#if defined(MANGO_DISPATCH_F16C)
+
+    // rgba.u8 <-> rgba.f16
+    // rgba.f16 <-> rgba.f32
+
+    {
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        TARGET_AVX2,
+        avx2_rgba_u8_from_rgba_f16<false>
+    },
+
+    {
+        Format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8),
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        TARGET_AVX2,
+        avx2_rgba_u8_from_rgba_f16<true>
+    },
+
+    {
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        TARGET_AVX2,
+        avx2_rgba_f16_from_rgba_u8
+    },
+
+    {
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        TARGET_AVX2,
+        avx2_rgba_f16_from_rgba_f32
+    },
+
+    {
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        TARGET_AVX2,
+        avx2_rgba_f32_from_rgba_f16
+    },
+
+#endif // MANGO_DISPATCH_F16C
+
+#endif // MANGO_DISPATCH_AVX2
+
+#if defined(MANGO_DISPATCH_AVX512)
+
+    // ----------------------------------------------------------------------------
+    // AVX-512
+    // ----------------------------------------------------------------------------
+
+    // rgba.u8 <-> rgba.f32
+
+    {
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        TARGET_AVX512,
+        avx512_rgba_u8_from_rgba_f32<false>
+    },
+
+    {
+        Format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8),
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        TARGET_AVX512,
+        avx512_rgba_u8_from_rgba_f32<true>
+    },
+
+    {
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        TARGET_AVX512,
+        avx512_rgba_f32_from_rgba_u8
+    },
+
+#if defined(MANGO_DISPATCH_F16C)
+
+    // rgba.u8 <-> rgba.f16
+    // rgba.f16 <-> rgba.f32
+
+    {
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        TARGET_AVX512,
+        avx512_rgba_u8_from_rgba_f16<false>
+    },
+
+    {
+        Format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8),
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        TARGET_AVX512,
+        avx512_rgba_u8_from_rgba_f16<true>
+    },
+
+    {
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        TARGET_AVX512,
+        avx512_rgba_f16_from_rgba_u8
+    },
+
+    {
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        TARGET_AVX512,
+        avx512_rgba_f16_from_rgba_f32
+    },
+
+    {
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        TARGET_AVX512,
+        avx512_rgba_f32_from_rgba_f16
+    },
+
+#endif // MANGO_DISPATCH_F16C
+
+#endif // MANGO_DISPATCH_AVX512
 
 #if defined(MANGO_ENABLE_NEON)
 
@@ -3188,6 +4140,75 @@ namespace
         }
     },
 
+#if defined(MANGO_ENABLE_NEON64)
+
+    // rgba.u8 <-> rgba.f32
+
+    {
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        ARM_NEON,
+        neon_rgba_u8_from_rgba_f32<false>
+    },
+
+    {
+        Format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8),
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        ARM_NEON,
+        neon_rgba_u8_from_rgba_f32<true>
+    },
+
+    {
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        ARM_NEON,
+        neon_rgba_f32_from_rgba_u8
+    },
+
+#if defined(MANGO_ENABLE_ARM_FP16)
+
+    // rgba.u8 <-> rgba.f16
+    // rgba.f16 <-> rgba.f32
+
+    {
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        ARM_NEON | ARM_FP16,
+        neon_rgba_u8_from_rgba_f16<false>
+    },
+
+    {
+        Format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8),
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        ARM_NEON | ARM_FP16,
+        neon_rgba_u8_from_rgba_f16<true>
+    },
+
+    {
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8),
+        ARM_NEON | ARM_FP16,
+        neon_rgba_f16_from_rgba_u8
+    },
+
+    {
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        ARM_NEON | ARM_FP16,
+        neon_rgba_f16_from_rgba_f32
+    },
+
+    {
+        Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32),
+        Format(64, Format::FLOAT16, Format::RGBA, 16, 16, 16, 16),
+        ARM_NEON | ARM_FP16,
+        neon_rgba_f32_from_rgba_f16
+    },
+
+#endif // defined(MANGO_ENABLE_ARM_FP16)
+
+#endif // MANGO_ENABLE_NEON64
+
 #endif // MANGO_ENABLE_NEON
 
     }; // end of custom blitter
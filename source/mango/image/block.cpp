@@ -1360,6 +1360,29 @@ namespace
         }
     }
 
+    // Replicate the last column and row of the (width x height) source area into
+    // the padding so that the partial blocks are compressed deterministically.
+    void padBlockEdges(const Surface& surface, int width, int height)
+    {
+        const int bpp = surface.format.bytes();
+
+        for (int y = 0; y < height; ++y)
+        {
+            u8* scan = surface.address(0, y);
+            const u8* last = scan + (width - 1) * bpp;
+
+            for (int x = width; x < surface.width; ++x)
+            {
+                std::memcpy(scan + x * bpp, last, bpp);
+            }
+        }
+
+        for (int y = height; y < surface.height; ++y)
+        {
+            std::memcpy(surface.address(0, y), surface.address(0, height - 1), surface.width * bpp);
+        }
+    }
+
 } // namespace
 
 namespace mango::image
@@ -1527,6 +1550,7 @@ namespace mango::image
         if (encodeSurface)
         {
             TemporaryBitmap temp(surface, compressed_width, compressed_height, format);
+            padBlockEdges(temp, std::min(surface.width, compressed_width), std::min(surface.height, compressed_height));
             encodeSurface(*this, memory.address, temp);
         }
         else
@@ -1546,6 +1570,7 @@ namespace mango::image
 
                     Surface source(surface, 0, y * height, source_width, source_height);
                     temp.blit(0, 0, source);
+                    padBlockEdges(temp, source_width, source_height);
 
                     u8* data = address + y * xblocks * bytes;
                     u8* image = temp.image;
@@ -3,6 +3,7 @@
     Copyright (C) 2012-2024 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
 #include <map>
+#include <algorithm>
 #include <mango/core/system.hpp>
 #include <mango/math/math.hpp>
 #include <mango/image/image.hpp>
@@ -130,6 +131,7 @@ namespace mango::image
     protected:
         std::map<std::string, ImageDecoder::CreateDecodeFunc> m_decoders;
         std::map<std::string, ImageEncoder::EncodeFunc> m_encoders;
+        std::map<std::string, AnimationEncoder::CreateEncodeFunc> m_animation_encoders;
 
     public:
         ImageServer()
@@ -181,6 +183,12 @@ namespace mango::image
             m_encoders[s] = func;
         }
 
+        void registerAnimationEncoder(AnimationEncoder::CreateEncodeFunc func, const std::string& extension)
+        {
+            std::string s = toLower(extension);
+            m_animation_encoders[s] = func;
+        }
+
         ImageDecoder::CreateDecodeFunc getImageDecoder(const std::string& extension) const
         {
             auto i = m_decoders.find(extension);
@@ -192,6 +200,12 @@ namespace mango::image
             auto i = m_encoders.find(extension);
             return i != m_encoders.end() ? i->second : nullptr;
         }
+
+        AnimationEncoder::CreateEncodeFunc getAnimationEncoder(const std::string& extension) const
+        {
+            auto i = m_animation_encoders.find(extension);
+            return i != m_animation_encoders.end() ? i->second : nullptr;
+        }
     } g_imageServer;
 
     void registerImageDecoder(ImageDecoder::CreateDecodeFunc func, const std::string& extension)
@@ -204,6 +218,11 @@ namespace mango::image
         g_imageServer.registerImageEncoder(func, extension);
     }
 
+    void registerAnimationEncoder(AnimationEncoder::CreateEncodeFunc func, const std::string& extension)
+    {
+        g_imageServer.registerAnimationEncoder(func, extension);
+    }
+
     bool isImageDecoder(const std::string& filename)
     {
         std::string extension = getLowerCaseExtension(filename);
@@ -218,6 +237,13 @@ namespace mango::image
         return func != nullptr;
     }
 
+    bool isAnimationEncoder(const std::string& filename)
+    {
+        std::string extension = getLowerCaseExtension(filename);
+        auto func = g_imageServer.getAnimationEncoder(extension);
+        return func != nullptr;
+    }
+
     // ----------------------------------------------------------------------------
     // ImageDecodeInterface
     // ----------------------------------------------------------------------------
@@ -230,11 +256,158 @@ namespace mango::image
         return ConstMemory();
     }
 
+    // ----------------------------------------------------------------------------
+    // ImageDecodeScheduler
+    // ----------------------------------------------------------------------------
+
+    struct ImageDecodeScheduler::State
+    {
+        struct Job
+        {
+            int priority;
+            u64 sequence;
+            std::function<void()> func;
+
+            // heap order: higher priority first, same priority in submission order
+            bool operator < (const Job& job) const
+            {
+                if (priority != job.priority)
+                    return priority < job.priority;
+                return sequence > job.sequence;
+            }
+        };
+
+        // number of scheduled decodes running in the calling thread
+        static inline thread_local int depth = 0;
+
+        ThreadPool& pool;
+        const int concurrency;
+
+        std::mutex mutex;
+        std::condition_variable idle;
+        std::vector<Job> jobs;
+        u64 sequence = 0;
+        int running = 0;
+
+        State(ThreadPool& pool, int concurrency)
+            : pool(pool)
+            , concurrency(concurrency > 0 ? concurrency : std::max(1, pool.size()))
+        {
+        }
+
+        ~State()
+        {
+            // the workers use the state until the queued jobs are complete
+            std::unique_lock<std::mutex> lock(mutex);
+            idle.wait(lock, [this] { return !running; });
+        }
+
+        void enqueue(int priority, std::function<void()>&& func)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                jobs.push_back({ priority, sequence++, std::move(func) });
+                std::push_heap(jobs.begin(), jobs.end());
+
+                if (running >= concurrency)
+                {
+                    // a running worker will pick up the job
+                    return;
+                }
+
+                ++running;
+            }
+
+            schedule();
+        }
+
+        void schedule()
+        {
+            pool.enqueue([this]
+            {
+                work();
+            });
+        }
+
+        // The worker runs jobs until there are no more waiting. A decoder waiting for its
+        // parallel work helps the pool; when it picks up a worker the worker goes back to the
+        // queue so that the decodes don't nest on the stack of the waiting decoder.
+        void work()
+        {
+            if (depth > 0)
+            {
+                schedule();
+                return;
+            }
+
+            for (;;)
+            {
+                std::function<void()> func;
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    if (jobs.empty())
+                    {
+                        // notify while holding the lock; the state is destroyed when idle
+                        if (!--running)
+                        {
+                            idle.notify_all();
+                        }
+                        return;
+                    }
+
+                    std::pop_heap(jobs.begin(), jobs.end());
+                    func = std::move(jobs.back().func);
+                    jobs.pop_back();
+                }
+
+                ++depth;
+                func();
+                --depth;
+            }
+        }
+    };
+
+    ImageDecodeScheduler::ImageDecodeScheduler(int concurrency)
+        : m_state(std::make_unique<State>(ThreadPool::getInstance(), concurrency))
+    {
+    }
+
+    ImageDecodeScheduler::ImageDecodeScheduler(ThreadPool& pool, int concurrency)
+        : m_state(std::make_unique<State>(pool, concurrency))
+    {
+    }
+
+    ImageDecodeScheduler::~ImageDecodeScheduler()
+    {
+        // the destructor waits until the queued jobs are complete
+    }
+
+    ImageDecodeScheduler& ImageDecodeScheduler::getInstance()
+    {
+        static ImageDecodeScheduler scheduler;
+        return scheduler;
+    }
+
+    void ImageDecodeScheduler::enqueue(int priority, std::function<void()>&& func)
+    {
+        m_state->enqueue(priority, std::move(func));
+    }
+
+    size_t ImageDecodeScheduler::getQueueSize() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->jobs.size();
+    }
+
     // ----------------------------------------------------------------------------
     // ImageDecoder
     // ----------------------------------------------------------------------------
 
     ImageDecoder::ImageDecoder(ConstMemory memory, const std::string& filename)
+        : m_memory_size(memory.size)
     {
         // Inspect signature to determine image format
         std::string extension = getImageFormatExtension(memory);
@@ -289,7 +462,10 @@ namespace mango::image
 
         if (m_interface)
         {
+            resetCancellation(options);
+
             Trace trace("ImageDecoder", m_interface->name);
+            ImageCodecStats::Scope scope(options.stats, ImageCodecStats::TOTAL, m_memory_size);
             status = m_interface->decode(dest, options, level, depth, face);
         }
         else
@@ -302,52 +478,90 @@ namespace mango::image
 
     ImageDecodeFuture ImageDecoder::launch(ImageDecodeCallback callback, const Surface& dest, const ImageDecodeOptions& options, int level, int depth, int face)
     {
-        if (m_interface)
+        Promise<ImageDecodeStatus> promise;
+        ImageDecodeFuture future = promise.getFuture();
+
+        if (!m_interface)
         {
-            if (m_interface.use_count() > 1)
-            {
-                MANGO_EXCEPTION("[ImageDecoder] async decoding already in progress.");
-            }
+            ImageDecodeStatus status;
+            status.setError("[WARNING] decode() is not supported for this extension.");
+            promise.set(status);
+            return future;
+        }
 
-            m_interface->callback = std::move(callback);
+        // the job holds a reference to the interface until the decoding is complete
+        if (m_interface.use_count() > 1)
+        {
+            MANGO_EXCEPTION("[ImageDecoder] async decoding already in progress.");
         }
 
-        return std::async(std::launch::async, [=] (std::shared_ptr<ImageDecodeInterface> interface)
+        m_interface->callback = std::move(callback);
+        resetCancellation(options);
+
+        ImageDecodeScheduler& scheduler = options.scheduler ? *options.scheduler : ImageDecodeScheduler::getInstance();
+
+        scheduler.enqueue(options.priority, [=, interface = m_interface, size = m_memory_size] () mutable
         {
             ImageDecodeStatus status;
 
-            if (interface)
+            try
             {
-                Trace trace("ImageDecoder", interface->name);
-                status = interface->decode(dest, options, level, depth, face);
-
-                if (!interface->async)
+                if (interface->cancelled)
                 {
-                    ImageDecodeRect rect;
-
-                    rect.x = 0;
-                    rect.y = 0;
-                    rect.width = interface->header.width;
-                    rect.height = interface->header.height;
-                    rect.progress = 1.0f;
-
-                    interface->callback(rect);
+                    status.setError("[ImageDecoder] decoding was cancelled before it started.");
+                }
+                else
+                {
+                    Trace trace("ImageDecoder", interface->name);
+                    ImageCodecStats::Scope scope(options.stats, ImageCodecStats::TOTAL, size);
+                    status = interface->decode(dest, options, level, depth, face);
+
+                    if (!interface->async && interface->callback)
+                    {
+                        ImageDecodeRect rect;
+
+                        rect.x = 0;
+                        rect.y = 0;
+                        rect.width = interface->header.width;
+                        rect.height = interface->header.height;
+                        rect.progress = 1.0f;
+
+                        interface->callback(rect);
+                    }
                 }
             }
-            else
+            catch (...)
             {
-                status.setError("[WARNING] decode() is not supported for this extension.");
+                interface.reset();
+                promise.setException(std::current_exception());
+                return;
             }
 
-            return status;
-        }, m_interface);
+            // release the decoder before the continuations so that they can launch it again
+            interface.reset();
+            promise.set(status);
+        });
+
+        return future;
+    }
+
+    void ImageDecoder::resetCancellation(const ImageDecodeOptions& options)
+    {
+        if (options.cancellation)
+        {
+            m_interface->cancelled.reset(*options.cancellation);
+        }
+        else
+        {
+            m_interface->cancelled.reset();
+        }
     }
 
     void ImageDecoder::cancel()
     {
         if (m_interface)
         {
-            m_interface->cancelled = true;
+            m_interface->cancelled.cancel();
         }
     }
 
@@ -412,7 +626,15 @@ namespace mango::image
 
         if (m_encode_func)
         {
+            ImageCodecStats::Scope scope(options.stats, ImageCodecStats::TOTAL);
+            u64 size = options.stats ? output.size() : 0;
+
             status = m_encode_func(output, source, options);
+
+            if (options.stats)
+            {
+                scope.setBytes(output.size() - size);
+            }
         }
         else
         {
@@ -422,4 +644,59 @@ namespace mango::image
         return status;
     }
 
+    // ----------------------------------------------------------------------------
+    // AnimationEncoder
+    // ----------------------------------------------------------------------------
+
+    AnimationEncoder::AnimationEncoder(Stream& output, const std::string& filename, const ImageEncodeOptions& options)
+    {
+        std::string extension = getLowerCaseExtension(filename);
+        auto func = g_imageServer.getAnimationEncoder(extension);
+        if (func)
+        {
+            m_interface.reset(func(output, options));
+        }
+    }
+
+    AnimationEncoder::~AnimationEncoder()
+    {
+    }
+
+    bool AnimationEncoder::isEncoder() const
+    {
+        return m_interface != nullptr;
+    }
+
+    ImageEncodeStatus AnimationEncoder::addFrame(const Surface& frame, int delay_numerator, int delay_denominator)
+    {
+        ImageEncodeStatus status;
+
+        if (m_interface)
+        {
+            status = m_interface->addFrame(frame, delay_numerator, delay_denominator);
+        }
+        else
+        {
+            status.setError("[WARNING] AnimationEncoder::addFrame() is not supported for this extension.");
+        }
+
+        return status;
+    }
+
+    ImageEncodeStatus AnimationEncoder::finish()
+    {
+        ImageEncodeStatus status;
+
+        if (m_interface)
+        {
+            status = m_interface->finish();
+        }
+        else
+        {
+            status.setError("[WARNING] AnimationEncoder::finish() is not supported for this extension.");
+        }
+
+        return status;
+    }
+
 } // namespace mango::image
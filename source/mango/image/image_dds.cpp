@@ -4,6 +4,8 @@
 */
 #include <mango/core/system.hpp>
 #include <mango/core/pointer.hpp>
+#include <mango/core/buffer.hpp>
+#include <mango/core/thread.hpp>
 #include <mango/image/image.hpp>
 
 namespace
@@ -1221,6 +1223,170 @@ namespace
         return x;
     }
 
+    // ------------------------------------------------------------
+    // ImageEncoder
+    // ------------------------------------------------------------
+
+    ImageEncodeStatus imageEncode(Stream& stream, const Surface& surface, const ImageEncodeOptions& options)
+    {
+        ImageEncodeStatus status;
+
+        const u32 compression = options.block_compression;
+        TextureCompression info(compression);
+
+        bool is_float;
+        u32 dxgiFormat;
+
+        if (compression != TextureCompression::NONE)
+        {
+            if ((!info.encodeBlock && !info.encodeSurface) || !info.dxgi)
+            {
+                status.setError("[ImageEncoder.DDS] Unsupported compression ({:#x}).", compression);
+                return status;
+            }
+
+            is_float = info.format.isFloat();
+            dxgiFormat = info.dxgi;
+        }
+        else
+        {
+            is_float = surface.format.isFloat();
+            dxgiFormat = is_float ? DXGI_FORMAT_R32G32B32A32_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM;
+        }
+
+        // the mipmaps are generated in this format
+        const Format format = is_float ? Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32)
+                                       : Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8);
+
+        const int levels = options.mipmaps ? u32_log2(std::max(surface.width, surface.height)) + 1 : 1;
+
+        std::vector<std::unique_ptr<Bitmap>> images(levels);
+        std::vector<Buffer> buffers(levels);
+        std::vector<TextureCompression::Status> results(levels);
+
+        ConcurrentQueue queue("dds.encoder");
+
+        // the levels are compressed in parallel while the next levels are generated
+        for (int level = 0; level < levels; ++level)
+        {
+            if (!level)
+            {
+                images[level] = std::make_unique<Bitmap>(surface, format);
+            }
+            else
+            {
+                const Bitmap& prev = *images[level - 1];
+                images[level] = std::make_unique<Bitmap>(std::max(1, prev.width / 2), std::max(1, prev.height / 2), format);
+                mipmap(*images[level], prev);
+            }
+
+            if (compression != TextureCompression::NONE)
+            {
+                queue.enqueue([&, level]
+                {
+                    const Bitmap& image = *images[level];
+                    buffers[level].reset(info.getBlockBytes(image.width, image.height));
+                    results[level] = info.compress(buffers[level], image);
+                });
+            }
+        }
+
+        queue.wait();
+
+        for (auto& result : results)
+        {
+            if (!result)
+            {
+                status.setError("[ImageEncoder.DDS] {}", result.info);
+                return status;
+            }
+        }
+
+        const int width = surface.width;
+        const int height = surface.height;
+
+        u32 flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT;
+        u32 pitchOrLinearSize;
+
+        if (compression != TextureCompression::NONE)
+        {
+            flags |= DDSD_LINEARSIZE;
+            pitchOrLinearSize = u32(info.getBlockBytes(width, height));
+        }
+        else
+        {
+            flags |= DDSD_PITCH;
+            pitchOrLinearSize = u32(width * format.bytes());
+        }
+
+        u32 caps = DDSCAPS_TEXTURE;
+        if (levels > 1)
+        {
+            caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+        }
+
+        LittleEndianStream s = stream;
+
+        // header
+        s.write32(FOURCC_DDS);
+        s.write32(124);
+        s.write32(flags);
+        s.write32(height);
+        s.write32(width);
+        s.write32(pitchOrLinearSize);
+        s.write32(0); // depth
+        s.write32(levels);
+
+        for (int i = 0; i < 11; ++i)
+        {
+            s.write32(0); // reserved
+        }
+
+        // pixel format
+        s.write32(32);
+        s.write32(DDPF_FOURCC);
+        s.write32(FOURCC_DX10);
+        s.write32(0); // bits
+        s.write32(0); // red mask
+        s.write32(0); // green mask
+        s.write32(0); // blue mask
+        s.write32(0); // alpha mask
+
+        s.write32(caps);
+        s.write32(0); // caps2
+        s.write32(0); // caps3
+        s.write32(0); // caps4
+        s.write32(0); // reserved
+
+        // DX10 header
+        s.write32(dxgiFormat);
+        s.write32(3); // resource dimension: texture2d
+        s.write32(0); // misc flags
+        s.write32(1); // array size
+        s.write32(0); // misc flags 2
+
+        // levels
+        for (int level = 0; level < levels; ++level)
+        {
+            if (compression != TextureCompression::NONE)
+            {
+                s.write(buffers[level].data(), buffers[level].size());
+            }
+            else
+            {
+                const Bitmap& image = *images[level];
+                const size_t bytes = image.width * format.bytes();
+
+                for (int y = 0; y < image.height; ++y)
+                {
+                    s.write(image.address(0, y), bytes);
+                }
+            }
+        }
+
+        return status;
+    }
+
 } // namespace
 
 namespace mango::image
@@ -1229,6 +1395,7 @@ namespace mango::image
     void registerImageCodecDDS()
     {
         registerImageDecoder(createInterface, ".dds");
+        registerImageEncoder(imageEncode, ".dds");
     }
 
 } // namespace mango::image
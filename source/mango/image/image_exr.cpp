@@ -1508,9 +1508,7 @@ struct ContextEXR
 
     u16 m_log_table[0x10000];
 
-    u64 m_time_decompress = 0;
-    u64 m_time_blit = 0;
-    u64 m_time_decode = 0;
+    ImageCodecStats* m_stats = nullptr;
 
     Buffer m_image_buffer;
     Surface m_surface;
@@ -1563,13 +1561,6 @@ struct ContextEXR
             s[i] = m_log_table[s[i]];
         }
     }
-
-    void report()
-    {
-        printLine(Print::Info, "  decompress: {}.{} ms (cpu time)", m_time_decompress / 1000, m_time_decompress % 1000);
-        printLine(Print::Info, "  blit: {}.{} ms (cpu time)", m_time_blit / 1000, m_time_blit % 1000);
-        printLine(Print::Info, "  decode: {}.{} ms", m_time_decode / 1000, m_time_decode % 1000);
-    }
 };
 
 ContextEXR::ContextEXR(ConstMemory memory)
@@ -2594,7 +2585,7 @@ void ContextEXR::decodeBlock(Surface surface, ConstMemory memory, int x0, int y0
 
     const u8* src = nullptr;
 
-    u64 time0 = mango::Time::us();
+    ImageCodecStats::Laps laps(m_stats);
 
     switch (m_attributes.compression)
     {
@@ -2645,7 +2636,7 @@ void ContextEXR::decodeBlock(Surface surface, ConstMemory memory, int x0, int y0
         return;
     }
 
-    u64 time1 = mango::Time::us();
+    laps.lap(ImageCodecStats::INFLATE, buffer.size());
 
     // select first layer
     const Layer& layer = m_attributes.chlist.layers[0];
@@ -2668,10 +2659,7 @@ void ContextEXR::decodeBlock(Surface surface, ConstMemory memory, int x0, int y0
             break;
     }
 
-    u64 time2 = mango::Time::us();
-
-    m_time_decompress += (time1 - time0);
-    m_time_blit += (time2 - time1);
+    laps.lap(ImageCodecStats::COLOR, u64(blockWidth) * blockHeight * surface.format.bytes());
 }
 
 void ContextEXR::decodeImage(const ImageDecodeOptions& options)
@@ -2682,6 +2670,8 @@ void ContextEXR::decodeImage(const ImageDecodeOptions& options)
         return;
     }
 
+    m_stats = options.stats;
+
     int width = m_header.width;
     int height = m_header.height * std::max(1, m_header.faces);
     size_t stride = width * m_header.format.bytes();
@@ -2695,8 +2685,6 @@ void ContextEXR::decodeImage(const ImageDecodeOptions& options)
         m_surface.stride = -m_surface.stride;
     }
 
-    u64 time0 = mango::Time::us();
-
     LittleEndianConstPointer p = m_pointer;
 
     ConcurrentQueue q;
@@ -2799,11 +2787,6 @@ void ContextEXR::decodeImage(const ImageDecodeOptions& options)
     }
 
     q.wait();
-
-    u64 time1 = mango::Time::us();
-    m_time_decode += (time1 - time0);
-
-    report();
 }
 
 ImageDecodeStatus ContextEXR::decode(const Surface& dest, const ImageDecodeOptions& options, int level, int depth, int face)
@@ -2830,6 +2813,7 @@ ImageDecodeStatus ContextEXR::decode(const Surface& dest, const ImageDecodeOptio
     if (face == 4) face = 5;
     else if (face == 5) face = 4;
 
+    ImageCodecStats::Scope scope(options.stats, ImageCodecStats::BLIT, u64(width) * height * dest.format.bytes());
     dest.blit(0, 0, Surface(m_surface, 0, face * height, width, (face + 1) * height));
 
     return status;
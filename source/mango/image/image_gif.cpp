@@ -8,7 +8,9 @@
 */
 #include <algorithm>
 #include <mango/core/pointer.hpp>
+#include <mango/core/buffer.hpp>
 #include <mango/core/system.hpp>
+#include <mango/core/thread.hpp>
 #include <mango/image/image.hpp>
 
 namespace
@@ -111,9 +113,6 @@ namespace
     struct gif_state
     {
         gif_logical_screen_descriptor screen_desc;
-        gif_image_descriptor image_desc;
-
-        bool first_frame = true;
 
         u16 delay = 2; // default: 50 Hz
         int disposal_method = 0;
@@ -122,6 +121,33 @@ namespace
         u8 transparent_color = 0;
     };
 
+    struct gif_frame
+    {
+        gif_image_descriptor image_desc;
+
+        // graphics control extension state for the frame
+        u16 delay;
+        int disposal_method;
+        int transparent_color_flag;
+        u8 transparent_color;
+
+        // lzw compressed data; minimum code size followed by the data sub-blocks
+        const u8* data;
+
+        int bytes() const
+        {
+            return image_desc.width * image_desc.height;
+        }
+    };
+
+    struct gif_rect
+    {
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+
     const u8* lzw_decode(u8* dest, u8* dest_end, const u8* src, const u8* src_end)
     {
         constexpr int MAX_STACK_SIZE = 8192;
@@ -341,10 +367,27 @@ namespace
         }
     }
 
-    const u8* read_image(const u8* data, const u8* end, gif_state& state, Surface& target)
+    void decode_frame(u8* bits, const gif_frame& frame, const u8* end)
     {
-        gif_image_descriptor image_desc;
-        data = image_desc.read(data, end);
+        const int width = frame.image_desc.width;
+        const int height = frame.image_desc.height;
+        const int bytes = frame.bytes();
+
+        // decode gif bit stream
+        lzw_decode(bits, bits + bytes, frame.data, end);
+
+        // deinterlace
+        if (frame.image_desc.interlaced())
+        {
+            std::unique_ptr<u8[]> temp(new u8[bytes]);
+            deinterlace(temp.get(), bits, width, height);
+            std::memcpy(bits, temp.get(), bytes);
+        }
+    }
+
+    void composite_frame(Surface& target, const gif_frame& frame, const gif_state& state, const u8* bits, bool first_frame)
+    {
+        const gif_image_descriptor& image_desc = frame.image_desc;
 
         Palette palette;
 
@@ -378,9 +421,9 @@ namespace
 
         // transparency
         u8 background = state.screen_desc.background;
-        u8 transparent = state.transparent_color;
+        u8 transparent = frame.transparent_color;
 
-        if (state.transparent_color_flag)
+        if (frame.transparent_color_flag)
         {
             palette[transparent].r = palette[background].r;
             palette[transparent].g = palette[background].g;
@@ -388,26 +431,13 @@ namespace
             palette[transparent].a = 0;
         }
 
-        bool blend = !state.first_frame && state.transparent_color_flag;
+        bool blend = !first_frame && frame.transparent_color_flag;
 
         int x = image_desc.left;
         int y = image_desc.top;
         int width = image_desc.width;
         int height = image_desc.height;
 
-        // decode gif bit stream
-        int bytes = width * height;
-        std::unique_ptr<u8[]> bits(new u8[bytes]);
-        data = lzw_decode(bits.get(), bits.get() + bytes, data, end);
-
-        // deinterlace
-        if (image_desc.interlaced())
-        {
-            u8* temp = new u8[bytes];
-            deinterlace(temp, bits.get(), width, height);
-            bits.reset(temp);
-        }
-
         void (*func)(u8*, const u8*, int , const Palette& , u8) = nullptr;
 
         if (target.palette)
@@ -422,7 +452,7 @@ namespace
 
         // NOTE: clipping happens with some image files; don't be too clever and "optimize" this later :)
         Surface rect(target, x, y, width, height);
-        u8* src = bits.get();
+        const u8* src = bits;
 
         for (int sy = 0; sy < rect.height; ++sy)
         {
@@ -430,8 +460,6 @@ namespace
             func(dest, src, rect.width, palette, transparent);
             src += width;
         }
-
-        return data;
     }
 
     void read_graphics_control_extension(const u8* p, gif_state& state)
@@ -509,9 +537,29 @@ namespace
         return data;
     }
 
-    const u8* read_chunks(const u8* data, const u8* end, gif_state& state, Surface& target)
+    const u8* skip_sub_blocks(const u8* data, const u8* end)
     {
         while (data < end)
+        {
+            u8 size = *data++;
+            if (!size)
+            {
+                return data;
+            }
+
+            data += size;
+        }
+
+        return nullptr;
+    }
+
+    // Scan the frames without decompressing them; the graphics control extension
+    // state is carried to the following frames.
+    std::vector<gif_frame> scan_frames(const u8* data, const u8* end, gif_state& state)
+    {
+        std::vector<gif_frame> frames;
+
+        while (data && data < end)
         {
             u8 chunkID = *data++;
             printLine(Print::Info, "  chunkID: {:#x}", int(chunkID));
@@ -522,15 +570,35 @@ namespace
                     break;
 
                 case GIF_IMAGE:
-                    data = read_image(data, end, state, target);
-                    return data;
+                {
+                    gif_frame frame;
+                    data = frame.image_desc.read(data, end);
+
+                    frame.delay = state.delay;
+                    frame.disposal_method = state.disposal_method;
+                    frame.transparent_color_flag = state.transparent_color_flag;
+                    frame.transparent_color = state.transparent_color;
+                    frame.data = data;
+
+                    // skip minimum code size and the compressed data
+                    data = data + 1 < end ? skip_sub_blocks(data + 1, end) : nullptr;
+                    if (!data)
+                    {
+                        // truncated file; the frame is decoded as far as there is data
+                        frames.push_back(frame);
+                        return frames;
+                    }
+
+                    frames.push_back(frame);
+                    break;
+                }
 
                 case GIF_TERMINATE:
-                    return nullptr;
+                    return frames;
             }
         }
 
-        return nullptr;
+        return frames;
     }
 
     // ------------------------------------------------------------
@@ -542,25 +610,34 @@ namespace
         ConstMemory m_memory;
         gif_state m_state;
 
+        std::vector<gif_frame> m_frames;
         int m_frame_counter = 0;
 
-        const u8* m_start;
         const u8* m_end;
-        const u8* m_data;
+
+        // animations are composited in a persistent RGBA canvas because the frames can have
+        // local palettes; indexed targets receive the frame indices and palette directly
+        std::unique_ptr<Bitmap> m_canvas;
+        std::unique_ptr<Bitmap> m_restore;
+        int m_dispose_method = 0;
+        gif_rect m_dispose_rect = { 0, 0, 0, 0 };
+
+        // the next frame is decompressed in the background while the current frame is composited
+        std::unique_ptr<u8[]> m_prefetch_bits;
+        int m_prefetch_index = -1;
+        ConcurrentQueue m_queue;
 
         Interface(ConstMemory memory)
             : m_memory(memory)
+            , m_queue("gif.decoder")
         {
-            m_start = nullptr;
             m_end = m_memory.end();
-            m_data = m_memory.address;
 
-            m_data = read_magic(header, m_data, m_end);
+            const u8* data = read_magic(header, m_memory.address, m_end);
             if (header.success)
             {
-                m_data = m_state.screen_desc.read(m_data, m_end);
-
-                m_start = m_data;
+                data = m_state.screen_desc.read(data, m_end);
+                m_frames = scan_frames(data, m_end, m_state);
 
                 header.width   = m_state.screen_desc.width;
                 header.height  = m_state.screen_desc.height;
@@ -569,11 +646,42 @@ namespace
                 header.faces   = 0;
                 header.format  = IndexedFormat(8);
                 header.compression = TextureCompression::NONE;
+
+                if (m_frames.size() > 1)
+                {
+                    Format format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8);
+                    m_canvas = std::make_unique<Bitmap>(header.width, header.height, format);
+                }
+            }
+        }
+
+        void dispose()
+        {
+            Surface rect(*m_canvas, m_dispose_rect.x, m_dispose_rect.y, m_dispose_rect.width, m_dispose_rect.height);
+
+            switch (m_dispose_method)
+            {
+                case 2:
+                    // restore background
+                    rect.clear(0.0f, 0.0f, 0.0f, 0.0f);
+                    break;
+
+                case 3:
+                    // restore previous
+                    if (m_restore)
+                    {
+                        rect.blit(0, 0, *m_restore);
+                    }
+                    break;
             }
+
+            m_dispose_method = 0;
+            m_restore.reset();
         }
 
         ~Interface()
         {
+            m_queue.wait();
         }
 
         ImageDecodeStatus decode(const Surface& dest, const ImageDecodeOptions& options, int level, int depth, int face) override
@@ -590,33 +698,90 @@ namespace
                 return status;
             }
 
-            DecodeTargetBitmap target(dest, header.width, header.height, header.format);
+            // the canvas is used only when the frames are resolved into colors
+            const bool canvas = m_canvas && !dest.format.isIndexed();
+            const Format& format = canvas ? m_canvas->format : header.format;
 
-            status.current_frame_index = m_frame_counter;
+            DecodeTargetBitmap target(dest, header.width, header.height, format);
 
-            if (m_data)
-            {
-                m_state.first_frame = status.current_frame_index == 0;
-                m_data = read_chunks(m_data, m_end, m_state, target);
-                m_frame_counter += (m_data != nullptr);
-            }
+            const int count = int(m_frames.size());
+            const int index = m_frame_counter;
 
-            if (!m_data)
+            status.current_frame_index = index;
+
+            if (index < count)
             {
-                // out of data - we reached the end of file
-                if (m_frame_counter > 1)
+                const gif_frame& frame = m_frames[index];
+
+                // complete the prefetch
+                m_queue.wait();
+
+                std::unique_ptr<u8[]> bits;
+
+                if (m_prefetch_index == index)
+                {
+                    bits = std::move(m_prefetch_bits);
+                }
+                else
+                {
+                    bits.reset(new u8[frame.bytes()]);
+                    decode_frame(bits.get(), frame, m_end);
+                }
+
+                m_prefetch_index = -1;
+                m_frame_counter = (index + 1) % count;
+
+                if (options.multithread && count > 1)
+                {
+                    const int next = m_frame_counter;
+                    const gif_frame& next_frame = m_frames[next];
+
+                    m_prefetch_index = next;
+                    m_prefetch_bits.reset(new u8[next_frame.bytes()]);
+
+                    u8* next_bits = m_prefetch_bits.get();
+
+                    m_queue.enqueue([&next_frame, next_bits, this]
+                    {
+                        decode_frame(next_bits, next_frame, m_end);
+                    });
+                }
+
+                if (canvas)
+                {
+                    if (index == 0)
+                    {
+                        m_canvas->clear(0.0f, 0.0f, 0.0f, 0.0f);
+                        m_dispose_method = 0;
+                        m_restore.reset();
+                    }
+
+                    dispose();
+
+                    const gif_image_descriptor& desc = frame.image_desc;
+                    m_dispose_rect = { desc.left, desc.top, desc.width, desc.height };
+                    m_dispose_method = frame.disposal_method;
+
+                    if (m_dispose_method == 3)
+                    {
+                        Surface rect(*m_canvas, desc.left, desc.top, desc.width, desc.height);
+                        m_restore = std::make_unique<Bitmap>(rect, rect.format);
+                    }
+
+                    composite_frame(*m_canvas, frame, m_state, bits.get(), index == 0);
+                    target.blit(0, 0, *m_canvas);
+                }
+                else
                 {
-                    // there was more than 1 frame so it is animation -> restart animation
-                    m_frame_counter = 0;
-                    m_data = m_start;
+                    composite_frame(target, frame, m_state, bits.get(), index == 0);
                 }
+
+                status.frame_delay_numerator = frame.delay;
+                status.frame_delay_denominator = 100;
             }
 
             status.next_frame_index = m_frame_counter;
 
-            status.frame_delay_numerator = m_state.delay;
-            status.frame_delay_denominator = 100;
-
             status.direct = target.isDirect();
 
             target.resolve();
@@ -846,13 +1011,278 @@ namespace
         }
         else
         {
-            QuantizedBitmap temp(surface);
+            QuantizedBitmap temp(surface, options.quality, options.dithering, options.quantize);
             gif_encode_file(stream, temp);
         }
 
         return status;
     }
 
+    // ------------------------------------------------------------
+    // AnimationEncoder
+    // ------------------------------------------------------------
+
+    // smallest rectangle containing the pixels which are different in the two images
+    gif_rect gif_dirty_rect(const Surface& current, const Surface& previous)
+    {
+        const int width = current.width;
+        const int height = current.height;
+
+        int x0 = width;
+        int y0 = height;
+        int x1 = -1;
+        int y1 = -1;
+
+        for (int y = 0; y < height; ++y)
+        {
+            const u32* a = current.address<u32>(0, y);
+            const u32* b = previous.address<u32>(0, y);
+
+            int left = 0;
+            while (left < width && a[left] == b[left])
+            {
+                ++left;
+            }
+
+            if (left == width)
+            {
+                // identical scanline
+                continue;
+            }
+
+            int right = width - 1;
+            while (a[right] == b[right])
+            {
+                --right;
+            }
+
+            x0 = std::min(x0, left);
+            x1 = std::max(x1, right);
+            y0 = std::min(y0, y);
+            y1 = y;
+        }
+
+        if (x1 < 0)
+        {
+            // identical frames; GIF does not allow empty frames so we update one pixel
+            return { 0, 0, 1, 1 };
+        }
+
+        return { x0, y0, x1 - x0 + 1, y1 - y0 + 1 };
+    }
+
+    void gif_encode_frame(Stream& stream, const Surface& surface, int x, int y, int delay)
+    {
+        LittleEndianStream s = stream;
+
+        // graphics control extension
+        s.write8(GIF_EXTENSION);
+        s.write8(GRAPHICS_CONTROL_EXTENSION);
+        s.write8(4); // block size
+        s.write8(1 << 2); // disposal method: do not dispose
+        s.write16(u16(delay));
+        s.write8(0); // transparent color
+        s.write8(0); // block terminator
+
+        // image descriptor
+        s.write8(GIF_IMAGE);
+
+        s.write16(u16(x));
+        s.write16(u16(y));
+        s.write16(u16(surface.width));
+        s.write16(u16(surface.height));
+
+        u8 field = 0;
+        field |= 0x80; // local color table present
+        field |= 0x07; // color table size: 256 colors
+        s.write8(field);
+
+        // local palette
+        const Palette& palette = surface;
+
+        for (int i = 0; i < 256; ++i)
+        {
+            s.write8(palette[i].r);
+            s.write8(palette[i].g);
+            s.write8(palette[i].b);
+        }
+
+        gif_encode_image_block(s, 8, surface);
+    }
+
+    struct AnimationInterface : AnimationEncodeInterface
+    {
+        Stream& m_output;
+        ImageEncodeOptions m_options;
+
+        int m_width = 0;
+        int m_height = 0;
+        bool m_header = false;
+        bool m_finished = false;
+
+        std::shared_ptr<Bitmap> m_previous;
+
+        // the frames are quantized and compressed in the ThreadPool and written in order
+        std::atomic<int> m_pending { 0 };
+        int m_pending_limit;
+        TicketQueue m_tickets;
+        ConcurrentQueue m_queue;
+
+        AnimationInterface(Stream& output, const ImageEncodeOptions& options)
+            : m_output(output)
+            , m_options(options)
+            , m_queue("gif.encoder")
+        {
+            // every pending frame holds a copy of the source image
+            m_pending_limit = int(std::max(size_t(2), ThreadPool::getHardwareConcurrency() * 2));
+        }
+
+        ~AnimationInterface()
+        {
+            if (!m_finished)
+            {
+                finish();
+            }
+        }
+
+        void writeHeader()
+        {
+            LittleEndianStream s = m_output;
+
+            // identifier
+            s.write("GIF89a", 6);
+
+            // screen descriptor
+            s.write16(u16(m_width));
+            s.write16(u16(m_height));
+
+            u8 packed = 0;
+            packed |= (0x7 << 4); // color resolution as bits - 1 (0 -> 1 bit, 7 -> 8 bits)
+            s.write8(packed); // no global color table; the frames have local color tables
+
+            s.write8(0); // background color
+            s.write8(0); // aspect ratio
+
+            // looping animation
+            s.write8(GIF_EXTENSION);
+            s.write8(APPLICATION_EXTENSION);
+            s.write8(11); // block size
+            s.write("NETSCAPE2.0", 11);
+            s.write8(3); // sub-block size
+            s.write8(1); // sub-block id
+            s.write16(0); // loop count: infinite
+            s.write8(0); // block terminator
+        }
+
+        ImageEncodeStatus addFrame(const Surface& frame, int delay_numerator, int delay_denominator) override
+        {
+            ImageEncodeStatus status;
+
+            if (m_finished)
+            {
+                status.setError("[ImageEncoder.GIF] The animation is finished.");
+                return status;
+            }
+
+            if (frame.width < 1 || frame.height < 1 || frame.width > 0xffff || frame.height > 0xffff)
+            {
+                status.setError("[ImageEncoder.GIF] Incorrect frame dimensions ({} x {}).", frame.width, frame.height);
+                return status;
+            }
+
+            if (!m_header)
+            {
+                m_width = frame.width;
+                m_height = frame.height;
+                writeHeader();
+                m_header = true;
+            }
+
+            if (frame.width != m_width || frame.height != m_height)
+            {
+                status.setError("[ImageEncoder.GIF] Frame dimensions ({} x {}) do not match the animation ({} x {}).",
+                    frame.width, frame.height, m_width, m_height);
+                return status;
+            }
+
+            // delay in 1/100th of seconds
+            int delay = delay_denominator > 0 ? (delay_numerator * 100 + delay_denominator / 2) / delay_denominator : 0;
+            delay = std::clamp(delay, 0, 0xffff);
+
+            // back-pressure: help the encoders until there is room for more frames
+            while (m_pending > m_pending_limit)
+            {
+                m_queue.steal();
+                std::this_thread::yield();
+            }
+
+            ++m_pending;
+
+            auto current = std::make_shared<Bitmap>(frame, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
+            auto previous = m_previous;
+            m_previous = current;
+
+            auto ticket = m_tickets.acquire();
+
+            m_queue.enqueue([this, current, previous, delay, ticket]
+            {
+                gif_rect rect = { 0, 0, current->width, current->height };
+
+                if (previous)
+                {
+                    rect = gif_dirty_rect(*current, *previous);
+                }
+
+                Surface source(*current, rect.x, rect.y, rect.width, rect.height);
+                QuantizedBitmap temp(source, m_options.quality, m_options.dithering, m_options.quantize);
+
+                auto buffer = std::make_shared<MemoryStream>();
+                gif_encode_frame(*buffer, temp, rect.x, rect.y, delay);
+
+                ticket.consume([this, buffer]
+                {
+                    m_output.write(buffer->data(), buffer->size());
+                    --m_pending;
+                });
+            });
+
+            return status;
+        }
+
+        ImageEncodeStatus finish() override
+        {
+            ImageEncodeStatus status;
+
+            if (m_finished)
+            {
+                return status;
+            }
+
+            m_queue.wait();
+            m_tickets.wait();
+
+            if (!m_header)
+            {
+                status.setError("[ImageEncoder.GIF] The animation does not have any frames.");
+            }
+            else
+            {
+                LittleEndianStream s = m_output;
+                s.write8(GIF_TERMINATE);
+            }
+
+            m_finished = true;
+
+            return status;
+        }
+    };
+
+    AnimationEncodeInterface* createAnimationEncoder(Stream& output, const ImageEncodeOptions& options)
+    {
+        AnimationEncodeInterface* x = new AnimationInterface(output, options);
+        return x;
+    }
+
 } // namespace
 
 namespace mango::image
@@ -862,6 +1292,7 @@ namespace mango::image
     {
         registerImageDecoder(createInterface, ".gif");
         registerImageEncoder(imageEncode, ".gif");
+        registerAnimationEncoder(createAnimationEncoder, ".gif");
     }
 
 } // namespace mango::image
@@ -6,20 +6,21 @@
 #include <mango/core/system.hpp>
 #include <mango/core/buffer.hpp>
 #include <mango/core/compress.hpp>
+#include <mango/core/thread.hpp>
 #include <mango/image/image.hpp>
 #include <mango/image/compression.hpp>
 
 #include <map>
+#include <mutex>
 #include "../../external/basisu/transcoder/basisu_transcoder.h"
 
 // MANGO TODO: more input validation so that fuzzing tests pass :)
-// MANGO TODO: supercompression transcoding API to ImageDecoder interface.
 /*
     Implementation note: The BASIS_LZ and UASTC supercompression schemes are
     meant as transcoders so that other (supported) block compression-formatted
-    data can be extracted from the supercompressed data. We don't yet have
-    API for this so we only support the decode-to-surface and can only get
-    uncompressed rgba data out.
+    data can be extracted from the supercompressed data. The target block format
+    is selected with ImageDecodeOptions::compression; the formats available for
+    the file are in the ImageHeader::supercompression mask.
 */
 
 namespace
@@ -885,16 +886,76 @@ namespace
     };
 
     static
-    std::mutex g_basis_mutex;
+    std::once_flag g_basis_once;
 
     static
     void initialize_basisu_only_once()
     {
-        // This should only be called once but it does have initialization
-        // flag internally so we just want to make sure there are no concurrent
-        // callers entering the initialization while it may be running.
-        std::lock_guard guard(g_basis_mutex);
-        basist::basisu_transcoder_init();
+        std::call_once(g_basis_once, []
+        {
+            basist::basisu_transcoder_init();
+        });
+    }
+
+    struct BasisTargetFormat
+    {
+        u32 compression;
+        u32 mask;
+        basist::transcoder_texture_format format;
+    };
+
+    static const BasisTargetFormat g_basis_target_formats[] =
+    {
+        { TextureCompression::ETC1_RGB, SUPERCOMPRESS_ETC1_RGB, basist::transcoder_texture_format::cTFETC1_RGB },
+        { TextureCompression::ETC2_RGBA, SUPERCOMPRESS_ETC2_RGBA, basist::transcoder_texture_format::cTFETC2_RGBA },
+        { TextureCompression::BC1_UNORM, SUPERCOMPRESS_BC1_UNORM, basist::transcoder_texture_format::cTFBC1_RGB },
+        { TextureCompression::BC1_UNORM_SRGB, SUPERCOMPRESS_BC1_UNORM, basist::transcoder_texture_format::cTFBC1_RGB },
+        { TextureCompression::BC3_UNORM, SUPERCOMPRESS_BC3_UNORM, basist::transcoder_texture_format::cTFBC3_RGBA },
+        { TextureCompression::BC3_UNORM_SRGB, SUPERCOMPRESS_BC3_UNORM, basist::transcoder_texture_format::cTFBC3_RGBA },
+        { TextureCompression::BC4_UNORM, SUPERCOMPRESS_BC4_UNORM, basist::transcoder_texture_format::cTFBC4_R },
+        { TextureCompression::BC5_UNORM, SUPERCOMPRESS_BC5_UNORM, basist::transcoder_texture_format::cTFBC5_RG },
+        { TextureCompression::BC7_UNORM, SUPERCOMPRESS_BC7_UNORM, basist::transcoder_texture_format::cTFBC7_RGBA },
+        { TextureCompression::BC7_UNORM_SRGB, SUPERCOMPRESS_BC7_UNORM, basist::transcoder_texture_format::cTFBC7_RGBA },
+        { TextureCompression::PVRTC_RGB_4BPP, SUPERCOMPRESS_PVRTC_RGB_4BPP, basist::transcoder_texture_format::cTFPVRTC1_4_RGB },
+        { TextureCompression::PVRTC_RGBA_4BPP, SUPERCOMPRESS_PVRTC_RGBA_4BPP, basist::transcoder_texture_format::cTFPVRTC1_4_RGBA },
+        { TextureCompression::ASTC_UNORM_4x4, SUPERCOMPRESS_ASTC_RGBA_4x4, basist::transcoder_texture_format::cTFASTC_4x4_RGBA },
+        { TextureCompression::ASTC_SRGB_4x4, SUPERCOMPRESS_ASTC_RGBA_4x4, basist::transcoder_texture_format::cTFASTC_4x4_RGBA },
+        { TextureCompression::ATC_RGB, SUPERCOMPRESS_ATC_RGB, basist::transcoder_texture_format::cTFATC_RGB },
+        { TextureCompression::ATC_RGBA_INTERPOLATED_ALPHA, SUPERCOMPRESS_ATC_RGBA, basist::transcoder_texture_format::cTFATC_RGBA },
+        { TextureCompression::FXT1_RGB, SUPERCOMPRESS_FXT1_RGB, basist::transcoder_texture_format::cTFFXT1_RGB },
+        { TextureCompression::PVRTC2_RGBA_4BPP, SUPERCOMPRESS_PVRTC2_RGBA_4BPP, basist::transcoder_texture_format::cTFPVRTC2_4_RGBA },
+        { TextureCompression::EAC_R11, SUPERCOMPRESS_EAC_R11, basist::transcoder_texture_format::cTFETC2_EAC_R11 },
+        { TextureCompression::EAC_RG11, SUPERCOMPRESS_EAC_RG11, basist::transcoder_texture_format::cTFETC2_EAC_RG11 },
+    };
+
+    static
+    const BasisTargetFormat* getBasisTargetFormat(u32 compression)
+    {
+        for (const auto& target : g_basis_target_formats)
+        {
+            if (target.compression == compression)
+            {
+                return &target;
+            }
+        }
+
+        return nullptr;
+    }
+
+    static
+    u32 getBasisSupercompressionMask(basist::basis_tex_format format)
+    {
+        u32 mask = 0;
+
+        for (const auto& target : g_basis_target_formats)
+        {
+            if (basist::basis_is_format_supported(target.format, format))
+            {
+                mask |= target.mask;
+            }
+        }
+
+        return mask;
     }
 
     // ------------------------------------------------------------
@@ -910,9 +971,15 @@ namespace
 
         bool m_is_etc1s = false;
         bool m_is_uastc = false;
+        bool m_uastc_alpha = false;
+
+        // the ETC1S codebooks are decoded once and shared by all transcoding threads
+        basist::basisu_lowlevel_etc1s_transcoder m_etc1s_transcoder;
+        std::once_flag m_etc1s_once;
 
         u32 m_supercompression = 0;
         Buffer m_buffer;
+        std::once_flag m_decompress_once;
 
         bool m_orientation_x = false;
         bool m_orientation_y = false;
@@ -969,7 +1036,7 @@ namespace
                     m_is_etc1s = true;
                     header.format = Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8);
                     header.linear = false;
-                    header.supercompression = SUPERCOMPRESS_BASISU_ETC1S;
+                    header.supercompression = getBasisSupercompressionMask(basist::basis_tex_format::cETC1S);
                     break;
                 case SUPERCOMPRESSION_ZSTANDARD:
                     break;
@@ -1059,7 +1126,7 @@ namespace
                             m_is_uastc = true;
                             header.format = Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8);
                             header.linear = false;
-                            header.supercompression = SUPERCOMPRESS_BASISU_UASTC;
+                            header.supercompression = getBasisSupercompressionMask(basist::basis_tex_format::cUASTC4x4);
                             break;
                     }
 
@@ -1094,6 +1161,13 @@ namespace
 
                     for (u32 i = 0; i < sample_count; ++i)
                     {
+                        if (i == 0 && colorModel == KDF_DF_MODEL_UASTC)
+                        {
+                            // channel type: RGB (0), RGBA (3), RRR (4), RRRG (5), RG (6)
+                            u8 channelType = p[3] & 0x0f;
+                            m_uastc_alpha = channelType == 3 || channelType == 5;
+                        }
+
                         p += 16; // skip
                     }
                 }
@@ -1206,84 +1280,196 @@ namespace
             return memory;
         }
 
-        ImageDecodeStatus decode(const Surface& dest, const ImageDecodeOptions& options, int level, int depth, int face) override
+        ImageDecodeStatus transcode(const Surface& dest, const ImageDecodeOptions& options, int level, int depth, int face)
         {
-            MANGO_UNREFERENCED(options);
-
-            decompress();
-
-            // MANGO TODO: typesize dictates endianness swap on big-endian
-
             ImageDecodeStatus status;
 
-            const int maxLevel = int(m_levels.size() - 1);
-            if (level < 0 || level > maxLevel)
+            const BasisTargetFormat* target = getBasisTargetFormat(options.compression);
+            if (!target || !(header.supercompression & target->mask))
             {
-                status.setError("Incorrect level ({}) [{} .. {}]", level, 0, maxLevel);
+                status.setError("[ImageDecoder.KTX2] Unsupported transcoding format ({:#x}).", options.compression);
                 return status;
             }
 
-            int width = std::max(1, header.width >> level);
-            int height = std::max(1, header.height >> level);
-            const Format& format = header.format;
+            TextureCompression info(options.compression);
 
-            if (m_is_etc1s)
+            int width = std::max(1, header.width >> level);
+            int xblocks = info.getBlocksX(width);
+            if (dest.stride < size_t(xblocks * info.bytes) || dest.stride % info.bytes)
             {
-                ConstMemory memory = this->memory(level, depth, 0);
+                status.setError("[ImageDecoder.KTX2] Incorrect stride ({}) for {} blocks of {} bytes.", dest.stride, xblocks, info.bytes);
+                return status;
+            }
 
-                Bitmap temp(width, height, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
-                //printLine(Print::Info, "memory: {} bytes", memory.size);
+            return transcode(dest, target->format, info.bytes, options, level, depth, face);
+        }
+
+        // Transcode into blocks or RGBA32 pixels; the stride is in bytes for both.
+        ImageDecodeStatus transcode(const Surface& dest, basist::transcoder_texture_format format, int bytes,
+                                    const ImageDecodeOptions& options, int level, int depth, int face)
+        {
+            ImageDecodeStatus status;
+
+            initialize_basisu_only_once();
 
-                initialize_basisu_only_once();
-                basist::basisu_lowlevel_etc1s_transcoder transcoder;
+            const bool uncompressed = basist::basis_transcoder_format_is_uncompressed(format);
 
-                transcoder.decode_palettes(
-                    m_basis.endpointCount, m_basis.endpointsData, m_basis.endpointsByteLength,
-                    m_basis.selectorCount, m_basis.selectorsData, m_basis.selectorsByteLength);
-                transcoder.decode_tables(m_basis.tablesData, m_basis.tablesByteLength);
+            const u32 width = std::max(1, header.width >> level);
+            const u32 height = std::max(1, header.height >> level);
+            const u32 xblocks = (width + 3) / 4;
+            const u32 yblocks = (height + 3) / 4;
 
-                int xblocks = std::max(1, width / 4);
-                int yblocks = std::max(1, height / 4);
+            // row pitch in blocks or pixels
+            const u32 pitch = u32(dest.stride / bytes);
+            const u32 rows = uncompressed ? height : yblocks;
+            const u32 columns = uncompressed ? width : xblocks;
+
+            // the transcoder writes pitch * rows elements into the destination
+            if (!dest.image || pitch < columns || dest.height < 0 || u32(dest.height) < rows)
+            {
+                status.setError("[ImageDecoder.KTX2] Destination ({} x {}) is too small for {} x {} {}.",
+                    pitch, dest.height, columns, rows, uncompressed ? "pixels" : "blocks");
+                return status;
+            }
+
+            if (m_is_etc1s)
+            {
+                std::call_once(m_etc1s_once, [this]
+                {
+                    m_etc1s_transcoder.decode_palettes(
+                        m_basis.endpointCount, m_basis.endpointsData, m_basis.endpointsByteLength,
+                        m_basis.selectorCount, m_basis.selectorsData, m_basis.selectorsByteLength);
+                    m_etc1s_transcoder.decode_tables(m_basis.tablesData, m_basis.tablesByteLength);
+                });
+
+                // the slice offsets are relative to the start of the level
+                ConstMemory memory = m_levels[level].memory;
 
                 const int imageIndex = level * header.faces + face;
                 BasisImageDesc desc = m_basis.readImageDesc(imageIndex);
 
-                bool x = transcoder.transcode_image(basist::transcoder_texture_format::cTFRGBA32,
-                    temp.image, width * height,
+                // the slices are entropy coded so each slice is transcoded with a single call;
+                // the codebooks are shared so that the levels and faces can be decoded in parallel
+                basist::basisu_transcoder_state state;
+
+                bool success = m_etc1s_transcoder.transcode_image(format,
+                    dest.image, pitch * rows,
                     memory.address, u32(memory.size),
                     xblocks, yblocks, width, height,
                     level,
                     desc.rgbSliceByteOffset, desc.rgbSliceByteLength,
-                    desc.alphaSliceByteOffset, desc.alphaSliceByteLength);
-
-                MANGO_UNREFERENCED(x);
-
-                dest.blit(0, 0, temp);
+                    desc.alphaSliceByteOffset, desc.alphaSliceByteLength,
+                    0, desc.alphaSliceByteLength != 0, false, pitch, &state, uncompressed ? height : 0);
+                if (!success)
+                {
+                    status.setError("[ImageDecoder.KTX2] ETC1S transcoding failed.");
+                }
             }
-            else if (m_is_uastc)
+            else
             {
                 ConstMemory memory = this->memory(level, depth, face);
 
-                Bitmap temp(width, height, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
+                if (memory.size < u64(xblocks) * yblocks * 16)
+                {
+                    status.setError("[ImageDecoder.KTX2] Not enough UASTC data ({} bytes).", memory.size);
+                    return status;
+                }
 
-                initialize_basisu_only_once();
-                basist::basisu_lowlevel_uastc_transcoder transcoder;
+                // UASTC blocks are independent so the rows of blocks are transcoded in parallel;
+                // PVRTC1 blocks are interleaved over the whole image and must be transcoded at once
+                const bool pvrtc1 = format == basist::transcoder_texture_format::cTFPVRTC1_4_RGB ||
+                                    format == basist::transcoder_texture_format::cTFPVRTC1_4_RGBA;
 
-                int xblocks = std::max(1, width / 4);
-                int yblocks = std::max(1, height / 4);
+                const u32 band = options.multithread && !pvrtc1 ? 16 : yblocks;
 
-                u32 slice_offset = 0;
-                u32 slice_length = u32(memory.size);
+                std::atomic<bool> success { true };
+                ConcurrentQueue q("ktx2.transcode");
 
-                bool x = transcoder.transcode_image(basist::transcoder_texture_format::cTFRGBA32,
-                    temp.image, width * height,
-                    memory.address, u32(memory.size),
-                    xblocks, yblocks, width, height, level,
-                    slice_offset, slice_length);
+                for (u32 y0 = 0; y0 < yblocks; y0 += band)
+                {
+                    auto func = [=, this, &dest, &success]
+                    {
+                        const u32 count = std::min(band, yblocks - y0);
+                        const u32 offset = y0 * xblocks * 16;
+                        const u32 length = count * xblocks * 16;
+
+                        const u32 y = y0 * 4;
+                        const u32 band_height = std::min(count * 4, height - y);
+
+                        u8* output = dest.image + (uncompressed ? y : y0) * dest.stride;
+                        const u32 output_rows = uncompressed ? band_height : count;
+
+                        basist::basisu_lowlevel_uastc_transcoder transcoder;
+                        basist::basisu_transcoder_state state;
+
+                        bool x = transcoder.transcode_image(format,
+                            output, pitch * output_rows,
+                            memory.address + offset, length,
+                            xblocks, count, width, band_height, level,
+                            0, length,
+                            0, m_uastc_alpha, false, pitch, &state, uncompressed ? band_height : 0);
+                        if (!x)
+                        {
+                            success = false;
+                        }
+                    };
+
+                    if (band < yblocks)
+                    {
+                        q.enqueue(func);
+                    }
+                    else
+                    {
+                        func();
+                    }
+                }
+
+                q.wait();
+
+                if (!success)
+                {
+                    status.setError("[ImageDecoder.KTX2] UASTC transcoding failed.");
+                }
+            }
 
-                MANGO_UNREFERENCED(x);
+            return status;
+        }
 
-                dest.blit(0, 0, temp);
+        ImageDecodeStatus decode(const Surface& dest, const ImageDecodeOptions& options, int level, int depth, int face) override
+        {
+            decompress();
+
+            // MANGO TODO: typesize dictates endianness swap on big-endian
+
+            ImageDecodeStatus status;
+
+            const int maxLevel = int(m_levels.size() - 1);
+            if (level < 0 || level > maxLevel)
+            {
+                status.setError("Incorrect level ({}) [{} .. {}]", level, 0, maxLevel);
+                return status;
+            }
+
+            int width = std::max(1, header.width >> level);
+            int height = std::max(1, header.height >> level);
+            const Format& format = header.format;
+
+            if ((m_is_etc1s || m_is_uastc) && options.compression != TextureCompression::NONE)
+            {
+                status = transcode(dest, options, level, depth, face);
+            }
+            else if (m_is_etc1s || m_is_uastc)
+            {
+                Bitmap temp(width, height, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
+
+                ImageDecodeOptions rgba = options;
+                rgba.compression = TextureCompression::NONE;
+
+                status = transcode(temp, basist::transcoder_texture_format::cTFRGBA32, 4, rgba, level, depth, face);
+                if (status)
+                {
+                    dest.blit(0, 0, temp);
+                }
             }
             else
             {
@@ -1324,7 +1510,8 @@ namespace
         {
             if (m_supercompression > SUPERCOMPRESSION_BASIS_LZ)
             {
-                if (!m_buffer.size())
+                // the levels are decompressed when the data is needed the first time
+                std::call_once(m_decompress_once, [this]
                 {
                     // compute storage requirements
                     u64 uncompressed_size = 0;
@@ -1368,7 +1555,7 @@ namespace
                         level.memory = dest;
                         data += level.uncompressed_length;
                     }
-                }
+                });
             }
         }
     };
@@ -1379,6 +1566,376 @@ namespace
         return x;
     }
 
+    // ------------------------------------------------------------
+    // ImageEncoder
+    // ------------------------------------------------------------
+
+    struct SampleKTX2
+    {
+        u8 channel;
+        u8 offset; // bytes
+        u8 length; // bytes
+    };
+
+    struct DescriptorKTX2
+    {
+        u8 model = KHR_DF_MODEL_UNSPECIFIED;
+        std::vector<SampleKTX2> samples;
+    };
+
+    static
+    DescriptorKTX2 getEncodeDescriptor(const TextureCompression& info)
+    {
+        DescriptorKTX2 desc;
+
+        switch (info.compression)
+        {
+            case TextureCompression::DXT1:
+            case TextureCompression::DXT1_SRGB:
+            case TextureCompression::DXT1_ALPHA1:
+            case TextureCompression::DXT1_ALPHA1_SRGB:
+                desc.model = KHR_DF_MODEL_BC1A;
+                desc.samples = { { KHR_DF_CHANNEL_BC1A_COLOR, 0, 8 } };
+                break;
+
+            case TextureCompression::DXT3:
+            case TextureCompression::DXT3_SRGB:
+                desc.model = KHR_DF_MODEL_BC2;
+                desc.samples = { { KHR_DF_CHANNEL_BC2_ALPHA, 0, 8 }, { KHR_DF_CHANNEL_BC2_COLOR, 8, 8 } };
+                break;
+
+            case TextureCompression::DXT5:
+            case TextureCompression::DXT5_SRGB:
+                desc.model = KHR_DF_MODEL_BC3;
+                desc.samples = { { KHR_DF_CHANNEL_BC3_ALPHA, 0, 8 }, { KHR_DF_CHANNEL_BC3_COLOR, 8, 8 } };
+                break;
+
+            case TextureCompression::RGTC1_RED:
+            case TextureCompression::RGTC1_SIGNED_RED:
+                desc.model = KHR_DF_MODEL_BC4;
+                desc.samples = { { KHR_DF_CHANNEL_BC4_DATA, 0, 8 } };
+                break;
+
+            case TextureCompression::RGTC2_RG:
+            case TextureCompression::RGTC2_SIGNED_RG:
+                desc.model = KHR_DF_MODEL_BC5;
+                desc.samples = { { KHR_DF_CHANNEL_BC5_RED, 0, 8 }, { KHR_DF_CHANNEL_BC5_GREEN, 8, 8 } };
+                break;
+
+            case TextureCompression::BPTC_RGB_UNSIGNED_FLOAT:
+            case TextureCompression::BPTC_RGB_SIGNED_FLOAT:
+                desc.model = KHR_DF_MODEL_BC6H;
+                desc.samples = { { KHR_DF_CHANNEL_BC6H_COLOR, 0, 16 } };
+                break;
+
+            case TextureCompression::BPTC_RGBA_UNORM:
+            case TextureCompression::BPTC_SRGB_ALPHA_UNORM:
+                desc.model = KHR_DF_MODEL_BC7;
+                desc.samples = { { KHR_DF_CHANNEL_BC7_DATA, 0, 16 } };
+                break;
+
+            case TextureCompression::ETC1_RGB:
+                desc.model = KHR_DF_MODEL_ETC1;
+                desc.samples = { { KHR_DF_CHANNEL_ETC1_COLOR, 0, 8 } };
+                break;
+
+            default:
+                if ((info.compression & 0xff) == TextureCompression::ASTC)
+                {
+                    desc.model = KHR_DF_MODEL_ASTC;
+                    desc.samples = { { KHR_DF_CHANNEL_ASTC_DATA, 0, 16 } };
+                }
+                break;
+        }
+
+        return desc;
+    }
+
+    static
+    void writeDataFormatDescriptor(LittleEndianStream& s, const TextureCompression& info, const Format& format)
+    {
+        DescriptorKTX2 desc;
+
+        u8 texelBlockDimension[4] = { 0, 0, 0, 0 };
+        u8 bytesPlane0;
+        u8 sampleFlags = 0;
+        u32 sampleLower = 0;
+        u32 sampleUpper = 0xffffffff;
+
+        if (info.compression != TextureCompression::NONE)
+        {
+            desc = getEncodeDescriptor(info);
+
+            texelBlockDimension[0] = u8(info.width - 1);
+            texelBlockDimension[1] = u8(info.height - 1);
+            texelBlockDimension[2] = u8(info.depth - 1);
+            bytesPlane0 = u8(info.bytes);
+
+            if (info.compression & TextureCompression::FLOAT)
+            {
+                sampleFlags = 0x80; // float
+                sampleLower = 0xbf800000; // -1.0f
+                sampleUpper = 0x3f800000; // 1.0f
+            }
+
+            if (info.compression & TextureCompression::SIGNED)
+            {
+                sampleFlags |= 0x40; // signed
+            }
+        }
+        else
+        {
+            const u8 size = u8(format.bytes() / 4);
+
+            desc.model = KHR_DF_MODEL_RGBSDA;
+            desc.samples =
+            {
+                { KHR_DF_CHANNEL_RGBSDA_RED, u8(size * 0), size },
+                { KHR_DF_CHANNEL_RGBSDA_GREEN, u8(size * 1), size },
+                { KHR_DF_CHANNEL_RGBSDA_BLUE, u8(size * 2), size },
+                { KHR_DF_CHANNEL_RGBSDA_ALPHA, u8(size * 3), size },
+            };
+
+            bytesPlane0 = u8(format.bytes());
+
+            if (format.isFloat())
+            {
+                sampleFlags = 0x80 | 0x40; // float, signed
+                sampleLower = 0xbf800000; // -1.0f
+                sampleUpper = 0x3f800000; // 1.0f
+            }
+            else
+            {
+                sampleUpper = 0xff;
+            }
+        }
+
+        const bool linear = info.compression == TextureCompression::NONE || info.isLinear();
+
+        const u32 blockSize = 24 + u32(desc.samples.size()) * 16;
+
+        s.write32(4 + blockSize); // totalSize
+
+        s.write32(KHR_DF_VENDORID_KHRONOS | (KHR_DF_KHR_DESCRIPTORTYPE_BASICFORMAT << 17));
+        s.write32(2 | (blockSize << 16)); // version 1.3
+        s.write8(desc.model);
+        s.write8(KHR_DF_PRIMARIES_BT709);
+        s.write8(linear ? KHR_DF_TRANSFER_LINEAR : KHR_DF_TRANSFER_SRGB);
+        s.write8(0); // flags: alpha straight
+        s.write(texelBlockDimension, 4);
+        s.write8(bytesPlane0);
+        for (int i = 0; i < 7; ++i)
+        {
+            s.write8(0); // bytesPlane1..7
+        }
+
+        for (const auto& sample : desc.samples)
+        {
+            u8 channel = sample.channel | sampleFlags;
+
+            // alpha channels are linear in sRGB formats
+            if (!linear && (sample.channel == 15))
+            {
+                channel |= 0x10;
+            }
+
+            s.write16(u16(sample.offset * 8));
+            s.write8(u8(sample.length * 8 - 1));
+            s.write8(channel);
+            s.write32(0); // sample positions
+            s.write32(sampleLower);
+            s.write32(sampleUpper);
+        }
+    }
+
+    ImageEncodeStatus imageEncode(Stream& stream, const Surface& surface, const ImageEncodeOptions& options)
+    {
+        ImageEncodeStatus status;
+
+        const u32 compression = options.block_compression;
+        TextureCompression info(compression);
+
+        bool is_float;
+        u32 vkFormat;
+        u32 typeSize;
+
+        if (compression != TextureCompression::NONE)
+        {
+            if ((!info.encodeBlock && !info.encodeSurface) || !info.vulkan || !getEncodeDescriptor(info).samples.size())
+            {
+                status.setError("[ImageEncoder.KTX2] Unsupported compression ({:#x}).", compression);
+                return status;
+            }
+
+            is_float = info.format.isFloat();
+            vkFormat = info.vulkan;
+            typeSize = 1;
+        }
+        else
+        {
+            is_float = surface.format.isFloat();
+            vkFormat = is_float ? FORMAT_R32G32B32A32_SFLOAT : FORMAT_R8G8B8A8_UNORM;
+            typeSize = is_float ? 4 : 1;
+        }
+
+        // the mipmaps are generated in this format
+        const Format format = is_float ? Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32)
+                                       : Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8);
+
+        const int levels = options.mipmaps ? u32_log2(std::max(surface.width, surface.height)) + 1 : 1;
+
+        std::vector<std::unique_ptr<Bitmap>> images(levels);
+        std::vector<Buffer> buffers(levels);
+        std::vector<Buffer> compressed(levels);
+        std::vector<Status> results(levels);
+
+        ConcurrentQueue queue("ktx2.encoder");
+
+        // the levels are compressed in parallel while the next levels are generated
+        for (int level = 0; level < levels; ++level)
+        {
+            if (!level)
+            {
+                images[level] = std::make_unique<Bitmap>(surface, format);
+            }
+            else
+            {
+                const Bitmap& prev = *images[level - 1];
+                images[level] = std::make_unique<Bitmap>(std::max(1, prev.width / 2), std::max(1, prev.height / 2), format);
+                mipmap(*images[level], prev);
+            }
+
+            queue.enqueue([&, level]
+            {
+                const Bitmap& image = *images[level];
+                Buffer& buffer = buffers[level];
+
+                if (compression != TextureCompression::NONE)
+                {
+                    buffer.reset(info.getBlockBytes(image.width, image.height));
+
+                    TextureCompression::Status result = info.compress(buffer, image);
+                    if (!result)
+                    {
+                        results[level].setError(result.info);
+                        return;
+                    }
+                }
+                else
+                {
+                    const size_t bytes = image.width * format.bytes();
+                    buffer.reset(bytes * image.height);
+
+                    for (int y = 0; y < image.height; ++y)
+                    {
+                        std::memcpy(buffer.data() + y * bytes, image.address(0, y), bytes);
+                    }
+                }
+
+                // supercompression
+                compressed[level].reset(zstd::bound(buffer.size()));
+
+                CompressionStatus result = zstd::compress(compressed[level], buffer, options.compression);
+                if (!result)
+                {
+                    results[level].setError(result.info);
+                    return;
+                }
+
+                compressed[level].resize(result.size);
+            });
+        }
+
+        queue.wait();
+
+        for (auto& result : results)
+        {
+            if (!result)
+            {
+                status.setError("[ImageEncoder.KTX2] {}", result.info);
+                return status;
+            }
+        }
+
+        // data format descriptor
+        MemoryStream dfd;
+        LittleEndianStream dfd_stream = dfd;
+        writeDataFormatDescriptor(dfd_stream, info, format);
+
+        // key/value data
+        MemoryStream kvd;
+        LittleEndianStream kvd_stream = kvd;
+
+        const char writer [] = "KTXwriter\0mango";
+        kvd_stream.write32(u32(sizeof(writer)));
+        kvd_stream.write(writer, sizeof(writer));
+        while (kvd.size() & 3)
+        {
+            kvd_stream.write8(0);
+        }
+
+        const u32 dfdByteOffset = 12 + 9 * 4 + 32 + levels * 24;
+        const u32 dfdByteLength = u32(dfd.size());
+        const u32 kvdByteOffset = dfdByteOffset + dfdByteLength;
+        const u32 kvdByteLength = u32(kvd.size());
+
+        // the levels are stored from the smallest to the largest; the supercompressed
+        // levels do not have alignment requirements
+        std::vector<u64> offsets(levels);
+        u64 offset = kvdByteOffset + kvdByteLength;
+
+        for (int level = levels - 1; level >= 0; --level)
+        {
+            offsets[level] = offset;
+            offset += compressed[level].size();
+        }
+
+        LittleEndianStream s = stream;
+
+        // header
+        constexpr u8 identifier [] =
+        {
+            0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32,
+            0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+        };
+
+        s.write(identifier, sizeof(identifier));
+        s.write32(vkFormat);
+        s.write32(typeSize);
+        s.write32(surface.width);
+        s.write32(surface.height);
+        s.write32(0); // pixelDepth
+        s.write32(0); // layerCount
+        s.write32(1); // faceCount
+        s.write32(levels);
+        s.write32(SUPERCOMPRESSION_ZSTANDARD);
+
+        // index
+        s.write32(dfdByteOffset);
+        s.write32(dfdByteLength);
+        s.write32(kvdByteOffset);
+        s.write32(kvdByteLength);
+        s.write64(0); // sgdByteOffset
+        s.write64(0); // sgdByteLength
+
+        for (int level = 0; level < levels; ++level)
+        {
+            s.write64(offsets[level]);
+            s.write64(compressed[level].size());
+            s.write64(buffers[level].size());
+        }
+
+        s.write(dfd.data(), dfd.size());
+        s.write(kvd.data(), kvd.size());
+
+        for (int level = levels - 1; level >= 0; --level)
+        {
+            s.write(compressed[level].data(), compressed[level].size());
+        }
+
+        return status;
+    }
+
 } // namespace
 
 namespace mango::image
@@ -1387,6 +1944,7 @@ namespace mango::image
     void registerImageCodecKTX2()
     {
         registerImageDecoder(createInterface, ".ktx2");
+        registerImageEncoder(imageEncode, ".ktx2");
     }
 
 } // namespace mango::image
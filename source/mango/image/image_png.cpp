@@ -636,7 +636,8 @@ namespace
 
 #endif // MANGO_ENABLE_SSE2
 
-#if defined(MANGO_ENABLE_SSE4_1)
+#if defined(MANGO_DISPATCH_SSE4_1)
+MANGO_TARGET_BEGIN_SSE4_1
 
     // -----------------------------------------------------------------------------------
     // SSE4.1 Filters
@@ -720,7 +721,8 @@ namespace
         }
     }
 
-#endif // MANGO_ENABLE_SSE4_1
+MANGO_TARGET_END
+#endif // MANGO_DISPATCH_SSE4_1
 
 #if defined(MANGO_ENABLE_NEON)
 
@@ -1160,8 +1162,8 @@ namespace
                         paeth = filter4_paeth_24bit_sse2;
                     }
 #endif
-#if defined(MANGO_ENABLE_SSE4_1)
-                    if (features & INTEL_SSE4_1)
+#if defined(MANGO_DISPATCH_SSE4_1)
+                    if ((features & TARGET_SSE4_1) == TARGET_SSE4_1)
                     {
                         sub = filter1_sub_24bit_sse41;
                     }
@@ -1563,7 +1565,8 @@ namespace
 
 #endif // MANGO_ENABLE_SSE2
 
-#if defined(MANGO_ENABLE_SSE4_1)
+#if defined(MANGO_DISPATCH_SSE4_1)
+MANGO_TARGET_BEGIN_SSE4_1
 
     void process_rgba16_sse41(const ColorState& state, int width, u8* dst, const u8* src)
     {
@@ -1635,7 +1638,8 @@ namespace
         }
     }
 
-#endif // MANGO_ENABLE_SSE4_1
+MANGO_TARGET_END
+#endif // MANGO_DISPATCH_SSE4_1
 
 #if defined(MANGO_ENABLE_NEON)
 
@@ -1793,8 +1797,8 @@ namespace
                 else
                 {
                     function = process_rgb8;
-#if defined(MANGO_ENABLE_SSE4_1)
-                    if (features & INTEL_SSE4_1)
+#if defined(MANGO_DISPATCH_SSE4_1)
+                    if ((features & TARGET_SSE4_1) == TARGET_SSE4_1)
                     {
                         function = process_rgb8_sse41;
                     }
@@ -1840,8 +1844,8 @@ namespace
                     function = process_rgba16_sse2;
                 }
 #endif
-#if defined(MANGO_ENABLE_SSE4_1)
-                if (features & INTEL_SSE4_1)
+#if defined(MANGO_DISPATCH_SSE4_1)
+                if ((features & TARGET_SSE4_1) == TARGET_SSE4_1)
                 {
                     function = process_rgba16_sse41;
                 }
@@ -1958,8 +1962,7 @@ namespace
         ColorState m_color_state;
         DecodeTargetBitmap* m_decode_target = nullptr;
 
-        u64 m_filter_time = 0;
-        u64 m_color_time = 0;
+        ImageCodecStats* m_stats = nullptr;
 
         // IHDR
         int m_width;
@@ -2191,7 +2194,7 @@ namespace
         void decode_idot(const Surface& target);
         bool decode_std(const Surface& target, ImageDecodeStatus& status);
 
-        ImageDecodeStatus decode(const Surface& dest, bool multithread);
+        ImageDecodeStatus decode(const Surface& dest, const ImageDecodeOptions& options);
     };
 
     void ParserPNG::read_IHDR(BigEndianConstPointer p, u32 size)
@@ -2925,7 +2928,7 @@ namespace
         Buffer zeros(bytes, 0);
         const u8* prev = zeros.data();
 
-        u64 time0 = Time::us();
+        ImageCodecStats::Scope scope(m_stats, ImageCodecStats::UNFILTER, u64(bytes) * height);
 
         for (int y = 0; y < height; ++y)
         {
@@ -2933,9 +2936,6 @@ namespace
             prev = buffer;
             buffer += bytes;
         }
-
-        u64 time1 = Time::us();
-        m_filter_time += (time1 - time0);
     }
 
     void ParserPNG::process_range(const Surface& target, u8* buffer, int y0, int y1)
@@ -2948,21 +2948,19 @@ namespace
 
         u8* image = target.image + y0 * target.stride;
 
+        const u64 bytes_per_scan = u64(target.width) * target.format.bytes();
+
+        ImageCodecStats::Laps laps(m_stats);
+
         for (int y = y0; y < y1; ++y)
         {
-            u64 time0 = Time::us();
-
             // filtering
             filter(buffer, buffer - bytes_per_line, int(bytes_per_line));
-
-            u64 time1 = Time::us();
-            m_filter_time += (time1 - time0);
+            laps.lap(ImageCodecStats::UNFILTER, bytes_per_line);
 
             // color conversion
             convert(m_color_state, target.width, image, buffer + PNG_FILTER_BYTE);
-
-            u64 time2 = Time::us();
-            m_color_time += (time2 - time1);
+            laps.lap(ImageCodecStats::COLOR, bytes_per_scan);
 
             buffer += bytes_per_line;
             image += target.stride;
@@ -2980,6 +2978,7 @@ namespace
         {
             if (!m_decode_target->isDirect())
             {
+                ImageCodecStats::Scope scope(m_stats, ImageCodecStats::BLIT, u64(rect.width) * rect.height * m_decode_target->format.bytes());
                 m_decode_target->resolve(rect.x, rect.y, rect.width, rect.height);
             }
         }
@@ -3013,18 +3012,17 @@ namespace
             // use de-interlaced temp buffer as processing source
             buffer = temp;
 
-            u64 time0 = Time::us();
-
-            // color conversion
-            for (int y = 0; y < target.height; ++y)
             {
-                convert(m_color_state, target.width, image, buffer + PNG_FILTER_BYTE);
-                image += target.stride;
-                buffer += bytes_per_line;
-            }
+                ImageCodecStats::Scope scope(m_stats, ImageCodecStats::COLOR, u64(target.width) * target.height * target.format.bytes());
 
-            u64 time1 = Time::us();
-            m_color_time += (time1 - time0);
+                // color conversion
+                for (int y = 0; y < target.height; ++y)
+                {
+                    convert(m_color_state, target.width, image, buffer + PNG_FILTER_BYTE);
+                    image += target.stride;
+                    buffer += bytes_per_line;
+                }
+            }
 
             ImageDecodeRect rect;
 
@@ -3038,6 +3036,7 @@ namespace
             {
                 if (!m_decode_target->isDirect())
                 {
+                    ImageCodecStats::Scope scope(m_stats, ImageCodecStats::BLIT, u64(rect.width) * rect.height * m_decode_target->format.bytes());
                     m_decode_target->resolve(rect.x, rect.y, rect.width, rect.height);
                 }
             }
@@ -3106,7 +3105,10 @@ namespace
                 buffer.address += bytes_per_line;
                 buffer.size -= bytes_per_line;
 
+                ImageCodecStats::Laps laps(m_stats);
                 CompressionStatus result = decompress(buffer, memory);
+                laps.lap(ImageCodecStats::INFLATE, result.size);
+
                 if (!result)
                 {
                     // NOTE: decompressors complain here that out of data
@@ -3183,10 +3185,12 @@ namespace
         ConstMemory top_memory = compressed_top;
         ConstMemory bottom_memory = compressed_bottom;
 
-        auto future = std::async(std::launch::async, [=]
+        auto future = std::async(std::launch::async, [=, this]
         {
             // Apple uses raw deflate format for iDOT extended IDAT chunks
+            ImageCodecStats::Scope scope(m_stats, ImageCodecStats::INFLATE);
             CompressionStatus result = deflate::decompress(bottom_buffer, bottom_memory);
+            scope.setBytes(result.size);
             return result.size;
         });
 
@@ -3198,7 +3202,9 @@ namespace
 
         auto decompress = deflate::decompress;
 
+        ImageCodecStats::Laps laps(m_stats);
         CompressionStatus result = decompress(top_buffer, top_memory);
+        laps.lap(ImageCodecStats::INFLATE, result.size);
 
         size_t bytes_out_top = result.size;
         size_t bytes_out_bottom = future.get();
@@ -3281,7 +3287,11 @@ namespace
                 state.next_out = buffer.address + state.total_out;
                 state.avail_out = u32(buffer.size - state.total_out);
 
+                u64 total_out = state.total_out;
+                ImageCodecStats::Laps laps(m_stats);
+
                 int s = isal_inflate(&state);
+                laps.lap(ImageCodecStats::INFLATE, state.total_out - total_out);
 
                 const char* error = nullptr;
                 switch (s)
@@ -3393,6 +3403,9 @@ namespace
                     return false;
                 }
 
+                u64 total_out = stream.total_out;
+                ImageCodecStats::Laps laps(m_stats);
+
                 do
                 {
                     stream.avail_out = uInt(buffer.size - stream.total_out);
@@ -3408,6 +3421,8 @@ namespace
                 }
                 while (stream.avail_in > 0);
 
+                laps.lap(ImageCodecStats::INFLATE, stream.total_out - total_out);
+
                 if (!m_interlace)
                 {
                     int y1 = int(stream.total_out / bytes_per_line);
@@ -3463,7 +3478,10 @@ namespace
 
             auto decompress = deflate::decompress;
 
+            ImageCodecStats::Laps laps(m_stats);
             CompressionStatus result = decompress(buffer, memory);
+            laps.lap(ImageCodecStats::INFLATE, result.size);
+
             if (!result)
             {
                 //printLine(Print::Info, "  {}", result.info);
@@ -3485,10 +3503,13 @@ namespace
         return true;
     }
 
-    ImageDecodeStatus ParserPNG::decode(const Surface& dest, bool multithread)
+    ImageDecodeStatus ParserPNG::decode(const Surface& dest, const ImageDecodeOptions& options)
     {
         ImageDecodeStatus status;
 
+        const bool multithread = options.multithread;
+        m_stats = options.stats;
+
         m_idat.clear();
         m_idot_index = 0;
 
@@ -3561,10 +3582,6 @@ namespace
             }
         }
 
-        // These are not wall times; it is cumulative time from all concurrent tasks
-        printLine(Print::Info, "  filter: {}.{} ms", m_filter_time / 1000, m_filter_time % 1000);
-        printLine(Print::Info, "  color: {}.{} ms", m_color_time / 1000, m_color_time % 1000);
-
         if (m_interface->cancelled)
         {
             return status;
@@ -3794,8 +3811,11 @@ namespace
 
         Buffer buffer(bytes_per_scan * surface.height);
 
+        ImageCodecStats::Laps laps(options.stats);
+
         // filtering
         filter_range(buffer, surface, color_bits, 0, surface.height);
+        laps.lap(ImageCodecStats::UNFILTER, buffer.size());
 
         // compute fpng scaling factor
         int factor = 0; // default: not supported
@@ -3851,6 +3871,8 @@ namespace
             bigEndian::ustore32(compressed.data() + bytes_out, adler);
             bytes_out += 4;
 
+            laps.lap(ImageCodecStats::INFLATE, bytes_out);
+
             // write chunkdID + compressed data
             write_chunk(stream, u32_mask_rev('I', 'D', 'A', 'T'), ConstMemory(compressed.data(), bytes_out));
         }
@@ -3863,6 +3885,8 @@ namespace
             Buffer compressed(bound);
             size_t bytes_out = deflate_zlib::compress(compressed, buffer, options.compression);
 
+            laps.lap(ImageCodecStats::INFLATE, bytes_out);
+
             // write chunkdID + compressed data
             write_chunk(stream, u32_mask_rev('I', 'D', 'A', 'T'), ConstMemory(compressed, bytes_out));
         }
@@ -3902,7 +3926,10 @@ namespace
 
             q.enqueue([=, &encoding_failure, &surface, &stream, &cumulative_adler]
             {
+                ImageCodecStats::Laps laps(options.stats);
+
                 filter_range(source.address, surface, color_bits, y, y + h);
+                laps.lap(ImageCodecStats::UNFILTER, source.size);
 
 #if defined(MANGO_ENABLE_ISAL)
 
@@ -4069,6 +4096,8 @@ namespace
 
 #endif
 
+                laps.lap(ImageCodecStats::INFLATE, segment_memory.size);
+
                 ticket.consume([=, &cumulative_adler, &stream]
                 {
                     cumulative_adler = ::adler32_combine(cumulative_adler, segment_adler, segment_length);
@@ -4210,7 +4239,7 @@ namespace
                 return status;
             }
 
-            status = m_parser.decode(dest, options.multithread);
+            status = m_parser.decode(dest, options);
 
             return status;
         }
@@ -6,12 +6,16 @@
     Original NeuQuant implementation (C) 1994 Anthony Becker
     Based on Self Organizing Map (SOM) neural network algorithm by Kohonen
 */
+#include <atomic>
+#include <thread>
+#include <mango/core/thread.hpp>
 #include <mango/math/math.hpp>
 #include <mango/image/quantize.hpp>
 
 namespace
 {
     using namespace mango;
+    using namespace mango::image;
 
     // ------------------------------------------------------------
     // constants
@@ -290,6 +294,433 @@ namespace
         }
     }
 
+    // ------------------------------------------------------------
+    // NearestColor
+    // ------------------------------------------------------------
+
+    // Exact nearest color search with squared euclidean distance; the palette is
+    // stored as structure-of-arrays so that 8 colors are compared in parallel.
+
+    struct NearestColor
+    {
+        alignas(32) s32 red[NETSIZE];
+        alignas(32) s32 green[NETSIZE];
+        alignas(32) s32 blue[NETSIZE];
+        int count;
+
+        NearestColor(const Color* colors, int size)
+        {
+            count = (size + 7) & ~7;
+
+            for (int i = 0; i < count; ++i)
+            {
+                if (i < size)
+                {
+                    red[i] = colors[i].r;
+                    green[i] = colors[i].g;
+                    blue[i] = colors[i].b;
+                }
+                else
+                {
+                    // padding which is never the nearest color
+                    red[i] = 0x1000;
+                    green[i] = 0x1000;
+                    blue[i] = 0x1000;
+                }
+            }
+        }
+
+        int find(int r, int g, int b) const
+        {
+            const math::int32x8 vr(r);
+            const math::int32x8 vg(g);
+            const math::int32x8 vb(b);
+
+            math::int32x8 best_distance(0x7fffffff);
+            math::int32x8 best_index(0);
+            math::int32x8 index = math::int32x8::ascend();
+
+            for (int i = 0; i < count; i += 8)
+            {
+                math::int32x8 dr = math::int32x8::uload(red + i) - vr;
+                math::int32x8 dg = math::int32x8::uload(green + i) - vg;
+                math::int32x8 db = math::int32x8::uload(blue + i) - vb;
+                math::int32x8 distance = math::mullo(dr, dr) + math::mullo(dg, dg) + math::mullo(db, db);
+
+                auto mask = distance < best_distance;
+                best_distance = math::select(mask, distance, best_distance);
+                best_index = math::select(mask, index, best_index);
+                index = index + 8;
+            }
+
+            alignas(32) s32 distances[8];
+            alignas(32) s32 indices[8];
+            math::int32x8::ustore(distances, best_distance);
+            math::int32x8::ustore(indices, best_index);
+
+            // the lowest index wins when the distances are equal
+            int result = indices[0];
+            s32 distance = distances[0];
+
+            for (int i = 1; i < 8; ++i)
+            {
+                if (distances[i] < distance || (distances[i] == distance && indices[i] < result))
+                {
+                    distance = distances[i];
+                    result = indices[i];
+                }
+            }
+
+            return result;
+        }
+    };
+
+    // ------------------------------------------------------------
+    // MedianCut
+    // ------------------------------------------------------------
+
+    // Histogram with 5 bits per component; each bin stores the sum of the colors
+    // so that the samples have the precise average color of the bin.
+
+    constexpr int HISTOGRAM_BITS = 5;
+    constexpr int HISTOGRAM_SIZE = 1 << (HISTOGRAM_BITS * 3);
+
+    struct HistogramBin
+    {
+        u64 r;
+        u64 g;
+        u64 b;
+        u64 count;
+    };
+
+    struct Sample
+    {
+        float color[3];
+        float weight;
+    };
+
+    struct Box
+    {
+        size_t begin;
+        size_t end;
+        float error;
+        int axis;
+        float mean[3];
+    };
+
+    static
+    void computeBox(Box& box, const Sample* samples)
+    {
+        double weight = 0.0;
+        double sum[3] = { 0.0, 0.0, 0.0 };
+        double sum2[3] = { 0.0, 0.0, 0.0 };
+
+        for (size_t i = box.begin; i < box.end; ++i)
+        {
+            const Sample& sample = samples[i];
+            weight += sample.weight;
+
+            for (int j = 0; j < 3; ++j)
+            {
+                double c = sample.color[j];
+                sum[j] += c * sample.weight;
+                sum2[j] += c * c * sample.weight;
+            }
+        }
+
+        box.error = 0.0f;
+        box.axis = 0;
+
+        double largest = -1.0;
+
+        for (int j = 0; j < 3; ++j)
+        {
+            double mean = weight > 0.0 ? sum[j] / weight : 0.0;
+            double error = std::max(0.0, sum2[j] - mean * sum[j]);
+
+            box.mean[j] = float(mean);
+            box.error += float(error);
+
+            if (error > largest)
+            {
+                largest = error;
+                box.axis = j;
+            }
+        }
+    }
+
+    static
+    std::vector<Sample> computeHistogram(const Surface& surface)
+    {
+        const int width = surface.width;
+        const int height = surface.height;
+
+        // histograms are computed in parallel for bands of scanlines and merged
+        const int bands = std::max(1, std::min({ int(ThreadPool::getHardwareConcurrency()), 8, height / 64 }));
+        std::vector<std::vector<HistogramBin>> histograms(bands);
+
+        ConcurrentQueue q("quantize.histogram");
+
+        for (int band = 0; band < bands; ++band)
+        {
+            q.enqueue([&, band]
+            {
+                std::vector<HistogramBin>& histogram = histograms[band];
+                histogram.resize(HISTOGRAM_SIZE, HistogramBin { 0, 0, 0, 0 });
+
+                const int y0 = band * height / bands;
+                const int y1 = (band + 1) * height / bands;
+
+                for (int y = y0; y < y1; ++y)
+                {
+                    const Color* scan = surface.address<Color>(0, y);
+
+                    for (int x = 0; x < width; ++x)
+                    {
+                        const Color color = scan[x];
+
+                        constexpr int shift = 8 - HISTOGRAM_BITS;
+                        u32 index = ((color.r >> shift) << (HISTOGRAM_BITS * 2)) |
+                                    ((color.g >> shift) << HISTOGRAM_BITS) |
+                                    (color.b >> shift);
+
+                        HistogramBin& bin = histogram[index];
+                        bin.r += color.r;
+                        bin.g += color.g;
+                        bin.b += color.b;
+                        ++bin.count;
+                    }
+                }
+            });
+        }
+
+        q.wait();
+
+        std::vector<Sample> samples;
+
+        for (int i = 0; i < HISTOGRAM_SIZE; ++i)
+        {
+            HistogramBin bin = histograms[0][i];
+
+            for (int band = 1; band < bands; ++band)
+            {
+                const HistogramBin& x = histograms[band][i];
+                bin.r += x.r;
+                bin.g += x.g;
+                bin.b += x.b;
+                bin.count += x.count;
+            }
+
+            if (bin.count)
+            {
+                float scale = 1.0f / float(bin.count);
+
+                Sample sample;
+                sample.color[0] = float(bin.r) * scale;
+                sample.color[1] = float(bin.g) * scale;
+                sample.color[2] = float(bin.b) * scale;
+                sample.weight = float(bin.count);
+                samples.push_back(sample);
+            }
+        }
+
+        return samples;
+    }
+
+    static
+    void refineKMeans(std::vector<Box>& clusters, const std::vector<Sample>& samples, int iterations)
+    {
+        const size_t count = samples.size();
+        const int size = int(clusters.size());
+
+        // the samples are split into fixed size chunks so that the result does not
+        // depend on the number of threads
+        constexpr size_t chunk_size = 4096;
+        const size_t chunks = (count + chunk_size - 1) / chunk_size;
+
+        struct Accumulator
+        {
+            double sum[3];
+            double weight;
+        };
+
+        std::vector<Accumulator> accumulators(chunks * size);
+
+        for (int iteration = 0; iteration < iterations; ++iteration)
+        {
+            Color colors[NETSIZE];
+
+            for (int i = 0; i < size; ++i)
+            {
+                colors[i] = Color(u8(clusters[i].mean[0] + 0.5f),
+                                  u8(clusters[i].mean[1] + 0.5f),
+                                  u8(clusters[i].mean[2] + 0.5f), 0xff);
+            }
+
+            NearestColor nearest(colors, size);
+
+            std::fill(accumulators.begin(), accumulators.end(), Accumulator { { 0.0, 0.0, 0.0 }, 0.0 });
+
+            ConcurrentQueue q("quantize.kmeans");
+
+            for (size_t chunk = 0; chunk < chunks; ++chunk)
+            {
+                q.enqueue([&, chunk]
+                {
+                    Accumulator* accumulator = accumulators.data() + chunk * size;
+
+                    const size_t begin = chunk * chunk_size;
+                    const size_t end = std::min(count, begin + chunk_size);
+
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        const Sample& sample = samples[i];
+                        int index = nearest.find(int(sample.color[0] + 0.5f),
+                                                 int(sample.color[1] + 0.5f),
+                                                 int(sample.color[2] + 0.5f));
+
+                        Accumulator& a = accumulator[index];
+                        a.sum[0] += sample.color[0] * sample.weight;
+                        a.sum[1] += sample.color[1] * sample.weight;
+                        a.sum[2] += sample.color[2] * sample.weight;
+                        a.weight += sample.weight;
+                    }
+                });
+            }
+
+            q.wait();
+
+            float change = 0.0f;
+
+            for (int i = 0; i < size; ++i)
+            {
+                Accumulator a { { 0.0, 0.0, 0.0 }, 0.0 };
+
+                for (size_t chunk = 0; chunk < chunks; ++chunk)
+                {
+                    const Accumulator& x = accumulators[chunk * size + i];
+                    a.sum[0] += x.sum[0];
+                    a.sum[1] += x.sum[1];
+                    a.sum[2] += x.sum[2];
+                    a.weight += x.weight;
+                }
+
+                // empty cluster keeps the previous center
+                if (a.weight > 0.0)
+                {
+                    for (int j = 0; j < 3; ++j)
+                    {
+                        float mean = float(a.sum[j] / a.weight);
+                        change = std::max(change, std::abs(mean - clusters[i].mean[j]));
+                        clusters[i].mean[j] = mean;
+                    }
+                }
+            }
+
+            if (change < 0.5f)
+            {
+                // the colors do not change after rounding
+                break;
+            }
+        }
+    }
+
+    static
+    Palette medianCut(const Surface& surface, float quality)
+    {
+        std::vector<Sample> samples = computeHistogram(surface);
+
+        std::vector<Box> boxes;
+
+        if (!samples.empty())
+        {
+            Box box;
+            box.begin = 0;
+            box.end = samples.size();
+            computeBox(box, samples.data());
+            boxes.push_back(box);
+        }
+
+        while (boxes.size() < NETSIZE)
+        {
+            // split the box with the largest error
+            int selected = -1;
+            float largest = 0.0f;
+
+            for (size_t i = 0; i < boxes.size(); ++i)
+            {
+                const Box& box = boxes[i];
+                if (box.end - box.begin > 1 && box.error > largest)
+                {
+                    largest = box.error;
+                    selected = int(i);
+                }
+            }
+
+            if (selected < 0)
+            {
+                break;
+            }
+
+            Box& box = boxes[selected];
+            const int axis = box.axis;
+
+            std::sort(samples.begin() + box.begin, samples.begin() + box.end, [axis] (const Sample& a, const Sample& b)
+            {
+                return a.color[axis] < b.color[axis];
+            });
+
+            // split at the median of the weights
+            double total = 0.0;
+            for (size_t i = box.begin; i < box.end; ++i)
+            {
+                total += samples[i].weight;
+            }
+
+            size_t split = box.begin + 1;
+            double weight = samples[box.begin].weight;
+
+            while (split < box.end - 1 && weight + samples[split].weight <= total * 0.5)
+            {
+                weight += samples[split].weight;
+                ++split;
+            }
+
+            Box upper;
+            upper.begin = split;
+            upper.end = box.end;
+            box.end = split;
+
+            computeBox(box, samples.data());
+            computeBox(upper, samples.data());
+            boxes.push_back(upper);
+        }
+
+        int iterations = int(math::clamp(quality, 0.0f, 1.0f) * 10.0f);
+        refineKMeans(boxes, samples, iterations);
+
+        Palette palette;
+        palette.size = NETSIZE;
+
+        Color color(0, 0, 0, 0xff);
+
+        for (int i = 0; i < NETSIZE; ++i)
+        {
+            if (i < int(boxes.size()))
+            {
+                const Box& box = boxes[i];
+                color = Color(u8(math::clamp(box.mean[0] + 0.5f, 0.0f, 255.0f)),
+                              u8(math::clamp(box.mean[1] + 0.5f, 0.0f, 255.0f)),
+                              u8(math::clamp(box.mean[2] + 0.5f, 0.0f, 255.0f)), 0xff);
+            }
+
+            // unused entries repeat the last color
+            palette.color[i] = color;
+        }
+
+        return palette;
+    }
+
 } // namespace
 
 namespace mango::image
@@ -299,35 +730,52 @@ namespace mango::image
     // ColorQuantizer
     // ----------------------------------------------------------------------------
 
-    ColorQuantizer::ColorQuantizer(const Surface& source, float quality)
+    ColorQuantizer::ColorQuantizer(const Surface& source, float quality, QuantizeMethod method)
+        : m_method(method)
     {
-        quality = math::clamp(quality, 0.0f, 1.0f);
-        int sample_factor = std::max(1, 30 - int(quality * 29.0f + 1.0f));
-
         // convert to correct format when required
         TemporaryBitmap temp(source, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
 
-        NeuQuant nq(temp.image, temp.width * temp.height * 4, sample_factor);
-
-        m_palette.size = NETSIZE;
+        if (method == QuantizeMethod::MedianCut)
+        {
+            m_palette = medianCut(temp, quality);
 
-        for (int i = 0; i < NETSIZE; ++i)
+            for (int i = 0; i < NETSIZE; ++i)
+            {
+                m_network[i][0] = m_palette[i].r;
+                m_network[i][1] = m_palette[i].g;
+                m_network[i][2] = m_palette[i].b;
+                m_network[i][3] = i;
+            }
+        }
+        else
         {
-            int r = nq.network[i][0];
-            int g = nq.network[i][1];
-            int b = nq.network[i][2];
-            m_palette.color[i] = Color(r, g, b, 0xff);
+            quality = math::clamp(quality, 0.0f, 1.0f);
+            int sample_factor = std::max(1, 30 - int(quality * 29.0f + 1.0f));
+
+            NeuQuant nq(temp.image, temp.width * temp.height * 4, sample_factor);
 
-            m_network[i][0] = nq.network[i][0];
-            m_network[i][1] = nq.network[i][1];
-            m_network[i][2] = nq.network[i][2];
-            m_network[i][3] = nq.network[i][3];
+            m_palette.size = NETSIZE;
+
+            for (int i = 0; i < NETSIZE; ++i)
+            {
+                int r = nq.network[i][0];
+                int g = nq.network[i][1];
+                int b = nq.network[i][2];
+                m_palette.color[i] = Color(r, g, b, 0xff);
+
+                m_network[i][0] = nq.network[i][0];
+                m_network[i][1] = nq.network[i][1];
+                m_network[i][2] = nq.network[i][2];
+                m_network[i][3] = nq.network[i][3];
+            }
         }
 
         buildIndex();
     }
 
     ColorQuantizer::ColorQuantizer(const Palette& palette)
+        : m_method(QuantizeMethod::NeuQuant)
     {
         if (palette.size != 256)
         {
@@ -374,18 +822,64 @@ namespace mango::image
         const int width = temp.width;
         const int height = temp.height;
 
+        NearestColor nearest(m_palette.color, NETSIZE);
+
+        // The error diffusion is pipelined across threads: a scanline can process pixel x
+        // when the previous scanline has completed pixel x + 2 so that the error from the
+        // previous scanline has been fully distributed and the two scanlines never write
+        // the same pixels. The result is identical to serial processing.
+        std::unique_ptr<std::atomic<int>[]> progress(new std::atomic<int>[height]);
+        std::atomic<int> next_scanline { 0 };
+
         for (int y = 0; y < height; ++y)
+        {
+            progress[y].store(0, std::memory_order_relaxed);
+        }
+
+        // direct mapped cache of the color lookups for each worker
+        constexpr u32 cache_bits = 15;
+
+        struct CacheEntry
+        {
+            u32 color; // 0xrrggbb; the high byte is set for an unused entry
+            u32 index;
+        };
+
+        auto process = [&] (int y, CacheEntry* cache)
         {
             Color* s = temp.address<Color>(0, y + 0);
             Color* n = temp.address<Color>(0, y + 1); // clipped in the loop
             u8* d = dest.address<u8>(0, y);
 
+            int ready = (dithering && y > 0) ? 0 : width;
+
             for (int x = 0; x < width; ++x)
             {
+                const int required = std::min(width, x + 3);
+                while (ready < required)
+                {
+                    ready = progress[y - 1].load(std::memory_order_acquire);
+                    if (ready < required)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+
                 int r = s[x].r;
                 int g = s[x].g;
                 int b = s[x].b;
-                int index = getIndex(r, g, b);
+
+                const u32 color = (r << 16) | (g << 8) | b;
+                CacheEntry& entry = cache[(color * 2654435761u) >> (32 - cache_bits)];
+
+                if (entry.color != color)
+                {
+                    entry.color = color;
+                    entry.index = m_method == QuantizeMethod::MedianCut ? nearest.find(r, g, b) : getIndex(r, g, b);
+                }
+
+                int index = int(entry.index);
+
                 d[x] = u8(index);
 
                 if (dithering)
@@ -421,8 +915,48 @@ namespace mango::image
                             distribute(n[x + 1], r, g, b, 1);
                         }
                     }
+
+                    if ((x & 15) == 15)
+                    {
+                        progress[y].store(x + 1, std::memory_order_release);
+                    }
                 }
             }
+
+            progress[y].store(width, std::memory_order_release);
+        };
+
+        // the scanlines are claimed in order so the previous scanline is always being
+        // processed by a running task and the waiting cannot deadlock
+        auto worker = [&]
+        {
+            std::vector<CacheEntry> cache(1 << cache_bits, CacheEntry { 0xff000000, 0 });
+
+            for (;;)
+            {
+                int y = next_scanline.fetch_add(1);
+                if (y >= height)
+                    break;
+                process(y, cache.data());
+            }
+        };
+
+        const int threads = std::min(int(ThreadPool::getHardwareConcurrency()), height);
+
+        if (u64(width) * height < 64 * 1024 || threads < 2)
+        {
+            worker();
+        }
+        else
+        {
+            ConcurrentQueue q("quantize");
+
+            for (int i = 0; i < threads; ++i)
+            {
+                q.enqueue(worker);
+            }
+
+            q.wait();
         }
     }
 
@@ -543,13 +1077,13 @@ namespace mango::image
     // QuantizedBitmap
     // ----------------------------------------------------------------------------
 
-    QuantizedBitmap::QuantizedBitmap(const Surface& source, float quality, bool dithering)
+    QuantizedBitmap::QuantizedBitmap(const Surface& source, float quality, bool dithering, QuantizeMethod method)
         : Bitmap(source.width, source.height, IndexedFormat(8))
     {
         // convert to correct format when required
         TemporaryBitmap temp(source, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
 
-        ColorQuantizer qt(temp, quality);
+        ColorQuantizer qt(temp, quality, method);
         qt.quantize(*this, temp, dithering);
 
         *this->palette = qt.getPalette();
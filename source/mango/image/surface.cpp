@@ -4,6 +4,9 @@
 */
 #include <vector>
 #include <algorithm>
+#include <bit>
+#include <cmath>
+#include <optional>
 #include <mango/core/system.hpp>
 #include <mango/core/cpuinfo.hpp>
 #include <mango/math/math.hpp>
@@ -19,141 +22,488 @@ namespace
     // linear/sRGB conversion tables
     // ------------------------------------------------------------
 
-    // linear to sRGB table
-    const u8 encode_srgb_table [] =
-    {
-        0x00, 0x0c, 0x15, 0x1c, 0x21, 0x26, 0x2a, 0x2e, 0x31, 0x34, 0x37, 0x3a, 0x3d, 0x3f, 0x42, 0x44,
-        0x46, 0x49, 0x4b, 0x4d, 0x4f, 0x51, 0x52, 0x54, 0x56, 0x58, 0x59, 0x5b, 0x5d, 0x5e, 0x60, 0x61,
-        0x63, 0x64, 0x66, 0x67, 0x68, 0x6a, 0x6b, 0x6c, 0x6e, 0x6f, 0x70, 0x72, 0x73, 0x74, 0x75, 0x76,
-        0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f, 0x80, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88,
-        0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8e, 0x8f, 0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
-        0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9d, 0x9e, 0x9f, 0xa0, 0xa1, 0xa1, 0xa2, 0xa3, 0xa4,
-        0xa5, 0xa5, 0xa6, 0xa7, 0xa8, 0xa8, 0xa9, 0xaa, 0xab, 0xab, 0xac, 0xad, 0xae, 0xae, 0xaf, 0xb0,
-        0xb0, 0xb1, 0xb2, 0xb3, 0xb3, 0xb4, 0xb5, 0xb5, 0xb6, 0xb7, 0xb7, 0xb8, 0xb9, 0xb9, 0xba, 0xbb,
-        0xbb, 0xbc, 0xbd, 0xbd, 0xbe, 0xbf, 0xbf, 0xc0, 0xc1, 0xc1, 0xc2, 0xc2, 0xc3, 0xc4, 0xc4, 0xc5,
-        0xc6, 0xc6, 0xc7, 0xc7, 0xc8, 0xc9, 0xc9, 0xca, 0xca, 0xcb, 0xcc, 0xcc, 0xcd, 0xcd, 0xce, 0xce,
-        0xcf, 0xd0, 0xd0, 0xd1, 0xd1, 0xd2, 0xd2, 0xd3, 0xd4, 0xd4, 0xd5, 0xd5, 0xd6, 0xd6, 0xd7, 0xd7,
-        0xd8, 0xd9, 0xd9, 0xda, 0xda, 0xdb, 0xdb, 0xdc, 0xdc, 0xdd, 0xdd, 0xde, 0xde, 0xdf, 0xdf, 0xe0,
-        0xe1, 0xe1, 0xe2, 0xe2, 0xe3, 0xe3, 0xe4, 0xe4, 0xe5, 0xe5, 0xe6, 0xe6, 0xe7, 0xe7, 0xe8, 0xe8,
-        0xe9, 0xe9, 0xea, 0xea, 0xeb, 0xeb, 0xec, 0xec, 0xed, 0xed, 0xee, 0xee, 0xee, 0xef, 0xef, 0xf0,
-        0xf0, 0xf1, 0xf1, 0xf2, 0xf2, 0xf3, 0xf3, 0xf4, 0xf4, 0xf5, 0xf5, 0xf6, 0xf6, 0xf6, 0xf7, 0xf7,
-        0xf8, 0xf8, 0xf9, 0xf9, 0xfa, 0xfa, 0xfb, 0xfb, 0xfb, 0xfc, 0xfc, 0xfd, 0xfd, 0xfe, 0xfe, 0xff
-    };
+    /*
+        The transfer functions are approximated with piecewise quadratic polynomials. The decoding
+        curve is split into uniform segments. The slope of the encoding curve is unbounded at zero,
+        so it is split into 32 segments per octave; the segment is selected with the exponent and
+        the highest mantissa bits of the linear value. The error is below 1 / 65535 so the results
+        can be stored into 16 bit UNORM components.
+    */
+
+    struct SRGBTable
+    {
+        static constexpr int decode_segments = 64;
+        static constexpr int encode_octaves = 9; // 2^-9 is below the linear segment threshold
+        static constexpr int encode_segments = encode_octaves * 32;
+
+        float decode_poly[decode_segments][3];
+        float encode_poly[encode_segments][3];
+
+        u8 decode_u8[256];          // 8 bit sRGB -> 8 bit linear
+        u8 encode_u8[256];          // 8 bit linear -> 8 bit sRGB
+        u16 decode_u16[256];        // 8 bit sRGB -> 16 bit linear
+        float decode_float[256];    // 8 bit sRGB -> linear float
+
+        SRGBTable()
+        {
+            auto decode_power = [] (double s)
+            {
+                return std::pow((s + 0.055) / 1.055, 2.4);
+            };
+
+            auto encode_power = [] (double x)
+            {
+                return 1.055 * std::pow(x, 1.0 / 2.4) - 0.055;
+            };
+
+            for (int i = 0; i < decode_segments; ++i)
+            {
+                double s0 = double(i + 0.0) / decode_segments;
+                double s1 = double(i + 1.0) / decode_segments;
+                interpolate(decode_poly[i], decode_power(s0), decode_power((s0 + s1) * 0.5), decode_power(s1));
+            }
+
+            for (int i = 0; i < encode_segments; ++i)
+            {
+                double scale = std::ldexp(1.0, (i >> 5) - encode_octaves);
+                double x0 = scale * (1.0 + ((i & 31) + 0.0) / 32.0);
+                double x1 = scale * (1.0 + ((i & 31) + 1.0) / 32.0);
+                interpolate(encode_poly[i], encode_power(x0), encode_power((x0 + x1) * 0.5), encode_power(x1));
+            }
+
+            for (int i = 0; i < 256; ++i)
+            {
+                double s = i / 255.0;
+                double linear = s <= 0.04045 ? s / 12.92 : decode_power(s);
+                double srgb = s <= 0.0031308 ? s * 12.92 : encode_power(s);
+
+                decode_u8[i] = u8(linear * 255.0 + 0.5);
+                encode_u8[i] = u8(srgb * 255.0 + 0.5);
+                decode_u16[i] = u16(linear * 65535.0 + 0.5);
+                decode_float[i] = float(linear);
+            }
+        }
+
+        // quadratic through the segment start, middle and end points
+        static void interpolate(float* poly, double f0, double f1, double f2)
+        {
+            poly[0] = float(f0);
+            poly[1] = float(-3.0 * f0 + 4.0 * f1 - f2);
+            poly[2] = float(2.0 * f0 - 4.0 * f1 + 2.0 * f2);
+        }
+
+        float decode(float s) const
+        {
+            // written so that NaN takes the clamp branch instead of indexing the table
+            if (!(s > 0.04045f))
+            {
+                return s > 0.0f ? s * (1.0f / 12.92f) : 0.0f;
+            }
+
+            if (!(s < 1.0f))
+            {
+                return 1.0f;
+            }
+
+            s *= float(decode_segments);
+            int index = int(s);
+            float t = s - float(index);
+
+            const float* poly = decode_poly[index];
+            return poly[0] + t * (poly[1] + t * poly[2]);
+        }
+
+        float encode(float linear) const
+        {
+            // written so that NaN takes the clamp branch instead of indexing the table
+            if (!(linear > 0.0031308f))
+            {
+                return linear > 0.0f ? linear * 12.92f : 0.0f;
+            }
 
-    // sRGB to linear table
-    const u8 decode_srgb_table [] =
-    {
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-        0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x03,
-        0x03, 0x03, 0x03, 0x03, 0x04, 0x04, 0x04, 0x04, 0x05, 0x05, 0x05, 0x05, 0x06, 0x06, 0x06, 0x06,
-        0x07, 0x07, 0x07, 0x08, 0x08, 0x08, 0x09, 0x09, 0x09, 0x0a, 0x0a, 0x0b, 0x0b, 0x0b, 0x0c, 0x0c,
-        0x0c, 0x0d, 0x0d, 0x0e, 0x0e, 0x0f, 0x0f, 0x10, 0x10, 0x10, 0x11, 0x11, 0x12, 0x12, 0x13, 0x14,
-        0x14, 0x15, 0x15, 0x16, 0x16, 0x17, 0x17, 0x18, 0x19, 0x19, 0x1a, 0x1a, 0x1b, 0x1c, 0x1c, 0x1d,
-        0x1e, 0x1e, 0x1f, 0x20, 0x20, 0x21, 0x22, 0x22, 0x23, 0x24, 0x24, 0x25, 0x26, 0x27, 0x27, 0x28,
-        0x29, 0x2a, 0x2b, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36,
-        0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3d, 0x3e, 0x3f, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46,
-        0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0x56, 0x57, 0x58,
-        0x59, 0x5a, 0x5c, 0x5d, 0x5e, 0x5f, 0x61, 0x62, 0x63, 0x65, 0x66, 0x67, 0x69, 0x6a, 0x6b, 0x6d,
-        0x6e, 0x70, 0x71, 0x72, 0x74, 0x75, 0x77, 0x78, 0x7a, 0x7b, 0x7d, 0x7e, 0x80, 0x81, 0x83, 0x84,
-        0x86, 0x87, 0x89, 0x8a, 0x8c, 0x8e, 0x8f, 0x91, 0x93, 0x94, 0x96, 0x98, 0x99, 0x9b, 0x9d, 0x9e,
-        0xa0, 0xa2, 0xa4, 0xa5, 0xa7, 0xa9, 0xab, 0xad, 0xae, 0xb0, 0xb2, 0xb4, 0xb6, 0xb8, 0xb9, 0xbb,
-        0xbd, 0xbf, 0xc1, 0xc3, 0xc5, 0xc7, 0xc9, 0xcb, 0xcd, 0xcf, 0xd1, 0xd3, 0xd5, 0xd7, 0xd9, 0xdb,
-        0xde, 0xe0, 0xe2, 0xe4, 0xe6, 0xe8, 0xea, 0xed, 0xef, 0xf1, 0xf3, 0xf5, 0xf8, 0xfa, 0xfc, 0xff 
+            if (!(linear < 1.0f))
+            {
+                return 1.0f;
+            }
+
+            u32 bits = std::bit_cast<u32>(linear);
+            int index = int(bits >> 18) - ((127 - encode_octaves) << 5);
+            float t = float(bits & 0x3ffff) * (1.0f / 262144.0f);
+
+            const float* poly = encode_poly[index];
+            return poly[0] + t * (poly[1] + t * poly[2]);
+        }
+
+        u8 encode8(float linear) const
+        {
+            return u8(encode(linear) * 255.0f + 0.5f);
+        }
     };
 
+    const SRGBTable& getSRGBTable()
+    {
+        static SRGBTable table;
+        return table;
+    }
+
     // ------------------------------------------------------------
     // linear/sRGB conversion functions
     // ------------------------------------------------------------
 
-    void srgbToLinear(const Surface& surface)
+    // surfaces smaller than this are converted in the calling thread
+    constexpr size_t srgb_parallel_threshold = 1024 * 1024;
+
+    // bytes converted in one slice
+    constexpr size_t srgb_parallel_slice = 128 * 1024;
+
+    // Calls func(y0, y1) for bands of rows; the bands are converted in the thread pool
+    // when the surface is large enough and the pool isn't already busy.
+    template <typename Func>
+    void process_rows(int height, size_t scan_bytes, bool multithread, Func func)
     {
-        for (int y = 0; y < surface.height; ++y)
+        scan_bytes = std::max(size_t(1), scan_bytes);
+
+        bool parallel = multithread && scan_bytes * height >= srgb_parallel_threshold &&
+                        ThreadPool::getHardwareConcurrency() > 1;
+
+        if (parallel)
         {
-            u8* scan = surface.address(0, y);
-            int count = surface.width;
+            ThreadPool& pool = ThreadPool::getInstance();
+            parallel = pool.getQueueSize() < size_t(pool.size());
+        }
 
-#if MANGO_SIMD_VECTOR_SIZE >= 256
-            while (count >= 8)
+        const int slice = int(std::max(size_t(1), srgb_parallel_slice / scan_bytes));
+
+        if (parallel && height >= slice * 2)
+        {
+            ConcurrentQueue queue;
+
+            for (int y = 0; y < height; y += slice)
+            {
+                queue.enqueue([=, &func]
+                {
+                    func(y, std::min(y + slice, height));
+                });
+            }
+
+            queue.wait();
+        }
+        else
+        {
+            func(0, height);
+        }
+    }
+
+    // byte offsets of the color components with the same type and size; alpha is not included
+    struct ComponentLayout
+    {
+        int bytes = 0; // bytes per pixel
+        int count = 0;
+        int offset[3];
+        int component[3];
+
+        ComponentLayout(const Format& format, Format::Type type, int bits)
+        {
+            if (format.type != type || format.isIndexed() || format.bits % bits)
+                return;
+
+            for (int c = 0; c < 3; ++c)
             {
-                int32x8 color = int32x8::uload(scan);
+                if (!format.size[c])
+                    continue;
+
+                if (format.size[c] != bits || format.offset[c] % bits)
+                {
+                    count = 0;
+                    return;
+                }
 
-                float32x8 r = convert<float32x8>((color      ) & int32x8(0xff)) * (1.0f / 255.0f);
-                float32x8 g = convert<float32x8>((color >>  8) & int32x8(0xff)) * (1.0f / 255.0f);
-                float32x8 b = convert<float32x8>((color >> 16) & int32x8(0xff)) * (1.0f / 255.0f);
-                r = srgb_to_linear(r) * 255.0f;
-                g = srgb_to_linear(g) * 255.0f;
-                b = srgb_to_linear(b) * 255.0f;
+                // the luminance formats have the same offset for all colors
+                int position = format.offset[c] / 8;
+                if (std::find(offset, offset + count, position) == offset + count)
+                {
+                    offset[count] = position;
+                    component[count] = c;
+                    ++count;
+                }
+            }
 
-                int32x8 red   = convert<int32x8>(r);
-                int32x8 green = convert<int32x8>(g);
-                int32x8 blue  = convert<int32x8>(b);
-                int32x8 alpha = color & int32x8(0xff000000);
+            bytes = format.bits / 8;
+        }
 
-                color = alpha | (blue << 16) | (green << 8) | red;
+        bool isValid() const
+        {
+            return count > 0;
+        }
+    };
 
-                int32x8::ustore(scan, color);
-                scan += 32;
-                count -= 8;
+    // converts the color components in place
+    template <typename T, typename Func>
+    void convert_components(const Surface& surface, const ComponentLayout& layout, bool multithread, Func func)
+    {
+        process_rows(surface.height, size_t(surface.width) * layout.bytes, multithread, [&] (int y0, int y1)
+        {
+            for (int y = y0; y < y1; ++y)
+            {
+                u8* scan = surface.address(0, y);
+
+                for (int x = 0; x < surface.width; ++x)
+                {
+                    for (int i = 0; i < layout.count; ++i)
+                    {
+                        T* value = reinterpret_cast<T*>(scan + layout.offset[i]);
+                        *value = func(*value);
+                    }
+
+                    scan += layout.bytes;
+                }
             }
-#endif
+        });
+    }
+
+    const Format float_rgba_format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32);
 
-            for (int x = 0; x < count; ++x)
+    // Converts the rows through a 32 bit float RGBA scanline. The load function converts
+    // the source scanline into float RGBA and the store function writes it into the dest;
+    // the store function may modify the scanline.
+    template <typename LoadFunc, typename StoreFunc>
+    void convert_float_scanlines(const Surface& dest, const Surface& source, bool multithread, LoadFunc load, StoreFunc store)
+    {
+        const size_t scan_bytes = size_t(source.width) * (source.format.bytes() + dest.format.bytes());
+
+        process_rows(source.height, scan_bytes, multithread, [&] (int y0, int y1)
+        {
+            std::vector<float> buffer(size_t(source.width) * 4);
+
+            for (int y = y0; y < y1; ++y)
             {
-                u8 r = scan[x * 4 + 0];
-                u8 g = scan[x * 4 + 1];
-                u8 b = scan[x * 4 + 2];
-                //u8 a = scan[x * 4 + 3];
-                scan[x * 4 + 0] = decode_srgb_table[r];
-                scan[x * 4 + 1] = decode_srgb_table[g];
-                scan[x * 4 + 2] = decode_srgb_table[b];
-                //scan[x * 4 + 3] = a;
+                load(buffer.data(), source.address(0, y));
+                store(dest.address(0, y), buffer.data());
             }
+        });
+    }
+
+    // blits one scanline with the blitter
+    struct ScanBlitter
+    {
+        Blitter blitter;
+        int width;
+
+        ScanBlitter(const Format& dest, const Format& source, int width, Palette* palette = nullptr)
+            : blitter(dest, source, palette)
+            , width(width)
+        {
+        }
+
+        void convert(void* dest, const void* source) const
+        {
+            Blitter::Rect rect;
+
+            rect.width = width;
+            rect.height = 1;
+            rect.source = { reinterpret_cast<u8*>(const_cast<void*>(source)), 0 };
+            rect.dest = { reinterpret_cast<u8*>(dest), 0 };
+
+            blitter.convert(rect);
+        }
+    };
+
+    void check_dimensions(const Surface& dest, const Surface& source)
+    {
+        if (dest.width != source.width || dest.height != source.height)
+        {
+            MANGO_EXCEPTION("Surface and source must have the same dimensions.");
         }
     }
 
-    void linearToSRGB(const Surface& surface)
+    void decode_srgb(const Surface& dest, const Surface& source, bool multithread)
     {
-        for (int y = 0; y < surface.height; ++y)
+        const SRGBTable& table = getSRGBTable();
+
+        const int width = source.width;
+        const float alpha_scale = 1.0f / 255.0f;
+
+        const ComponentLayout layout(source.format, Format::UNORM, 8);
+        const bool source_alpha = source.format.size[3] == 8 && !(source.format.offset[3] % 8);
+        const bool load_direct = layout.isValid() && (source_alpha || !source.format.isAlpha());
+
+        // the blitters are created only when needed; they don't support all directions
+        std::optional<ScanBlitter> loader;
+        if (!load_direct)
         {
-            u8* scan = surface.address(0, y);
-            int count = surface.width;
+            loader.emplace(float_rgba_format, source.format, width, source.palette);
+        }
+
+        ScanBlitter storer(dest.format, float_rgba_format, width);
 
-#if MANGO_SIMD_VECTOR_SIZE >= 256
-            while (count >= 8)
+        convert_float_scanlines(dest, source, multithread, [&] (float* d, const u8* s)
+        {
+            if (load_direct)
             {
-                int32x8 color = int32x8::uload(scan);
+                // the 8 bit components are decoded with a table
+                const int alpha_offset = source.format.offset[3] / 8;
+                const bool luminance = source.format.isLuminance();
 
-                float32x8 r = convert<float32x8>((color      ) & int32x8(0xff)) * (1.0f / 255.0f);
-                float32x8 g = convert<float32x8>((color >>  8) & int32x8(0xff)) * (1.0f / 255.0f);
-                float32x8 b = convert<float32x8>((color >> 16) & int32x8(0xff)) * (1.0f / 255.0f);
-                r = linear_to_srgb(r) * 255.0f;
-                g = linear_to_srgb(g) * 255.0f;
-                b = linear_to_srgb(b) * 255.0f;
+                for (int x = 0; x < width; ++x)
+                {
+                    float color[3] = { 0.0f, 0.0f, 0.0f };
 
-                int32x8 red   = convert<int32x8>(r);
-                int32x8 green = convert<int32x8>(g);
-                int32x8 blue  = convert<int32x8>(b);
-                int32x8 alpha = color & int32x8(0xff000000);
+                    for (int i = 0; i < layout.count; ++i)
+                    {
+                        color[layout.component[i]] = table.decode_float[s[layout.offset[i]]];
+                    }
 
-                color = alpha | (blue << 16) | (green << 8) | red;
+                    if (luminance)
+                    {
+                        color[1] = color[0];
+                        color[2] = color[0];
+                    }
 
-                int32x8::ustore(scan, color);
-                scan += 32;
-                count -= 8;
+                    d[x * 4 + 0] = color[0];
+                    d[x * 4 + 1] = color[1];
+                    d[x * 4 + 2] = color[2];
+                    d[x * 4 + 3] = source_alpha ? s[alpha_offset] * alpha_scale : 1.0f;
+                    s += layout.bytes;
+                }
             }
-#endif
+            else
+            {
+                loader->convert(d, s);
+
+                for (int x = 0; x < width; ++x)
+                {
+                    d[x * 4 + 0] = table.decode(d[x * 4 + 0]);
+                    d[x * 4 + 1] = table.decode(d[x * 4 + 1]);
+                    d[x * 4 + 2] = table.decode(d[x * 4 + 2]);
+                }
+            }
+        },
+        [&] (u8* d, float* s)
+        {
+            storer.convert(d, s);
+        });
+    }
+
+    void encode_srgb(const Surface& dest, const Surface& source, bool multithread)
+    {
+        const SRGBTable& table = getSRGBTable();
+
+        const int width = source.width;
+
+        const ComponentLayout layout(dest.format, Format::UNORM, 8);
+        const bool dest_alpha = dest.format.size[3] == 8 && !(dest.format.offset[3] % 8);
+        const bool store_direct = layout.isValid() && (dest_alpha || !dest.format.isAlpha());
+
+        ScanBlitter loader(float_rgba_format, source.format, width, source.palette);
+
+        std::optional<ScanBlitter> storer;
+        if (!store_direct)
+        {
+            storer.emplace(dest.format, float_rgba_format, width);
+        }
+
+        convert_float_scanlines(dest, source, multithread, [&] (float* d, const u8* s)
+        {
+            loader.convert(d, s);
+        },
+        [&] (u8* d, float* s)
+        {
+            if (store_direct)
+            {
+                // the 8 bit components are encoded directly from the float values
+                const int alpha_offset = dest.format.offset[3] / 8;
+
+                for (int x = 0; x < width; ++x)
+                {
+                    for (int i = 0; i < layout.count; ++i)
+                    {
+                        d[layout.offset[i]] = table.encode8(s[x * 4 + layout.component[i]]);
+                    }
 
-            for (int x = 0; x < count; ++x)
+                    if (dest_alpha)
+                    {
+                        // NaN alpha is stored as zero like the color components
+                        float alpha = s[x * 4 + 3];
+                        alpha = alpha > 0.0f ? std::min(alpha, 1.0f) : 0.0f;
+                        d[alpha_offset] = u8(alpha * 255.0f + 0.5f);
+                    }
+
+                    d += layout.bytes;
+                }
+            }
+            else
             {
-                u8 r = scan[x * 4 + 0];
-                u8 g = scan[x * 4 + 1];
-                u8 b = scan[x * 4 + 2];
-                //u8 a = scan[x * 4 + 3];
-                scan[x * 4 + 0] = encode_srgb_table[r];
-                scan[x * 4 + 1] = encode_srgb_table[g];
-                scan[x * 4 + 2] = encode_srgb_table[b];
-                //scan[x * 4 + 3] = a;
+                for (int x = 0; x < width; ++x)
+                {
+                    s[x * 4 + 0] = table.encode(s[x * 4 + 0]);
+                    s[x * 4 + 1] = table.encode(s[x * 4 + 1]);
+                    s[x * 4 + 2] = table.encode(s[x * 4 + 2]);
+                }
+
+                storer->convert(d, s);
             }
+        });
+    }
+
+    void decode_srgb(const Surface& surface, bool multithread)
+    {
+        const SRGBTable& table = getSRGBTable();
+
+        if (ComponentLayout layout(surface.format, Format::UNORM, 8); layout.isValid())
+        {
+            convert_components<u8>(surface, layout, multithread, [&] (u8 value)
+            {
+                return table.decode_u8[value];
+            });
+        }
+        else if (ComponentLayout layout(surface.format, Format::UNORM, 16); layout.isValid())
+        {
+            convert_components<u16>(surface, layout, multithread, [&] (u16 value)
+            {
+                return u16(table.decode(value * (1.0f / 65535.0f)) * 65535.0f + 0.5f);
+            });
+        }
+        else if (ComponentLayout layout(surface.format, Format::FLOAT32, 32); layout.isValid())
+        {
+            convert_components<float>(surface, layout, multithread, [&] (float value)
+            {
+                return table.decode(value);
+            });
+        }
+        else
+        {
+            decode_srgb(surface, surface, multithread);
+        }
+    }
+
+    void encode_srgb(const Surface& surface, bool multithread)
+    {
+        const SRGBTable& table = getSRGBTable();
+
+        if (ComponentLayout layout(surface.format, Format::UNORM, 8); layout.isValid())
+        {
+            convert_components<u8>(surface, layout, multithread, [&] (u8 value)
+            {
+                return table.encode_u8[value];
+            });
+        }
+        else if (ComponentLayout layout(surface.format, Format::UNORM, 16); layout.isValid())
+        {
+            convert_components<u16>(surface, layout, multithread, [&] (u16 value)
+            {
+                return u16(table.encode(value * (1.0f / 65535.0f)) * 65535.0f + 0.5f);
+            });
+        }
+        else if (ComponentLayout layout(surface.format, Format::FLOAT32, 32); layout.isValid())
+        {
+            convert_components<float>(surface, layout, multithread, [&] (float value)
+            {
+                return table.encode(value);
+            });
+        }
+        else
+        {
+            encode_srgb(surface, surface, multithread);
         }
     }
 
@@ -184,32 +534,39 @@ namespace
         }
     }
 
+    // the luminance is computed from 16 bit linear colors so that the dark tones don't band
+
     void grayscale_srgb(u8* d, const u8* s, int width)
     {
+        const SRGBTable& table = getSRGBTable();
+
         for (int x = 0; x < width; ++x)
         {
-            u32 r = decode_srgb_table[s[x * 4 + 0]];
-            u32 g = decode_srgb_table[s[x * 4 + 1]];
-            u32 b = decode_srgb_table[s[x * 4 + 2]];
-            u8 luminance = u8((r * 77 + g * 150 + b * 29) >> 8);
-            d[x] = encode_srgb_table[luminance];
+            u32 r = table.decode_u16[s[x * 4 + 0]];
+            u32 g = table.decode_u16[s[x * 4 + 1]];
+            u32 b = table.decode_u16[s[x * 4 + 2]];
+            u32 luminance = (r * 77 + g * 150 + b * 29) >> 8;
+            d[x] = table.encode8(luminance * (1.0f / 65535.0f));
         }
     }
 
     void grayscale_srgb_alpha(u8* d, const u8* s, int width)
     {
+        const SRGBTable& table = getSRGBTable();
+
         for (int x = 0; x < width; ++x)
         {
-            u32 r = decode_srgb_table[s[x * 4 + 0]];
-            u32 g = decode_srgb_table[s[x * 4 + 1]];
-            u32 b = decode_srgb_table[s[x * 4 + 2]];
-            u8 luminance = u8((r * 77 + g * 150 + b * 29) >> 8);
-            d[x * 2 + 0] = encode_srgb_table[luminance];
+            u32 r = table.decode_u16[s[x * 4 + 0]];
+            u32 g = table.decode_u16[s[x * 4 + 1]];
+            u32 b = table.decode_u16[s[x * 4 + 2]];
+            u32 luminance = (r * 77 + g * 150 + b * 29) >> 8;
+            d[x * 2 + 0] = table.encode8(luminance * (1.0f / 65535.0f));
             d[x * 2 + 1] = s[x * 4 + 3];
         }
     }
 
-#if defined(MANGO_ENABLE_SSE4_1)
+#if defined(MANGO_DISPATCH_SSE4_1)
+MANGO_TARGET_BEGIN_SSE4_1
 
     void sse41_grayscale_linear(u8* d, const u8* s, int width)
     {
@@ -266,9 +623,11 @@ namespace
         grayscale_linear(d, s, width);
     }
 
-#endif // defined(MANGO_ENABLE_SSE4_1)
+MANGO_TARGET_END
+#endif // defined(MANGO_DISPATCH_SSE4_1)
 
-#if defined(MANGO_ENABLE_AVX2)
+#if defined(MANGO_DISPATCH_AVX2)
+MANGO_TARGET_BEGIN_AVX2
 
     void avx2_grayscale_linear(u8* d, const u8* s, int width)
     {
@@ -330,6 +689,13 @@ namespace
         grayscale_linear(d, s, width);
     }
 
+MANGO_TARGET_END
+#endif // defined(MANGO_DISPATCH_AVX2)
+
+#if defined(MANGO_ENABLE_AVX2)
+
+    // NOTE: the sRGB conversion uses the simd vector types so AVX2 must be the build target
+
     void avx2_grayscale_srgb(u8* d, const u8* s, int width)
     {
         // The scales are negative because signed range is [-128, 127] and we want a power of two
@@ -491,16 +857,21 @@ namespace
         u64 features = getCPUFlags();
         MANGO_UNREFERENCED(features);
 
-#if defined(MANGO_ENABLE_SSE4_1)
-        if (features & INTEL_SSE4_1)
+#if defined(MANGO_DISPATCH_SSE4_1)
+        if ((features & TARGET_SSE4_1) == TARGET_SSE4_1)
         {
             table[0] = sse41_grayscale_linear;
         }
 #endif
+#if defined(MANGO_DISPATCH_AVX2)
+        if ((features & TARGET_AVX2) == TARGET_AVX2)
+        {
+            table[0] = avx2_grayscale_linear;
+        }
+#endif
 #if defined(MANGO_ENABLE_AVX2)
         if (features & INTEL_AVX2)
         {
-            table[0] = avx2_grayscale_linear;
             table[2] = avx2_grayscale_srgb;
         }
 #endif
@@ -845,7 +1216,7 @@ namespace mango::image
         clear(color.r * s, color.g * s, color.b * s, color.a * s);
     }
 
-    void Surface::blit(int x, int y, const Surface& source) const
+    void Surface::blit(int x, int y, const Surface& source, const BlitOptions& options) const
     {
         if (!source.width || !source.height || !source.format.bits || !format.bits)
             return;
@@ -874,13 +1245,24 @@ namespace mango::image
 
         Blitter blitter(dest.format, source.format, source.palette);
 
-#if 0
-        // enabling this creates a wind-tunnel for laptops
-        const int slice = 128;
+        const size_t scan_bytes = size_t(rect.width) * (source.format.bytes() + dest.format.bytes());
+        const size_t bytes = scan_bytes * rect.height;
+
+        bool parallel = options.multithread && bytes >= options.threshold &&
+                        ThreadPool::getHardwareConcurrency() > 1;
 
-        if (ThreadPool::getHardwareConcurrency() > 2 && rect.height >= slice * 2)
+        if (parallel)
         {
-            ConcurrentQueue queue("blitter");
+            // don't compete with the work which is already keeping the pool busy
+            ThreadPool& pool = ThreadPool::getInstance();
+            parallel = pool.getQueueSize() < size_t(pool.size());
+        }
+
+        const int slice = int(std::max(size_t(1), options.slice / scan_bytes));
+
+        if (parallel && rect.height >= slice * 2)
+        {
+            ConcurrentQueue queue;
 
             for (int y = 0; y < rect.height; y += slice)
             {
@@ -889,7 +1271,7 @@ namespace mango::image
                     int y0 = y;
                     int y1 = std::min(y + slice, rect.height);
 
-                    BlitRect temp = rect;
+                    Blitter::Rect temp = rect;
 
                     temp.dest.address += y0 * rect.dest.stride;
                     temp.source.address += y0 * rect.source.stride;
@@ -898,9 +1280,10 @@ namespace mango::image
                     blitter.convert(temp);
                 });
             }
+
+            queue.wait();
         }
         else
-#endif
         {
             blitter.convert(rect);
         }
@@ -1181,7 +1564,13 @@ namespace mango::image
             else
             {
                 // rgba <- rgba
-                target.blit(0, 0, source);
+                // The whole decoded image is converted at once; large conversions are worth
+                // splitting when the pool is idle.
+                BlitOptions options;
+                options.multithread = true;
+                options.threshold = 64 * 1024 * 1024;
+
+                target.blit(0, 0, source, options);
             }
         }
     }
@@ -1198,20 +1587,43 @@ namespace mango::image
     LuminanceBitmap::LuminanceBitmap(const Surface& source, bool alpha, bool force_linear)
         : Bitmap(source.width, source.height, alpha ? LuminanceFormat(16, 0x00ff, 0xff00) : LuminanceFormat(8, 0xff, 0))
     {
-        // convert to correct format when required
-        TemporaryBitmap temp(source, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
-
         // select conversion function
         bool linear = source.format.isLinear() || force_linear;
         auto func = select_conversion_function(alpha, linear);
 
-        // resolve conversion
-        for (int y = 0; y < temp.height; ++y)
+        const Format rgba(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8);
+        const bool direct = source.format == rgba;
+
+        Blitter blitter(rgba, source.format, source.palette);
+
+        const size_t scan_bytes = size_t(width) * (source.format.bytes() + format.bytes());
+
+        // resolve conversion in bands of rows; other source formats are converted one scanline at a time
+        process_rows(height, scan_bytes, true, [&] (int y0, int y1)
         {
-            const u8* s = temp.address(0, y);
-            u8* d = address(0, y);
-            func(d, s, temp.width);
-        }
+            std::vector<u8> buffer(direct ? 0 : size_t(width) * 4);
+
+            for (int y = y0; y < y1; ++y)
+            {
+                const u8* s = source.address(0, y);
+                u8* d = address(0, y);
+
+                if (!direct)
+                {
+                    Blitter::Rect rect;
+
+                    rect.width = width;
+                    rect.height = 1;
+                    rect.source = { const_cast<u8*>(s), 0 };
+                    rect.dest = { buffer.data(), 0 };
+
+                    blitter.convert(rect);
+                    s = buffer.data();
+                }
+
+                func(d, s, width);
+            }
+        });
     }
 
     // ----------------------------------------------------------------------------
@@ -1250,6 +1662,130 @@ namespace mango::image
         }
     }
 
+    void mipmap(const Surface& dest, const Surface& source)
+    {
+        if (dest.width != std::max(1, source.width / 2) || dest.height != std::max(1, source.height / 2))
+        {
+            MANGO_EXCEPTION("Destination must be half the size of the source.");
+        }
+
+        if (dest.format != source.format)
+        {
+            MANGO_EXCEPTION("Surface and source must have the same format.");
+        }
+
+        const bool is_float = source.format == Format(128, Format::FLOAT32, Format::RGBA, 32, 32, 32, 32);
+        const bool is_unorm = source.format.bits == 32 && source.format.type == Format::UNORM &&
+                              source.format.size == Color(8, 8, 8, 8);
+        if (!is_unorm && !is_float)
+        {
+            MANGO_EXCEPTION("Format must be 32 bit UNORM with 8 bit components or 128 bit FLOAT32 RGBA.");
+        }
+
+        // The destination texel covers n / (n / 2) source texels. An even dimension is filtered
+        // with two equal weights. An odd dimension is filtered with three weights, which cover
+        // the overlapping source texels, so the last column or row is not dropped.
+        struct Taps
+        {
+            int index[3];
+            float weight[3];
+        };
+
+        auto computeTaps = [] (int size, int count)
+        {
+            std::vector<Taps> taps(count);
+
+            for (int i = 0; i < count; ++i)
+            {
+                Taps& tap = taps[i];
+
+                for (int j = 0; j < 3; ++j)
+                {
+                    tap.index[j] = std::min(i * 2 + j, size - 1);
+                }
+
+                if (size == 1)
+                {
+                    tap.weight[0] = 1.0f;
+                    tap.weight[1] = 0.0f;
+                    tap.weight[2] = 0.0f;
+                }
+                else if (size & 1)
+                {
+                    tap.weight[0] = float(count - i) / size;
+                    tap.weight[1] = float(count) / size;
+                    tap.weight[2] = float(i + 1) / size;
+                }
+                else
+                {
+                    tap.weight[0] = 0.5f;
+                    tap.weight[1] = 0.5f;
+                    tap.weight[2] = 0.0f;
+                }
+            }
+
+            return taps;
+        };
+
+        const std::vector<Taps> xtaps = computeTaps(source.width, dest.width);
+        const std::vector<Taps> ytaps = computeTaps(source.height, dest.height);
+
+        std::vector<float32x4> temp(source.width);
+
+        for (int y = 0; y < dest.height; ++y)
+        {
+            const Taps& ytap = ytaps[y];
+
+            // vertical filter into a float scanline
+            for (int x = 0; x < source.width; ++x)
+            {
+                float32x4 sum = 0.0f;
+
+                for (int j = 0; j < 3; ++j)
+                {
+                    float32x4 sample;
+
+                    if (is_float)
+                    {
+                        sample = source.address<float32x4>(0, ytap.index[j])[x];
+                    }
+                    else
+                    {
+                        const u8* s = source.address<u8>(x, ytap.index[j]);
+                        sample = float32x4(s[0], s[1], s[2], s[3]);
+                    }
+
+                    sum = sum + sample * ytap.weight[j];
+                }
+
+                temp[x] = sum;
+            }
+
+            // horizontal filter into the destination
+            for (int x = 0; x < dest.width; ++x)
+            {
+                const Taps& xtap = xtaps[x];
+
+                float32x4 sum = temp[xtap.index[0]] * xtap.weight[0] +
+                                temp[xtap.index[1]] * xtap.weight[1] +
+                                temp[xtap.index[2]] * xtap.weight[2];
+
+                if (is_float)
+                {
+                    dest.address<float32x4>(0, y)[x] = sum;
+                }
+                else
+                {
+                    u8* d = dest.address<u8>(x, y);
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        d[c] = u8(std::min(sum[c] + 0.5f, 255.0f));
+                    }
+                }
+            }
+        }
+    }
+
     void transform(const Surface& surface, ConstMemory icc)
     {
         image::ColorManager manager;
@@ -1258,14 +1794,26 @@ namespace mango::image
         manager.transform(surface, display, profile);
     }
 
-    void srgbToLinear(const Surface& surface)
+    void srgbToLinear(const Surface& surface, bool multithread)
+    {
+        decode_srgb(surface, multithread);
+    }
+
+    void linearToSRGB(const Surface& surface, bool multithread)
+    {
+        encode_srgb(surface, multithread);
+    }
+
+    void srgbToLinear(const Surface& dest, const Surface& source, bool multithread)
     {
-        ::srgbToLinear(surface);
+        check_dimensions(dest, source);
+        decode_srgb(dest, source, multithread);
     }
 
-    void linearToSRGB(const Surface& surface)
+    void linearToSRGB(const Surface& dest, const Surface& source, bool multithread)
     {
-        ::linearToSRGB(surface);
+        check_dimensions(dest, source);
+        encode_srgb(dest, source, multithread);
     }
 
 } // namespace mango::image
@@ -349,6 +349,11 @@ namespace mango::image::jpeg
 
         void (*idct) (u8* dest, const s16* data, const s16* qt);
         void (*process) (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+
+        // fancy upsampling: the chroma is upsampled one row at a time and converted with the luma row
+        void (*upsample_h2v1) (u8* dest, const u8* src, int width);
+        void (*upsample_h2v2) (u8* dest, const u8* src, const u8* neighbor, int width);
+        void (*process_row) (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
     };
 
     // ----------------------------------------------------------------------------
@@ -378,6 +383,7 @@ namespace mango::image::jpeg
         int restartCounter;
 
         int m_hardware_concurrency;
+        ImageCodecStats* m_stats = nullptr;
 
         std::string m_encoding;
         std::string m_compression;
@@ -389,6 +395,8 @@ namespace mango::image::jpeg
         const Surface* m_target = nullptr;  // caller surface
         const Surface* m_surface = nullptr; // temporary color conversion/clipping surface
         bool m_request_blitting = false;
+        bool m_fancy_upsampling = false; // triangle filter chroma upsampling (h2v1, h2v2)
+        bool m_decode_coefficients = false; // entropy decoding only (transcoding)
 
         int m_aligned_width;
         int m_aligned_height;
@@ -444,6 +452,7 @@ namespace mango::image::jpeg
         void decodeSequential();
         void decodeSequentialST();
         void decodeSequentialMT(int N);
+        void decodeSequentialBlocks();
         void decodeMultiScan();
         void decodeProgressive();
         void decodeProgressiveDC();
@@ -451,6 +460,8 @@ namespace mango::image::jpeg
         void finishProgressive();
 
         void process_range(int y0, int y1, const s16* data);
+        void process_range_fancy(int y0, int y1, const s16* data);
+        void update_range(int y0, int y1);
         void process_and_clip(u8* dest, size_t stride, const s16* data, int width, int height);
         void blit_and_update(const ImageDecodeRect& rect, bool force_blit = false);
 
@@ -470,6 +481,7 @@ namespace mango::image::jpeg
         void setInterface(ImageDecodeInterface* interface);
 
         ImageDecodeStatus decode(const Surface& target, const ImageDecodeOptions& options);
+        ImageDecodeStatus decodeCoefficients(JPEGCoefficients& coefficients);
     };
 
     // ----------------------------------------------------------------------------
@@ -499,53 +511,67 @@ namespace mango::image::jpeg
     void process_cmyk_rgba              (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_8bit             (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
 
+    void upsample_h2v1                  (u8* dest, const u8* src, int width);
+    void upsample_h2v2                  (u8* dest, const u8* src, const u8* neighbor, int width);
+
     void process_ycbcr_bgr              (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgr_8x8          (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgr_8x16         (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgr_16x8         (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgr_16x16        (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_bgr_row          (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
 
     void process_ycbcr_rgb              (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgb_8x8          (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgb_8x16         (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgb_16x8         (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgb_16x16        (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_rgb_row          (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
 
     void process_ycbcr_bgra             (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgra_8x8         (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgra_8x16        (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgra_16x8        (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgra_16x16       (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_bgra_row         (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
 
     void process_ycbcr_rgba             (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgba_8x8         (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgba_8x16        (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgba_16x8        (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgba_16x16       (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_rgba_row         (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
 
 #if defined(MANGO_ENABLE_NEON)
 
     void idct_neon                      (u8* dest, const s16* data, const s16* qt);
 
+    void upsample_h2v1_neon             (u8* dest, const u8* src, int width);
+    void upsample_h2v2_neon             (u8* dest, const u8* src, const u8* neighbor, int width);
+
     void process_ycbcr_bgra_8x8_neon    (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgra_8x16_neon   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgra_16x8_neon   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgra_16x16_neon  (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_bgra_row_neon    (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
 
     void process_ycbcr_rgba_8x8_neon    (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgba_8x16_neon   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgba_16x8_neon   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgba_16x16_neon  (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_rgba_row_neon    (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
 
     void process_ycbcr_bgr_8x8_neon     (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgr_8x16_neon    (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgr_16x8_neon    (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgr_16x16_neon   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_bgr_row_neon     (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
 
     void process_ycbcr_rgb_8x8_neon     (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgb_8x16_neon    (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgb_16x8_neon    (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgb_16x16_neon   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_rgb_row_neon     (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
 
 #endif // MANGO_ENABLE_NEON
 
@@ -553,15 +579,20 @@ namespace mango::image::jpeg
 
     void idct_sse2                      (u8* dest, const s16* data, const s16* qt);
 
+    void upsample_h2v1_sse2             (u8* dest, const u8* src, int width);
+    void upsample_h2v2_sse2             (u8* dest, const u8* src, const u8* neighbor, int width);
+
     void process_ycbcr_bgra_8x8_sse2    (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgra_8x16_sse2   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgra_16x8_sse2   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgra_16x16_sse2  (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_bgra_row_sse2    (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
 
     void process_ycbcr_rgba_8x8_sse2    (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgba_8x16_sse2   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgba_16x8_sse2   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgba_16x16_sse2  (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_rgba_row_sse2    (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
 
 #endif // MANGO_ENABLE_SSE2
 
@@ -571,21 +602,48 @@ namespace mango::image::jpeg
     void process_ycbcr_bgr_8x16_sse41   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgr_16x8_sse41   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_bgr_16x16_sse41  (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_bgr_row_sse41    (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
 
     void process_ycbcr_rgb_8x8_sse41    (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgb_8x16_sse41   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgb_16x8_sse41   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
     void process_ycbcr_rgb_16x16_sse41  (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_rgb_row_sse41    (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
 
 #endif // MANGO_ENABLE_SSE4_1
 
-#if defined(MANGO_ENABLE_AVX2)
+#if defined(MANGO_DISPATCH_AVX2)
+
+    void process_ycbcr_bgra_8x8_avx2    (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_bgra_8x16_avx2   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_bgra_16x8_avx2   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_bgra_16x16_avx2  (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_bgra_row_avx2    (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
 
     void process_ycbcr_rgba_8x8_avx2    (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_rgba_8x16_avx2   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_rgba_16x8_avx2   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_rgba_16x16_avx2  (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_rgba_row_avx2    (u8* dest, const u8* y, const u8* cb, const u8* cr, int width);
+
+#endif // MANGO_DISPATCH_AVX2
+
+#if defined(MANGO_DISPATCH_AVX512)
+
+    void process_ycbcr_bgra_8x8_avx512   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_bgra_8x16_avx512  (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_bgra_16x8_avx512  (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_bgra_16x16_avx512 (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+
+    void process_ycbcr_rgba_8x8_avx512   (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_rgba_8x16_avx512  (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_rgba_16x8_avx512  (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
+    void process_ycbcr_rgba_16x16_avx512 (u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height);
 
-#endif // MANGO_ENABLE_AVX2
+#endif // MANGO_DISPATCH_AVX512
 
     SampleFormat getSampleFormat(const Format& format);
     ImageEncodeStatus encodeImage(Stream& stream, const Surface& surface, const ImageEncodeOptions& options);
+    ImageEncodeStatus encodeCoefficients(Stream& stream, const JPEGCoefficients& coefficients, const JPEGTranscodeOptions& options);
 
 } // namespace mango::jpeg
@@ -1301,6 +1301,8 @@ namespace mango::image::jpeg
         const u8* end = memory.end();
         const u8* p = memory.address;
 
+        ImageCodecStats::Laps laps(m_stats);
+
         for ( ; p < end; )
         {
             if (!header)
@@ -1318,8 +1320,6 @@ namespace mango::image::jpeg
             u16 marker = bigEndian::uload16(p);
             p += 2;
 
-            u64 time0 = Time::us();
-
             switch (marker)
             {
                 case MARKER_SOI:
@@ -1472,12 +1472,15 @@ namespace mango::image::jpeg
                     break;
             }
 
-            u64 time1 = Time::us();
-            printLine(Print::Info, "  Time: {} us", time1 - time0);
-            printLine(Print::Info, "");
-
-            MANGO_UNREFERENCED(time0);
-            MANGO_UNREFERENCED(time1);
+            if (marker == MARKER_SOS)
+            {
+                // the scan decoding records its own stages
+                laps.skip();
+            }
+            else
+            {
+                laps.lap(ImageCodecStats::PARSE);
+            }
         }
     }
 
@@ -1719,9 +1722,10 @@ namespace mango::image::jpeg
 
 #endif // MANGO_ENABLE_SSE4_1
 
-#if defined(MANGO_ENABLE_AVX2)
+#if defined(MANGO_DISPATCH_AVX2)
 
-        if (flags & INTEL_AVX2)
+        // NOTE: the AVX2 and AVX-512 functions have the 8 bit idct built-in
+        if ((flags & TARGET_AVX2) == TARGET_AVX2 && m_precision == 8)
         {
             switch (sample)
             {
@@ -1732,15 +1736,66 @@ namespace mango::image::jpeg
                 case SampleType::U8_RGB:
                     break;
                 case SampleType::U8_BGRA:
+                    process_ycbcr_8x8   = process_ycbcr_bgra_8x8_avx2;
+                    process_ycbcr_8x16  = process_ycbcr_bgra_8x16_avx2;
+                    process_ycbcr_16x8  = process_ycbcr_bgra_16x8_avx2;
+                    process_ycbcr_16x16 = process_ycbcr_bgra_16x16_avx2;
+                    simd_8x8   = "AVX2";
+                    simd_8x16  = "AVX2";
+                    simd_16x8  = "AVX2";
+                    simd_16x16 = "AVX2";
                     break;
                 case SampleType::U8_RGBA:
-                    process_ycbcr_8x8 = process_ycbcr_rgba_8x8_avx2;
+                    process_ycbcr_8x8   = process_ycbcr_rgba_8x8_avx2;
+                    process_ycbcr_8x16  = process_ycbcr_rgba_8x16_avx2;
+                    process_ycbcr_16x8  = process_ycbcr_rgba_16x8_avx2;
+                    process_ycbcr_16x16 = process_ycbcr_rgba_16x16_avx2;
                     simd_8x8   = "AVX2";
+                    simd_8x16  = "AVX2";
+                    simd_16x8  = "AVX2";
+                    simd_16x16 = "AVX2";
                     break;
             }
         }
 
-#endif // MANGO_ENABLE_AVX2
+#endif // MANGO_DISPATCH_AVX2
+
+#if defined(MANGO_DISPATCH_AVX512)
+
+        if ((flags & TARGET_AVX512) == TARGET_AVX512 && m_precision == 8)
+        {
+            switch (sample)
+            {
+                case SampleType::U8_Y:
+                    break;
+                case SampleType::U8_BGR:
+                    break;
+                case SampleType::U8_RGB:
+                    break;
+                case SampleType::U8_BGRA:
+                    process_ycbcr_8x8   = process_ycbcr_bgra_8x8_avx512;
+                    process_ycbcr_8x16  = process_ycbcr_bgra_8x16_avx512;
+                    process_ycbcr_16x8  = process_ycbcr_bgra_16x8_avx512;
+                    process_ycbcr_16x16 = process_ycbcr_bgra_16x16_avx512;
+                    simd_8x8   = "AVX512BW";
+                    simd_8x16  = "AVX512BW";
+                    simd_16x8  = "AVX512BW";
+                    simd_16x16 = "AVX512BW";
+                    break;
+                case SampleType::U8_RGBA:
+                    process_ycbcr_8x8   = process_ycbcr_rgba_8x8_avx512;
+                    process_ycbcr_8x16  = process_ycbcr_rgba_8x16_avx512;
+                    process_ycbcr_16x8  = process_ycbcr_rgba_16x8_avx512;
+                    process_ycbcr_16x16 = process_ycbcr_rgba_16x16_avx512;
+                    simd_8x8   = "AVX512BW";
+                    simd_8x16  = "AVX512BW";
+                    simd_16x8  = "AVX512BW";
+                    simd_16x16 = "AVX512BW";
+                    break;
+            }
+        }
+
+#endif // MANGO_DISPATCH_AVX512
 
         std::string id;
 
@@ -1803,6 +1858,126 @@ namespace mango::image::jpeg
                 break;
         }
 
+        // configure fancy upsampling
+
+        m_fancy_upsampling = false;
+
+        const Frame* frame = processState.frame;
+
+        bool is_h2 = m_components == 3 && frame[0].hsf == 2 && (frame[0].vsf == 1 || frame[0].vsf == 2) &&
+                     frame[1].hsf == 1 && frame[1].vsf == 1 && frame[2].hsf == 1 && frame[2].vsf == 1;
+
+        if (options.fancy_upsampling && is_h2 && m_precision == 8 && !is_lossless && sample != SampleType::U8_Y)
+        {
+            const char* simd_row = "";
+
+            processState.upsample_h2v1 = upsample_h2v1;
+            processState.upsample_h2v2 = upsample_h2v2;
+
+            switch (sample)
+            {
+                case SampleType::U8_Y:
+                    break;
+                case SampleType::U8_BGR:
+                    processState.process_row = process_ycbcr_bgr_row;
+                    break;
+                case SampleType::U8_RGB:
+                    processState.process_row = process_ycbcr_rgb_row;
+                    break;
+                case SampleType::U8_BGRA:
+                    processState.process_row = process_ycbcr_bgra_row;
+                    break;
+                case SampleType::U8_RGBA:
+                    processState.process_row = process_ycbcr_rgba_row;
+                    break;
+            }
+
+#if defined(MANGO_ENABLE_NEON)
+            if (flags & ARM_NEON)
+            {
+                processState.upsample_h2v1 = upsample_h2v1_neon;
+                processState.upsample_h2v2 = upsample_h2v2_neon;
+
+                switch (sample)
+                {
+                    case SampleType::U8_Y:
+                        break;
+                    case SampleType::U8_BGR:
+                        processState.process_row = process_ycbcr_bgr_row_neon;
+                        break;
+                    case SampleType::U8_RGB:
+                        processState.process_row = process_ycbcr_rgb_row_neon;
+                        break;
+                    case SampleType::U8_BGRA:
+                        processState.process_row = process_ycbcr_bgra_row_neon;
+                        break;
+                    case SampleType::U8_RGBA:
+                        processState.process_row = process_ycbcr_rgba_row_neon;
+                        break;
+                }
+
+                simd_row = "NEON";
+            }
+#endif
+
+#if defined(MANGO_ENABLE_SSE2)
+            if (flags & INTEL_SSE2)
+            {
+                processState.upsample_h2v1 = upsample_h2v1_sse2;
+                processState.upsample_h2v2 = upsample_h2v2_sse2;
+
+                if (sample == SampleType::U8_BGRA)
+                {
+                    processState.process_row = process_ycbcr_bgra_row_sse2;
+                }
+
+                if (sample == SampleType::U8_RGBA)
+                {
+                    processState.process_row = process_ycbcr_rgba_row_sse2;
+                }
+
+                simd_row = "SSE2";
+            }
+#endif
+
+#if defined(MANGO_ENABLE_SSE4_1)
+            if (flags & INTEL_SSE4_1)
+            {
+                if (sample == SampleType::U8_BGR)
+                {
+                    processState.process_row = process_ycbcr_bgr_row_sse41;
+                    simd_row = "SSE4.1";
+                }
+
+                if (sample == SampleType::U8_RGB)
+                {
+                    processState.process_row = process_ycbcr_rgb_row_sse41;
+                    simd_row = "SSE4.1";
+                }
+            }
+#endif
+
+#if defined(MANGO_DISPATCH_AVX2)
+            if ((flags & TARGET_AVX2) == TARGET_AVX2)
+            {
+                if (sample == SampleType::U8_BGRA)
+                {
+                    processState.process_row = process_ycbcr_bgra_row_avx2;
+                    simd_row = "AVX2";
+                }
+
+                if (sample == SampleType::U8_RGBA)
+                {
+                    processState.process_row = process_ycbcr_rgba_row_avx2;
+                    simd_row = "AVX2";
+                }
+            }
+#endif
+
+            m_fancy_upsampling = true;
+            id = fmt::format("YCbCr {}x{} fancy {}", xblock, yblock, simd_row);
+        }
+
         m_ycbcr_name = id;
 
         printLine(Print::Info, "[ConfigureCPU]");
@@ -1836,6 +2011,7 @@ namespace mango::image::jpeg
 
         // configure multithreading
         m_hardware_concurrency = int(options.multithread ? ThreadPool::getHardwareConcurrency() : 1);
+        m_stats = options.stats;
 
         if (is_lossless)
         {
@@ -1925,6 +2101,162 @@ namespace mango::image::jpeg
         return m_decode_status;
     }
 
+    ImageDecodeStatus Parser::decodeCoefficients(JPEGCoefficients& coefficients)
+    {
+        ImageDecodeStatus status;
+
+        if (!scan_memory.address || !header)
+        {
+            status.setError(header.info);
+            return status;
+        }
+
+        if (is_lossless || is_differential)
+        {
+            status.setError("[ImageDecoder.JPG] Lossless and hierarchical images have no DCT coefficients.");
+            return status;
+        }
+
+        if (m_precision != 8)
+        {
+            status.setError("[ImageDecoder.JPG] Only 8 bit precision can be transcoded.");
+            return status;
+        }
+
+        size_t num_blocks = size_t(mcus) * blocks_in_mcu;
+        blockVector.resize(num_blocks * 64);
+        std::memset(blockVector.data(), 0, num_blocks * 64 * sizeof(s16));
+
+        m_hardware_concurrency = 1;
+        m_stats = nullptr;
+
+        // entropy decoding
+        m_decode_coefficients = true;
+        parse(scan_memory, true);
+        m_decode_coefficients = false;
+
+        if (!header)
+        {
+            blockVector.resize(0);
+            status.setError(header.info);
+            return status;
+        }
+
+        coefficients.width = m_width;
+        coefficients.height = m_height;
+        coefficients.components = m_components;
+
+        for (int i = 0; i < JPEG_MAX_COMPS_IN_SCAN; ++i)
+        {
+            for (int j = 0; j < 64; ++j)
+            {
+                coefficients.qtable[i][j] = u16(quantTable[i].table[j]);
+            }
+        }
+
+        // rearrange the MCUs into component planes
+        for (int c = 0; c < m_components; ++c)
+        {
+            const Frame& frame = processState.frame[c];
+            JPEGCoefficients::Component& component = coefficients.component[c];
+
+            component.id = frame.compid;
+            component.hsf = frame.hsf;
+            component.vsf = frame.vsf;
+            component.tq = frame.tq;
+            component.width = xmcu * frame.hsf;
+            component.height = ymcu * frame.vsf;
+            component.data.resize(size_t(component.width) * component.height * 64);
+
+            const s16* mcu = blockVector + frame.offset * 64;
+
+            for (int y = 0; y < ymcu; ++y)
+            {
+                for (int x = 0; x < xmcu; ++x)
+                {
+                    const s16* source = mcu;
+
+                    for (int by = 0; by < frame.vsf; ++by)
+                    {
+                        for (int bx = 0; bx < frame.hsf; ++bx)
+                        {
+                            s16* dest = component.block(x * frame.hsf + bx, y * frame.vsf + by);
+
+                            // the encoder tables cover the 8 bit baseline coefficient range
+                            dest[0] = std::clamp(source[0], s16(-1024), s16(1023));
+
+                            for (int j = 1; j < 64; ++j)
+                            {
+                                dest[j] = std::clamp(source[j], s16(-1023), s16(1023));
+                            }
+
+                            source += 64;
+                        }
+                    }
+
+                    mcu += blocks_in_mcu * 64;
+                }
+            }
+        }
+
+        blockVector.resize(0);
+
+        // metadata segments between SOI and the first scan
+        coefficients.metadata.reset();
+
+        const u8* p = m_memory.address + 2;
+        const u8* end = m_memory.end();
+
+        while (p + 4 <= end)
+        {
+            if (p[0] != 0xff)
+            {
+                break;
+            }
+
+            if (p[1] == 0xff)
+            {
+                // fill byte
+                ++p;
+                continue;
+            }
+
+            u16 marker = bigEndian::uload16(p);
+            if (marker == MARKER_SOS || marker == MARKER_EOI)
+            {
+                break;
+            }
+
+            const u8* next = p + 2 + bigEndian::uload16(p + 2);
+            if (next > end)
+            {
+                break;
+            }
+
+            const u8 magic_mango [] = { 0x4d, 0x61, 0x6e, 0x67, 0x6f, 0x31 }; // 'Mango1'
+
+            bool is_metadata = (marker >= MARKER_APP0 && marker <= MARKER_APP15) || marker == MARKER_COM;
+            if (marker == MARKER_APP14 && next - p >= 10 && !std::memcmp(p + 4, magic_mango, 6))
+            {
+                // restart offsets of the mango encoder are not valid after transcoding
+                is_metadata = false;
+            }
+
+            if (is_metadata)
+            {
+                coefficients.metadata.append(p, next - p);
+            }
+
+            p = next;
+        }
+
+        status.info = m_encoding;
+        status.info += ", ";
+        status.info += m_compression;
+
+        return status;
+    }
+
     std::string Parser::getInfo() const
     {
         std::string info = m_encoding;
@@ -1994,6 +2326,8 @@ namespace mango::image::jpeg
 
         bool first = true;
 
+        ImageCodecStats::Scope scope(m_stats, ImageCodecStats::ENTROPY, decodeState.buffer.end - decodeState.buffer.ptr);
+
         for (int y = 0; y < ysize; ++y)
         {
             if (m_interface->cancelled)
@@ -2070,7 +2404,11 @@ namespace mango::image::jpeg
 
     void Parser::decodeSequential()
     {
-        if (m_hardware_concurrency > 1)
+        if (m_decode_coefficients)
+        {
+            decodeSequentialBlocks();
+        }
+        else if (m_hardware_concurrency > 1)
         {
             int n = getTaskSize(ymcu);
             decodeSequentialMT(n);
@@ -2094,9 +2432,20 @@ namespace mango::image::jpeg
             const size_t xstride = bytes_per_pixel * xblock;
             const size_t ystride = stride * yblock;
             const int N = 8;
+            const int mcu_data_size = blocks_in_mcu * 64;
+
+            const size_t mcu_row_size = size_t(xmcu) * mcu_data_size;
 
             AlignedStorage<s16> data(JPEG_MAX_SAMPLES_IN_MCU);
 
+            // fancy upsampling processes the MCUs one band at a time; the band is stored
+            // between the MCU rows above and below it which are decoded one row ahead
+            AlignedStorage<s16> band;
+            if (m_fancy_upsampling)
+            {
+                band.resize((N + 2) * mcu_row_size);
+            }
+
             u8* image = m_surface->image;
 
             int restart_counter = 0;
@@ -2111,7 +2460,13 @@ namespace mango::image::jpeg
                 int y0 = scan;
                 int y1 = std::min(scan + N, ymcu);
 
-                for (int y = y0; y < y1; ++y)
+                // the first row of the band was decoded ahead with the previous band
+                const int ystart = m_fancy_upsampling && y0 ? y0 + 1 : y0;
+                const int yend = m_fancy_upsampling ? std::min(y1 + 1, ymcu) : y1;
+
+                ImageCodecStats::Laps laps(m_stats);
+
+                for (int y = ystart; y < yend; ++y)
                 {
                     const int xmcu_last = xmcu - 1;
                     const int ymcu_last = ymcu - 1;
@@ -2125,12 +2480,20 @@ namespace mango::image::jpeg
 
                     for (int x = 0; x < xmcu; ++x)
                     {
-                        decodeState.decode(data, &decodeState);
+                        s16* mcu = m_fancy_upsampling ? band + ((y - y0 + 1) * xmcu + x) * mcu_data_size : data;
 
-                        int xsize = x == xmcu_last ? xblock_last : xblock;
-                        int ysize = y == ymcu_last ? yblock_last : yblock;
+                        decodeState.decode(mcu, &decodeState);
+                        laps.lap(ImageCodecStats::ENTROPY);
+
+                        if (!m_fancy_upsampling)
+                        {
+                            int xsize = x == xmcu_last ? xblock_last : xblock;
+                            int ysize = y == ymcu_last ? yblock_last : yblock;
+
+                            process_and_clip(dest, stride, data, xsize, ysize);
+                            laps.lap(ImageCodecStats::IDCT, xsize * ysize * bytes_per_pixel);
+                        }
 
-                        process_and_clip(dest, stride, data, xsize, ysize);
                         dest += xstride;
 
                         if (++restart_counter == restartInterval)
@@ -2156,15 +2519,17 @@ namespace mango::image::jpeg
                     }
                 }
 
-                ImageDecodeRect rect;
-
-                rect.x = 0;
-                rect.y = y0 * yblock;
-                rect.width = m_width;
-                rect.height = std::min(m_height, y1 * yblock) - y0 * yblock;
-                rect.progress = float(rect.height) / m_height;
+                if (m_fancy_upsampling)
+                {
+                    process_range(y0, y1, band + mcu_row_size);
 
-                blit_and_update(rect);
+                    // the last row and the row decoded ahead are the start of the next band
+                    std::memcpy(band, band + (y1 - y0) * mcu_row_size, 2 * mcu_row_size * sizeof(s16));
+                }
+                else
+                {
+                    update_range(y0, y1);
+                }
             }
 
             // update parser pointer
@@ -2179,10 +2544,15 @@ namespace mango::image::jpeg
 
             const int mcu_data_size = blocks_in_mcu * 64;
             const int N = 8;
-            const int ncount = N * xmcu;
+            const size_t mcu_row_size = size_t(xmcu) * mcu_data_size;
+
+            // fancy upsampling stores the band between the MCU rows above and below it;
+            // the row below is decoded ahead and carried over to the next band with the last row
+            const int context = m_fancy_upsampling ? 1 : 0;
 
-            void* aligned_ptr = aligned_malloc(ncount * mcu_data_size * sizeof(s16), 64);
+            void* aligned_ptr = aligned_malloc((N + context * 2) * mcu_row_size * sizeof(s16), 64);
             s16* data = reinterpret_cast<s16*>(aligned_ptr);
+            s16* band = data + context * mcu_row_size;
 
             for (int y = 0; y < ymcu; y += N)
             {
@@ -2193,11 +2563,16 @@ namespace mango::image::jpeg
 
                 const int y0 = y;
                 const int y1 = std::min(y + N, ymcu);
-                const int count = (y1 - y0) * xmcu;
+                const int ystart = context && y0 ? y0 + 1 : y0;
+                const int yend = std::min(y1 + context, ymcu);
 
-                for (int i = 0; i < count; ++i)
                 {
-                    decodeState.decode(data + i * mcu_data_size, &decodeState);
+                    ImageCodecStats::Scope scope(m_stats, ImageCodecStats::ENTROPY);
+
+                    for (int i = (ystart - y0) * xmcu; i < (yend - y0) * xmcu; ++i)
+                    {
+                        decodeState.decode(band + i * mcu_data_size, &decodeState);
+                    }
                 }
 
                 if (decodeState.buffer.ptr >= decodeState.buffer.end)
@@ -2206,10 +2581,15 @@ namespace mango::image::jpeg
                     break;
                 }
 
-                process_range(y0, y1, data);
+                process_range(y0, y1, band);
+
+                if (context)
+                {
+                    std::memcpy(data, data + (y1 - y0) * mcu_row_size, 2 * mcu_row_size * sizeof(s16));
+                }
             }
 
-            aligned_free(data);
+            aligned_free(aligned_ptr);
 
             // update parser pointer
             const u8* p = seekMarker(decodeState.buffer.ptr - 12, decodeState.buffer.end);
@@ -2217,6 +2597,49 @@ namespace mango::image::jpeg
         }
     }
 
+    void Parser::decodeSequentialBlocks()
+    {
+        // entropy decoding only; the coefficients of all MCUs are stored for transcoding
+
+        const int mcu_data_size = blocks_in_mcu * 64;
+
+        s16* data = blockVector;
+        int restart_counter = 0;
+
+        ImageCodecStats::Scope scope(m_stats, ImageCodecStats::ENTROPY);
+
+        for (int i = 0; i < mcus; ++i)
+        {
+            decodeState.decode(data, &decodeState);
+            data += mcu_data_size;
+
+            if (++restart_counter == restartInterval)
+            {
+                decodeState.restart();
+                restart_counter = 0;
+
+                const u8* p = decodeState.buffer.ptr;
+                p = seekMarker(p, decodeState.buffer.end);
+                if (isRestartMarker(p))
+                {
+                    p += 2;
+                }
+
+                if (p >= decodeState.buffer.end)
+                {
+                    // out of data
+                    break;
+                }
+
+                decodeState.buffer.ptr = p;
+            }
+        }
+
+        // update parser pointer
+        const u8* p = seekMarker(decodeState.buffer.ptr - 12, decodeState.buffer.end);
+        decodeState.buffer.ptr = p;
+    }
+
     void Parser::decodeSequentialMT(int N)
     {
         ConcurrentQueue queue("jpeg:sequential");
@@ -2237,6 +2660,9 @@ namespace mango::image::jpeg
 
             const u32* offsets = m_restart_offsets.data();
 
+            // the offsets are the end of each MCU row; the first row starts from the scan
+            const u8* first = p;
+
             for (int y = 0; y < ymcu; y += N)
             {
                 if (m_interface->cancelled)
@@ -2262,6 +2688,44 @@ namespace mango::image::jpeg
 
                     const u8* ptr = p;
 
+                    if (m_fancy_upsampling)
+                    {
+                        // decode the band with the MCU rows above and below it and let process_range() upsample it
+                        const int mcu_data_size = blocks_in_mcu * 64;
+                        const size_t mcu_row_size = size_t(xmcu) * mcu_data_size;
+                        const int ystart = std::max(y0 - 1, 0);
+                        const int yend = std::min(y1 + 1, ymcu);
+
+                        AlignedStorage<s16> band((y1 - y0 + 2) * mcu_row_size);
+
+                        {
+                            ImageCodecStats::Scope scope(m_stats, ImageCodecStats::ENTROPY);
+
+                            for (int i = ystart; i < yend; ++i)
+                            {
+                                DecodeState state = decodeState;
+                                state.buffer.ptr = i ? m_memory.address + offsets[i - 1] : first;
+
+                                s16* mcu = band + (i - y0 + 1) * mcu_row_size;
+
+                                for (int x = 0; x < xmcu; ++x)
+                                {
+                                    state.decode(mcu, &state);
+                                    mcu += mcu_data_size;
+                                }
+                            }
+                        }
+
+                        if (!m_interface->cancelled)
+                        {
+                            process_range(y0, y1, band + mcu_row_size);
+                        }
+
+                        return;
+                    }
+
+                    ImageCodecStats::Laps laps(m_stats);
+
                     for (int i = y0; i < y1; ++i)
                     {
                         if (m_interface->cancelled)
@@ -2279,13 +2743,17 @@ namespace mango::image::jpeg
                         for (int x = 0; x < xmcu_last; ++x)
                         {
                             state.decode(data, &state);
+                            laps.lap(ImageCodecStats::ENTROPY);
                             process_and_clip(dest, stride, data, xblock, height);
+                            laps.lap(ImageCodecStats::IDCT, xblock * height * bytes_per_pixel);
                             dest += xstride;
                         }
 
                         // last column
                         state.decode(data, &state);
+                        laps.lap(ImageCodecStats::ENTROPY);
                         process_and_clip(dest, stride, data, xblock_last, height);
+                        laps.lap(ImageCodecStats::IDCT, xblock_last * height * bytes_per_pixel);
                     }
 
                     ImageDecodeRect rect;
@@ -2330,6 +2798,9 @@ namespace mango::image::jpeg
 
             u8* image = m_surface->image;
 
+            // start of the MCU row above the band
+            const u8* above = p;
+
             for (int y = 0; y < ymcu; y += N)
             {
                 if (m_interface->cancelled)
@@ -2344,7 +2815,27 @@ namespace mango::image::jpeg
                 // enqueue task
                 queue.enqueue([=, this] (const u8* p)
                 {
-                    for (int y = y0; y < y1; ++y)
+                    ImageCodecStats::Laps laps(m_stats);
+
+                    // fancy upsampling processes the MCUs one band at a time; the band is decoded
+                    // with the MCU rows above and below it
+                    const int mcu_data_size = blocks_in_mcu * 64;
+                    const size_t mcu_row_size = size_t(xmcu) * mcu_data_size;
+                    AlignedStorage<s16> band;
+                    if (m_fancy_upsampling)
+                    {
+                        band.resize((y1 - y0 + 2) * mcu_row_size);
+                    }
+
+                    const int ystart = m_fancy_upsampling ? std::max(y0 - 1, 0) : y0;
+                    const int yend = m_fancy_upsampling ? std::min(y1 + 1, ymcu) : y1;
+
+                    if (ystart < y0)
+                    {
+                        p = above;
+                    }
+
+                    for (int y = ystart; y < yend; ++y)
                     {
                         if (m_interface->cancelled)
                         {
@@ -2366,14 +2857,21 @@ namespace mango::image::jpeg
 
                         for (int x = 0; x < xmcu; ++x)
                         {
-                            state.decode(data, &state);
+                            s16* mcu = m_fancy_upsampling ? band + ((y - y0 + 1) * xmcu + x) * mcu_data_size : data;
+
+                            state.decode(mcu, &state);
+                            laps.lap(ImageCodecStats::ENTROPY);
 
-                            u8* dest = image + y * ystride + x * xstride;
+                            if (!m_fancy_upsampling)
+                            {
+                                u8* dest = image + y * ystride + x * xstride;
 
-                            int width  = x == xmcu_last ? xblock_last : xblock;
-                            int height = y == ymcu_last ? yblock_last : yblock;
+                                int width  = x == xmcu_last ? xblock_last : xblock;
+                                int height = y == ymcu_last ? yblock_last : yblock;
 
-                            process_and_clip(dest, stride, data, width, height);
+                                process_and_clip(dest, stride, data, width, height);
+                                laps.lap(ImageCodecStats::IDCT, width * height * bytes_per_pixel);
+                            }
                         }
 
                         p = seekMarker(state.buffer.ptr, state.buffer.end);
@@ -2389,20 +2887,20 @@ namespace mango::image::jpeg
                         }
                     }
 
-                    ImageDecodeRect rect;
-
-                    rect.x = 0;
-                    rect.y = y0 * yblock;
-                    rect.width = m_width;
-                    rect.height = std::min(m_height, y1 * yblock) - y0 * yblock;
-                    rect.progress = float(rect.height) / m_height;
-
-                    blit_and_update(rect);
+                    if (m_fancy_upsampling)
+                    {
+                        process_range(y0, y1, band + mcu_row_size);
+                    }
+                    else
+                    {
+                        update_range(y0, y1);
+                    }
                 }, p);
 
                 // skip N restart intervals (handled by the task queue)
                 for (int i = y0; i < y1; ++i)
                 {
+                    above = p;
                     p = seekMarker(p, decodeState.buffer.end);
                     if (isRestartMarker(p))
                     {
@@ -2428,6 +2926,17 @@ namespace mango::image::jpeg
             // ---------------------------------------------------------------
 
             const int mcu_data_size = blocks_in_mcu * 64;
+            const size_t mcu_row_size = size_t(xmcu) * mcu_data_size;
+
+            // fancy upsampling stores the band between the MCU rows above and below it;
+            // the row below is decoded ahead and carried over to the next band with the last row
+            const int context = m_fancy_upsampling ? 1 : 0;
+
+            AlignedStorage<s16> carry;
+            if (context)
+            {
+                carry.resize(2 * mcu_row_size);
+            }
 
             for (int y = 0; y < ymcu; y += N)
             {
@@ -2439,15 +2948,30 @@ namespace mango::image::jpeg
 
                 const int y0 = y;
                 const int y1 = std::min(y + N, ymcu);
-                const int count = (y1 - y0) * xmcu;
+                const int ystart = context && y0 ? y0 + 1 : y0;
+                const int yend = std::min(y1 + context, ymcu);
                 printLine(Print::Info, "  Process: [{}, {}] --> ThreadPool.", y0, y1 - 1);
 
-                void* aligned_ptr = aligned_malloc(count * mcu_data_size * sizeof(s16), 64);
-                s16* data = reinterpret_cast<s16*>(aligned_ptr);
+                void* aligned_ptr = aligned_malloc((y1 - y0 + context * 2) * mcu_row_size * sizeof(s16), 64);
+                s16* data = reinterpret_cast<s16*>(aligned_ptr) + context * mcu_row_size;
+
+                if (ystart > y0)
+                {
+                    std::memcpy(data - mcu_row_size, carry, 2 * mcu_row_size * sizeof(s16));
+                }
+
+                {
+                    ImageCodecStats::Scope scope(m_stats, ImageCodecStats::ENTROPY);
+
+                    for (int i = (ystart - y0) * xmcu; i < (yend - y0) * xmcu; ++i)
+                    {
+                        decodeState.decode(data + i * mcu_data_size, &decodeState);
+                    }
+                }
 
-                for (int i = 0; i < count; ++i)
+                if (yend > y1)
                 {
-                    decodeState.decode(data + i * mcu_data_size, &decodeState);
+                    std::memcpy(carry, data + (y1 - y0 - 1) * mcu_row_size, 2 * mcu_row_size * sizeof(s16));
                 }
 
                 // enqueue task
@@ -2473,6 +2997,8 @@ namespace mango::image::jpeg
         s16* data = blockVector;
         data += decodeState.block[0].offset;
 
+        ImageCodecStats::Scope scope(m_stats, ImageCodecStats::ENTROPY);
+
         for (int y = 0; y < ymcu; ++y)
         {
             if (m_interface->cancelled)
@@ -2537,6 +3063,8 @@ namespace mango::image::jpeg
                 // enqueue task
                 queue.enqueue([=, this]
                 {
+                    ImageCodecStats::Scope scope(m_stats, ImageCodecStats::ENTROPY);
+
                     DecodeState state = decodeState;
                     state.buffer.ptr = p;
 
@@ -2563,6 +3091,8 @@ namespace mango::image::jpeg
         {
             s16* data = blockVector;
 
+            ImageCodecStats::Scope scope(m_stats, ImageCodecStats::ENTROPY);
+
             for (int i = 0; i < mcus; ++i)
             {
                 if (!(i & 0x200) && m_interface->cancelled)
@@ -2616,6 +3146,8 @@ namespace mango::image::jpeg
                 // enqueue task
                 queue.enqueue([=, this]
                 {
+                    ImageCodecStats::Scope scope(m_stats, ImageCodecStats::ENTROPY);
+
                     DecodeState state = decodeState;
                     state.buffer.ptr = p;
 
@@ -2663,6 +3195,8 @@ namespace mango::image::jpeg
 
             printLine(Print::Info, "    blocks: {} x {} ({} x {})", xs, ys, xs * hsize, ys * vsize);
 
+            ImageCodecStats::Scope scope(m_stats, ImageCodecStats::ENTROPY);
+
             for (int y = 0; y < ys; ++y)
             {
                 if (m_interface->cancelled)
@@ -2725,6 +3259,12 @@ namespace mango::image::jpeg
 
     void Parser::process_range(int y0, int y1, const s16* data)
     {
+        if (m_fancy_upsampling)
+        {
+            process_range_fancy(y0, y1, data);
+            return;
+        }
+
         const size_t stride = m_surface->stride;
         const size_t bytes_per_pixel = m_surface->format.bytes();
         const size_t xstride = bytes_per_pixel * xblock;
@@ -2742,6 +3282,8 @@ namespace mango::image::jpeg
         const int xblock_last = xclip ? xclip : xblock;
         const int yblock_last = yclip ? yclip : yblock;
 
+        ImageCodecStats::Laps laps(m_stats);
+
         for (int y = y0; y < y1; ++y)
         {
             if (m_interface->cancelled)
@@ -2763,8 +3305,15 @@ namespace mango::image::jpeg
             process_and_clip(dest, stride, data, xblock_last, ysize);
             data += mcu_data_size;
             dest += xstride;
+
+            laps.lap(ImageCodecStats::IDCT, m_width * ysize * bytes_per_pixel);
         }
 
+        update_range(y0, y1);
+    }
+
+    void Parser::update_range(int y0, int y1)
+    {
         ImageDecodeRect rect;
 
         rect.x = 0;
@@ -2776,6 +3325,185 @@ namespace mango::image::jpeg
         blit_and_update(rect);
     }
 
+    void Parser::process_range_fancy(int y0, int y1, const s16* data)
+    {
+        // The MCUs are transformed into component planes first so that the chroma filter
+        // can see the neighbouring samples across the MCU boundaries. The MCU rows y0 - 1 and y1
+        // must be stored before and after the band when they are inside the image; the chroma
+        // filter reads one row of context from them and replicates only at the image edges.
+
+        const int rows = y1 - y0;
+        const int vsf = processState.frame[0].vsf;
+
+        const int luma_width = xmcu * xblock;
+        const int luma_height = rows * yblock;
+        const int chroma_width = xmcu * 8;
+        const int chroma_height = rows * 8;
+
+        // the chroma rows have room for the edge samples and the SIMD loops reading past the end
+        const int padding = 32;
+        const size_t luma_stride = luma_width + padding;
+        const size_t chroma_stride = chroma_width + padding * 2;
+
+        // the chroma planes have one row of context above and below the band
+        std::vector<u8> buffer(luma_stride * luma_height + chroma_stride * (chroma_height + 2) * 2 +
+                               (chroma_width * 2 + padding * 2) * 2);
+
+        u8* planes[3];
+        size_t strides[3];
+
+        planes[0] = buffer.data();
+        planes[1] = planes[0] + luma_stride * luma_height + padding + chroma_stride;
+        planes[2] = planes[1] + chroma_stride * (chroma_height + 2);
+        strides[0] = luma_stride;
+        strides[1] = chroma_stride;
+        strides[2] = chroma_stride;
+
+        u8* upsampled_cb = planes[2] + chroma_stride * (chroma_height + 1);
+        u8* upsampled_cr = upsampled_cb + chroma_width * 2 + padding;
+
+        const int mcu_data_size = blocks_in_mcu * 64;
+        const size_t mcu_row_size = size_t(xmcu) * mcu_data_size;
+
+        ImageCodecStats::Laps laps(m_stats);
+
+        // transform one scanline of chroma from the last block row (above) or the first block row (below)
+        auto context = [&] (const s16* mcu, int plane_row, bool last)
+        {
+            for (int x = 0; x < xmcu; ++x)
+            {
+                for (int c = 1; c < 3; ++c)
+                {
+                    const Frame& frame = processState.frame[c];
+                    const int by = last ? frame.vsf - 1 : 0;
+
+                    for (int bx = 0; bx < frame.hsf; ++bx)
+                    {
+                        const int index = frame.offset + by * frame.hsf + bx;
+
+                        u8 temp[64];
+                        processState.idct(temp, mcu + index * 64, processState.block[index].qt);
+
+                        u8* dest = planes[c] + plane_row * ptrdiff_t(chroma_stride) + (x * frame.hsf + bx) * 8;
+                        std::memcpy(dest, temp + (last ? 56 : 0), 8);
+                    }
+                }
+
+                mcu += mcu_data_size;
+            }
+        };
+
+        const bool has_above = vsf == 2 && y0 > 0;
+        const bool has_below = vsf == 2 && y1 < ymcu;
+
+        if (has_above)
+        {
+            context(data - mcu_row_size, -1, true);
+        }
+
+        if (has_below)
+        {
+            context(data + rows * mcu_row_size, chroma_height, false);
+        }
+
+        for (int y = 0; y < rows; ++y)
+        {
+            if (m_interface->cancelled)
+            {
+                return;
+            }
+
+            for (int x = 0; x < xmcu; ++x)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    const Frame& frame = processState.frame[c];
+
+                    for (int by = 0; by < frame.vsf; ++by)
+                    {
+                        for (int bx = 0; bx < frame.hsf; ++bx)
+                        {
+                            const int index = frame.offset + by * frame.hsf + bx;
+
+                            u8 temp[64];
+                            processState.idct(temp, data + index * 64, processState.block[index].qt);
+
+                            u8* dest = planes[c] + (y * frame.vsf + by) * 8 * strides[c] + (x * frame.hsf + bx) * 8;
+
+                            for (int i = 0; i < 8; ++i)
+                            {
+                                std::memcpy(dest + i * strides[c], temp + i * 8, 8);
+                            }
+                        }
+                    }
+                }
+
+                data += mcu_data_size;
+            }
+        }
+
+        // visible area of the band
+        const int ybase = y0 * yblock;
+        const int width = m_width;
+        const int height = std::min(luma_height, m_height - ybase);
+        const int cwidth = (width + 1) / 2;
+        const int cheight = (height + vsf - 1) / vsf;
+
+        for (int c = 1; c < 3; ++c)
+        {
+            // replicate the edge rows at the top and bottom of the image
+            u8* top = planes[c] - chroma_stride;
+            u8* bottom = planes[c] + cheight * chroma_stride;
+
+            if (!has_above)
+            {
+                std::memcpy(top, top + chroma_stride, cwidth);
+            }
+
+            if (!has_below)
+            {
+                std::memcpy(bottom, bottom - chroma_stride, cwidth);
+            }
+
+            // replicate the edge samples
+            for (int y = -1; y <= cheight; ++y)
+            {
+                u8* s = planes[c] + y * ptrdiff_t(chroma_stride);
+                s[-1] = s[0];
+                s[cwidth] = s[cwidth - 1];
+            }
+        }
+
+        const size_t stride = m_surface->stride;
+        u8* image = m_surface->image + ybase * stride;
+
+        for (int y = 0; y < height; ++y)
+        {
+            const u8* cb = planes[1] + (y / vsf) * chroma_stride;
+            const u8* cr = planes[2] + (y / vsf) * chroma_stride;
+
+            if (vsf == 1)
+            {
+                processState.upsample_h2v1(upsampled_cb, cb, cwidth);
+                processState.upsample_h2v1(upsampled_cr, cr, cwidth);
+            }
+            else
+            {
+                // the even rows are closer to the chroma row above, the odd rows to the row below
+                const ptrdiff_t offset = (y & 1) ? ptrdiff_t(chroma_stride) : -ptrdiff_t(chroma_stride);
+
+                processState.upsample_h2v2(upsampled_cb, cb, cb + offset, cwidth);
+                processState.upsample_h2v2(upsampled_cr, cr, cr + offset, cwidth);
+            }
+
+            processState.process_row(image + y * stride, planes[0] + y * luma_stride, upsampled_cb, upsampled_cr, width);
+        }
+
+        laps.lap(ImageCodecStats::IDCT, size_t(width) * height * m_surface->format.bytes());
+
+        update_range(y0, y1);
+    }
+
     void Parser::process_and_clip(u8* dest, size_t stride, const s16* data, int width, int height)
     {
         if (xblock != width || yblock != height)
@@ -2807,6 +3535,8 @@ namespace mango::image::jpeg
     {
         if (!m_decode_status.direct || force_blit)
         {
+            ImageCodecStats::Scope scope(m_stats, ImageCodecStats::BLIT, u64(rect.width) * rect.height * m_target->format.bytes());
+
             // color conversion and clipping
             Surface source(*m_surface, rect.x, rect.y, rect.width, rect.height);
             m_target->blit(rect.x, rect.y, source);
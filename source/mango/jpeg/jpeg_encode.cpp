@@ -193,6 +193,19 @@ namespace
         0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA,
     };
 
+    // natural order index of each coefficient in the zigzag order
+    const u8 g_zigzag_table_inverse [] =
+    {
+         0,  1,  8, 16,  9,  2,  3, 10,
+        17, 24, 32, 25, 18, 11,  4,  5,
+        12, 19, 26, 33, 40, 48, 41, 34,
+        27, 20, 13,  6,  7, 14, 21, 28,
+        35, 42, 49, 56, 57, 50, 43, 36,
+        29, 22, 15, 23, 30, 37, 44, 51,
+        58, 59, 52, 45, 38, 31, 39, 46,
+        53, 60, 61, 54, 47, 55, 62, 63,
+    };
+
     // ----------------------------------------------------------------------------
     // HuffmanEncoder
     // ----------------------------------------------------------------------------
@@ -256,7 +269,7 @@ namespace
         HuffmanType code;
         int space;
 
-        int last_dc_value[3] = { 0, 0, 0 };
+        int last_dc_value[4] = { 0, 0, 0, 0 };
         void (*fdct)(s16* dest, const s16* data, const s16* qtable);
 
         HuffmanEncoder()
@@ -293,6 +306,287 @@ namespace
         }
     };
 
+    // ----------------------------------------------------------------------------
+    // HuffmanTable
+    // ----------------------------------------------------------------------------
+
+    // symbol frequencies gathered from the image; [0] is luminance, [1] chrominance
+    struct HuffmanStatistics
+    {
+        u64 dc[2][257];
+        u64 ac[2][257];
+
+        HuffmanStatistics()
+        {
+            std::memset(this, 0, sizeof(HuffmanStatistics));
+        }
+
+        void merge(const HuffmanStatistics& other)
+        {
+            for (int i = 0; i < 257; ++i)
+            {
+                dc[0][i] += other.dc[0][i];
+                dc[1][i] += other.dc[1][i];
+                ac[0][i] += other.ac[0][i];
+                ac[1][i] += other.ac[1][i];
+            }
+        }
+    };
+
+    struct HuffmanTable
+    {
+        u8 bits[17];      // number of codes of each length
+        u8 values[256];   // symbols in the order of increasing code length
+        int count;        // number of symbols
+
+        u16 code[256];
+        u8 size[256];
+
+        // Builds an optimal table with code lengths limited to 16 bits (JPEG Annex K.2)
+        void build(const u64* frequency)
+        {
+            u64 freq[257];
+            int codesize[257];
+            int others[257];
+
+            std::memcpy(freq, frequency, 256 * sizeof(u64));
+
+            bool empty = true;
+            for (int i = 0; i < 256; ++i)
+            {
+                empty &= freq[i] == 0;
+            }
+
+            if (empty)
+            {
+                // the table must have at least one symbol
+                freq[0] = 1;
+            }
+
+            // reserve one code point so that no code consists of all 1-bits
+            freq[256] = 1;
+
+            for (int i = 0; i < 257; ++i)
+            {
+                codesize[i] = 0;
+                others[i] = -1;
+            }
+
+            for (;;)
+            {
+                // find the two least frequent symbols; ties go to the larger symbol
+                int c1 = -1;
+                int c2 = -1;
+                u64 v1 = ~0ull;
+                u64 v2 = ~0ull;
+
+                for (int i = 0; i < 257; ++i)
+                {
+                    if (freq[i] && freq[i] <= v1)
+                    {
+                        v2 = v1;
+                        c2 = c1;
+                        v1 = freq[i];
+                        c1 = i;
+                    }
+                    else if (freq[i] && freq[i] <= v2)
+                    {
+                        v2 = freq[i];
+                        c2 = i;
+                    }
+                }
+
+                if (c2 < 0)
+                {
+                    break;
+                }
+
+                // merge the two trees
+                freq[c1] += freq[c2];
+                freq[c2] = 0;
+
+                ++codesize[c1];
+                while (others[c1] >= 0)
+                {
+                    c1 = others[c1];
+                    ++codesize[c1];
+                }
+
+                others[c1] = c2;
+
+                ++codesize[c2];
+                while (others[c2] >= 0)
+                {
+                    c2 = others[c2];
+                    ++codesize[c2];
+                }
+            }
+
+            int lengths[33] = {};
+
+            for (int i = 0; i < 257; ++i)
+            {
+                if (codesize[i])
+                {
+                    ++lengths[std::min(codesize[i], 32)];
+                }
+            }
+
+            // limit the code lengths to 16 bits
+            for (int i = 32; i > 16; --i)
+            {
+                while (lengths[i] > 0)
+                {
+                    int j = i - 2;
+                    while (!lengths[j])
+                    {
+                        --j;
+                    }
+
+                    lengths[i] -= 2;
+                    lengths[i - 1] += 1;
+                    lengths[j + 1] += 2;
+                    lengths[j] -= 1;
+                }
+            }
+
+            // remove the reserved code point from the longest codes
+            int i = 16;
+            while (!lengths[i])
+            {
+                --i;
+            }
+
+            --lengths[i];
+
+            bits[0] = 0;
+            for (int i = 1; i <= 16; ++i)
+            {
+                bits[i] = u8(lengths[i]);
+            }
+
+            count = 0;
+            for (int length = 1; length <= 32; ++length)
+            {
+                for (int symbol = 0; symbol < 256; ++symbol)
+                {
+                    if (codesize[symbol] == length)
+                    {
+                        values[count++] = u8(symbol);
+                    }
+                }
+            }
+
+            // generate the codes (JPEG Annex C)
+            std::memset(size, 0, sizeof(size));
+
+            u32 value = 0;
+            int index = 0;
+
+            for (int length = 1; length <= 16; ++length)
+            {
+                for (int j = 0; j < bits[length]; ++j)
+                {
+                    int symbol = values[index++];
+                    code[symbol] = u16(value++);
+                    size[symbol] = u8(length);
+                }
+
+                value <<= 1;
+            }
+        }
+
+        // Appends a DHT marker; id is the table class (0: DC, 1: AC) and destination
+        void write(Buffer& buffer, u8 id) const
+        {
+            BigEndianPointer p = buffer.append(5 + 16 + count);
+            p.write16(MARKER_DHT);
+            p.write16(u16(3 + 16 + count));
+            p.write8(id);
+            p.write(bits + 1, 16);
+            p.write(values, count);
+        }
+    };
+
+    // Huffman codes in the layout used by the block encoders; the codes are pre-shifted
+    // to make room for the coefficient bits and the sizes include the coefficient bits.
+    struct EncodeTable
+    {
+        alignas(64) u32 ac_code[176];
+        alignas(64) u16 ac_size[176];
+        u32 dc_code[12];
+        u16 dc_size[12];
+
+        void build(const HuffmanTable& dc, const HuffmanTable& ac)
+        {
+            for (int size = 0; size < 12; ++size)
+            {
+                dc_code[size] = u32(dc.code[size]) << size;
+                dc_size[size] = u16(dc.size[size] + size);
+            }
+
+            std::memset(ac_code, 0, sizeof(ac_code));
+            std::memset(ac_size, 0, sizeof(ac_size));
+
+            // end of block and zero run length
+            ac_code[0] = ac.code[0x00];
+            ac_size[0] = ac.size[0x00];
+            ac_code[1] = ac.code[0xf0];
+            ac_size[1] = ac.size[0xf0];
+
+            for (int size = 1; size <= 10; ++size)
+            {
+                for (int run = 0; run < 16; ++run)
+                {
+                    int symbol = (run << 4) | size;
+                    int index = run + size * 16;
+                    ac_code[index] = u32(ac.code[symbol]) << size;
+                    ac_size[index] = u16(ac.size[symbol] + size);
+                }
+            }
+        }
+    };
+
+    // ----------------------------------------------------------------------------
+    // progressive scan scripts
+    // ----------------------------------------------------------------------------
+
+    struct ProgressiveScan
+    {
+        int component; // -1: all components (dc scans)
+        int Ss;        // spectral selection
+        int Se;
+        int Ah;        // successive approximation
+        int Al;
+    };
+
+    // The default scripts of libjpeg: the DC and the low frequency luminance are sent
+    // first with reduced precision, the last bit of the AC coefficients is sent last.
+
+    const ProgressiveScan g_progressive_ycbcr [] =
+    {
+        { -1, 0,  0, 0, 1 },
+        {  0, 1,  5, 0, 2 },
+        {  2, 1, 63, 0, 1 },
+        {  1, 1, 63, 0, 1 },
+        {  0, 6, 63, 0, 2 },
+        {  0, 1, 63, 2, 1 },
+        { -1, 0,  0, 1, 0 },
+        {  2, 1, 63, 1, 0 },
+        {  1, 1, 63, 1, 0 },
+        {  0, 1, 63, 1, 0 },
+    };
+
+    const ProgressiveScan g_progressive_y [] =
+    {
+        { -1, 0,  0, 0, 1 },
+        {  0, 1,  5, 0, 2 },
+        {  0, 6, 63, 0, 2 },
+        {  0, 1, 63, 2, 1 },
+        { -1, 0,  0, 1, 0 },
+        {  0, 1, 63, 1, 0 },
+    };
+
     struct jpegEncoder
     {
         Surface m_surface;
@@ -306,6 +600,14 @@ namespace
         int vertical_mcus;
         int cols_in_right_mcus;
         int rows_in_bottom_mcus;
+        int bytes_per_pixel;
+
+        // luminance sampling factors; the chroma is always sampled at 1x1
+        int hsf;
+        int vsf;
+
+        int blocks_in_mcu;
+        int mcu_channel[6]; // channel of each block in the MCU
 
         u8 luminance_qtable[BLOCK_SIZE];
         u8 chrominance_qtable[BLOCK_SIZE];
@@ -325,6 +627,14 @@ namespace
         Channel channel[3];
         int components;
 
+        // optimized huffman tables; [0] is luminance, [1] chrominance
+        HuffmanTable dc_tables[2];
+        HuffmanTable ac_tables[2];
+        EncodeTable encode_tables[2];
+
+        // quantized coefficients for the progressive scans
+        JPEGCoefficients coefficients;
+
         std::string info;
 
         u64 restart_offset = 0;
@@ -332,19 +642,30 @@ namespace
 
         using ReadFunc = void (*)(s16*, const u8*, size_t, int, int);
 
-        void (*read_8x8) (s16* block, const u8* input, size_t stride, int rows, int cols);
-        void (*read)     (s16* block, const u8* input, size_t stride, int rows, int cols);
-        void (*fdct)     (s16* dest, const s16* data, const s16* qtable);
-        u8*  (*encode)   (HuffmanEncoder& encoder, u8* p, const s16* input, const Channel& channel);
+        void (*read_8x8)   (s16* block, const u8* input, size_t stride, int rows, int cols);
+        void (*read)       (s16* block, const u8* input, size_t stride, int rows, int cols);
+        void (*downsample) (s16* dest, const s16* left, const s16* right);
+        void (*fdct)       (s16* dest, const s16* data, const s16* qtable);
+        u8*  (*encode)     (HuffmanEncoder& encoder, u8* p, const s16* input, const Channel& channel);
 
         jpegEncoder(const Surface& surface, SampleType sample, const ImageEncodeOptions& options);
         ~jpegEncoder();
 
         void writeMarkers(BigEndianStream& p, int interval);
 
+        void readMCU(s16* block, const u8* image, size_t stride, ReadFunc read_func, int rows, int cols);
+
+        template <typename Func>
+        void readInterval(int y0, int y1, const u8* image, size_t stride, Func&& func);
+
         void encodeScan(Buffer& buffer, HuffmanEncoder& huffman, const u8* src, size_t stride, ReadFunc read_func, int rows);
         void encodeInterval(Buffer& buffer, int y0, int y1, int restartCounter, const u8* image, size_t stride);
+        void gatherInterval(HuffmanStatistics& stats, int y0, int y1, const u8* image, size_t stride);
+        void optimizeHuffmanTables(const u8* image, size_t stride);
         ImageEncodeStatus encodeImage(Stream& stream);
+
+        void transformInterval(int y0, int y1, const u8* image, size_t stride);
+        ImageEncodeStatus encodeProgressive(Stream& stream);
     };
 
     // ----------------------------------------------------------------------------
@@ -1072,18 +1393,6 @@ namespace
 
         p = encode_dc(encoder, p, block[0], channel);
 
-        const u8 zigzag_table_inverse [] =
-        {
-             0,  1,  8, 16,  9,  2,  3, 10,
-            17, 24, 32, 25, 18, 11,  4,  5,
-            12, 19, 26, 33, 40, 48, 41, 34,
-            27, 20, 13,  6,  7, 14, 21, 28,
-            35, 42, 49, 56, 57, 50, 43, 36,
-            29, 22, 15, 23, 30, 37, 44, 51,
-            58, 59, 52, 45, 38, 31, 39, 46,
-            53, 60, 61, 54, 47, 55, 62, 63,
-        };
-
         const u32* ac_code = channel.ac_code;
         const u16* ac_size = channel.ac_size;
         const u32 zero16_code = ac_code[1];
@@ -1093,7 +1402,7 @@ namespace
 
         for (int i = 1; i < 64; ++i)
         {
-            int coeff = block[zigzag_table_inverse[i]];
+            int coeff = block[g_zigzag_table_inverse[i]];
             if (coeff)
             {
                 while (counter > 15)
@@ -1128,6 +1437,50 @@ namespace
         return p;
     }
 
+    // ----------------------------------------------------------------------------
+    // gather_block_statistics
+    // ----------------------------------------------------------------------------
+
+    // Counts the symbols the block encoders emit for a quantized block
+    static
+    void gather_block_statistics(HuffmanStatistics& stats, const s16* block, int& last_dc, int table)
+    {
+        int dc = block[0] - last_dc;
+        last_dc = block[0];
+
+        int absDC = std::abs(dc);
+        ++stats.dc[table][absDC ? u32_log2(absDC) + 1 : 0];
+
+        u64* ac = stats.ac[table];
+        int counter = 0;
+
+        for (int i = 1; i < 64; ++i)
+        {
+            int coeff = block[g_zigzag_table_inverse[i]];
+            if (coeff)
+            {
+                // zero run length symbols
+                ac[0xf0] += counter >> 4;
+                counter &= 15;
+
+                int size = u32_log2(std::abs(coeff)) + 1;
+                ++ac[(counter << 4) | size];
+
+                counter = 0;
+            }
+            else
+            {
+                ++counter;
+            }
+        }
+
+        if (counter)
+        {
+            // end of block
+            ++ac[0x00];
+        }
+    }
+
 #if defined(MANGO_ENABLE_SSE4_1)
 
     // ----------------------------------------------------------------------------
@@ -1380,7 +1733,8 @@ namespace
 
 #endif // defined(MANGO_ENABLE_SSE4_1)
 
-#if defined(MANGO_ENABLE_AVX512)
+#if defined(MANGO_DISPATCH_AVX512)
+MANGO_TARGET_BEGIN_AVX512
 
     // ----------------------------------------------------------------------------
     // encode_block_avx512
@@ -1544,7 +1898,8 @@ namespace
         return p;
     }
 
-#endif // defined(MANGO_ENABLE_AVX512)
+MANGO_TARGET_END
+#endif // defined(MANGO_DISPATCH_AVX512)
 
 #if defined(MANGO_ENABLE_NEON64)
 
@@ -2314,558 +2669,1992 @@ namespace
 #endif // MANGO_ENABLE_NEON
 
     // ----------------------------------------------------------------------------
-    // jpegEncoder
+    // downsample
     // ----------------------------------------------------------------------------
 
-    jpegEncoder::jpegEncoder(const Surface& surface, SampleType sample, const ImageEncodeOptions& options)
-        : m_surface(surface)
-        , m_sample(sample)
-        , m_options(options)
-        , inverse_luminance_qtable(64)
-        , inverse_chrominance_qtable(64)
+    // The chroma of two horizontally adjacent 8x8 blocks is averaged into one 8x8 block
+    // (h2v1) or into four rows of it (h2v2). The rounding bias alternates between the
+    // columns so that the rounding errors do not accumulate to one direction.
+
+    static
+    void downsample_h2v1(s16* dest, const s16* left, const s16* right)
     {
-        components = 0;
+        for (int y = 0; y < 8; ++y)
+        {
+            for (int x = 0; x < 4; ++x)
+            {
+                const int bias = x & 1;
+                dest[x + 0] = s16((left[x * 2 + 0] + left[x * 2 + 1] + bias) >> 1);
+                dest[x + 4] = s16((right[x * 2 + 0] + right[x * 2 + 1] + bias) >> 1);
+            }
 
-        channel[0].component = 0;
-        channel[0].qtable = inverse_luminance_qtable;
-        channel[0].dc_code = g_luminance_dc_code_table;
-        channel[0].dc_size = g_luminance_dc_size_table;
-        channel[0].ac_code = g_luminance_ac_code_table;
-        channel[0].ac_size = g_luminance_ac_size_table;
+            dest += 8;
+            left += 8;
+            right += 8;
+        }
+    }
 
-        channel[1].component = 1;
-        channel[1].qtable = inverse_chrominance_qtable;
-        channel[1].dc_code = g_chrominance_dc_code_table;
-        channel[1].dc_size = g_chrominance_dc_size_table;
-        channel[1].ac_code = g_chrominance_ac_code_table;
-        channel[1].ac_size = g_chrominance_ac_size_table;
+    static
+    void downsample_h2v2(s16* dest, const s16* left, const s16* right)
+    {
+        for (int y = 0; y < 4; ++y)
+        {
+            for (int x = 0; x < 4; ++x)
+            {
+                const int bias = 1 + (x & 1);
+                dest[x + 0] = s16((left[x * 2 + 0] + left[x * 2 + 1] + left[x * 2 + 8] + left[x * 2 + 9] + bias) >> 2);
+                dest[x + 4] = s16((right[x * 2 + 0] + right[x * 2 + 1] + right[x * 2 + 8] + right[x * 2 + 9] + bias) >> 2);
+            }
 
-        channel[2].component = 2;
-        channel[2].qtable = inverse_chrominance_qtable;
-        channel[2].dc_code = g_chrominance_dc_code_table;
-        channel[2].dc_size = g_chrominance_dc_size_table;
-        channel[2].ac_code = g_chrominance_ac_code_table;
-        channel[2].ac_size = g_chrominance_ac_size_table;
+            dest += 8;
+            left += 16;
+            right += 16;
+        }
+    }
 
-        int bytes_per_pixel = 0;
-        read_8x8 = nullptr;
+#if defined(MANGO_ENABLE_SSE2)
 
-        u64 flags = options.simd ? getCPUFlags() : 0;
-        MANGO_UNREFERENCED(flags);
+    static
+    void downsample_h2v1_sse2(s16* dest, const s16* left, const s16* right)
+    {
+        const __m128i one = _mm_set1_epi16(1);
+        const __m128i bias = _mm_setr_epi32(0, 1, 0, 1);
 
-        // select sampler
+        for (int y = 0; y < 8; ++y)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + y * 8));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + y * 8));
 
-        const char* sampler_name = "Scalar";
+            // sum horizontal pairs
+            a = _mm_add_epi32(_mm_madd_epi16(a, one), bias);
+            b = _mm_add_epi32(_mm_madd_epi16(b, one), bias);
+            a = _mm_srai_epi32(a, 1);
+            b = _mm_srai_epi32(b, 1);
 
-        switch (sample)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + y * 8), _mm_packs_epi32(a, b));
+        }
+    }
+
+    static
+    void downsample_h2v2_sse2(s16* dest, const s16* left, const s16* right)
+    {
+        const __m128i one = _mm_set1_epi16(1);
+        const __m128i bias = _mm_setr_epi32(1, 2, 1, 2);
+
+        for (int y = 0; y < 4; ++y)
         {
-            case SampleType::U8_Y:
-#if defined(MANGO_ENABLE_SSE2)
-                if (flags & INTEL_SSE2)
-                {
-                    read_8x8 = read_y_format_sse2;
-                    sampler_name = "Y 8x8 SSE2";
-                }
-#endif
+            const __m128i* a = reinterpret_cast<const __m128i*>(left + y * 16);
+            const __m128i* b = reinterpret_cast<const __m128i*>(right + y * 16);
+
+            // sum vertical pairs
+            __m128i va = _mm_add_epi16(_mm_loadu_si128(a + 0), _mm_loadu_si128(a + 1));
+            __m128i vb = _mm_add_epi16(_mm_loadu_si128(b + 0), _mm_loadu_si128(b + 1));
+
+            // sum horizontal pairs
+            va = _mm_add_epi32(_mm_madd_epi16(va, one), bias);
+            vb = _mm_add_epi32(_mm_madd_epi16(vb, one), bias);
+            va = _mm_srai_epi32(va, 2);
+            vb = _mm_srai_epi32(vb, 2);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + y * 8), _mm_packs_epi32(va, vb));
+        }
+    }
+
+#endif // MANGO_ENABLE_SSE2
+
 #if defined(MANGO_ENABLE_NEON)
-                if (flags & ARM_NEON)
-                {
-                    read_8x8 = read_y_format_neon;
-                    sampler_name = "Y 8x8 NEON";
-                }
-#endif
-                read = read_y_format;
-                bytes_per_pixel = 1;
-                components = 1;
-                break;
 
-            case SampleType::U8_BGR:
-#if defined(MANGO_ENABLE_SSE4_1)
-                if (flags & INTEL_SSE4_1)
-                {
-                    read_8x8 = read_bgr_format_sse41;
-                    sampler_name = "BGR 8x8 SSE4.1";
+    static
+    void downsample_h2v1_neon(s16* dest, const s16* left, const s16* right)
+    {
+        const s32 bias_table [] = { 0, 1, 0, 1 };
+        const int32x4_t bias = vld1q_s32(bias_table);
+
+        for (int y = 0; y < 8; ++y)
+        {
+            // sum horizontal pairs
+            int32x4_t a = vaddq_s32(vpaddlq_s16(vld1q_s16(left + y * 8)), bias);
+            int32x4_t b = vaddq_s32(vpaddlq_s16(vld1q_s16(right + y * 8)), bias);
+            int16x4_t a16 = vshrn_n_s32(a, 1);
+            int16x4_t b16 = vshrn_n_s32(b, 1);
+
+            vst1q_s16(dest + y * 8, vcombine_s16(a16, b16));
+        }
+    }
+
+    static
+    void downsample_h2v2_neon(s16* dest, const s16* left, const s16* right)
+    {
+        const s32 bias_table [] = { 1, 2, 1, 2 };
+        const int32x4_t bias = vld1q_s32(bias_table);
+
+        for (int y = 0; y < 4; ++y)
+        {
+            // sum vertical pairs
+            int16x8_t va = vaddq_s16(vld1q_s16(left + y * 16), vld1q_s16(left + y * 16 + 8));
+            int16x8_t vb = vaddq_s16(vld1q_s16(right + y * 16), vld1q_s16(right + y * 16 + 8));
+
+            // sum horizontal pairs
+            int32x4_t a = vaddq_s32(vpaddlq_s16(va), bias);
+            int32x4_t b = vaddq_s32(vpaddlq_s16(vb), bias);
+            int16x4_t a16 = vshrn_n_s32(a, 2);
+            int16x4_t b16 = vshrn_n_s32(b, 2);
+
+            vst1q_s16(dest + y * 8, vcombine_s16(a16, b16));
+        }
+    }
+
+#endif // MANGO_ENABLE_NEON
+
+    // ----------------------------------------------------------------------------
+    // ProgressiveEncoder
+    // ----------------------------------------------------------------------------
+
+    // Entropy coder for the progressive scans (JPEG G.1.2). The same code first gathers the
+    // symbol statistics for the optimized huffman tables of the scan and then encodes it.
+
+    struct ProgressiveEncoder
+    {
+        static constexpr int buffer_size = 8192;
+        static constexpr int flush_threshold = buffer_size - 2048;
+        static constexpr int max_correction_bits = 1000;
+
+        HuffmanEncoder huffman;
+        Buffer* buffer;
+        HuffmanStatistics* stats;
+        const HuffmanTable* dc_tables;
+        const HuffmanTable* ac_tables;
+
+        int last_dc[4] = { 0, 0, 0, 0 };
+        int eobrun = 0;
+        int correction_count = 0;
+
+        u8 temp[buffer_size];
+        u8* ptr;
+
+        u8 correction_bits[max_correction_bits];
+
+        // gather statistics
+        ProgressiveEncoder(HuffmanStatistics& stats)
+            : buffer(nullptr)
+            , stats(&stats)
+            , dc_tables(nullptr)
+            , ac_tables(nullptr)
+            , ptr(temp)
+        {
+        }
+
+        // encode using the tables
+        ProgressiveEncoder(Buffer& buffer, const HuffmanTable* dc_tables, const HuffmanTable* ac_tables)
+            : buffer(&buffer)
+            , stats(nullptr)
+            , dc_tables(dc_tables)
+            , ac_tables(ac_tables)
+            , ptr(temp)
+        {
+        }
+
+        void emitDC(int table, int symbol)
+        {
+            if (stats)
+                ++stats->dc[table][symbol];
+            else
+                ptr = huffman.putBits(ptr, dc_tables[table].code[symbol], dc_tables[table].size[symbol]);
+        }
+
+        void emitAC(int table, int symbol)
+        {
+            if (stats)
+                ++stats->ac[table][symbol];
+            else
+                ptr = huffman.putBits(ptr, ac_tables[table].code[symbol], ac_tables[table].size[symbol]);
+        }
+
+        void emitBits(u32 value, int count)
+        {
+            if (!stats && count)
+            {
+                ptr = huffman.putBits(ptr, value & ((1u << count) - 1), count);
+            }
+        }
+
+        void emitCorrectionBits(const u8* bits, int count)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                emitBits(bits[i], 1);
+            }
+        }
+
+        void emitEOBRun(int table)
+        {
+            if (eobrun > 0)
+            {
+                int size = u32_log2(eobrun);
+                emitAC(table, size << 4);
+                emitBits(eobrun, size);
+                eobrun = 0;
+
+                emitCorrectionBits(correction_bits, correction_count);
+                correction_count = 0;
+            }
+        }
+
+        void encodeFirstDC(const s16* block, int component, int table, int Al)
+        {
+            int dc = block[0] >> Al;
+            int diff = dc - last_dc[component];
+            last_dc[component] = dc;
+
+            int absDiff = std::abs(diff);
+            int size = absDiff ? u32_log2(absDiff) + 1 : 0;
+
+            emitDC(table, size);
+            emitBits(diff - (diff < 0), size);
+        }
+
+        void encodeRefineDC(const s16* block, int Al)
+        {
+            emitBits((block[0] >> Al) & 1, 1);
+        }
+
+        void encodeFirstAC(const s16* block, int table, int Ss, int Se, int Al)
+        {
+            int run = 0;
+
+            for (int k = Ss; k <= Se; ++k)
+            {
+                int coeff = block[g_zigzag_table_inverse[k]];
+                int absCoeff = std::abs(coeff) >> Al;
+
+                if (!absCoeff)
+                {
+                    ++run;
+                    continue;
                 }
-#endif
-#if defined(MANGO_ENABLE_NEON)
-                if (flags & ARM_NEON)
+
+                emitEOBRun(table);
+
+                while (run > 15)
                 {
-                    read_8x8 = read_bgr_format_neon;
-                    sampler_name = "BGR 8x8 NEON";
+                    emitAC(table, 0xf0);
+                    run -= 16;
                 }
-#endif
-                read = read_bgr_format;
-                bytes_per_pixel = 3;
-                components = 3;
-                break;
 
-            case SampleType::U8_RGB:
-#if defined(MANGO_ENABLE_SSE4_1)
-                if (flags & INTEL_SSE4_1)
+                int size = u32_log2(absCoeff) + 1;
+                emitAC(table, (run << 4) | size);
+                emitBits(coeff < 0 ? ~absCoeff : absCoeff, size);
+
+                run = 0;
+            }
+
+            if (run > 0)
+            {
+                if (++eobrun == 0x7fff)
                 {
-                    read_8x8 = read_rgb_format_sse41;
-                    sampler_name = "RGB 8x8 SSE4.1";
+                    emitEOBRun(table);
                 }
-#endif
-#if defined(MANGO_ENABLE_NEON)
-                if (flags & ARM_NEON)
+            }
+        }
+
+        void encodeRefineAC(const s16* block, int table, int Ss, int Se, int Al)
+        {
+            int absolute[64];
+
+            // the last coefficient which becomes nonzero in this scan
+            int eob = 0;
+
+            for (int k = Ss; k <= Se; ++k)
+            {
+                int value = std::abs(block[g_zigzag_table_inverse[k]]) >> Al;
+                absolute[k] = value;
+                if (value == 1)
                 {
-                    read_8x8 = read_rgb_format_neon;
-                    sampler_name = "RGB 8x8 NEON";
+                    eob = k;
                 }
-#endif
-                read = read_rgb_format;
-                bytes_per_pixel = 3;
-                components = 3;
-                break;
+            }
 
-            case SampleType::U8_BGRA:
-#if defined(MANGO_ENABLE_SSE2)
-                if (flags & INTEL_SSE2)
+            int run = 0;
+
+            // the correction bits of this block are appended to the buffered bits
+            u8* bits = correction_bits + correction_count;
+            int count = 0;
+
+            for (int k = Ss; k <= Se; ++k)
+            {
+                int value = absolute[k];
+                if (!value)
                 {
-                    read_8x8 = read_bgra_format_sse2;
-                    sampler_name = "BGRA 8x8 SSE2";
+                    ++run;
+                    continue;
                 }
-#endif
-#if defined(MANGO_ENABLE_NEON)
-                if (flags & ARM_NEON)
+
+                // zero run length symbols; not needed when the run can be folded into EOB
+                while (run > 15 && k <= eob)
                 {
-                    read_8x8 = read_bgra_format_neon;
-                    sampler_name = "BGRA 8x8 NEON";
+                    emitEOBRun(table);
+                    emitAC(table, 0xf0);
+                    run -= 16;
+
+                    emitCorrectionBits(bits, count);
+                    bits = correction_bits;
+                    count = 0;
                 }
-#endif
-                read = read_bgra_format;
-                bytes_per_pixel = 4;
-                components = 3;
-                break;
 
-            case SampleType::U8_RGBA:
-#if defined(MANGO_ENABLE_SSE2)
-                if (flags & INTEL_SSE2)
+                if (value > 1)
                 {
-                    read_8x8 = read_rgba_format_sse2;
-                    sampler_name = "RGBA 8x8 SSE2";
+                    // previously nonzero coefficient; only the correction bit is needed
+                    bits[count++] = u8(value & 1);
+                    continue;
                 }
-#endif
-#if defined(MANGO_ENABLE_NEON)
-                if (flags & ARM_NEON)
+
+                emitEOBRun(table);
+
+                // newly nonzero coefficient
+                emitAC(table, (run << 4) | 1);
+                emitBits(block[g_zigzag_table_inverse[k]] < 0 ? 0 : 1, 1);
+
+                emitCorrectionBits(bits, count);
+                bits = correction_bits;
+                count = 0;
+
+                run = 0;
+            }
+
+            if (run > 0 || count > 0)
+            {
+                ++eobrun;
+                correction_count += count;
+
+                if (eobrun == 0x7fff || correction_count > max_correction_bits - 64)
                 {
-                    read_8x8 = read_rgba_format_neon;
-                    sampler_name = "RGBA 8x8 NEON";
+                    emitEOBRun(table);
                 }
-#endif
-                read = read_rgba_format;
-                bytes_per_pixel = 4;
-                components = 3;
-                break;
+            }
         }
 
-        if (!read_8x8)
+        void flushBuffer()
         {
-            // no accelerated 8x8 sampler found; use the default
-            read_8x8 = read;
+            if (ptr - temp > flush_threshold)
+            {
+                buffer->append(temp, ptr - temp);
+                ptr = temp;
+            }
         }
 
-        // select fdct
+        void flush(int table)
+        {
+            emitEOBRun(table);
 
-        fdct = fdct_scalar;
-        const char* fdct_name = "Scalar";
+            if (!stats)
+            {
+                // pad the last byte with 1-bits
+                int bits = (JPEG_REGISTER_BITS - huffman.space) & 7;
+                if (bits)
+                {
+                    emitBits(0xff, 8 - bits);
+                }
 
-#if defined(MANGO_ENABLE_SSE2)
-        if (flags & INTEL_SSE2)
-        {
-            fdct = fdct_sse2;
-            fdct_name = "SSE2";
+                ptr = huffman.flush(ptr);
+                buffer->append(temp, ptr - temp);
+                ptr = temp;
+            }
         }
-#endif
+    };
 
-#if defined(MANGO_ENABLE_AVX2__disabled)
-        if (flags & INTEL_AVX2)
+    // ----------------------------------------------------------------------------
+    // progressive scans
+    // ----------------------------------------------------------------------------
+
+    // MCU structure of the coefficient planes
+    struct BlockLayout
+    {
+        int horizontal_mcus;
+        int vertical_mcus;
+
+        int blocks_in_mcu = 0;
+        int mcu_component[JPEG_MAX_BLOCKS_IN_MCU];
+        int mcu_x[JPEG_MAX_BLOCKS_IN_MCU]; // block position inside the MCU
+        int mcu_y[JPEG_MAX_BLOCKS_IN_MCU];
+
+        BlockLayout(const JPEGCoefficients& coefficients)
         {
-            fdct = fdct_avx2;
-            fdct_name = "AVX2";
+            int hmax = 1;
+            int vmax = 1;
+
+            for (int c = 0; c < coefficients.components; ++c)
+            {
+                const JPEGCoefficients::Component& component = coefficients.component[c];
+
+                hmax = std::max(hmax, component.hsf);
+                vmax = std::max(vmax, component.vsf);
+
+                for (int y = 0; y < component.vsf; ++y)
+                {
+                    for (int x = 0; x < component.hsf; ++x)
+                    {
+                        mcu_component[blocks_in_mcu] = c;
+                        mcu_x[blocks_in_mcu] = x;
+                        mcu_y[blocks_in_mcu] = y;
+                        ++blocks_in_mcu;
+                    }
+                }
+            }
+
+            horizontal_mcus = div_ceil(coefficients.width, hmax * 8);
+            vertical_mcus = div_ceil(coefficients.height, vmax * 8);
         }
-#endif
 
-#if defined(MANGO_ENABLE_NEON)
+        const s16* block(const JPEGCoefficients& coefficients, int x, int y, int index) const
         {
-            fdct = fdct_neon;
-            fdct_name = "NEON";
+            const JPEGCoefficients::Component& component = coefficients.component[mcu_component[index]];
+            return component.block(x * component.hsf + mcu_x[index], y * component.vsf + mcu_y[index]);
         }
-#endif
-
-        // select block encoder
-
-        encode = encode_block_scalar;
-        const char* encode_name = "Scalar";
+    };
 
-#if defined(MANGO_ENABLE_SSE4_1)
-        if (flags & INTEL_SSE4_1)
+    std::vector<ProgressiveScan> getProgressiveScript(int components)
+    {
+        if (components == 1)
         {
-            encode = encode_block_sse41;
-            encode_name = "SSE4.1";
+            return std::vector<ProgressiveScan>(std::begin(g_progressive_y), std::end(g_progressive_y));
         }
-#endif
 
-#if defined(MANGO_ENABLE_AVX512)
-        if (flags & INTEL_AVX512BW)
+        if (components == 3)
         {
-            encode = encode_block_avx512bw;
-            encode_name = "AVX512BW";
+            return std::vector<ProgressiveScan>(std::begin(g_progressive_ycbcr), std::end(g_progressive_ycbcr));
         }
-#endif
 
-#if defined(MANGO_ENABLE_NEON64)
+        // DC first, then the AC of each component with one bit of refinement
+        std::vector<ProgressiveScan> scans;
+
+        scans.push_back({ -1, 0, 0, 0, 1 });
+
+        for (int c = 0; c < components; ++c)
         {
-            encode = encode_block_neon64;
-            encode_name = "NEON64";
+            scans.push_back({ c, 1, 63, 0, 1 });
         }
-#endif
 
-        // build encoder info string
-        info = "fDCT: ";
-        info += fdct_name;
+        scans.push_back({ -1, 0, 0, 1, 0 });
 
-        info += ", Color: ";
-        info += sampler_name;
+        for (int c = 0; c < components; ++c)
+        {
+            scans.push_back({ c, 1, 63, 1, 0 });
+        }
 
-        info += ", Encoder: ";
-        info += encode_name;
+        return scans;
+    }
 
-        mcu_width = 8;
-        mcu_height = 8;
+    // Writes the huffman tables, the SOS marker and the entropy coded data of a scan.
+    void encodeProgressiveScan(Buffer& buffer, const JPEGCoefficients& coefficients, const BlockLayout& layout, const ProgressiveScan& scan)
+    {
+        const bool dc_scan = scan.Ss == 0;
+        const bool interleaved = scan.component < 0 && coefficients.components > 1;
+        const int first = std::max(0, scan.component);
 
-        horizontal_mcus = (m_surface.width + mcu_width - 1) >> 3;
-        vertical_mcus   = (m_surface.height + mcu_height - 1) >> 3;
+        auto encodeScanData = [&] (ProgressiveEncoder& encoder)
+        {
+            if (interleaved)
+            {
+                // interleaved DC scan; the blocks are in MCU order
+                for (int y = 0; y < layout.vertical_mcus; ++y)
+                {
+                    for (int x = 0; x < layout.horizontal_mcus; ++x)
+                    {
+                        for (int i = 0; i < layout.blocks_in_mcu; ++i)
+                        {
+                            const int c = layout.mcu_component[i];
+                            const s16* block = layout.block(coefficients, x, y, i);
+
+                            if (scan.Ah)
+                                encoder.encodeRefineDC(block, scan.Al);
+                            else
+                                encoder.encodeFirstDC(block, c, c ? 1 : 0, scan.Al);
+                        }
+
+                        encoder.flushBuffer();
+                    }
+                }
+            }
+            else
+            {
+                // non-interleaved scan; the blocks are in component raster order
+                const JPEGCoefficients::Component& component = coefficients.component[first];
+                const int width = coefficients.getBlockWidth(first);
+                const int height = coefficients.getBlockHeight(first);
+                const int table = first ? 1 : 0;
 
-        rows_in_bottom_mcus = m_surface.height - (vertical_mcus - 1) * mcu_height;
-        cols_in_right_mcus  = m_surface.width  - (horizontal_mcus - 1) * mcu_width;
+                for (int y = 0; y < height; ++y)
+                {
+                    for (int x = 0; x < width; ++x)
+                    {
+                        const s16* block = component.block(x, y);
+
+                        if (dc_scan)
+                        {
+                            if (scan.Ah)
+                                encoder.encodeRefineDC(block, scan.Al);
+                            else
+                                encoder.encodeFirstDC(block, first, table, scan.Al);
+                        }
+                        else
+                        {
+                            if (scan.Ah)
+                                encoder.encodeRefineAC(block, table, scan.Ss, scan.Se, scan.Al);
+                            else
+                                encoder.encodeFirstAC(block, table, scan.Ss, scan.Se, scan.Al);
+                        }
+
+                        encoder.flushBuffer();
+                    }
+                }
+            }
 
-        mcu_stride = mcu_width * bytes_per_pixel;
+            encoder.flush(first ? 1 : 0);
+        };
 
-        // initialize quantization tables
+        const int count = interleaved ? coefficients.components : 1;
+        const bool refine_dc = dc_scan && scan.Ah;
 
-        const u8 zigzag_table [] =
+        HuffmanTable dc_tables[2];
+        HuffmanTable ac_tables[2];
+
+        if (!refine_dc)
         {
-             0,  1,  5,  6, 14, 15, 27, 28,
-             2,  4,  7, 13, 16, 26, 29, 42,
-             3,  8, 12, 17, 25, 30, 41, 43,
-             9, 11, 18, 24, 31, 40, 44, 53,
-            10, 19, 23, 32, 39, 45, 52, 54,
-            20, 22, 33, 38, 46, 51, 55, 60,
-            21, 34, 37, 47, 50, 56, 59, 61,
+            // gather the symbol statistics for the optimal huffman tables of the scan
+            HuffmanStatistics stats;
+            {
+                ProgressiveEncoder encoder(stats);
+                encodeScanData(encoder);
+            }
+
+            // the chrominance components share the table
+            const int tables = interleaved ? 2 : 1;
+
+            for (int i = 0; i < tables; ++i)
+            {
+                const int table = interleaved ? i : (first ? 1 : 0);
+
+                if (dc_scan)
+                {
+                    dc_tables[table].build(stats.dc[table]);
+                    dc_tables[table].write(buffer, u8(0x00 | table));
+                }
+                else
+                {
+                    ac_tables[table].build(stats.ac[table]);
+                    ac_tables[table].write(buffer, u8(0x10 | table));
+                }
+            }
+        }
+
+        // Start of scan marker
+        BigEndianPointer p = buffer.append(8 + count * 2);
+
+        p.write16(MARKER_SOS);
+        p.write16(u16(6 + count * 2)); // header length
+        p.write8(u8(count)); // Ns
+
+        for (int i = 0; i < count; ++i)
+        {
+            const int c = first + i;
+            const int table = c ? 1 : 0;
+            p.write8(u8(coefficients.component[c].id)); // component id
+            p.write8(u8(dc_scan ? table << 4 : table)); // huffman table selectors
+        }
+
+        p.write8(u8(scan.Ss));
+        p.write8(u8(scan.Se));
+        p.write8(u8((scan.Ah << 4) | scan.Al));
+
+        ProgressiveEncoder encoder(buffer, dc_tables, ac_tables);
+        encodeScanData(encoder);
+    }
+
+    // Encodes the scans in parallel and writes them in order; the frame header must be written already.
+    void encodeProgressiveScans(BigEndianStream& s, const JPEGCoefficients& coefficients, bool multithread)
+    {
+        const BlockLayout layout(coefficients);
+        const std::vector<ProgressiveScan> scans = getProgressiveScript(coefficients.components);
+
+        if (multithread)
+        {
+            ConcurrentQueue queue;
+            TicketQueue tk;
+
+            for (const ProgressiveScan& scan : scans)
+            {
+                auto ticket = tk.acquire();
+
+                queue.enqueue([&s, &coefficients, &layout, ticket, scan]
+                {
+                    Buffer buffer;
+                    encodeProgressiveScan(buffer, coefficients, layout, scan);
+
+                    Memory memory = buffer.acquire();
+
+                    // tickets are consumed in acquired order
+                    ticket.consume([&s, memory]
+                    {
+                        s.write(memory);
+                        Buffer::release(memory);
+                    });
+                });
+            }
+
+            // wait until all work has been submitted
+            queue.wait();
+
+            // wait until all tickets have been consumed (encoded data has been written)
+            tk.wait();
+        }
+        else
+        {
+            for (const ProgressiveScan& scan : scans)
+            {
+                Buffer buffer;
+                encodeProgressiveScan(buffer, coefficients, layout, scan);
+                s.write(buffer);
+            }
+        }
+    }
+
+    // ----------------------------------------------------------------------------
+    // jpegEncoder
+    // ----------------------------------------------------------------------------
+
+    using EncodeFunc = u8* (*)(HuffmanEncoder& encoder, u8* p, const s16* input, const jpegEncoder::Channel& channel);
+
+    EncodeFunc getBlockEncoder(u64 flags, const char*& name)
+    {
+        MANGO_UNREFERENCED(flags);
+
+        EncodeFunc encode = encode_block_scalar;
+        name = "Scalar";
+
+#if defined(MANGO_ENABLE_SSE4_1)
+        if (flags & INTEL_SSE4_1)
+        {
+            encode = encode_block_sse41;
+            name = "SSE4.1";
+        }
+#endif
+
+#if defined(MANGO_DISPATCH_AVX512)
+        if ((flags & TARGET_AVX512) == TARGET_AVX512)
+        {
+            encode = encode_block_avx512bw;
+            name = "AVX512BW";
+        }
+#endif
+
+#if defined(MANGO_ENABLE_NEON64)
+        {
+            encode = encode_block_neon64;
+            name = "NEON64";
+        }
+#endif
+
+        return encode;
+    }
+
+    jpegEncoder::jpegEncoder(const Surface& surface, SampleType sample, const ImageEncodeOptions& options)
+        : m_surface(surface)
+        , m_sample(sample)
+        , m_options(options)
+        , inverse_luminance_qtable(64)
+        , inverse_chrominance_qtable(64)
+    {
+        components = 0;
+
+        channel[0].component = 0;
+        channel[0].qtable = inverse_luminance_qtable;
+        channel[0].dc_code = g_luminance_dc_code_table;
+        channel[0].dc_size = g_luminance_dc_size_table;
+        channel[0].ac_code = g_luminance_ac_code_table;
+        channel[0].ac_size = g_luminance_ac_size_table;
+
+        channel[1].component = 1;
+        channel[1].qtable = inverse_chrominance_qtable;
+        channel[1].dc_code = g_chrominance_dc_code_table;
+        channel[1].dc_size = g_chrominance_dc_size_table;
+        channel[1].ac_code = g_chrominance_ac_code_table;
+        channel[1].ac_size = g_chrominance_ac_size_table;
+
+        channel[2].component = 2;
+        channel[2].qtable = inverse_chrominance_qtable;
+        channel[2].dc_code = g_chrominance_dc_code_table;
+        channel[2].dc_size = g_chrominance_dc_size_table;
+        channel[2].ac_code = g_chrominance_ac_code_table;
+        channel[2].ac_size = g_chrominance_ac_size_table;
+
+        bytes_per_pixel = 0;
+        read_8x8 = nullptr;
+
+        u64 flags = options.simd ? getCPUFlags() : 0;
+        MANGO_UNREFERENCED(flags);
+
+        // select sampler
+
+        const char* sampler_name = "Scalar";
+
+        switch (sample)
+        {
+            case SampleType::U8_Y:
+#if defined(MANGO_ENABLE_SSE2)
+                if (flags & INTEL_SSE2)
+                {
+                    read_8x8 = read_y_format_sse2;
+                    sampler_name = "Y 8x8 SSE2";
+                }
+#endif
+#if defined(MANGO_ENABLE_NEON)
+                if (flags & ARM_NEON)
+                {
+                    read_8x8 = read_y_format_neon;
+                    sampler_name = "Y 8x8 NEON";
+                }
+#endif
+                read = read_y_format;
+                bytes_per_pixel = 1;
+                components = 1;
+                break;
+
+            case SampleType::U8_BGR:
+#if defined(MANGO_ENABLE_SSE4_1)
+                if (flags & INTEL_SSE4_1)
+                {
+                    read_8x8 = read_bgr_format_sse41;
+                    sampler_name = "BGR 8x8 SSE4.1";
+                }
+#endif
+#if defined(MANGO_ENABLE_NEON)
+                if (flags & ARM_NEON)
+                {
+                    read_8x8 = read_bgr_format_neon;
+                    sampler_name = "BGR 8x8 NEON";
+                }
+#endif
+                read = read_bgr_format;
+                bytes_per_pixel = 3;
+                components = 3;
+                break;
+
+            case SampleType::U8_RGB:
+#if defined(MANGO_ENABLE_SSE4_1)
+                if (flags & INTEL_SSE4_1)
+                {
+                    read_8x8 = read_rgb_format_sse41;
+                    sampler_name = "RGB 8x8 SSE4.1";
+                }
+#endif
+#if defined(MANGO_ENABLE_NEON)
+                if (flags & ARM_NEON)
+                {
+                    read_8x8 = read_rgb_format_neon;
+                    sampler_name = "RGB 8x8 NEON";
+                }
+#endif
+                read = read_rgb_format;
+                bytes_per_pixel = 3;
+                components = 3;
+                break;
+
+            case SampleType::U8_BGRA:
+#if defined(MANGO_ENABLE_SSE2)
+                if (flags & INTEL_SSE2)
+                {
+                    read_8x8 = read_bgra_format_sse2;
+                    sampler_name = "BGRA 8x8 SSE2";
+                }
+#endif
+#if defined(MANGO_ENABLE_NEON)
+                if (flags & ARM_NEON)
+                {
+                    read_8x8 = read_bgra_format_neon;
+                    sampler_name = "BGRA 8x8 NEON";
+                }
+#endif
+                read = read_bgra_format;
+                bytes_per_pixel = 4;
+                components = 3;
+                break;
+
+            case SampleType::U8_RGBA:
+#if defined(MANGO_ENABLE_SSE2)
+                if (flags & INTEL_SSE2)
+                {
+                    read_8x8 = read_rgba_format_sse2;
+                    sampler_name = "RGBA 8x8 SSE2";
+                }
+#endif
+#if defined(MANGO_ENABLE_NEON)
+                if (flags & ARM_NEON)
+                {
+                    read_8x8 = read_rgba_format_neon;
+                    sampler_name = "RGBA 8x8 NEON";
+                }
+#endif
+                read = read_rgba_format;
+                bytes_per_pixel = 4;
+                components = 3;
+                break;
+        }
+
+        if (!read_8x8)
+        {
+            // no accelerated 8x8 sampler found; use the default
+            read_8x8 = read;
+        }
+
+        // select fdct
+
+        fdct = fdct_scalar;
+        const char* fdct_name = "Scalar";
+
+#if defined(MANGO_ENABLE_SSE2)
+        if (flags & INTEL_SSE2)
+        {
+            fdct = fdct_sse2;
+            fdct_name = "SSE2";
+        }
+#endif
+
+#if defined(MANGO_ENABLE_AVX2__disabled)
+        if (flags & INTEL_AVX2)
+        {
+            fdct = fdct_avx2;
+            fdct_name = "AVX2";
+        }
+#endif
+
+#if defined(MANGO_ENABLE_NEON)
+        {
+            fdct = fdct_neon;
+            fdct_name = "NEON";
+        }
+#endif
+
+        // select block encoder
+
+        const char* encode_name = "Scalar";
+        encode = getBlockEncoder(flags, encode_name);
+
+        // select chroma subsampling
+
+        hsf = 1;
+        vsf = 1;
+        downsample = nullptr;
+
+        const char* subsampling_name = "4:4:4";
+
+        if (components == 3)
+        {
+            switch (options.subsampling)
+            {
+                case ChromaSubsampling::S444:
+                    break;
+
+                case ChromaSubsampling::S422:
+                    hsf = 2;
+                    downsample = downsample_h2v1;
+#if defined(MANGO_ENABLE_SSE2)
+                    if (flags & INTEL_SSE2)
+                    {
+                        downsample = downsample_h2v1_sse2;
+                    }
+#endif
+#if defined(MANGO_ENABLE_NEON)
+                    if (flags & ARM_NEON)
+                    {
+                        downsample = downsample_h2v1_neon;
+                    }
+#endif
+                    subsampling_name = "4:2:2";
+                    break;
+
+                case ChromaSubsampling::S420:
+                    hsf = 2;
+                    vsf = 2;
+                    downsample = downsample_h2v2;
+#if defined(MANGO_ENABLE_SSE2)
+                    if (flags & INTEL_SSE2)
+                    {
+                        downsample = downsample_h2v2_sse2;
+                    }
+#endif
+#if defined(MANGO_ENABLE_NEON)
+                    if (flags & ARM_NEON)
+                    {
+                        downsample = downsample_h2v2_neon;
+                    }
+#endif
+                    subsampling_name = "4:2:0";
+                    break;
+            }
+        }
+
+        // luminance blocks followed by the chrominance blocks
+        blocks_in_mcu = 0;
+
+        for (int i = 0; i < hsf * vsf; ++i)
+        {
+            mcu_channel[blocks_in_mcu++] = 0;
+        }
+
+        for (int i = 1; i < components; ++i)
+        {
+            mcu_channel[blocks_in_mcu++] = i;
+        }
+
+        // build encoder info string
+        info = "fDCT: ";
+        info += fdct_name;
+
+        info += ", Color: ";
+        info += sampler_name;
+
+        info += ", Encoder: ";
+        info += encode_name;
+
+        if (components == 3)
+        {
+            info += ", ";
+            info += subsampling_name;
+        }
+
+        if (options.progressive)
+        {
+            info += ", Progressive";
+        }
+        else if (options.optimize_huffman)
+        {
+            info += ", Optimized Huffman";
+        }
+
+        mcu_width = hsf * 8;
+        mcu_height = vsf * 8;
+
+        horizontal_mcus = div_ceil(m_surface.width, mcu_width);
+        vertical_mcus   = div_ceil(m_surface.height, mcu_height);
+
+        rows_in_bottom_mcus = m_surface.height - (vertical_mcus - 1) * mcu_height;
+        cols_in_right_mcus  = m_surface.width  - (horizontal_mcus - 1) * mcu_width;
+
+        mcu_stride = mcu_width * bytes_per_pixel;
+
+        // initialize quantization tables
+
+        const u8 zigzag_table [] =
+        {
+             0,  1,  5,  6, 14, 15, 27, 28,
+             2,  4,  7, 13, 16, 26, 29, 42,
+             3,  8, 12, 17, 25, 30, 41, 43,
+             9, 11, 18, 24, 31, 40, 44, 53,
+            10, 19, 23, 32, 39, 45, 52, 54,
+            20, 22, 33, 38, 46, 51, 55, 60,
+            21, 34, 37, 47, 50, 56, 59, 61,
             35, 36, 48, 49, 57, 58, 62, 63
         };
 
-        // configure quality
-        u32 quality = u32(std::pow(1.0f + std::clamp(1.0f - options.quality, 0.0f, 1.0f), 11.0f) * 8.0f);
+        // configure quality
+        u32 quality = u32(std::pow(1.0f + std::clamp(1.0f - options.quality, 0.0f, 1.0f), 11.0f) * 8.0f);
+
+        for (int i = 0; i < 64; ++i)
+        {
+            u8 index = zigzag_table[i];
+
+            // luminance
+            u32 L = u32_clamp((g_luminance_quant_table[i] * quality + 0x200) >> 10, 2, 255);
+            luminance_qtable[index] = u8(L);
+            inverse_luminance_qtable[i] = u16(0x8000 / L);
+
+            // chrominance
+            u32 C = u32_clamp((g_chrominance_quant_table [i] * quality + 0x200) >> 10, 2, 255);
+            chrominance_qtable[index] = u8(C);
+            inverse_chrominance_qtable[i] = u16(0x8000 / C);
+        }
+    }
+
+    jpegEncoder::~jpegEncoder()
+    {
+    }
+
+    void jpegEncoder::writeMarkers(BigEndianStream& p, int interval)
+    {
+        // Start of image marker
+        p.write16(MARKER_SOI);
+
+        // ICC profile.  splitting to multiple markers if necessary
+        if (m_options.icc.size)
+        {
+            const size_t magicICCLength = 12;
+            const u8 magicICC[magicICCLength] = { 0x49, 0x43, 0x43, 0x5f, 0x50, 0x52, 0x4f, 0x46, 0x49, 0x4c, 0x45, 0 }; // 'ICC_PROFILE', 0
+
+            const size_t iccMaxSegmentSize = 65000;  // marker size is 16bit minus icc stuff, if larger we need to split
+            const size_t iccSegments = (m_options.icc.size + iccMaxSegmentSize - 1) / iccMaxSegmentSize;
+
+            for(size_t i=0; i < iccSegments; i++)
+            {
+                const size_t size = i < (iccSegments - 1) ? iccMaxSegmentSize :  m_options.icc.size % iccMaxSegmentSize;
+                p.write16(MARKER_APP2);
+                p.write16(u16(size + magicICCLength + 4));
+                p.write(magicICC, magicICCLength);
+                p.write8(u8(i + 1)); // segment index, 1-based
+                p.write8(u8(iccSegments));
+                p.write(m_options.icc.slice(i * iccMaxSegmentSize), size);
+            }
+        }
+
+        if (!m_options.progressive)
+        {
+            // MANGO marker
+            const u8 magic_mango [] = { 0x4d, 0x61, 0x6e, 0x67, 0x6f, 0x31 }; // 'Mango1'
+            const u32 magic_mango_size = sizeof(magic_mango);
+
+            int intervals = div_ceil(vertical_mcus, interval);
+
+            p.write16(MARKER_APP14);
+            p.write16(u16(6 + magic_mango_size + intervals * sizeof(u32)));
+            p.write(magic_mango, magic_mango_size);
+            p.write32(interval);
+
+            restart_offset = p.offset();
+
+            for (int i = 0; i < intervals; ++i)
+            {
+                // reserve space for restart offsets
+                p.write32(0);
+            }
+        }
+
+        // Quantization table marker
+        p.write16(MARKER_DQT);
+        p.write16(0x43); // quantization table length
+        p.write8(0x00); // Pq, Tq
+
+        // Lqt table
+        p.write(luminance_qtable, 64);
+
+        // Quantization table marker
+        p.write16(MARKER_DQT);
+        p.write16(0x43); // quantization table length
+        p.write8(0x01); // Pq, Tq
+
+        // Cqt table
+        p.write(chrominance_qtable, 64);
+
+        // Start of frame marker
+        p.write16(m_options.progressive ? MARKER_SOF2 : MARKER_SOF0);
+
+        u8 number_of_components = 0;
+
+        switch (m_sample)
+        {
+            case SampleType::U8_Y:
+                number_of_components = 1;
+                break;
+
+            case SampleType::U8_RGB:
+            case SampleType::U8_BGR:
+            case SampleType::U8_BGRA:
+            case SampleType::U8_RGBA:
+                number_of_components = 3;
+                break;
+        }
+
+        u16 header_length = 8 + 3 * number_of_components;
+
+        p.write16(header_length); // frame header length
+        p.write8(8); // precision
+        p.write16(u16(m_surface.height)); // image height
+        p.write16(u16(m_surface.width)); // image width
+        p.write8(number_of_components); // Nf
+
+        for (int i = 0; i < number_of_components; ++i)
+        {
+            p.write8(u8(i + 1)); // component id
+            p.write8(i ? 0x11 : u8((hsf << 4) | vsf)); // sampling factors
+            p.write8(i ? 0x01 : 0x00); // quantization table
+        }
+
+        if (m_options.progressive)
+        {
+            // the scans have their own huffman tables
+            return;
+        }
+
+        // huffman table (DHT)
+        if (m_options.optimize_huffman)
+        {
+            Buffer buffer;
+
+            for (int i = 0; i < std::min(components, 2); ++i)
+            {
+                dc_tables[i].write(buffer, u8(0x00 | i));
+                ac_tables[i].write(buffer, u8(0x10 | i));
+            }
+
+            p.write(buffer, buffer.size());
+        }
+        else
+        {
+            p.write(g_marker_data, sizeof(g_marker_data));
+        }
+
+        // Define Restart Interval (DRI)
+        p.write16(MARKER_DRI);
+        p.write16(4);
+        p.write16(horizontal_mcus * interval);
+
+        // Start of scan marker
+        p.write16(MARKER_SOS);
+        p.write16(6 + number_of_components * 2); // header length
+        p.write8(number_of_components); // Ns
+
+        const u8 nsdata[] =
+        {
+            0x01, 0x00,
+            0x02, 0x11,
+            0x03, 0x11,
+        };
+
+        p.write(nsdata, number_of_components * 2);
+        p.write8(0x00);
+        p.write8(0x3f);
+        p.write8(0x00);
+    }
+
+    void jpegEncoder::readMCU(s16* block, const u8* image, size_t stride, ReadFunc read_func, int rows, int cols)
+    {
+        if (hsf == 1 && vsf == 1)
+        {
+            read_func(block, image, stride, rows, cols);
+            return;
+        }
+
+        u8 temp[16 * 16 * 4];
+
+        if (rows < mcu_height || cols < mcu_width)
+        {
+            // clipped MCU; replicate the edge pixels over the whole MCU
+            const int bytes = cols * bytes_per_pixel;
+
+            for (int y = 0; y < mcu_height; ++y)
+            {
+                u8* dest = temp + y * mcu_stride;
+                std::memcpy(dest, image + std::min(y, rows - 1) * stride, bytes);
+
+                for (int x = bytes; x < mcu_stride; x += bytes_per_pixel)
+                {
+                    std::memcpy(dest + x, dest + bytes - bytes_per_pixel, bytes_per_pixel);
+                }
+            }
+
+            image = temp;
+            stride = mcu_stride;
+        }
+
+        // Y, Cb and Cr of each 8x8 block in the MCU
+        s16 samples[4][BLOCK_SIZE * 3];
+
+        for (int y = 0; y < vsf; ++y)
+        {
+            for (int x = 0; x < hsf; ++x)
+            {
+                s16* dest = samples[y * hsf + x];
+                read_8x8(dest, image + y * 8 * stride + x * 8 * bytes_per_pixel, stride, 8, 8);
+                std::memcpy(block + (y * hsf + x) * BLOCK_SIZE, dest, BLOCK_SIZE * sizeof(s16));
+            }
+        }
+
+        s16* cb = block + hsf * vsf * BLOCK_SIZE;
+        s16* cr = cb + BLOCK_SIZE;
+
+        for (int y = 0; y < vsf; ++y)
+        {
+            const s16* left = samples[y * 2 + 0];
+            const s16* right = samples[y * 2 + 1];
+            downsample(cb + y * 32, left + BLOCK_SIZE * 1, right + BLOCK_SIZE * 1);
+            downsample(cr + y * 32, left + BLOCK_SIZE * 2, right + BLOCK_SIZE * 2);
+        }
+    }
+
+    template <typename Func>
+    void jpegEncoder::readInterval(int y0, int y1, const u8* image, size_t stride, Func&& func)
+    {
+        const int right_mcu = horizontal_mcus - 1;
+
+        for (int y = y0; y < y1; ++y)
+        {
+            int rows = mcu_height;
+            auto read_func = read_8x8;
+
+            if (y >= vertical_mcus - 1)
+            {
+                // vertical clipping
+                rows = rows_in_bottom_mcus;
+                read_func = read;
+            }
+
+            const u8* scan = image;
+            int cols = mcu_width;
+
+            for (int x = 0; x < horizontal_mcus; ++x)
+            {
+                if (x >= right_mcu)
+                {
+                    // horizontal clipping
+                    cols = cols_in_right_mcus;
+                    read_func = read;
+                }
+
+                s16 block[BLOCK_SIZE * 6];
+                readMCU(block, scan, stride, read_func, rows, cols);
+                func(block, x, y);
+
+                scan += mcu_stride;
+            }
+
+            image += stride * mcu_height;
+        }
+    }
+
+    void jpegEncoder::encodeScan(Buffer& buffer, HuffmanEncoder& huffman, const u8* image, size_t stride, ReadFunc read_func, int rows)
+    {
+        const int right_mcu = horizontal_mcus - 1;
+
+        // the worst case MCU is six blocks of ~420 bytes (with stuffing)
+        constexpr int buffer_size = 8192;
+        constexpr int flush_threshold = buffer_size - 3072;
+
+        u8 temp[buffer_size]; // encoding buffer
+        u8* ptr = temp;
+
+        int cols = mcu_width;
+        auto reader = read_func;
+
+        for (int x = 0; x < horizontal_mcus; ++x)
+        {
+            if (x >= right_mcu)
+            {
+                // horizontal clipping
+                cols = cols_in_right_mcus;
+                reader = read; // clipping reader
+            }
+
+            // read MCU data
+            s16 block[BLOCK_SIZE * 6];
+            readMCU(block, image, stride, reader, rows, cols);
+
+            // encode the data in MCU
+            for (int i = 0; i < blocks_in_mcu; ++i)
+            {
+                ptr = encode(huffman, ptr, block + i * BLOCK_SIZE, channel[mcu_channel[i]]);
+            }
+
+            // flush encoding buffer
+            if (ptr - temp > flush_threshold)
+            {
+                buffer.append(temp, ptr - temp);
+                ptr = temp;
+            }
+
+            image += mcu_stride;
+        }
+
+        // flush encoding buffer
+        buffer.append(temp, ptr - temp);
+    }
+
+    void jpegEncoder::encodeInterval(Buffer& buffer, int y0, int y1, int restartCounter, const u8* image, size_t stride)
+    {
+        HuffmanEncoder huffman;
+        huffman.fdct = fdct;
+
+        for (int y = y0; y < y1; ++y)
+        {
+            int rows = mcu_height;
+            auto read_func = read_8x8; // default: optimized 8x8 reader
+
+            if (y >= vertical_mcus - 1)
+            {
+                // vertical clipping
+                rows = rows_in_bottom_mcus;
+                read_func = read; // clipping reader
+            }
+
+            encodeScan(buffer, huffman, image, stride, read_func, rows);
+            image += stride * mcu_height;
+        }
+
+        // flush huffman encoder
+        u8 temp[16];
+        u8* ptr = huffman.flush(temp);
+        buffer.append(temp, ptr - temp);
+
+        // write restart marker
+        BigEndianPointer p = buffer.append(2);
+        p.write16(MARKER_RST0 + (restartCounter & 7));
+    }
+
+    void jpegEncoder::gatherInterval(HuffmanStatistics& stats, int y0, int y1, const u8* image, size_t stride)
+    {
+        // the dc prediction is reset at the restart marker
+        int last_dc[3] = { 0, 0, 0 };
+
+        readInterval(y0, y1, image, stride, [&] (const s16* block, int x, int y)
+        {
+            MANGO_UNREFERENCED(x);
+            MANGO_UNREFERENCED(y);
+
+            for (int i = 0; i < blocks_in_mcu; ++i)
+            {
+                const Channel& c = channel[mcu_channel[i]];
+
+                s16 temp[BLOCK_SIZE];
+                fdct(temp, block + i * BLOCK_SIZE, c.qtable);
+                gather_block_statistics(stats, temp, last_dc[c.component], c.component ? 1 : 0);
+            }
+        });
+    }
+
+    void jpegEncoder::optimizeHuffmanTables(const u8* image, size_t stride)
+    {
+        // The symbol statistics are gathered from the restart intervals in parallel; the
+        // DCT is computed again in the encoding pass instead of storing the coefficients.
+
+        const int N = 8; // number of restart intervals in a task
+        const int tasks = div_ceil(vertical_mcus, N);
+
+        std::vector<HuffmanStatistics> stats(tasks);
+
+        ConcurrentQueue queue;
+
+        for (int i = 0; i < tasks; ++i)
+        {
+            auto func = [this, &stats, i, N, image, stride]
+            {
+                const int y0 = i * N;
+                const int y1 = std::min(vertical_mcus, y0 + N);
+
+                for (int y = y0; y < y1; ++y)
+                {
+                    gatherInterval(stats[i], y, y + 1, image + y * stride * mcu_height, stride);
+                }
+            };
+
+            if (m_options.multithread)
+            {
+                queue.enqueue(func);
+            }
+            else
+            {
+                func();
+            }
+        }
+
+        queue.wait();
+
+        for (int i = 1; i < tasks; ++i)
+        {
+            stats[0].merge(stats[i]);
+        }
+
+        for (int i = 0; i < std::min(components, 2); ++i)
+        {
+            dc_tables[i].build(stats[0].dc[i]);
+            ac_tables[i].build(stats[0].ac[i]);
+            encode_tables[i].build(dc_tables[i], ac_tables[i]);
+        }
+
+        for (int i = 0; i < components; ++i)
+        {
+            const EncodeTable& table = encode_tables[i ? 1 : 0];
+            channel[i].dc_code = table.dc_code;
+            channel[i].dc_size = table.dc_size;
+            channel[i].ac_code = table.ac_code;
+            channel[i].ac_size = table.ac_size;
+        }
+    }
+
+    ImageEncodeStatus jpegEncoder::encodeImage(Stream& stream)
+    {
+        if (m_options.progressive)
+        {
+            return encodeProgressive(stream);
+        }
+
+        const u8* image = m_surface.image;
+        size_t stride = m_surface.stride;
+
+        if (m_options.optimize_huffman)
+        {
+            optimizeHuffmanTables(image, stride);
+        }
+
+        BigEndianStream s(stream);
+
+        // encode MCUs
+        int N = 1; // number of MCU scans per restart interval
+        int restartCounter = 0;
+
+        // writing marker data
+        writeMarkers(s, N);
+
+        if (m_options.multithread)
+        {
+            ConcurrentQueue queue;
+            TicketQueue tk;
+
+            for (int y = 0; y < vertical_mcus; y += N)
+            {
+                auto ticket = tk.acquire();
+
+                queue.enqueue([this, &s, ticket, N, y, restartCounter, image, stride]
+                {
+                    Buffer buffer;
+                    encodeInterval(buffer, y, std::min(vertical_mcus, y + N), restartCounter, image, stride);
+
+                    Memory memory = buffer.acquire();
+
+                    // tickets are consumed in acquired order
+                    ticket.consume([this, &s, memory]
+                    {
+                        // write encoded data
+                        s.write(memory);
+                        Buffer::release(memory);
+
+                        // store offset
+                        u64 offset = s.offset();
+                        restart_offsets.push_back(offset);
+                    });
+                });
+
+                ++restartCounter;
+                image += stride * mcu_height * N;
+            }
+
+            // wait until all work has been submitted
+            queue.wait();
+
+            // wait until all tickets have been consumed (encoded data has been written)
+            tk.wait();
+        }
+        else
+        {
+            for (int y = 0; y < vertical_mcus; y += N)
+            {
+                Buffer buffer;
+                encodeInterval(buffer, y, std::min(vertical_mcus, y + N), restartCounter, image, stride);
+
+                // write encoded data
+                s.write(buffer);
+
+                // store offset
+                u64 offset = s.offset();
+                restart_offsets.push_back(offset);
+
+                ++restartCounter;
+                image += stride * mcu_height * N;
+            }
+        }
+
+        // EOI marker
+        s.write16(MARKER_EOI);
+
+        // patch restart offsets
+        s.seek(restart_offset, Stream::SeekMode::Begin);
+
+        for (u32 offset : restart_offsets)
+        {
+            s.write32(offset);
+        }
+
+        ImageEncodeStatus status;
+        status.info = info;
+
+        return status;
+    }
+
+    void jpegEncoder::transformInterval(int y0, int y1, const u8* image, size_t stride)
+    {
+        readInterval(y0, y1, image, stride, [&] (const s16* block, int x, int y)
+        {
+            for (int i = 0; i < blocks_in_mcu; ++i)
+            {
+                const int c = mcu_channel[i];
+
+                int bx = x;
+                int by = y;
+
+                if (!c)
+                {
+                    bx = x * hsf + i % hsf;
+                    by = y * vsf + i / hsf;
+                }
+
+                fdct(coefficients.component[c].block(bx, by), block + i * BLOCK_SIZE, channel[c].qtable);
+            }
+        });
+    }
+
+    ImageEncodeStatus jpegEncoder::encodeProgressive(Stream& stream)
+    {
+        const u8* image = m_surface.image;
+        size_t stride = m_surface.stride;
+
+        // The progressive scans need the whole image; the coefficients are computed first
+        // and the scans are then encoded in parallel, each with its own huffman tables.
+
+        coefficients.width = m_surface.width;
+        coefficients.height = m_surface.height;
+        coefficients.components = components;
+
+        for (int c = 0; c < components; ++c)
+        {
+            JPEGCoefficients::Component& component = coefficients.component[c];
+
+            component.id = c + 1;
+            component.hsf = c ? 1 : hsf;
+            component.vsf = c ? 1 : vsf;
+            component.tq = c ? 1 : 0;
+            component.width = horizontal_mcus * component.hsf;
+            component.height = vertical_mcus * component.vsf;
+            component.data.resize(size_t(component.width) * component.height * BLOCK_SIZE);
+        }
+
+        const int N = 8; // number of MCU rows in a task
+
+        ConcurrentQueue queue;
+
+        for (int y = 0; y < vertical_mcus; y += N)
+        {
+            auto func = [this, y, N, image, stride]
+            {
+                transformInterval(y, std::min(vertical_mcus, y + N), image + y * stride * mcu_height, stride);
+            };
+
+            if (m_options.multithread)
+            {
+                queue.enqueue(func);
+            }
+            else
+            {
+                func();
+            }
+        }
+
+        queue.wait();
+
+        BigEndianStream s(stream);
+
+        // writing marker data
+        writeMarkers(s, 0);
+
+        encodeProgressiveScans(s, coefficients, m_options.multithread);
+
+        // EOI marker
+        s.write16(MARKER_EOI);
+
+        ImageEncodeStatus status;
+        status.info = info;
+
+        return status;
+    }
+
+    // ----------------------------------------------------------------------------
+    // CoefficientEncoder
+    // ----------------------------------------------------------------------------
+
+    // Entropy codes quantized coefficients again for lossless transcoding; the block
+    // encoders are shared with jpegEncoder by replacing the fdct with a copy.
+
+    static
+    void fdct_copy(s16* dest, const s16* data, const s16* qtable)
+    {
+        MANGO_UNREFERENCED(qtable);
+        std::memcpy(dest, data, BLOCK_SIZE * sizeof(s16));
+    }
+
+    struct CoefficientEncoder
+    {
+        const JPEGCoefficients& m_coefficients;
+        const JPEGTranscodeOptions& m_options;
+        const BlockLayout m_layout;
+
+        jpegEncoder::Channel channel[4];
+
+        // optimized huffman tables; [0] is luminance, [1] chrominance
+        HuffmanTable dc_tables[2];
+        HuffmanTable ac_tables[2];
+        EncodeTable encode_tables[2];
+
+        EncodeFunc encode;
+        std::string info;
+
+        CoefficientEncoder(const JPEGCoefficients& coefficients, const JPEGTranscodeOptions& options);
+
+        void writeMarkers(BigEndianStream& p);
+        void gatherInterval(HuffmanStatistics& stats, int y);
+        void optimizeHuffmanTables();
+        void encodeInterval(Buffer& buffer, int y);
+        ImageEncodeStatus encodeImage(Stream& stream);
+    };
+
+    CoefficientEncoder::CoefficientEncoder(const JPEGCoefficients& coefficients, const JPEGTranscodeOptions& options)
+        : m_coefficients(coefficients)
+        , m_options(options)
+        , m_layout(coefficients)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            channel[c].component = c;
+            channel[c].qtable = nullptr;
+            channel[c].dc_code = c ? g_chrominance_dc_code_table : g_luminance_dc_code_table;
+            channel[c].dc_size = c ? g_chrominance_dc_size_table : g_luminance_dc_size_table;
+            channel[c].ac_code = c ? g_chrominance_ac_code_table : g_luminance_ac_code_table;
+            channel[c].ac_size = c ? g_chrominance_ac_size_table : g_luminance_ac_size_table;
+        }
+
+        const char* encode_name = "Scalar";
+        encode = getBlockEncoder(getCPUFlags(), encode_name);
 
-        for (int i = 0; i < 64; ++i)
-        {
-            u8 index = zigzag_table[i];
+        info = "Transcode: ";
+        info += options.progressive ? "Progressive" : "Sequential";
 
-            // luminance
-            u32 L = u32_clamp((g_luminance_quant_table[i] * quality + 0x200) >> 10, 2, 255);
-            luminance_qtable[index] = u8(L);
-            inverse_luminance_qtable[i] = u16(0x8000 / L);
+        if (!options.progressive)
+        {
+            info += ", Encoder: ";
+            info += encode_name;
 
-            // chrominance
-            u32 C = u32_clamp((g_chrominance_quant_table [i] * quality + 0x200) >> 10, 2, 255);
-            chrominance_qtable[index] = u8(C);
-            inverse_chrominance_qtable[i] = u16(0x8000 / C);
+            if (options.optimize_huffman)
+            {
+                info += ", Optimized Huffman";
+            }
         }
     }
 
-    jpegEncoder::~jpegEncoder()
+    void CoefficientEncoder::writeMarkers(BigEndianStream& p)
     {
-    }
+        const JPEGCoefficients& coefficients = m_coefficients;
 
-    void jpegEncoder::writeMarkers(BigEndianStream& p, int interval)
-    {
-        // Start of image marker
+        // Start of image
         p.write16(MARKER_SOI);
 
-        // ICC profile.  splitting to multiple markers if necessary
-        if (m_options.icc.size)
+        // APPn and COM segments
+        ConstMemory metadata = coefficients.metadata;
+
+        for (const u8* s = metadata.address; s + 4 <= metadata.end(); )
         {
-            const size_t magicICCLength = 12;
-            const u8 magicICC[magicICCLength] = { 0x49, 0x43, 0x43, 0x5f, 0x50, 0x52, 0x4f, 0x46, 0x49, 0x4c, 0x45, 0 }; // 'ICC_PROFILE', 0
+            u16 marker = bigEndian::uload16(s);
+            size_t size = std::min(size_t(2 + bigEndian::uload16(s + 2)), size_t(metadata.end() - s));
 
-            const size_t iccMaxSegmentSize = 65000;  // marker size is 16bit minus icc stuff, if larger we need to split
-            const size_t iccSegments = (m_options.icc.size + iccMaxSegmentSize - 1) / iccMaxSegmentSize;
+            const u8 magic_adobe [] = { 0x41, 0x64, 0x6f, 0x62, 0x65 }; // 'Adobe'
+            bool is_adobe = marker == MARKER_APP14 && size >= 9 && !std::memcmp(s + 4, magic_adobe, 5);
 
-            for(size_t i=0; i < iccSegments; i++)
+            // the Adobe marker defines the color transform and is always kept
+            if (m_options.metadata || is_adobe)
             {
-                const size_t size = i < (iccSegments - 1) ? iccMaxSegmentSize :  m_options.icc.size % iccMaxSegmentSize;
-                p.write16(MARKER_APP2);
-                p.write16(u16(size + magicICCLength + 4));
-                p.write(magicICC, magicICCLength);
-                p.write8(u8(i + 1)); // segment index, 1-based
-                p.write8(u8(iccSegments));
-                p.write(m_options.icc.slice(i * iccMaxSegmentSize), size);
+                p.write(s, size);
             }
-        }
-
-        // MANGO marker
-        const u8 magic_mango [] = { 0x4d, 0x61, 0x6e, 0x67, 0x6f, 0x31 }; // 'Mango1'
-        const u32 magic_mango_size = sizeof(magic_mango);
-
-        int intervals = div_ceil(vertical_mcus, interval);
 
-        p.write16(MARKER_APP14);
-        p.write16(u16(6 + magic_mango_size + intervals * sizeof(u32)));
-        p.write(magic_mango, magic_mango_size);
-        p.write32(interval);
+            s += size;
+        }
 
-        restart_offset = p.offset();
+        // quantization tables
+        bool is_extended = false;
+        bool is_used[4] = { false, false, false, false };
 
-        for (int i = 0; i < intervals; ++i)
+        for (int c = 0; c < coefficients.components; ++c)
         {
-            // reserve space for restart offsets
-            p.write32(0);
+            is_used[coefficients.component[c].tq & 3] = true;
         }
 
-        // Quantization table marker
-        p.write16(MARKER_DQT);
-        p.write16(0x43); // quantization table length
-        p.write8(0x00); // Pq, Tq
-
-        // Lqt table
-        p.write(luminance_qtable, 64);
-
-        // Quantization table marker
-        p.write16(MARKER_DQT);
-        p.write16(0x43); // quantization table length
-        p.write8(0x01); // Pq, Tq
+        for (int i = 0; i < 4; ++i)
+        {
+            if (!is_used[i])
+                continue;
 
-        // Cqt table
-        p.write(chrominance_qtable, 64);
+            bool is_16bit = false;
 
-        // Start of frame marker
-        p.write16(MARKER_SOF0);
+            for (int j = 0; j < 64; ++j)
+            {
+                is_16bit |= coefficients.qtable[i][j] > 255;
+            }
 
-        u8 number_of_components = 0;
+            is_extended |= is_16bit;
 
-        switch (m_sample)
-        {
-            case SampleType::U8_Y:
-                number_of_components = 1;
-                break;
+            p.write16(MARKER_DQT);
+            p.write16(u16(3 + 64 * (is_16bit ? 2 : 1)));
+            p.write8(u8((is_16bit ? 0x10 : 0x00) | i));
 
-            case SampleType::U8_RGB:
-            case SampleType::U8_BGR:
-            case SampleType::U8_BGRA:
-            case SampleType::U8_RGBA:
-                number_of_components = 3;
-                break;
+            for (int j = 0; j < 64; ++j)
+            {
+                u16 value = coefficients.qtable[i][zigzagTable[j]];
+                if (is_16bit)
+                    p.write16(value);
+                else
+                    p.write8(u8(value));
+            }
         }
 
-        u16 header_length = 8 + 3 * number_of_components;
+        // Start of frame marker
+        u16 sof = is_extended ? MARKER_SOF1 : MARKER_SOF0;
+        p.write16(m_options.progressive ? u16(MARKER_SOF2) : sof);
 
-        p.write16(header_length); // frame header length
+        p.write16(u16(8 + 3 * coefficients.components)); // frame header length
         p.write8(8); // precision
-        p.write16(u16(m_surface.height)); // image height
-        p.write16(u16(m_surface.width)); // image width
-        p.write8(number_of_components); // Nf
+        p.write16(u16(coefficients.height));
+        p.write16(u16(coefficients.width));
+        p.write8(u8(coefficients.components)); // Nf
 
-        const u8 nfdata[] =
+        for (int c = 0; c < coefficients.components; ++c)
         {
-            0x01, 0x11, 0x00, // component 1
-            0x00, 0x00, 0x00, // padding
-            0x01, 0x11, 0x00, // component 1
-            0x02, 0x11, 0x01, // component 2
-            0x03, 0x11, 0x01, // component 3
-        };
+            const JPEGCoefficients::Component& component = coefficients.component[c];
+            p.write8(u8(component.id));
+            p.write8(u8((component.hsf << 4) | component.vsf));
+            p.write8(u8(component.tq));
+        }
 
-        p.write(nfdata + (number_of_components - 1) * 3, number_of_components * 3);
+        if (m_options.progressive)
+        {
+            // the scans have their own huffman tables
+            return;
+        }
 
         // huffman table (DHT)
-        p.write(g_marker_data, sizeof(g_marker_data));
+        if (m_options.optimize_huffman)
+        {
+            Buffer buffer;
 
-        // Define Restart Interval (DRI)
+            for (int i = 0; i < std::min(coefficients.components, 2); ++i)
+            {
+                dc_tables[i].write(buffer, u8(0x00 | i));
+                ac_tables[i].write(buffer, u8(0x10 | i));
+            }
+
+            p.write(buffer, buffer.size());
+        }
+        else
+        {
+            p.write(g_marker_data, sizeof(g_marker_data));
+        }
+
+        // Define Restart Interval (DRI); every MCU row is an interval
         p.write16(MARKER_DRI);
         p.write16(4);
-        p.write16(horizontal_mcus * interval);
+        p.write16(u16(m_layout.horizontal_mcus));
 
         // Start of scan marker
         p.write16(MARKER_SOS);
-        p.write16(6 + number_of_components * 2); // header length
-        p.write8(number_of_components); // Ns
+        p.write16(u16(6 + coefficients.components * 2)); // header length
+        p.write8(u8(coefficients.components)); // Ns
 
-        const u8 nsdata[] =
+        for (int c = 0; c < coefficients.components; ++c)
         {
-            0x01, 0x00,
-            0x02, 0x11,
-            0x03, 0x11,
-        };
+            p.write8(u8(coefficients.component[c].id));
+            p.write8(c ? 0x11 : 0x00);
+        }
 
-        p.write(nsdata, number_of_components * 2);
         p.write8(0x00);
         p.write8(0x3f);
         p.write8(0x00);
     }
 
-    void jpegEncoder::encodeScan(Buffer& buffer, HuffmanEncoder& huffman, const u8* image, size_t stride, ReadFunc read_func, int rows)
+    void CoefficientEncoder::gatherInterval(HuffmanStatistics& stats, int y)
     {
-        const int right_mcu = horizontal_mcus - 1;
+        // the dc prediction is reset at the restart marker
+        int last_dc[4] = { 0, 0, 0, 0 };
 
-        constexpr int buffer_size = 4096;
-        constexpr int flush_threshold = buffer_size - 1024;
+        for (int x = 0; x < m_layout.horizontal_mcus; ++x)
+        {
+            for (int i = 0; i < m_layout.blocks_in_mcu; ++i)
+            {
+                const int c = m_layout.mcu_component[i];
+                const s16* block = m_layout.block(m_coefficients, x, y, i);
+                gather_block_statistics(stats, block, last_dc[c], c ? 1 : 0);
+            }
+        }
+    }
 
-        u8 temp[buffer_size]; // encoding buffer
-        u8* ptr = temp;
+    void CoefficientEncoder::optimizeHuffmanTables()
+    {
+        const int N = 8; // number of restart intervals in a task
+        const int tasks = div_ceil(m_layout.vertical_mcus, N);
 
-        int cols = mcu_width;
-        auto reader = read_func;
+        std::vector<HuffmanStatistics> stats(tasks);
 
-        for (int x = 0; x < horizontal_mcus; ++x)
+        ConcurrentQueue queue;
+
+        for (int i = 0; i < tasks; ++i)
         {
-            if (x >= right_mcu)
+            auto func = [this, &stats, i, N]
             {
-                // horizontal clipping
-                cols = cols_in_right_mcus;
-                reader = read; // clipping reader
-            }
+                const int y0 = i * N;
+                const int y1 = std::min(m_layout.vertical_mcus, y0 + N);
 
-            // read MCU data
-            s16 block[BLOCK_SIZE * 3];
-            reader(block, image, stride, rows, cols);
+                for (int y = y0; y < y1; ++y)
+                {
+                    gatherInterval(stats[i], y);
+                }
+            };
 
-            // encode the data in MCU
-            for (int i = 0; i < components; ++i)
+            if (m_options.multithread)
             {
-                ptr = encode(huffman, ptr, block + i * BLOCK_SIZE, channel[i]);
+                queue.enqueue(func);
             }
-
-            // flush encoding buffer
-            if (ptr - temp > flush_threshold)
+            else
             {
-                buffer.append(temp, ptr - temp);
-                ptr = temp;
+                func();
             }
+        }
 
-            image += mcu_stride;
+        queue.wait();
+
+        for (int i = 1; i < tasks; ++i)
+        {
+            stats[0].merge(stats[i]);
         }
 
-        // flush encoding buffer
-        buffer.append(temp, ptr - temp);
+        for (int i = 0; i < std::min(m_coefficients.components, 2); ++i)
+        {
+            dc_tables[i].build(stats[0].dc[i]);
+            ac_tables[i].build(stats[0].ac[i]);
+            encode_tables[i].build(dc_tables[i], ac_tables[i]);
+        }
+
+        for (int c = 0; c < m_coefficients.components; ++c)
+        {
+            const EncodeTable& table = encode_tables[c ? 1 : 0];
+            channel[c].dc_code = table.dc_code;
+            channel[c].dc_size = table.dc_size;
+            channel[c].ac_code = table.ac_code;
+            channel[c].ac_size = table.ac_size;
+        }
     }
 
-    void jpegEncoder::encodeInterval(Buffer& buffer, int y0, int y1, int restartCounter, const u8* image, size_t stride)
+    void CoefficientEncoder::encodeInterval(Buffer& buffer, int y)
     {
         HuffmanEncoder huffman;
-        huffman.fdct = fdct;
+        huffman.fdct = fdct_copy;
 
-        for (int y = y0; y < y1; ++y)
+        // the worst case MCU is ten blocks of ~420 bytes (with stuffing)
+        constexpr int buffer_size = 16384;
+        constexpr int flush_threshold = buffer_size - 5120;
+
+        u8 temp[buffer_size];
+        u8* ptr = temp;
+
+        for (int x = 0; x < m_layout.horizontal_mcus; ++x)
         {
-            int rows = mcu_height;
-            auto read_func = read_8x8; // default: optimized 8x8 reader
+            for (int i = 0; i < m_layout.blocks_in_mcu; ++i)
+            {
+                const s16* block = m_layout.block(m_coefficients, x, y, i);
+                ptr = encode(huffman, ptr, block, channel[m_layout.mcu_component[i]]);
+            }
 
-            if (y >= vertical_mcus - 1)
+            // flush encoding buffer
+            if (ptr - temp > flush_threshold)
             {
-                // vertical clipping
-                rows = rows_in_bottom_mcus;
-                read_func = read; // clipping reader
+                buffer.append(temp, ptr - temp);
+                ptr = temp;
             }
+        }
 
-            encodeScan(buffer, huffman, image, stride, read_func, rows);
-            image += stride * mcu_height;
+        // pad the last byte with 1-bits
+        int bits = (JPEG_REGISTER_BITS - huffman.space) & 7;
+        if (bits)
+        {
+            ptr = huffman.putBits(ptr, (1 << (8 - bits)) - 1, 8 - bits);
         }
 
-        // flush huffman encoder
-        u8 temp[16];
-        u8* ptr = huffman.flush(temp);
+        ptr = huffman.flush(ptr);
         buffer.append(temp, ptr - temp);
 
-        // write restart marker
-        BigEndianPointer p = buffer.append(2);
-        p.write16(MARKER_RST0 + (restartCounter & 7));
+        if (y < m_layout.vertical_mcus - 1)
+        {
+            // write restart marker
+            BigEndianPointer p = buffer.append(2);
+            p.write16(MARKER_RST0 + (y & 7));
+        }
     }
 
-    ImageEncodeStatus jpegEncoder::encodeImage(Stream& stream)
+    ImageEncodeStatus CoefficientEncoder::encodeImage(Stream& stream)
     {
-        const u8* image = m_surface.image;
-        size_t stride = m_surface.stride;
+        ImageEncodeStatus status;
 
-        BigEndianStream s(stream);
+        const JPEGCoefficients& coefficients = m_coefficients;
 
-        // encode MCUs
-        int N = 1; // number of MCU scans per restart interval
-        int restartCounter = 0;
+        if (coefficients.components < 1 || coefficients.components > 4 ||
+            coefficients.width < 1 || coefficients.height < 1 ||
+            coefficients.width > 65535 || coefficients.height > 65535 ||
+            m_layout.blocks_in_mcu > JPEG_MAX_BLOCKS_IN_MCU)
+        {
+            status.setError("[ImageEncoder.JPG] Incorrect coefficients.");
+            return status;
+        }
 
-        // writing marker data
-        writeMarkers(s, N);
+        BigEndianStream s(stream);
 
-        if (m_options.multithread)
+        if (m_options.progressive)
         {
-            ConcurrentQueue queue;
-            TicketQueue tk;
+            writeMarkers(s);
+            encodeProgressiveScans(s, coefficients, m_options.multithread);
+        }
+        else
+        {
+            if (m_options.optimize_huffman)
+            {
+                optimizeHuffmanTables();
+            }
 
-            for (int y = 0; y < vertical_mcus; y += N)
+            writeMarkers(s);
+
+            if (m_options.multithread)
             {
-                auto ticket = tk.acquire();
+                ConcurrentQueue queue;
+                TicketQueue tk;
 
-                queue.enqueue([this, &s, ticket, N, y, restartCounter, image, stride]
+                for (int y = 0; y < m_layout.vertical_mcus; ++y)
                 {
-                    Buffer buffer;
-                    encodeInterval(buffer, y, std::min(vertical_mcus, y + N), restartCounter, image, stride);
+                    auto ticket = tk.acquire();
 
-                    Memory memory = buffer.acquire();
-
-                    // tickets are consumed in acquired order
-                    ticket.consume([this, &s, memory]
+                    queue.enqueue([this, &s, ticket, y]
                     {
-                        // write encoded data
-                        s.write(memory);
-                        Buffer::release(memory);
+                        Buffer buffer;
+                        encodeInterval(buffer, y);
 
-                        // store offset
-                        u64 offset = s.offset();
-                        restart_offsets.push_back(offset);
-                    });
-                });
+                        Memory memory = buffer.acquire();
 
-                ++restartCounter;
-                image += stride * mcu_height * N;
-            }
+                        // tickets are consumed in acquired order
+                        ticket.consume([&s, memory]
+                        {
+                            s.write(memory);
+                            Buffer::release(memory);
+                        });
+                    });
+                }
 
-            // wait until all work has been submitted
-            queue.wait();
+                // wait until all work has been submitted
+                queue.wait();
 
-            // wait until all tickets have been consumed (encoded data has been written)
-            tk.wait();
-        }
-        else
-        {
-            for (int y = 0; y < vertical_mcus; y += N)
+                // wait until all tickets have been consumed (encoded data has been written)
+                tk.wait();
+            }
+            else
             {
-                Buffer buffer;
-                encodeInterval(buffer, y, std::min(vertical_mcus, y + N), restartCounter, image, stride);
-
-                // write encoded data
-                s.write(buffer);
-
-                // store offset
-                u64 offset = s.offset();
-                restart_offsets.push_back(offset);
-
-                ++restartCounter;
-                image += stride * mcu_height * N;
+                for (int y = 0; y < m_layout.vertical_mcus; ++y)
+                {
+                    Buffer buffer;
+                    encodeInterval(buffer, y);
+                    s.write(buffer);
+                }
             }
         }
 
         // EOI marker
         s.write16(MARKER_EOI);
 
-        // patch restart offsets
-        s.seek(restart_offset, Stream::SeekMode::Begin);
-
-        for (u32 offset : restart_offsets)
-        {
-            s.write32(offset);
-        }
-
-        ImageEncodeStatus status;
         status.info = info;
 
         return status;
@@ -2892,4 +4681,11 @@ namespace mango::image::jpeg
         return status;
     }
 
+    ImageEncodeStatus encodeCoefficients(Stream& stream, const JPEGCoefficients& coefficients, const JPEGTranscodeOptions& options)
+    {
+        CoefficientEncoder encoder(coefficients, options);
+        ImageEncodeStatus status = encoder.encodeImage(stream);
+        return status;
+    }
+
 } // namespace mango::image::jpeg
@@ -3,6 +3,7 @@
     Copyright (C) 2012-2023 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
 #include "jpeg.hpp"
+#include "jpeg_idct_simd.hpp"
 
 namespace
 {
@@ -143,340 +144,26 @@ namespace mango::image::jpeg
     // SSE2 implementation
     // ------------------------------------------------------------------------------------------------
 
-    // Copyright 2009 Intel Corporation
-    // All Rights Reserved
-    //
-    // Permission is granted to use, copy, distribute and prepare derivative works of this
-    // software for any purpose and without fee, provided, that the above copyright notice
-    // and this statement appear in all copies.  Intel makes no representations about the
-    // suitability of this software for any purpose.  THIS SOFTWARE IS PROVIDED "AS IS."
-    // INTEL SPECIFICALLY DISCLAIMS ALL WARRANTIES, EXPRESS OR IMPLIED, AND ALL LIABILITY,
-    // INCLUDING CONSEQUENTIAL AND OTHER INDIRECT DAMAGES, FOR THE USE OF THIS SOFTWARE,
-    // INCLUDING LIABILITY FOR INFRINGEMENT OF ANY PROPRIETARY RIGHTS, AND INCLUDING THE
-    // WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  Intel does not
-    // assume any responsibility for any errors which may appear in this software nor any
-    // responsibility to update it.
-    //
-    // From:
-    // https://software.intel.com/sites/default/files/m/d/4/1/d/8/UsingIntelAVXToImplementIDCT-r1_5.pdf
-    // https://software.intel.com/file/29048
-    //
-    // Requires SSE
-    //
-
-    // Table for rows 0,4 - constants are multiplied on cos_4_16
-    alignas(16) static
-    s16 shortM128_tab_i_04 [] =
-    {
-        16384, 21407, 16384, 8867, 16384, -8867, 16384, -21407,
-        16384, 8867, -16384, -21407, -16384, 21407, 16384, -8867,
-        22725, 19266, 19266, -4520, 12873, -22725, 4520, -12873,
-        12873, 4520, -22725, -12873, 4520, 19266, 19266, -22725
-    };
-
-    // Table for rows 1,7 - constants are multiplied on cos_1_16
-    alignas(16) static
-    s16 shortM128_tab_i_17 [] =
-    {
-        22725, 29692, 22725, 12299, 22725, -12299, 22725, -29692,
-        22725, 12299, -22725, -29692, -22725, 29692, 22725, -12299,
-        31521, 26722, 26722, -6270, 17855, -31521, 6270, -17855,
-        17855, 6270, -31521, -17855, 6270, 26722, 26722, -31521
-    };
-
-    // Table for rows 2,6 - constants are multiplied on cos_2_16
-    alignas(16) static
-    s16 shortM128_tab_i_26 [] =
-    {
-        21407, 27969, 21407, 11585, 21407, -11585, 21407, -27969,
-        21407, 11585, -21407, -27969, -21407, 27969, 21407, -11585,
-        29692, 25172, 25172, -5906, 16819, -29692, 5906, -16819,
-        16819, 5906, -29692, -16819, 5906, 25172, 25172, -29692
-    };
-
-    // Table for rows 3,5 - constants are multiplied on cos_3_16
-    alignas(16) static
-    s16 shortM128_tab_i_35 [] =
-    {
-        19266, 25172, 19266, 10426, 19266, -10426, 19266, -25172,
-        19266, 10426, -19266, -25172, -19266, 25172, 19266, -10426,
-        26722, 22654, 22654, -5315, 15137, -26722, 5315, -15137,
-        15137, 5315, -26722, -15137, 5315, 22654, 22654, -26722
-    };
-
     void idct_sse2(u8* dest, const s16* src, const s16* qt)
     {
         const __m128i* data = reinterpret_cast<const __m128i *>(src);
         const __m128i* qtable = reinterpret_cast<const __m128i *>(qt);
 
         // Load and dequantize
-        __m128i v0 = _mm_mullo_epi16(data[0], qtable[0]);
-        __m128i v1 = _mm_mullo_epi16(data[1], qtable[1]);
-        __m128i v2 = _mm_mullo_epi16(data[2], qtable[2]);
-        __m128i v3 = _mm_mullo_epi16(data[3], qtable[3]);
-        __m128i v4 = _mm_mullo_epi16(data[4], qtable[4]);
-        __m128i v5 = _mm_mullo_epi16(data[5], qtable[5]);
-        __m128i v6 = _mm_mullo_epi16(data[6], qtable[6]);
-        __m128i v7 = _mm_mullo_epi16(data[7], qtable[7]);
-
-        __m128i r_xmm0, r_xmm1, r_xmm2, r_xmm3, r_xmm4, r_xmm5, r_xmm6, r_xmm7;
-        __m128i row0, row1, row2, row3, row4, row5, row6, row7;
-
-        // row 1 and Row 3
-
-        const __m128i* table04 = reinterpret_cast<const __m128i*>(shortM128_tab_i_04);
-        const __m128i* table26 = reinterpret_cast<const __m128i*>(shortM128_tab_i_26);
-
-        r_xmm0 = _mm_shufflelo_epi16(v0, 0xd8);
-        r_xmm1 = _mm_shuffle_epi32(r_xmm0, 0x00);
-        r_xmm1 = _mm_madd_epi16(r_xmm1, table04[0]);
-        r_xmm3 = _mm_shuffle_epi32(r_xmm0, 0x55);
-        r_xmm0 = _mm_shufflehi_epi16(r_xmm0, 0xd8);
-        r_xmm3 = _mm_madd_epi16(r_xmm3, table04[2]);
-        r_xmm2 = _mm_shuffle_epi32(r_xmm0, 0xaa);
-        r_xmm0 = _mm_shuffle_epi32(r_xmm0, 0xff);
-        r_xmm2 = _mm_madd_epi16(r_xmm2, table04[1]);
-
-        const __m128i round_inv_row = _mm_set1_epi32(2048);
-
-        r_xmm4 = _mm_shufflehi_epi16(v2, 0xd8);
-        r_xmm1 = _mm_add_epi32(r_xmm1, round_inv_row);
-        r_xmm4 = _mm_shufflelo_epi16(r_xmm4, 0xd8);
-        r_xmm0 = _mm_madd_epi16(r_xmm0, table04[3]);
-        r_xmm5 = _mm_shuffle_epi32(r_xmm4, 0x00);
-        r_xmm6 = _mm_shuffle_epi32(r_xmm4, 0xaa);
-        r_xmm5 = _mm_madd_epi16(r_xmm5, table26[0]);
-        r_xmm1 = _mm_add_epi32(r_xmm1, r_xmm2);
-        r_xmm7 = _mm_shuffle_epi32(r_xmm4, 0x55);
-        r_xmm6 = _mm_madd_epi16(r_xmm6, table26[1]);
-        r_xmm0 = _mm_add_epi32(r_xmm0, r_xmm3);
-        r_xmm4 = _mm_shuffle_epi32(r_xmm4, 0xff);
-        r_xmm2 = _mm_sub_epi32(r_xmm1, r_xmm0);
-        r_xmm7 = _mm_madd_epi16(r_xmm7, table26[2]);
-        r_xmm0 = _mm_add_epi32(r_xmm0, r_xmm1);
-        r_xmm2 = _mm_srai_epi32(r_xmm2, 12);
-        r_xmm5 = _mm_add_epi32(r_xmm5, round_inv_row);
-        r_xmm4 = _mm_madd_epi16(r_xmm4, table26[3]);
-        r_xmm5 = _mm_add_epi32(r_xmm5, r_xmm6);
-        r_xmm0 = _mm_srai_epi32(r_xmm0, 12);
-        r_xmm2 = _mm_shuffle_epi32(r_xmm2, 0x1b);
-        row0 = _mm_packs_epi32(r_xmm0, r_xmm2);
-
-        r_xmm4 = _mm_add_epi32(r_xmm4, r_xmm7);
-        r_xmm6 = _mm_sub_epi32(r_xmm5, r_xmm4);
-        r_xmm4 = _mm_add_epi32(r_xmm4, r_xmm5);
-        r_xmm6 = _mm_srai_epi32(r_xmm6, 12);
-        r_xmm4 = _mm_srai_epi32(r_xmm4, 12);
-        r_xmm6 = _mm_shuffle_epi32(r_xmm6, 0x1b);
-        row2 = _mm_packs_epi32(r_xmm4, r_xmm6);
-
-        // row 5 and row 7
-
-        r_xmm0 = _mm_shufflelo_epi16(v4, 0xd8);
-        r_xmm1 = _mm_shuffle_epi32(r_xmm0, 0x00);
-        r_xmm1 = _mm_madd_epi16(r_xmm1, table04[0]);
-        r_xmm3 = _mm_shuffle_epi32(r_xmm0, 0x55);
-        r_xmm0 = _mm_shufflehi_epi16(r_xmm0, 0xd8);
-        r_xmm3 = _mm_madd_epi16(r_xmm3, table04[2]);
-        r_xmm2 = _mm_shuffle_epi32(r_xmm0, 0xaa);
-        r_xmm0 = _mm_shuffle_epi32(r_xmm0, 0xff);
-        r_xmm2 = _mm_madd_epi16(r_xmm2, table04[1]);
-        r_xmm4 = _mm_shufflehi_epi16(v6, 0xd8);
-        r_xmm1 = _mm_add_epi32(r_xmm1, round_inv_row);
-        r_xmm4 = _mm_shufflelo_epi16(r_xmm4, 0xd8);
-        r_xmm0 = _mm_madd_epi16(r_xmm0, table04[3]);
-        r_xmm5 = _mm_shuffle_epi32(r_xmm4, 0x00);
-        r_xmm6 = _mm_shuffle_epi32(r_xmm4, 0xaa);
-        r_xmm5 = _mm_madd_epi16(r_xmm5, table26[0]);
-        r_xmm1 = _mm_add_epi32(r_xmm1, r_xmm2);
-        r_xmm7 = _mm_shuffle_epi32(r_xmm4, 0x55);
-        r_xmm6 = _mm_madd_epi16(r_xmm6, table26[1]);
-        r_xmm0 = _mm_add_epi32(r_xmm0, r_xmm3);
-        r_xmm4 = _mm_shuffle_epi32(r_xmm4, 0xff);
-        r_xmm2 = _mm_sub_epi32(r_xmm1, r_xmm0);
-        r_xmm7 = _mm_madd_epi16(r_xmm7, table26[2]);
-        r_xmm0 = _mm_add_epi32(r_xmm0, r_xmm1);
-        r_xmm2 = _mm_srai_epi32(r_xmm2, 12);
-        r_xmm5 = _mm_add_epi32(r_xmm5, round_inv_row);
-        r_xmm4 = _mm_madd_epi16(r_xmm4, table26[3]);
-        r_xmm5 = _mm_add_epi32(r_xmm5, r_xmm6);
-        r_xmm0 = _mm_srai_epi32(r_xmm0, 12);
-        r_xmm2 = _mm_shuffle_epi32(r_xmm2, 0x1b);
-        row4 = _mm_packs_epi32(r_xmm0, r_xmm2);
-
-        r_xmm4 = _mm_add_epi32(r_xmm4, r_xmm7);
-        r_xmm6 = _mm_sub_epi32(r_xmm5, r_xmm4);
-        r_xmm4 = _mm_add_epi32(r_xmm4, r_xmm5);
-        r_xmm6 = _mm_srai_epi32(r_xmm6, 12);
-        r_xmm4 = _mm_srai_epi32(r_xmm4, 12);
-        r_xmm6 = _mm_shuffle_epi32(r_xmm6, 0x1b);
-        row6 = _mm_packs_epi32(r_xmm4, r_xmm6);
-
-        // row 4 and row 2
-
-        const __m128i* table35 = reinterpret_cast<const __m128i*>(shortM128_tab_i_35);
-        const __m128i* table17 = reinterpret_cast<const __m128i*>(shortM128_tab_i_17);
-
-        r_xmm0 = _mm_shufflelo_epi16(v3, 0xd8);
-        r_xmm1 = _mm_shuffle_epi32(r_xmm0, 0x00);
-        r_xmm1 = _mm_madd_epi16(r_xmm1, table35[0]);
-        r_xmm3 = _mm_shuffle_epi32(r_xmm0, 0x55);
-        r_xmm0 = _mm_shufflehi_epi16(r_xmm0, 0xd8);
-        r_xmm3 = _mm_madd_epi16(r_xmm3, table35[2]);
-        r_xmm2 = _mm_shuffle_epi32(r_xmm0, 0xaa);
-        r_xmm0 = _mm_shuffle_epi32(r_xmm0, 0xff);
-        r_xmm2 = _mm_madd_epi16(r_xmm2, table35[1]);
-        r_xmm4 = _mm_shufflehi_epi16(v1, 0xd8);
-        r_xmm1 = _mm_add_epi32(r_xmm1, round_inv_row);
-        r_xmm4 = _mm_shufflelo_epi16(r_xmm4, 0xd8);
-        r_xmm0 = _mm_madd_epi16(r_xmm0, table35[3]);
-        r_xmm5 = _mm_shuffle_epi32(r_xmm4, 0x00);
-        r_xmm6 = _mm_shuffle_epi32(r_xmm4, 0xaa);
-        r_xmm5 = _mm_madd_epi16(r_xmm5, table17[0]);
-        r_xmm1 = _mm_add_epi32(r_xmm1, r_xmm2);
-        r_xmm7 = _mm_shuffle_epi32(r_xmm4, 0x55);
-        r_xmm6 = _mm_madd_epi16(r_xmm6, table17[1]);
-        r_xmm0 = _mm_add_epi32(r_xmm0, r_xmm3);
-        r_xmm4 = _mm_shuffle_epi32(r_xmm4, 0xff);
-        r_xmm2 = _mm_sub_epi32(r_xmm1, r_xmm0);
-        r_xmm7 = _mm_madd_epi16(r_xmm7, table17[2]);
-        r_xmm0 = _mm_add_epi32(r_xmm0, r_xmm1);
-        r_xmm2 = _mm_srai_epi32(r_xmm2, 12);
-        r_xmm5 = _mm_add_epi32(r_xmm5, round_inv_row);
-        r_xmm4 = _mm_madd_epi16(r_xmm4, table17[3]);
-        r_xmm5 = _mm_add_epi32(r_xmm5, r_xmm6);
-        r_xmm0 = _mm_srai_epi32(r_xmm0, 12);
-        r_xmm2 = _mm_shuffle_epi32(r_xmm2, 0x1b);
-        row3 = _mm_packs_epi32(r_xmm0, r_xmm2);
-
-        r_xmm4 = _mm_add_epi32(r_xmm4, r_xmm7);
-        r_xmm6 = _mm_sub_epi32(r_xmm5, r_xmm4);
-        r_xmm4 = _mm_add_epi32(r_xmm5, r_xmm4);
-        r_xmm6 = _mm_srai_epi32(r_xmm6, 12);
-        r_xmm4 = _mm_srai_epi32(r_xmm4, 12);
-        r_xmm6 = _mm_shuffle_epi32(r_xmm6, 0x1b);
-        row1 = _mm_packs_epi32(r_xmm4, r_xmm6);
-
-        // row 6 and row 8
-
-        r_xmm0 = _mm_shufflelo_epi16(v5, 0xd8);
-        r_xmm1 = _mm_shuffle_epi32(r_xmm0, 0x00);
-        r_xmm1 = _mm_madd_epi16(r_xmm1, table35[0]);
-        r_xmm3 = _mm_shuffle_epi32(r_xmm0, 0x55);
-        r_xmm0 = _mm_shufflehi_epi16(r_xmm0, 0xd8);
-        r_xmm3 = _mm_madd_epi16(r_xmm3, table35[2]);
-        r_xmm2 = _mm_shuffle_epi32(r_xmm0, 0xaa);
-        r_xmm0 = _mm_shuffle_epi32(r_xmm0, 0xff);
-        r_xmm2 = _mm_madd_epi16(r_xmm2, table35[1]);
-        r_xmm4 = _mm_shufflehi_epi16(v7, 0xd8);
-        r_xmm1 = _mm_add_epi32(r_xmm1, round_inv_row);
-        r_xmm4 = _mm_shufflelo_epi16(r_xmm4, 0xd8);
-        r_xmm0 = _mm_madd_epi16(r_xmm0, table35[3]);
-        r_xmm5 = _mm_shuffle_epi32(r_xmm4, 0x00);
-        r_xmm6 = _mm_shuffle_epi32(r_xmm4, 0xaa);
-        r_xmm5 = _mm_madd_epi16(r_xmm5, table17[0]);
-        r_xmm1 = _mm_add_epi32(r_xmm1, r_xmm2);
-        r_xmm7 = _mm_shuffle_epi32(r_xmm4, 0x55);
-        r_xmm6 = _mm_madd_epi16(r_xmm6, table17[1]);
-        r_xmm0 = _mm_add_epi32(r_xmm0, r_xmm3);
-        r_xmm4 = _mm_shuffle_epi32(r_xmm4, 0xff);
-        r_xmm2 = _mm_sub_epi32(r_xmm1, r_xmm0);
-        r_xmm7 = _mm_madd_epi16(r_xmm7, table17[2]);
-        r_xmm0 = _mm_add_epi32(r_xmm0, r_xmm1);
-        r_xmm2 = _mm_srai_epi32(r_xmm2, 12);
-        r_xmm5 = _mm_add_epi32(r_xmm5, round_inv_row);
-        r_xmm4 = _mm_madd_epi16(r_xmm4, table17[3]);
-        r_xmm5 = _mm_add_epi32(r_xmm5, r_xmm6);
-        r_xmm0 = _mm_srai_epi32(r_xmm0, 12);
-        r_xmm2 = _mm_shuffle_epi32(r_xmm2, 0x1b);
-        row5 = _mm_packs_epi32(r_xmm0, r_xmm2);
-
-        r_xmm4 = _mm_add_epi32(r_xmm4, r_xmm7);
-        r_xmm6 = _mm_sub_epi32(r_xmm5, r_xmm4);
-        r_xmm4 = _mm_add_epi32(r_xmm5, r_xmm4);
-        r_xmm6 = _mm_srai_epi32(r_xmm6, 12);
-        r_xmm4 = _mm_srai_epi32(r_xmm4, 12);
-        r_xmm6 = _mm_shuffle_epi32(r_xmm6, 0x1b);
-        row7 = _mm_packs_epi32(r_xmm4, r_xmm6);
-
-        const __m128i tg = _mm_set_epi16(-19195, -19195, -21746, -21746, 27146, 27146, 13036, 13036);
-        const __m128i one = _mm_set1_epi16(1);
-
-        r_xmm1 = _mm_shuffle_epi32(tg, 0xaa);
-        r_xmm0 = _mm_mulhi_epi16(r_xmm1, row5);
-        r_xmm1 = _mm_mulhi_epi16(r_xmm1, row3);
-        r_xmm5 = _mm_shuffle_epi32(tg, 0x00);
-        r_xmm4 = _mm_mulhi_epi16(r_xmm5, row7);
-        r_xmm5 = _mm_mulhi_epi16(r_xmm5, row1);
-        r_xmm0 = _mm_adds_epi16(r_xmm0, row5);
-        r_xmm1 = _mm_adds_epi16(r_xmm1, row3);
-        r_xmm0 = _mm_adds_epi16(r_xmm0, row3);
-        r_xmm3 = _mm_shuffle_epi32(tg, 0x55);
-        r_xmm7 = _mm_mulhi_epi16(r_xmm3, row6);
-        r_xmm3 = _mm_mulhi_epi16(r_xmm3, row2);
-        r_xmm5 = _mm_subs_epi16(r_xmm5, row7);
-        r_xmm4 = _mm_adds_epi16(r_xmm4, row1);
-        r_xmm2 = _mm_subs_epi16(r_xmm2, r_xmm1);
-        r_xmm1 = _mm_adds_epi16(r_xmm0, r_xmm4);
-        r_xmm1 = _mm_adds_epi16(r_xmm1, one);
-        r_xmm4 = _mm_subs_epi16(r_xmm4, r_xmm0);
-        r_xmm6 = _mm_adds_epi16(r_xmm5, r_xmm2);
-        r_xmm5 = _mm_subs_epi16(r_xmm5, r_xmm2);
-        r_xmm5 = _mm_adds_epi16(r_xmm5, one);
-
-        __m128i temp7 = r_xmm1;
-        __m128i temp3 = r_xmm6;
-
-        r_xmm0 = _mm_shuffle_epi32(tg, 0xff);
-        r_xmm1 = _mm_subs_epi16(r_xmm4, r_xmm5);
-        r_xmm4 = _mm_adds_epi16(r_xmm4, r_xmm5);
-        r_xmm2 = _mm_mulhi_epi16(r_xmm0, r_xmm4);
-        r_xmm7 = _mm_adds_epi16(r_xmm7, row2);
-        r_xmm3 = _mm_subs_epi16(r_xmm3, row6);
-        r_xmm0 = _mm_mulhi_epi16(r_xmm0, r_xmm1);
-        r_xmm0 = _mm_adds_epi16(r_xmm0, r_xmm1);
-        r_xmm5 = _mm_adds_epi16(row0, row4);
-        r_xmm6 = _mm_subs_epi16(row0, row4);
-        r_xmm4 = _mm_adds_epi16(r_xmm4, r_xmm2);
-
-        r_xmm4 = _mm_or_si128(r_xmm4, one);
-        r_xmm0 = _mm_or_si128(r_xmm0, one);
+        __m128i v[8];
 
-        const s16 bias = 128 << 5;
-        const __m128i round_inv_col = _mm_set1_epi16(16 + bias);
-        const __m128i round_inv_corr = _mm_sub_epi16(round_inv_col, one);
-
-        r_xmm1 = _mm_subs_epi16(r_xmm6, r_xmm3);
-        r_xmm1 = _mm_adds_epi16(r_xmm1, round_inv_corr);
-        r_xmm2 = _mm_subs_epi16(r_xmm5, r_xmm7);
-        r_xmm2 = _mm_adds_epi16(r_xmm2, round_inv_corr);
-        r_xmm5 = _mm_adds_epi16(r_xmm5, r_xmm7);
-        r_xmm5 = _mm_adds_epi16(r_xmm5, round_inv_col);
-        r_xmm6 = _mm_adds_epi16(r_xmm6, r_xmm3);
-        r_xmm6 = _mm_adds_epi16(r_xmm6, round_inv_col);
-
-        __m128i r0 = _mm_adds_epi16(r_xmm5, temp7);
-        __m128i r1 = _mm_adds_epi16(r_xmm6, r_xmm4);
-        __m128i r2 = _mm_adds_epi16(r_xmm1, r_xmm0);
-        __m128i r3 = _mm_adds_epi16(r_xmm2, temp3);
-        __m128i r4 = _mm_subs_epi16(r_xmm2, temp3);
-        __m128i r5 = _mm_subs_epi16(r_xmm1, r_xmm0);
-        __m128i r6 = _mm_subs_epi16(r_xmm6, r_xmm4);
-        __m128i r7 = _mm_subs_epi16(r_xmm5, temp7);
-
-        r0 = _mm_srai_epi16(r0, 5);
-        r1 = _mm_srai_epi16(r1, 5);
-        r2 = _mm_srai_epi16(r2, 5);
-        r3 = _mm_srai_epi16(r3, 5);
-        r4 = _mm_srai_epi16(r4, 5);
-        r5 = _mm_srai_epi16(r5, 5);
-        r6 = _mm_srai_epi16(r6, 5);
-        r7 = _mm_srai_epi16(r7, 5);
-
-        __m128i s0 = _mm_packus_epi16(r0, r1);
-        __m128i s1 = _mm_packus_epi16(r2, r3);
-        __m128i s2 = _mm_packus_epi16(r4, r5);
-        __m128i s3 = _mm_packus_epi16(r6, r7);
+        for (int i = 0; i < 8; ++i)
+        {
+            v[i] = _mm_mullo_epi16(data[i], qtable[i]);
+        }
+
+        __m128i r[8];
+        ap922::sse2::idct(r, v);
+
+        __m128i s0 = _mm_packus_epi16(r[0], r[1]);
+        __m128i s1 = _mm_packus_epi16(r[2], r[3]);
+        __m128i s2 = _mm_packus_epi16(r[4], r[5]);
+        __m128i s3 = _mm_packus_epi16(r[6], r[7]);
 
         // store
         __m128i* d = reinterpret_cast<__m128i *>(dest);
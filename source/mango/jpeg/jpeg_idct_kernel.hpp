@@ -0,0 +1,141 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+
+// NOTE: no include guard; jpeg_idct_simd.hpp includes the kernel in a namespace for each
+// instruction set with the lane type S and its vector type V declared. The kernel is
+// compiled inside the target region of the instruction set so that it inlines the lane
+// functions and passes the vectors in registers.
+
+    // one dimensional transform of two rows: the rows a and b use the same table
+    static inline
+    void transform_rows(V& out_a, V& out_b, V a, V b, const s16* table_a, const s16* table_b)
+    {
+        const V round_inv_row = S::set32(2048);
+
+        V r_xmm0, r_xmm1, r_xmm2, r_xmm3, r_xmm4, r_xmm5, r_xmm6, r_xmm7;
+
+        r_xmm0 = S::shufflelo(a);
+        r_xmm1 = S::splat0(r_xmm0);
+        r_xmm1 = S::madd16(r_xmm1, S::table(table_a + 0));
+        r_xmm3 = S::splat1(r_xmm0);
+        r_xmm0 = S::shufflehi(r_xmm0);
+        r_xmm3 = S::madd16(r_xmm3, S::table(table_a + 16));
+        r_xmm2 = S::splat2(r_xmm0);
+        r_xmm0 = S::splat3(r_xmm0);
+        r_xmm2 = S::madd16(r_xmm2, S::table(table_a + 8));
+        r_xmm4 = S::shufflehi(b);
+        r_xmm1 = S::add32(r_xmm1, round_inv_row);
+        r_xmm4 = S::shufflelo(r_xmm4);
+        r_xmm0 = S::madd16(r_xmm0, S::table(table_a + 24));
+        r_xmm5 = S::splat0(r_xmm4);
+        r_xmm6 = S::splat2(r_xmm4);
+        r_xmm5 = S::madd16(r_xmm5, S::table(table_b + 0));
+        r_xmm1 = S::add32(r_xmm1, r_xmm2);
+        r_xmm7 = S::splat1(r_xmm4);
+        r_xmm6 = S::madd16(r_xmm6, S::table(table_b + 8));
+        r_xmm0 = S::add32(r_xmm0, r_xmm3);
+        r_xmm4 = S::splat3(r_xmm4);
+        r_xmm2 = S::sub32(r_xmm1, r_xmm0);
+        r_xmm7 = S::madd16(r_xmm7, S::table(table_b + 16));
+        r_xmm0 = S::add32(r_xmm0, r_xmm1);
+        r_xmm2 = S::srai32(r_xmm2, 12);
+        r_xmm5 = S::add32(r_xmm5, round_inv_row);
+        r_xmm4 = S::madd16(r_xmm4, S::table(table_b + 24));
+        r_xmm5 = S::add32(r_xmm5, r_xmm6);
+        r_xmm0 = S::srai32(r_xmm0, 12);
+        r_xmm2 = S::reverse(r_xmm2);
+        out_a = S::packs32(r_xmm0, r_xmm2);
+
+        r_xmm4 = S::add32(r_xmm4, r_xmm7);
+        r_xmm6 = S::sub32(r_xmm5, r_xmm4);
+        r_xmm4 = S::add32(r_xmm4, r_xmm5);
+        r_xmm6 = S::srai32(r_xmm6, 12);
+        r_xmm4 = S::srai32(r_xmm4, 12);
+        r_xmm6 = S::reverse(r_xmm6);
+        out_b = S::packs32(r_xmm4, r_xmm6);
+    }
+
+    // Inverse transform of dequantized coefficients; v[i] is row i of the block(s) and the
+    // result r[i] is row i of samples, biased to unsigned range but not yet clamped to 8 bits.
+    static inline
+    void idct(V* r, const V* v)
+    {
+        V row0, row1, row2, row3, row4, row5, row6, row7;
+
+        transform_rows(row0, row2, v[0], v[2], tab_i_04, tab_i_26);
+        transform_rows(row4, row6, v[4], v[6], tab_i_04, tab_i_26);
+        transform_rows(row3, row1, v[3], v[1], tab_i_35, tab_i_17);
+        transform_rows(row5, row7, v[5], v[7], tab_i_35, tab_i_17);
+
+        const V tg0 = S::set16(13036);
+        const V tg1 = S::set16(27146);
+        const V tg2 = S::set16(-21746);
+        const V tg3 = S::set16(-19195);
+        const V one = S::set16(1);
+
+        V r_xmm0, r_xmm1, r_xmm2, r_xmm3, r_xmm4, r_xmm5, r_xmm6, r_xmm7;
+
+        r_xmm1 = tg2;
+        r_xmm0 = S::mulhi16(r_xmm1, row5);
+        r_xmm1 = S::mulhi16(r_xmm1, row3);
+        r_xmm5 = tg0;
+        r_xmm4 = S::mulhi16(r_xmm5, row7);
+        r_xmm5 = S::mulhi16(r_xmm5, row1);
+        r_xmm0 = S::adds16(r_xmm0, row5);
+        r_xmm1 = S::adds16(r_xmm1, row3);
+        r_xmm0 = S::adds16(r_xmm0, row3);
+        r_xmm3 = tg1;
+        r_xmm7 = S::mulhi16(r_xmm3, row6);
+        r_xmm3 = S::mulhi16(r_xmm3, row2);
+        r_xmm5 = S::subs16(r_xmm5, row7);
+        r_xmm4 = S::adds16(r_xmm4, row1);
+        r_xmm2 = S::subs16(row5, r_xmm1);
+        r_xmm1 = S::adds16(r_xmm0, r_xmm4);
+        r_xmm1 = S::adds16(r_xmm1, one);
+        r_xmm4 = S::subs16(r_xmm4, r_xmm0);
+        r_xmm6 = S::adds16(r_xmm5, r_xmm2);
+        r_xmm5 = S::subs16(r_xmm5, r_xmm2);
+        r_xmm5 = S::adds16(r_xmm5, one);
+
+        V temp7 = r_xmm1;
+        V temp3 = r_xmm6;
+
+        r_xmm0 = tg3;
+        r_xmm1 = S::subs16(r_xmm4, r_xmm5);
+        r_xmm4 = S::adds16(r_xmm4, r_xmm5);
+        r_xmm2 = S::mulhi16(r_xmm0, r_xmm4);
+        r_xmm7 = S::adds16(r_xmm7, row2);
+        r_xmm3 = S::subs16(r_xmm3, row6);
+        r_xmm0 = S::mulhi16(r_xmm0, r_xmm1);
+        r_xmm0 = S::adds16(r_xmm0, r_xmm1);
+        r_xmm5 = S::adds16(row0, row4);
+        r_xmm6 = S::subs16(row0, row4);
+        r_xmm4 = S::adds16(r_xmm4, r_xmm2);
+
+        r_xmm4 = S::bitwise_or(r_xmm4, one);
+        r_xmm0 = S::bitwise_or(r_xmm0, one);
+
+        const s16 bias = 128 << 5;
+        const V round_inv_col = S::set16(16 + bias);
+        const V round_inv_corr = S::subs16(round_inv_col, one);
+
+        r_xmm1 = S::subs16(r_xmm6, r_xmm3);
+        r_xmm1 = S::adds16(r_xmm1, round_inv_corr);
+        r_xmm2 = S::subs16(r_xmm5, r_xmm7);
+        r_xmm2 = S::adds16(r_xmm2, round_inv_corr);
+        r_xmm5 = S::adds16(r_xmm5, r_xmm7);
+        r_xmm5 = S::adds16(r_xmm5, round_inv_col);
+        r_xmm6 = S::adds16(r_xmm6, r_xmm3);
+        r_xmm6 = S::adds16(r_xmm6, round_inv_col);
+
+        r[0] = S::srai16(S::adds16(r_xmm5, temp7), 5);
+        r[1] = S::srai16(S::adds16(r_xmm6, r_xmm4), 5);
+        r[2] = S::srai16(S::adds16(r_xmm1, r_xmm0), 5);
+        r[3] = S::srai16(S::adds16(r_xmm2, temp3), 5);
+        r[4] = S::srai16(S::subs16(r_xmm2, temp3), 5);
+        r[5] = S::srai16(S::subs16(r_xmm1, r_xmm0), 5);
+        r[6] = S::srai16(S::subs16(r_xmm6, r_xmm4), 5);
+        r[7] = S::srai16(S::subs16(r_xmm5, temp7), 5);
+    }
@@ -0,0 +1,213 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include "jpeg.hpp"
+
+// Copyright 2009 Intel Corporation
+// All Rights Reserved
+//
+// Permission is granted to use, copy, distribute and prepare derivative works of this
+// software for any purpose and without fee, provided, that the above copyright notice
+// and this statement appear in all copies.  Intel makes no representations about the
+// suitability of this software for any purpose.  THIS SOFTWARE IS PROVIDED "AS IS."
+// INTEL SPECIFICALLY DISCLAIMS ALL WARRANTIES, EXPRESS OR IMPLIED, AND ALL LIABILITY,
+// INCLUDING CONSEQUENTIAL AND OTHER INDIRECT DAMAGES, FOR THE USE OF THIS SOFTWARE,
+// INCLUDING LIABILITY FOR INFRINGEMENT OF ANY PROPRIETARY RIGHTS, AND INCLUDING THE
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  Intel does not
+// assume any responsibility for any errors which may appear in this software nor any
+// responsibility to update it.
+//
+// From:
+// https://software.intel.com/sites/default/files/m/d/4/1/d/8/UsingIntelAVXToImplementIDCT-r1_5.pdf
+// https://software.intel.com/file/29048
+//
+// Requires SSE
+//
+
+// The transform only uses operations which work independently in each 128 bit lane so
+// wider vectors transform one 8x8 block per lane: AVX2 does two and AVX-512 four blocks
+// at a time. The kernel in jpeg_idct_kernel.hpp is shared by the SSE2 idct and the fused
+// AVX2 / AVX-512 decoding functions which convert the color straight from the registers;
+// it is included in the target region of each instruction set as ap922::sse2::idct(),
+// ap922::avx2::idct() and ap922::avx512::idct().
+
+namespace mango::image::jpeg::ap922
+{
+
+    // Table for rows 0,4 - constants are multiplied on cos_4_16
+    alignas(16) static const
+    s16 tab_i_04 [] =
+    {
+        16384, 21407, 16384, 8867, 16384, -8867, 16384, -21407,
+        16384, 8867, -16384, -21407, -16384, 21407, 16384, -8867,
+        22725, 19266, 19266, -4520, 12873, -22725, 4520, -12873,
+        12873, 4520, -22725, -12873, 4520, 19266, 19266, -22725
+    };
+
+    // Table for rows 1,7 - constants are multiplied on cos_1_16
+    alignas(16) static const
+    s16 tab_i_17 [] =
+    {
+        22725, 29692, 22725, 12299, 22725, -12299, 22725, -29692,
+        22725, 12299, -22725, -29692, -22725, 29692, 22725, -12299,
+        31521, 26722, 26722, -6270, 17855, -31521, 6270, -17855,
+        17855, 6270, -31521, -17855, 6270, 26722, 26722, -31521
+    };
+
+    // Table for rows 2,6 - constants are multiplied on cos_2_16
+    alignas(16) static const
+    s16 tab_i_26 [] =
+    {
+        21407, 27969, 21407, 11585, 21407, -11585, 21407, -27969,
+        21407, 11585, -21407, -27969, -21407, 27969, 21407, -11585,
+        29692, 25172, 25172, -5906, 16819, -29692, 5906, -16819,
+        16819, 5906, -29692, -16819, 5906, 25172, 25172, -29692
+    };
+
+    // Table for rows 3,5 - constants are multiplied on cos_3_16
+    alignas(16) static const
+    s16 tab_i_35 [] =
+    {
+        19266, 25172, 19266, 10426, 19266, -10426, 19266, -25172,
+        19266, 10426, -19266, -25172, -19266, 25172, 19266, -10426,
+        26722, 22654, 22654, -5315, 15137, -26722, 5315, -15137,
+        15137, 5315, -26722, -15137, 5315, 22654, 22654, -26722
+    };
+
+#if defined(MANGO_ENABLE_SSE2)
+
+    struct SSE2
+    {
+        using V = __m128i;
+
+        static V table(const s16* p) { return _mm_load_si128(reinterpret_cast<const __m128i *>(p)); }
+        static V set16(s16 x) { return _mm_set1_epi16(x); }
+        static V set32(s32 x) { return _mm_set1_epi32(x); }
+
+        static V shufflelo(V a) { return _mm_shufflelo_epi16(a, 0xd8); }
+        static V shufflehi(V a) { return _mm_shufflehi_epi16(a, 0xd8); }
+        static V splat0(V a) { return _mm_shuffle_epi32(a, 0x00); }
+        static V splat1(V a) { return _mm_shuffle_epi32(a, 0x55); }
+        static V splat2(V a) { return _mm_shuffle_epi32(a, 0xaa); }
+        static V splat3(V a) { return _mm_shuffle_epi32(a, 0xff); }
+        static V reverse(V a) { return _mm_shuffle_epi32(a, 0x1b); }
+
+        static V madd16(V a, V b) { return _mm_madd_epi16(a, b); }
+        static V mulhi16(V a, V b) { return _mm_mulhi_epi16(a, b); }
+        static V adds16(V a, V b) { return _mm_adds_epi16(a, b); }
+        static V subs16(V a, V b) { return _mm_subs_epi16(a, b); }
+        static V srai16(V a, int n) { return _mm_srai_epi16(a, n); }
+        static V add32(V a, V b) { return _mm_add_epi32(a, b); }
+        static V sub32(V a, V b) { return _mm_sub_epi32(a, b); }
+        static V srai32(V a, int n) { return _mm_srai_epi32(a, n); }
+        static V packs32(V a, V b) { return _mm_packs_epi32(a, b); }
+        static V bitwise_or(V a, V b) { return _mm_or_si128(a, b); }
+    };
+
+    namespace sse2
+    {
+        using S = SSE2;
+        using V = S::V;
+
+#include "jpeg_idct_kernel.hpp"
+
+    } // namespace sse2
+
+#endif // MANGO_ENABLE_SSE2
+
+#if defined(MANGO_DISPATCH_AVX2)
+MANGO_TARGET_BEGIN_AVX2
+
+    struct AVX2
+    {
+        using V = __m256i;
+
+        static V table(const s16* p) { return _mm256_broadcastsi128_si256(SSE2::table(p)); }
+        static V set16(s16 x) { return _mm256_set1_epi16(x); }
+        static V set32(s32 x) { return _mm256_set1_epi32(x); }
+
+        static V shufflelo(V a) { return _mm256_shufflelo_epi16(a, 0xd8); }
+        static V shufflehi(V a) { return _mm256_shufflehi_epi16(a, 0xd8); }
+        static V splat0(V a) { return _mm256_shuffle_epi32(a, 0x00); }
+        static V splat1(V a) { return _mm256_shuffle_epi32(a, 0x55); }
+        static V splat2(V a) { return _mm256_shuffle_epi32(a, 0xaa); }
+        static V splat3(V a) { return _mm256_shuffle_epi32(a, 0xff); }
+        static V reverse(V a) { return _mm256_shuffle_epi32(a, 0x1b); }
+
+        static V madd16(V a, V b) { return _mm256_madd_epi16(a, b); }
+        static V mulhi16(V a, V b) { return _mm256_mulhi_epi16(a, b); }
+        static V adds16(V a, V b) { return _mm256_adds_epi16(a, b); }
+        static V subs16(V a, V b) { return _mm256_subs_epi16(a, b); }
+        static V srai16(V a, int n) { return _mm256_srai_epi16(a, n); }
+        static V add32(V a, V b) { return _mm256_add_epi32(a, b); }
+        static V sub32(V a, V b) { return _mm256_sub_epi32(a, b); }
+        static V srai32(V a, int n) { return _mm256_srai_epi32(a, n); }
+        static V packs32(V a, V b) { return _mm256_packs_epi32(a, b); }
+        static V bitwise_or(V a, V b) { return _mm256_or_si256(a, b); }
+    };
+
+    namespace avx2
+    {
+        using S = AVX2;
+        using V = S::V;
+
+#include "jpeg_idct_kernel.hpp"
+
+    } // namespace avx2
+
+MANGO_TARGET_END
+#endif // MANGO_DISPATCH_AVX2
+
+#if defined(MANGO_DISPATCH_AVX512)
+MANGO_TARGET_BEGIN_AVX512
+
+    // The unmasked forms of the broadcast, shuffle and shift intrinsics pass an uninitialized
+    // vector as the merge source in the GCC 12 headers which trips -Wuninitialized; the
+    // zero-masking forms with all lanes enabled compile to the same instructions.
+
+    struct AVX512
+    {
+        using V = __m512i;
+
+        static constexpr __mmask16 all = 0xffff;
+
+        static V table(const s16* p) { return _mm512_maskz_broadcast_i32x4(all, SSE2::table(p)); }
+        static V set16(s16 x) { return _mm512_set1_epi16(x); }
+        static V set32(s32 x) { return _mm512_set1_epi32(x); }
+
+        static V shufflelo(V a) { return _mm512_shufflelo_epi16(a, 0xd8); }
+        static V shufflehi(V a) { return _mm512_shufflehi_epi16(a, 0xd8); }
+        static V splat0(V a) { return _mm512_maskz_shuffle_epi32(all, a, _MM_PERM_AAAA); }
+        static V splat1(V a) { return _mm512_maskz_shuffle_epi32(all, a, _MM_PERM_BBBB); }
+        static V splat2(V a) { return _mm512_maskz_shuffle_epi32(all, a, _MM_PERM_CCCC); }
+        static V splat3(V a) { return _mm512_maskz_shuffle_epi32(all, a, _MM_PERM_DDDD); }
+        static V reverse(V a) { return _mm512_maskz_shuffle_epi32(all, a, _MM_PERM_ABCD); }
+
+        static V madd16(V a, V b) { return _mm512_madd_epi16(a, b); }
+        static V mulhi16(V a, V b) { return _mm512_mulhi_epi16(a, b); }
+        static V adds16(V a, V b) { return _mm512_adds_epi16(a, b); }
+        static V subs16(V a, V b) { return _mm512_subs_epi16(a, b); }
+        static V srai16(V a, int n) { return _mm512_srai_epi16(a, n); }
+        static V add32(V a, V b) { return _mm512_add_epi32(a, b); }
+        static V sub32(V a, V b) { return _mm512_sub_epi32(a, b); }
+        static V srai32(V a, int n) { return _mm512_maskz_srai_epi32(all, a, n); }
+        static V packs32(V a, V b) { return _mm512_packs_epi32(a, b); }
+        static V bitwise_or(V a, V b) { return _mm512_or_si512(a, b); }
+    };
+
+    namespace avx512
+    {
+        using S = AVX512;
+        using V = S::V;
+
+#include "jpeg_idct_kernel.hpp"
+
+    } // namespace avx512
+
+MANGO_TARGET_END
+#endif // MANGO_DISPATCH_AVX512
+
+} // namespace mango::image::jpeg::ap922
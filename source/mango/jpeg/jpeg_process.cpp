@@ -3,6 +3,7 @@
     Copyright (C) 2012-2024 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
 #include "jpeg.hpp"
+#include "jpeg_idct_simd.hpp"
 
 namespace mango::image::jpeg
 {
@@ -297,6 +298,7 @@ void write_color_rgb(u8* dest, int y, int r, int g, int b)
 #define FUNCTION_YCBCR_8x16    process_ycbcr_bgra_8x16
 #define FUNCTION_YCBCR_16x8    process_ycbcr_bgra_16x8
 #define FUNCTION_YCBCR_16x16   process_ycbcr_bgra_16x16
+#define FUNCTION_YCBCR_ROW     process_ycbcr_bgra_row
 #include "jpeg_process_func.hpp"
 #undef WRITE_COLOR
 #undef XSTEP
@@ -305,6 +307,7 @@ void write_color_rgb(u8* dest, int y, int r, int g, int b)
 #undef FUNCTION_YCBCR_8x16
 #undef FUNCTION_YCBCR_16x8
 #undef FUNCTION_YCBCR_16x16
+#undef FUNCTION_YCBCR_ROW
 
 // Generate YCBCR to RGBA functions
 #define WRITE_COLOR            write_color_rgba
@@ -314,6 +317,7 @@ void write_color_rgb(u8* dest, int y, int r, int g, int b)
 #define FUNCTION_YCBCR_8x16    process_ycbcr_rgba_8x16
 #define FUNCTION_YCBCR_16x8    process_ycbcr_rgba_16x8
 #define FUNCTION_YCBCR_16x16   process_ycbcr_rgba_16x16
+#define FUNCTION_YCBCR_ROW     process_ycbcr_rgba_row
 #include "jpeg_process_func.hpp"
 #undef WRITE_COLOR
 #undef XSTEP
@@ -322,6 +326,7 @@ void write_color_rgb(u8* dest, int y, int r, int g, int b)
 #undef FUNCTION_YCBCR_8x16
 #undef FUNCTION_YCBCR_16x8
 #undef FUNCTION_YCBCR_16x16
+#undef FUNCTION_YCBCR_ROW
 
 // Generate YCBCR to BGR functions
 #define WRITE_COLOR            write_color_bgr
@@ -331,6 +336,7 @@ void write_color_rgb(u8* dest, int y, int r, int g, int b)
 #define FUNCTION_YCBCR_8x16    process_ycbcr_bgr_8x16
 #define FUNCTION_YCBCR_16x8    process_ycbcr_bgr_16x8
 #define FUNCTION_YCBCR_16x16   process_ycbcr_bgr_16x16
+#define FUNCTION_YCBCR_ROW     process_ycbcr_bgr_row
 #include "jpeg_process_func.hpp"
 #undef WRITE_COLOR
 #undef XSTEP
@@ -339,6 +345,7 @@ void write_color_rgb(u8* dest, int y, int r, int g, int b)
 #undef FUNCTION_YCBCR_8x16
 #undef FUNCTION_YCBCR_16x8
 #undef FUNCTION_YCBCR_16x16
+#undef FUNCTION_YCBCR_ROW
 
 // Generate YCBCR to RGB functions
 #define WRITE_COLOR            write_color_rgb
@@ -348,6 +355,7 @@ void write_color_rgb(u8* dest, int y, int r, int g, int b)
 #define FUNCTION_YCBCR_8x16    process_ycbcr_rgb_8x16
 #define FUNCTION_YCBCR_16x8    process_ycbcr_rgb_16x8
 #define FUNCTION_YCBCR_16x16   process_ycbcr_rgb_16x16
+#define FUNCTION_YCBCR_ROW     process_ycbcr_rgb_row
 #include "jpeg_process_func.hpp"
 #undef WRITE_COLOR
 #undef XSTEP
@@ -356,6 +364,44 @@ void write_color_rgb(u8* dest, int y, int r, int g, int b)
 #undef FUNCTION_YCBCR_8x16
 #undef FUNCTION_YCBCR_16x8
 #undef FUNCTION_YCBCR_16x16
+#undef FUNCTION_YCBCR_ROW
+
+// ----------------------------------------------------------------------------
+// Fancy upsampling
+// ----------------------------------------------------------------------------
+
+/*
+    Triangle filter chroma upsampling, which libjpeg calls "fancy upsampling". Each output
+    sample is 3/4 of the nearest chroma sample and 1/4 of the next nearest one. This places
+    the output samples between the input samples the same way as libjpeg does.
+
+    The caller replicates the edge samples into src[-1] and src[width] (and the same in the
+    neighbour row). The filters then need no special cases at the edges. The rows are padded
+    so the SIMD versions may read and write past the end in whole vectors.
+*/
+
+void upsample_h2v1(u8* dest, const u8* src, int width)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        int s = src[x] * 3;
+        dest[x * 2 + 0] = u8((s + src[x - 1] + 1) >> 2);
+        dest[x * 2 + 1] = u8((s + src[x + 1] + 2) >> 2);
+    }
+}
+
+void upsample_h2v2(u8* dest, const u8* src, const u8* neighbor, int width)
+{
+    // neighbor is the chroma row above or below the output row
+    for (int x = 0; x < width; ++x)
+    {
+        int s0 = src[x - 1] * 3 + neighbor[x - 1];
+        int s1 = src[x + 0] * 3 + neighbor[x + 0];
+        int s2 = src[x + 1] * 3 + neighbor[x + 1];
+        dest[x * 2 + 0] = u8((s1 * 3 + s0 + 8) >> 4);
+        dest[x * 2 + 1] = u8((s1 * 3 + s2 + 7) >> 4);
+    }
+}
 
 #undef COMPUTE_CBCR
 
@@ -449,6 +495,7 @@ void convert_ycbcr_rgb_8x1_neon(u8* dest, int16x8_t y, int16x8_t cb, int16x8_t c
 #define FUNCTION_YCBCR_8x16  process_ycbcr_bgra_8x16_neon
 #define FUNCTION_YCBCR_16x8  process_ycbcr_bgra_16x8_neon
 #define FUNCTION_YCBCR_16x16 process_ycbcr_bgra_16x16_neon
+#define FUNCTION_YCBCR_ROW   process_ycbcr_bgra_row_neon
 #include "jpeg_process_neon.hpp"
 #undef INNERLOOP_YCBCR
 #undef XSTEP
@@ -456,6 +503,7 @@ void convert_ycbcr_rgb_8x1_neon(u8* dest, int16x8_t y, int16x8_t cb, int16x8_t c
 #undef FUNCTION_YCBCR_8x16
 #undef FUNCTION_YCBCR_16x8
 #undef FUNCTION_YCBCR_16x16
+#undef FUNCTION_YCBCR_ROW
 
 // Generate YCBCR to RGBA functions
 #define INNERLOOP_YCBCR      convert_ycbcr_rgba_8x1_neon
@@ -464,6 +512,7 @@ void convert_ycbcr_rgb_8x1_neon(u8* dest, int16x8_t y, int16x8_t cb, int16x8_t c
 #define FUNCTION_YCBCR_8x16  process_ycbcr_rgba_8x16_neon
 #define FUNCTION_YCBCR_16x8  process_ycbcr_rgba_16x8_neon
 #define FUNCTION_YCBCR_16x16 process_ycbcr_rgba_16x16_neon
+#define FUNCTION_YCBCR_ROW   process_ycbcr_rgba_row_neon
 #include "jpeg_process_neon.hpp"
 #undef INNERLOOP_YCBCR
 #undef XSTEP
@@ -471,6 +520,7 @@ void convert_ycbcr_rgb_8x1_neon(u8* dest, int16x8_t y, int16x8_t cb, int16x8_t c
 #undef FUNCTION_YCBCR_8x16
 #undef FUNCTION_YCBCR_16x8
 #undef FUNCTION_YCBCR_16x16
+#undef FUNCTION_YCBCR_ROW
 
 // Generate YCBCR to BGR functions
 #define INNERLOOP_YCBCR      convert_ycbcr_bgr_8x1_neon
@@ -479,6 +529,7 @@ void convert_ycbcr_rgb_8x1_neon(u8* dest, int16x8_t y, int16x8_t cb, int16x8_t c
 #define FUNCTION_YCBCR_8x16  process_ycbcr_bgr_8x16_neon
 #define FUNCTION_YCBCR_16x8  process_ycbcr_bgr_16x8_neon
 #define FUNCTION_YCBCR_16x16 process_ycbcr_bgr_16x16_neon
+#define FUNCTION_YCBCR_ROW   process_ycbcr_bgr_row_neon
 #include "jpeg_process_neon.hpp"
 #undef INNERLOOP_YCBCR
 #undef XSTEP
@@ -486,6 +537,7 @@ void convert_ycbcr_rgb_8x1_neon(u8* dest, int16x8_t y, int16x8_t cb, int16x8_t c
 #undef FUNCTION_YCBCR_8x16
 #undef FUNCTION_YCBCR_16x8
 #undef FUNCTION_YCBCR_16x16
+#undef FUNCTION_YCBCR_ROW
 
 // Generate YCBCR to RGB functions
 #define INNERLOOP_YCBCR      convert_ycbcr_rgb_8x1_neon
@@ -494,6 +546,7 @@ void convert_ycbcr_rgb_8x1_neon(u8* dest, int16x8_t y, int16x8_t cb, int16x8_t c
 #define FUNCTION_YCBCR_8x16  process_ycbcr_rgb_8x16_neon
 #define FUNCTION_YCBCR_16x8  process_ycbcr_rgb_16x8_neon
 #define FUNCTION_YCBCR_16x16 process_ycbcr_rgb_16x16_neon
+#define FUNCTION_YCBCR_ROW   process_ycbcr_rgb_row_neon
 #include "jpeg_process_neon.hpp"
 #undef INNERLOOP_YCBCR
 #undef XSTEP
@@ -501,6 +554,63 @@ void convert_ycbcr_rgb_8x1_neon(u8* dest, int16x8_t y, int16x8_t cb, int16x8_t c
 #undef FUNCTION_YCBCR_8x16
 #undef FUNCTION_YCBCR_16x8
 #undef FUNCTION_YCBCR_16x16
+#undef FUNCTION_YCBCR_ROW
+
+void upsample_h2v1_neon(u8* dest, const u8* src, int width)
+{
+    const uint8x16_t three = vdupq_n_u8(3);
+    const uint16x8_t one = vdupq_n_u16(1);
+
+    for (int x = 0; x < width; x += 16)
+    {
+        uint8x16_t s0 = vld1q_u8(src + x - 1);
+        uint8x16_t s1 = vld1q_u8(src + x + 0);
+        uint8x16_t s2 = vld1q_u8(src + x + 1);
+
+        uint16x8_t lo = vmull_u8(vget_low_u8(s1), vget_low_u8(three));
+        uint16x8_t hi = vmull_u8(vget_high_u8(s1), vget_high_u8(three));
+
+        uint8x16x2_t result;
+
+        // (s * 3 + left + 1) >> 2
+        uint16x8_t even_lo = vaddq_u16(vaddw_u8(lo, vget_low_u8(s0)), one);
+        uint16x8_t even_hi = vaddq_u16(vaddw_u8(hi, vget_high_u8(s0)), one);
+        result.val[0] = vcombine_u8(vshrn_n_u16(even_lo, 2), vshrn_n_u16(even_hi, 2));
+
+        // (s * 3 + right + 2) >> 2
+        uint16x8_t odd_lo = vaddw_u8(lo, vget_low_u8(s2));
+        uint16x8_t odd_hi = vaddw_u8(hi, vget_high_u8(s2));
+        result.val[1] = vcombine_u8(vrshrn_n_u16(odd_lo, 2), vrshrn_n_u16(odd_hi, 2));
+
+        vst2q_u8(dest + x * 2, result);
+    }
+}
+
+void upsample_h2v2_neon(u8* dest, const u8* src, const u8* neighbor, int width)
+{
+    const uint8x8_t three = vdup_n_u8(3);
+    const uint16x8_t seven = vdupq_n_u16(7);
+
+    for (int x = 0; x < width; x += 8)
+    {
+        // column sums: src * 3 + neighbor
+        uint16x8_t s0 = vmlal_u8(vmovl_u8(vld1_u8(neighbor + x - 1)), vld1_u8(src + x - 1), three);
+        uint16x8_t s1 = vmlal_u8(vmovl_u8(vld1_u8(neighbor + x + 0)), vld1_u8(src + x + 0), three);
+        uint16x8_t s2 = vmlal_u8(vmovl_u8(vld1_u8(neighbor + x + 1)), vld1_u8(src + x + 1), three);
+
+        uint16x8_t s = vmulq_n_u16(s1, 3);
+
+        uint8x8x2_t result;
+
+        // (s * 3 + left + 8) >> 4
+        result.val[0] = vrshrn_n_u16(vaddq_u16(s, s0), 4);
+
+        // (s * 3 + right + 7) >> 4
+        result.val[1] = vshrn_n_u16(vaddq_u16(vaddq_u16(s, s2), seven), 4);
+
+        vst2_u8(dest + x * 2, result);
+    }
+}
 
 #endif // MANGO_ENABLE_NEON
 
@@ -633,6 +743,7 @@ void convert_ycbcr_rgba_8x1_sse2(u8* dest, __m128i y, __m128i cb, __m128i cr, __
 #define FUNCTION_YCBCR_8x16  process_ycbcr_bgra_8x16_sse2
 #define FUNCTION_YCBCR_16x8  process_ycbcr_bgra_16x8_sse2
 #define FUNCTION_YCBCR_16x16 process_ycbcr_bgra_16x16_sse2
+#define FUNCTION_YCBCR_ROW   process_ycbcr_bgra_row_sse2
 #include "jpeg_process_sse2.hpp"
 #undef INNERLOOP_YCBCR
 #undef XSTEP
@@ -640,6 +751,7 @@ void convert_ycbcr_rgba_8x1_sse2(u8* dest, __m128i y, __m128i cb, __m128i cr, __
 #undef FUNCTION_YCBCR_8x16
 #undef FUNCTION_YCBCR_16x8
 #undef FUNCTION_YCBCR_16x16
+#undef FUNCTION_YCBCR_ROW
 
 // Generate YCBCR to RGBA functions
 #define INNERLOOP_YCBCR      convert_ycbcr_rgba_8x1_sse2
@@ -648,6 +760,7 @@ void convert_ycbcr_rgba_8x1_sse2(u8* dest, __m128i y, __m128i cb, __m128i cr, __
 #define FUNCTION_YCBCR_8x16  process_ycbcr_rgba_8x16_sse2
 #define FUNCTION_YCBCR_16x8  process_ycbcr_rgba_16x8_sse2
 #define FUNCTION_YCBCR_16x16 process_ycbcr_rgba_16x16_sse2
+#define FUNCTION_YCBCR_ROW   process_ycbcr_rgba_row_sse2
 #include "jpeg_process_sse2.hpp"
 #undef INNERLOOP_YCBCR
 #undef XSTEP
@@ -655,6 +768,83 @@ void convert_ycbcr_rgba_8x1_sse2(u8* dest, __m128i y, __m128i cb, __m128i cr, __
 #undef FUNCTION_YCBCR_8x16
 #undef FUNCTION_YCBCR_16x8
 #undef FUNCTION_YCBCR_16x16
+#undef FUNCTION_YCBCR_ROW
+
+static inline
+__m128i upsample_h2v1_8x1_sse2(__m128i s0, __m128i s1, __m128i s2)
+{
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i two = _mm_set1_epi16(2);
+
+    __m128i s = _mm_add_epi16(s1, _mm_add_epi16(s1, s1));
+    __m128i even = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(s, s0), one), 2);
+    __m128i odd = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(s, s2), two), 2);
+
+    return _mm_packus_epi16(_mm_unpacklo_epi16(even, odd), _mm_unpackhi_epi16(even, odd));
+}
+
+static inline
+__m128i upsample_h2v2_8x1_sse2(__m128i s0, __m128i s1, __m128i s2)
+{
+    const __m128i seven = _mm_set1_epi16(7);
+    const __m128i eight = _mm_set1_epi16(8);
+
+    __m128i s = _mm_add_epi16(s1, _mm_add_epi16(s1, s1));
+    __m128i even = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(s, s0), eight), 4);
+    __m128i odd = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(s, s2), seven), 4);
+
+    return _mm_packus_epi16(_mm_unpacklo_epi16(even, odd), _mm_unpackhi_epi16(even, odd));
+}
+
+void upsample_h2v1_sse2(u8* dest, const u8* src, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int x = 0; x < width; x += 16)
+    {
+        __m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x - 1));
+        __m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x + 0));
+        __m128i s2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x + 1));
+
+        __m128i lo = upsample_h2v1_8x1_sse2(_mm_unpacklo_epi8(s0, zero), _mm_unpacklo_epi8(s1, zero), _mm_unpacklo_epi8(s2, zero));
+        __m128i hi = upsample_h2v1_8x1_sse2(_mm_unpackhi_epi8(s0, zero), _mm_unpackhi_epi8(s1, zero), _mm_unpackhi_epi8(s2, zero));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x * 2 +  0), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x * 2 + 16), hi);
+    }
+}
+
+void upsample_h2v2_sse2(u8* dest, const u8* src, const u8* neighbor, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int x = 0; x < width; x += 16)
+    {
+        __m128i s[3];
+        __m128i n[3];
+
+        for (int i = 0; i < 3; ++i)
+        {
+            s[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x + i - 1));
+            n[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(neighbor + x + i - 1));
+        }
+
+        // column sums: src * 3 + neighbor
+        __m128i lo[3];
+        __m128i hi[3];
+
+        for (int i = 0; i < 3; ++i)
+        {
+            __m128i s_lo = _mm_unpacklo_epi8(s[i], zero);
+            __m128i s_hi = _mm_unpackhi_epi8(s[i], zero);
+            lo[i] = _mm_add_epi16(_mm_add_epi16(s_lo, _mm_add_epi16(s_lo, s_lo)), _mm_unpacklo_epi8(n[i], zero));
+            hi[i] = _mm_add_epi16(_mm_add_epi16(s_hi, _mm_add_epi16(s_hi, s_hi)), _mm_unpackhi_epi8(n[i], zero));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x * 2 +  0), upsample_h2v2_8x1_sse2(lo[0], lo[1], lo[2]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x * 2 + 16), upsample_h2v2_8x1_sse2(hi[0], hi[1], hi[2]));
+    }
+}
 
 #endif // MANGO_ENABLE_SSE2
 
@@ -787,6 +977,7 @@ void convert_ycbcr_rgb_8x1_sse41(u8* dest, __m128i y, __m128i cb, __m128i cr, __
 #define FUNCTION_YCBCR_8x16  process_ycbcr_bgr_8x16_sse41
 #define FUNCTION_YCBCR_16x8  process_ycbcr_bgr_16x8_sse41
 #define FUNCTION_YCBCR_16x16 process_ycbcr_bgr_16x16_sse41
+#define FUNCTION_YCBCR_ROW   process_ycbcr_bgr_row_sse41
 #include "jpeg_process_sse2.hpp"
 #undef INNERLOOP_YCBCR
 #undef XSTEP
@@ -794,6 +985,7 @@ void convert_ycbcr_rgb_8x1_sse41(u8* dest, __m128i y, __m128i cb, __m128i cr, __
 #undef FUNCTION_YCBCR_8x16
 #undef FUNCTION_YCBCR_16x8
 #undef FUNCTION_YCBCR_16x16
+#undef FUNCTION_YCBCR_ROW
 
 // Generate YCBCR to RGB functions
 #define INNERLOOP_YCBCR      convert_ycbcr_rgb_8x1_sse41
@@ -802,6 +994,7 @@ void convert_ycbcr_rgb_8x1_sse41(u8* dest, __m128i y, __m128i cb, __m128i cr, __
 #define FUNCTION_YCBCR_8x16  process_ycbcr_rgb_8x16_sse41
 #define FUNCTION_YCBCR_16x8  process_ycbcr_rgb_16x8_sse41
 #define FUNCTION_YCBCR_16x16 process_ycbcr_rgb_16x16_sse41
+#define FUNCTION_YCBCR_ROW   process_ycbcr_rgb_row_sse41
 #include "jpeg_process_sse2.hpp"
 #undef INNERLOOP_YCBCR
 #undef XSTEP
@@ -809,6 +1002,7 @@ void convert_ycbcr_rgb_8x1_sse41(u8* dest, __m128i y, __m128i cb, __m128i cr, __
 #undef FUNCTION_YCBCR_8x16
 #undef FUNCTION_YCBCR_16x8
 #undef FUNCTION_YCBCR_16x16
+#undef FUNCTION_YCBCR_ROW
 
 #endif // MANGO_ENABLE_SSE4_1
 
@@ -816,12 +1010,19 @@ void convert_ycbcr_rgb_8x1_sse41(u8* dest, __m128i y, __m128i cb, __m128i cr, __
 // AVX2 implementation
 // ------------------------------------------------------------------------------------------------
 
-#if defined(MANGO_ENABLE_AVX2)
+#if defined(MANGO_DISPATCH_AVX2)
+MANGO_TARGET_BEGIN_AVX2
+
+// The AVX2 and AVX-512 functions are fused: the blocks are transformed two (AVX2) or four
+// (AVX-512) at a time and the color conversion reads the samples straight from the registers
+// without storing the transformed blocks into memory. The transform is the same as in idct_sse2()
+// so these can be used only with 8 bit precision.
 
 #define JPEG_CONST_AVX2(x, y) _mm256_setr_epi16(x, y, x, y, x, y, x, y, x, y, x, y, x, y, x, y)
 
+template <bool bgra>
 static inline
-u8* convert_ycbcr_rgba_8x2_avx2(u8* dest, size_t stride, __m256i y, __m256i cb, __m256i cr, __m256i alpha, __m256i s0, __m256i s1, __m256i s2, __m256i rounding)
+void convert_ycbcr_8x2_avx2(u8* dest0, u8* dest1, __m256i y, __m256i cb, __m256i cr, __m256i alpha, __m256i s0, __m256i s1, __m256i s2, __m256i rounding)
 {
     __m256i zero = _mm256_setzero_si256();
 
@@ -860,6 +1061,11 @@ u8* convert_ycbcr_rgba_8x2_avx2(u8* dest, size_t stride, __m256i y, __m256i cb,
     __m256i b = _mm256_packs_epi32(b_l, b_h);
     __m256i a = alpha; // can't be generated: 0xffff (-1) will become 0 with packus (signed saturation)
 
+    if constexpr (bgra)
+    {
+        std::swap(r, b);
+    }
+
     __m256i rb = _mm256_packus_epi16(r, b);        // RRRRRRRRBBBBBBBB
     __m256i ga = _mm256_packus_epi16(g, a);        // GGGGGGGGAAAAAAAA
     __m256i rg = _mm256_unpacklo_epi8(rb, ga);     // RGRGRGRGRGRGRGRG
@@ -870,22 +1076,119 @@ u8* convert_ycbcr_rgba_8x2_avx2(u8* dest, size_t stride, __m256i y, __m256i cb,
     __m256i color0 = _mm256_permute2x128_si256(rgba0, rgba1, 0x20);
     __m256i color1 = _mm256_permute2x128_si256(rgba0, rgba1, 0x31);
 
-    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest +  0), color0);
-    dest += stride;
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest0), color0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest1), color1);
+}
 
-    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest +  0), color1);
-    dest += stride;
+static inline
+__m256i load_2x8_avx2(const s16* p0, const s16* p1)
+{
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p0));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p1));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(a), b, 1);
+}
 
-    return dest;
+// horizontal 2x upsampling of the chroma row; the input is [Cb | Cr]
+static inline
+void upsample_cbcr_avx2(__m256i& cb, __m256i& cr, __m256i cbcr, __m256i tosigned)
+{
+    __m256i lo = _mm256_unpacklo_epi16(cbcr, cbcr);
+    __m256i hi = _mm256_unpackhi_epi16(cbcr, cbcr);
+    cb = _mm256_sub_epi16(_mm256_permute2x128_si256(lo, hi, 0x20), tosigned);
+    cr = _mm256_sub_epi16(_mm256_permute2x128_si256(lo, hi, 0x31), tosigned);
 }
 
-void process_ycbcr_rgba_8x8_avx2(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+// Inverse transform of two blocks: the rows of the first block are in the low and the second
+// block in the high 128 bit lane. The samples are clamped to 8 bits but not packed.
+static inline
+void idct_2x8_avx2(__m256i* r, const s16* data0, const s16* data1, const s16* qt0, const s16* qt1)
+{
+    __m256i v[8];
+
+    for (int i = 0; i < 8; ++i)
+    {
+        v[i] = _mm256_mullo_epi16(load_2x8_avx2(data0 + i * 8, data1 + i * 8),
+                                  load_2x8_avx2(qt0 + i * 8, qt1 + i * 8));
+    }
+
+    ap922::avx2::idct(r, v);
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i limit = _mm256_set1_epi16(255);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        r[i] = _mm256_min_epi16(_mm256_max_epi16(r[i], zero), limit);
+    }
+}
+
+struct TransformAVX2
 {
-    u8 result[64 * 3];
+    // inverse transform of four blocks: a is [block0 | block1] and b is [block2 | block3]
+    static inline
+    void idct(__m256i* a, __m256i* b, const s16* const* data, const s16* const* qt)
+    {
+        idct_2x8_avx2(a, data[0], data[1], qt[0], qt[1]);
+        idct_2x8_avx2(b, data[2], data[3], qt[2], qt[3]);
+    }
+};
 
-    state->idct(result +   0, data +   0, state->block[0].qt); // Y
-    state->idct(result +  64, data +  64, state->block[1].qt); // Cb
-    state->idct(result + 128, data + 128, state->block[2].qt); // Cr
+MANGO_TARGET_END
+
+#if defined(MANGO_DISPATCH_AVX512)
+MANGO_TARGET_BEGIN_AVX512
+
+struct TransformAVX512
+{
+    // inverse transform of four blocks in one pass: a is [block0 | block1] and b is [block2 | block3]
+    static inline
+    void idct(__m256i* a, __m256i* b, const s16* const* data, const s16* const* qt)
+    {
+        // the zero-masking insert and extract avoid the uninitialized merge source of the
+        // unmasked intrinsics in the GCC 12 headers (see ap922::AVX512)
+        constexpr __mmask8 all = 0xff;
+
+        __m512i v[8];
+
+        for (int i = 0; i < 8; ++i)
+        {
+            __m512i d = _mm512_castsi256_si512(load_2x8_avx2(data[0] + i * 8, data[1] + i * 8));
+            __m512i q = _mm512_castsi256_si512(load_2x8_avx2(qt[0] + i * 8, qt[1] + i * 8));
+            d = _mm512_maskz_inserti64x4(all, d, load_2x8_avx2(data[2] + i * 8, data[3] + i * 8), 1);
+            q = _mm512_maskz_inserti64x4(all, q, load_2x8_avx2(qt[2] + i * 8, qt[3] + i * 8), 1);
+            v[i] = _mm512_mullo_epi16(d, q);
+        }
+
+        __m512i r[8];
+        ap922::avx512::idct(r, v);
+
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i limit = _mm512_set1_epi16(255);
+
+        for (int i = 0; i < 8; ++i)
+        {
+            __m512i s = _mm512_min_epi16(_mm512_max_epi16(r[i], zero), limit);
+            a[i] = _mm512_maskz_extracti64x4_epi64(all, s, 0);
+            b[i] = _mm512_maskz_extracti64x4_epi64(all, s, 1);
+        }
+    }
+};
+
+MANGO_TARGET_END
+#endif // MANGO_DISPATCH_AVX512
+
+MANGO_TARGET_BEGIN_AVX2
+
+template <typename Transform, bool bgra>
+void process_ycbcr_8x8_fused(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    // the Cr block is transformed twice to fill the four block transform
+    const s16* blocks[] = { data, data + 64, data + 128, data + 128 };
+    const s16* qt[] = { state->block[0].qt, state->block[1].qt, state->block[2].qt, state->block[2].qt };
+
+    __m256i ycb[8]; // Y | Cb
+    __m256i crcr[8]; // Cr | Cr
+    Transform::idct(ycb, crcr, blocks, qt);
 
     // color conversion
     const __m256i s0 = JPEG_CONST_AVX2(JPEG_FIXED( 1.00000), JPEG_FIXED( 1.40200));
@@ -895,36 +1198,281 @@ void process_ycbcr_rgba_8x8_avx2(u8* dest, size_t stride, const s16* data, Proce
     const __m256i tosigned = _mm256_set1_epi16(128);
     const __m256i alpha = _mm256_set1_epi16(0x00ff);
 
-    for (int y = 0; y < 2; ++y)
+    for (int i = 0; i < 8; i += 2)
     {
-        __m256i y0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(result + y * 32 + 0));
-        __m256i cb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(result + y * 32 + 64));
-        __m256i cr = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(result + y * 32 + 128));
+        __m256i y = _mm256_permute2x128_si256(ycb[i], ycb[i + 1], 0x20);
+        __m256i cb = _mm256_permute2x128_si256(ycb[i], ycb[i + 1], 0x31);
+        __m256i cr = _mm256_permute2x128_si256(crcr[i], crcr[i + 1], 0x20);
 
-        y0 = _mm256_permute4x64_epi64(y0, _MM_SHUFFLE(3, 1, 2, 0));
-        cb = _mm256_permute4x64_epi64(cb, _MM_SHUFFLE(3, 1, 2, 0));
-        cr = _mm256_permute4x64_epi64(cr, _MM_SHUFFLE(3, 1, 2, 0));
+        cb = _mm256_sub_epi16(cb, tosigned);
+        cr = _mm256_sub_epi16(cr, tosigned);
 
-        __m256i zero = _mm256_setzero_si256();
+        convert_ycbcr_8x2_avx2<bgra>(dest, dest + stride, y, cb, cr, alpha, s0, s1, s2, rounding);
+        dest += stride * 2;
+    }
 
-        __m256i cb0 = _mm256_unpacklo_epi8(cb, zero);
-        __m256i cr0 = _mm256_unpacklo_epi8(cr, zero);
-        __m256i cb1 = _mm256_unpackhi_epi8(cb, zero);
-        __m256i cr1 = _mm256_unpackhi_epi8(cr, zero);
+    MANGO_UNREFERENCED(width);
+    MANGO_UNREFERENCED(height);
+}
 
-        cb0 = _mm256_sub_epi16(cb0, tosigned);
-        cr0 = _mm256_sub_epi16(cr0, tosigned);
-        cb1 = _mm256_sub_epi16(cb1, tosigned);
-        cr1 = _mm256_sub_epi16(cr1, tosigned);
+template <typename Transform, bool bgra>
+void process_ycbcr_8x16_fused(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    const s16* blocks[] = { data, data + 64, data + 128, data + 192 };
+    const s16* qt[] = { state->block[0].qt, state->block[1].qt, state->block[2].qt, state->block[3].qt };
 
-        dest = convert_ycbcr_rgba_8x2_avx2(dest, stride, _mm256_unpacklo_epi8(y0, zero), cb0, cr0, alpha, s0, s1, s2, rounding);
-        dest = convert_ycbcr_rgba_8x2_avx2(dest, stride, _mm256_unpackhi_epi8(y0, zero), cb1, cr1, alpha, s0, s1, s2, rounding);
+    __m256i luma[8]; // Y0 | Y1
+    __m256i cbcr[8]; // Cb | Cr
+    Transform::idct(luma, cbcr, blocks, qt);
+
+    // color conversion
+    const __m256i s0 = JPEG_CONST_AVX2(JPEG_FIXED( 1.00000), JPEG_FIXED( 1.40200));
+    const __m256i s1 = JPEG_CONST_AVX2(JPEG_FIXED( 1.00000), JPEG_FIXED( 1.77200));
+    const __m256i s2 = JPEG_CONST_AVX2(JPEG_FIXED(-0.34414), JPEG_FIXED(-0.71414));
+    const __m256i rounding = _mm256_set1_epi32(1 << (JPEG_PREC - 1));
+    const __m256i tosigned = _mm256_set1_epi16(128);
+    const __m256i alpha = _mm256_set1_epi16(0x00ff);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        // two luma rows share one chroma row
+        int j = (i * 2) & 7;
+
+        __m256i y = i < 4 ? _mm256_permute2x128_si256(luma[j], luma[j + 1], 0x20)
+                          : _mm256_permute2x128_si256(luma[j], luma[j + 1], 0x31);
+        __m256i cb = _mm256_permute2x128_si256(cbcr[i], cbcr[i], 0x00);
+        __m256i cr = _mm256_permute2x128_si256(cbcr[i], cbcr[i], 0x11);
+
+        cb = _mm256_sub_epi16(cb, tosigned);
+        cr = _mm256_sub_epi16(cr, tosigned);
+
+        convert_ycbcr_8x2_avx2<bgra>(dest, dest + stride, y, cb, cr, alpha, s0, s1, s2, rounding);
+        dest += stride * 2;
     }
 
     MANGO_UNREFERENCED(width);
     MANGO_UNREFERENCED(height);
 }
 
-#endif // MANGO_ENABLE_AVX2
+template <typename Transform, bool bgra>
+void process_ycbcr_16x8_fused(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    const s16* blocks[] = { data, data + 64, data + 128, data + 192 };
+    const s16* qt[] = { state->block[0].qt, state->block[1].qt, state->block[2].qt, state->block[3].qt };
+
+    __m256i luma[8]; // Y0 | Y1
+    __m256i cbcr[8]; // Cb | Cr
+    Transform::idct(luma, cbcr, blocks, qt);
+
+    // color conversion
+    const __m256i s0 = JPEG_CONST_AVX2(JPEG_FIXED( 1.00000), JPEG_FIXED( 1.40200));
+    const __m256i s1 = JPEG_CONST_AVX2(JPEG_FIXED( 1.00000), JPEG_FIXED( 1.77200));
+    const __m256i s2 = JPEG_CONST_AVX2(JPEG_FIXED(-0.34414), JPEG_FIXED(-0.71414));
+    const __m256i rounding = _mm256_set1_epi32(1 << (JPEG_PREC - 1));
+    const __m256i tosigned = _mm256_set1_epi16(128);
+    const __m256i alpha = _mm256_set1_epi16(0x00ff);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        __m256i cb;
+        __m256i cr;
+        upsample_cbcr_avx2(cb, cr, cbcr[i], tosigned);
+
+        convert_ycbcr_8x2_avx2<bgra>(dest, dest + 32, luma[i], cb, cr, alpha, s0, s1, s2, rounding);
+        dest += stride;
+    }
+
+    MANGO_UNREFERENCED(width);
+    MANGO_UNREFERENCED(height);
+}
+
+template <typename Transform, bool bgra>
+void process_ycbcr_16x16_fused(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    const s16* blocks[] = { data, data + 64, data + 128, data + 192 };
+    const s16* qt[] = { state->block[0].qt, state->block[1].qt, state->block[2].qt, state->block[3].qt };
+
+    __m256i luma[16]; // Y0 | Y1, Y2 | Y3
+    __m256i cbcr[8]; // Cb | Cr
+    Transform::idct(luma, luma + 8, blocks, qt);
+    idct_2x8_avx2(cbcr, data + 256, data + 320, state->block[4].qt, state->block[5].qt);
+
+    // color conversion
+    const __m256i s0 = JPEG_CONST_AVX2(JPEG_FIXED( 1.00000), JPEG_FIXED( 1.40200));
+    const __m256i s1 = JPEG_CONST_AVX2(JPEG_FIXED( 1.00000), JPEG_FIXED( 1.77200));
+    const __m256i s2 = JPEG_CONST_AVX2(JPEG_FIXED(-0.34414), JPEG_FIXED(-0.71414));
+    const __m256i rounding = _mm256_set1_epi32(1 << (JPEG_PREC - 1));
+    const __m256i tosigned = _mm256_set1_epi16(128);
+    const __m256i alpha = _mm256_set1_epi16(0x00ff);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        __m256i cb;
+        __m256i cr;
+        upsample_cbcr_avx2(cb, cr, cbcr[i], tosigned);
+
+        // two luma rows share one chroma row
+        convert_ycbcr_8x2_avx2<bgra>(dest, dest + 32, luma[i * 2 + 0], cb, cr, alpha, s0, s1, s2, rounding);
+        dest += stride;
+
+        convert_ycbcr_8x2_avx2<bgra>(dest, dest + 32, luma[i * 2 + 1], cb, cr, alpha, s0, s1, s2, rounding);
+        dest += stride;
+    }
+
+    MANGO_UNREFERENCED(width);
+    MANGO_UNREFERENCED(height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_bgra_8x8_avx2(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_8x8_fused<TransformAVX2, true>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_bgra_8x16_avx2(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_8x16_fused<TransformAVX2, true>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_bgra_16x8_avx2(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_16x8_fused<TransformAVX2, true>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_bgra_16x16_avx2(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_16x16_fused<TransformAVX2, true>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_rgba_8x8_avx2(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_8x8_fused<TransformAVX2, false>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_rgba_8x16_avx2(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_8x16_fused<TransformAVX2, false>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_rgba_16x8_avx2(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_16x8_fused<TransformAVX2, false>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_rgba_16x16_avx2(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_16x16_fused<TransformAVX2, false>(dest, stride, data, state, width, height);
+}
+
+template <bool bgra>
+static inline
+void process_ycbcr_row_avx2(u8* dest, const u8* y, const u8* cb, const u8* cr, int width)
+{
+    const __m256i s0 = JPEG_CONST_AVX2(JPEG_FIXED( 1.00000), JPEG_FIXED( 1.40200));
+    const __m256i s1 = JPEG_CONST_AVX2(JPEG_FIXED( 1.00000), JPEG_FIXED( 1.77200));
+    const __m256i s2 = JPEG_CONST_AVX2(JPEG_FIXED(-0.34414), JPEG_FIXED(-0.71414));
+    const __m256i rounding = _mm256_set1_epi32(1 << (JPEG_PREC - 1));
+    const __m256i tosigned = _mm256_set1_epi16(128);
+    const __m256i alpha = _mm256_set1_epi16(0x00ff);
+
+    // NOTE: the sources are padded so the last partial group can be read in full
+    for (int x = 0; x < width; x += 16)
+    {
+        __m256i y0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x)));
+        __m256i cb0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(cb + x)));
+        __m256i cr0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(cr + x)));
+
+        cb0 = _mm256_sub_epi16(cb0, tosigned);
+        cr0 = _mm256_sub_epi16(cr0, tosigned);
+
+        if (width - x >= 16)
+        {
+            convert_ycbcr_8x2_avx2<bgra>(dest, dest + 32, y0, cb0, cr0, alpha, s0, s1, s2, rounding);
+        }
+        else
+        {
+            u8 temp[64];
+            convert_ycbcr_8x2_avx2<bgra>(temp, temp + 32, y0, cb0, cr0, alpha, s0, s1, s2, rounding);
+            std::memcpy(dest, temp, (width - x) * 4);
+        }
+
+        dest += 64;
+    }
+}
+
+void process_ycbcr_bgra_row_avx2(u8* dest, const u8* y, const u8* cb, const u8* cr, int width)
+{
+    process_ycbcr_row_avx2<true>(dest, y, cb, cr, width);
+}
+
+void process_ycbcr_rgba_row_avx2(u8* dest, const u8* y, const u8* cb, const u8* cr, int width)
+{
+    process_ycbcr_row_avx2<false>(dest, y, cb, cr, width);
+}
+
+MANGO_TARGET_END
+
+#if defined(MANGO_DISPATCH_AVX512)
+MANGO_TARGET_BEGIN_AVX512
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_bgra_8x8_avx512(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_8x8_fused<TransformAVX512, true>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_bgra_8x16_avx512(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_8x16_fused<TransformAVX512, true>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_bgra_16x8_avx512(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_16x8_fused<TransformAVX512, true>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_bgra_16x16_avx512(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_16x16_fused<TransformAVX512, true>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_rgba_8x8_avx512(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_8x8_fused<TransformAVX512, false>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_rgba_8x16_avx512(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_8x16_fused<TransformAVX512, false>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_rgba_16x8_avx512(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_16x8_fused<TransformAVX512, false>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_FLATTEN
+void process_ycbcr_rgba_16x16_avx512(u8* dest, size_t stride, const s16* data, ProcessState* state, int width, int height)
+{
+    process_ycbcr_16x16_fused<TransformAVX512, false>(dest, stride, data, state, width, height);
+}
+
+MANGO_TARGET_END
+#endif // MANGO_DISPATCH_AVX512
+
+#endif // MANGO_DISPATCH_AVX2
 
 } // namespace mango::image::jpeg
@@ -285,3 +285,18 @@ void FUNCTION_YCBCR_16x16(u8* dest, size_t stride, const s16* data, ProcessState
 }
 
 #endif
+
+#ifdef FUNCTION_YCBCR_ROW
+
+void FUNCTION_YCBCR_ROW(u8* dest, const u8* y, const u8* cb, const u8* cr, int width)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        int r, g, b;
+        COMPUTE_CBCR(cb[x], cr[x]);
+        WRITE_COLOR(dest, y[x], r, g, b);
+        dest += XSTEP;
+    }
+}
+
+#endif
@@ -176,3 +176,41 @@ void FUNCTION_YCBCR_16x16(u8* dest, size_t stride, const s16* data, ProcessState
 }
 
 #endif
+
+#ifdef FUNCTION_YCBCR_ROW
+
+void FUNCTION_YCBCR_ROW(u8* dest, const u8* y, const u8* cb, const u8* cr, int width)
+{
+    const uint8x8_t tosigned = vdup_n_u8(0x80);
+    const int16x8_t s0 = vdupq_n_s16(JPEG_FIXED( 1.40200));
+    const int16x8_t s1 = vdupq_n_s16(JPEG_FIXED(-0.71414));
+    const int16x8_t s2 = vdupq_n_s16(JPEG_FIXED(-0.34414));
+    const int16x8_t s3 = vdupq_n_s16(JPEG_FIXED( 1.77200));
+
+    // NOTE: the sources are padded so the last partial group can be read in full
+    for (int x = 0; x < width; x += 8)
+    {
+        uint8x8_t u_y  = vld1_u8(y + x);
+        uint8x8_t u_cb = vld1_u8(cb + x);
+        uint8x8_t u_cr = vld1_u8(cr + x);
+
+        int16x8_t s_y = vreinterpretq_s16_u16(vshll_n_u8(u_y, 4));
+        int16x8_t s_cb = vshll_n_s8(vreinterpret_s8_u8(vsub_u8(u_cb, tosigned)), 7);
+        int16x8_t s_cr = vshll_n_s8(vreinterpret_s8_u8(vsub_u8(u_cr, tosigned)), 7);
+
+        if (width - x >= 8)
+        {
+            INNERLOOP_YCBCR(dest, s_y, s_cb, s_cr, s0, s1, s2, s3);
+        }
+        else
+        {
+            u8 temp[XSTEP];
+            INNERLOOP_YCBCR(temp, s_y, s_cb, s_cr, s0, s1, s2, s3);
+            std::memcpy(dest, temp, (width - x) * (XSTEP / 8));
+        }
+
+        dest += XSTEP;
+    }
+}
+
+#endif
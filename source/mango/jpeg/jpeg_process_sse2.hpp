@@ -262,3 +262,42 @@ void FUNCTION_YCBCR_16x16(u8* dest, size_t stride, const s16* data, ProcessState
 }
 
 #endif
+
+#ifdef FUNCTION_YCBCR_ROW
+
+void FUNCTION_YCBCR_ROW(u8* dest, const u8* y, const u8* cb, const u8* cr, int width)
+{
+    const __m128i s0 = JPEG_CONST_SSE2(JPEG_FIXED( 1.00000), JPEG_FIXED( 1.40200));
+    const __m128i s1 = JPEG_CONST_SSE2(JPEG_FIXED( 1.00000), JPEG_FIXED( 1.77200));
+    const __m128i s2 = JPEG_CONST_SSE2(JPEG_FIXED(-0.34414), JPEG_FIXED(-0.71414));
+    const __m128i rounding = _mm_set1_epi32(1 << (JPEG_PREC - 1));
+    const __m128i tosigned = _mm_set1_epi16(128);
+    const __m128i zero = _mm_setzero_si128();
+
+    // NOTE: the sources are padded so the last partial group can be read in full
+    for (int x = 0; x < width; x += 8)
+    {
+        __m128i y0 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(y + x));
+        __m128i cb0 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(cb + x));
+        __m128i cr0 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(cr + x));
+
+        y0 = _mm_unpacklo_epi8(y0, zero);
+        cb0 = _mm_sub_epi16(_mm_unpacklo_epi8(cb0, zero), tosigned);
+        cr0 = _mm_sub_epi16(_mm_unpacklo_epi8(cr0, zero), tosigned);
+
+        if (width - x >= 8)
+        {
+            INNERLOOP_YCBCR(dest, y0, cb0, cr0, s0, s1, s2, rounding);
+        }
+        else
+        {
+            u8 temp[XSTEP];
+            INNERLOOP_YCBCR(temp, y0, cb0, cr0, s0, s1, s2, rounding);
+            std::memcpy(dest, temp, (width - x) * (XSTEP / 8));
+        }
+
+        dest += XSTEP;
+    }
+}
+
+#endif
@@ -0,0 +1,297 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2025 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#include <mango/core/core.hpp>
+#include <mango/image/image.hpp>
+#include "jpeg.hpp"
+
+namespace
+{
+    using namespace mango;
+    using namespace mango::image;
+
+    struct TransformInterface : ImageDecodeInterface
+    {
+        ImageDecodeStatus decode(const Surface& dest, const ImageDecodeOptions& options, int level, int depth, int face) override
+        {
+            MANGO_UNREFERENCED(dest);
+            MANGO_UNREFERENCED(options);
+            MANGO_UNREFERENCED(level);
+            MANGO_UNREFERENCED(depth);
+            MANGO_UNREFERENCED(face);
+            return ImageDecodeStatus();
+        }
+    };
+
+    bool isTransposed(JPEGTransform transform)
+    {
+        switch (transform)
+        {
+            case JPEGTransform::TRANSPOSE:
+            case JPEGTransform::TRANSVERSE:
+            case JPEGTransform::ROTATE_90:
+            case JPEGTransform::ROTATE_270:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // the transform mirrors the source x-axis
+    bool isMirrorX(JPEGTransform transform)
+    {
+        switch (transform)
+        {
+            case JPEGTransform::FLIP_HORIZONTAL:
+            case JPEGTransform::TRANSVERSE:
+            case JPEGTransform::ROTATE_180:
+            case JPEGTransform::ROTATE_270:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // the transform mirrors the source y-axis
+    bool isMirrorY(JPEGTransform transform)
+    {
+        switch (transform)
+        {
+            case JPEGTransform::FLIP_VERTICAL:
+            case JPEGTransform::TRANSVERSE:
+            case JPEGTransform::ROTATE_90:
+            case JPEGTransform::ROTATE_180:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Transforms the coefficients of one block. Mirroring the pixels negates the odd
+    // frequencies of the mirrored axis and transposing the pixels transposes the frequencies.
+    void transformBlock(s16* dest, const s16* source, bool transpose, bool mirror_u, bool mirror_v)
+    {
+        for (int v = 0; v < 8; ++v)
+        {
+            for (int u = 0; u < 8; ++u)
+            {
+                int value = transpose ? source[u * 8 + v] : source[v * 8 + u];
+
+                if (((u & mirror_u) ^ (v & mirror_v)) & 1)
+                {
+                    value = -value;
+                }
+
+                dest[v * 8 + u] = s16(value);
+            }
+        }
+    }
+
+} // namespace
+
+namespace mango::image
+{
+
+    int JPEGCoefficients::getBlockWidth(int index) const
+    {
+        int hmax = 1;
+        for (int i = 0; i < components; ++i)
+        {
+            hmax = std::max(hmax, component[i].hsf);
+        }
+
+        return div_ceil(div_ceil(width * component[index].hsf, hmax), 8);
+    }
+
+    int JPEGCoefficients::getBlockHeight(int index) const
+    {
+        int vmax = 1;
+        for (int i = 0; i < components; ++i)
+        {
+            vmax = std::max(vmax, component[i].vsf);
+        }
+
+        return div_ceil(div_ceil(height * component[index].vsf, vmax), 8);
+    }
+
+    ImageDecodeStatus decodeJPEGCoefficients(JPEGCoefficients& coefficients, ConstMemory memory)
+    {
+        TransformInterface interface;
+
+        jpeg::Parser parser(memory);
+        parser.setInterface(&interface);
+
+        return parser.decodeCoefficients(coefficients);
+    }
+
+    ImageDecodeStatus transformJPEGCoefficients(JPEGCoefficients& dest, const JPEGCoefficients& source, const JPEGTranscodeOptions& options)
+    {
+        ImageDecodeStatus status;
+
+        const JPEGTransform transform = options.transform;
+        const bool transpose = isTransposed(transform);
+
+        int hmax = 1;
+        int vmax = 1;
+
+        for (int i = 0; i < source.components; ++i)
+        {
+            hmax = std::max(hmax, source.component[i].hsf);
+            vmax = std::max(vmax, source.component[i].vsf);
+        }
+
+        const int mcu_width = hmax * 8;
+        const int mcu_height = vmax * 8;
+
+        // crop rectangle; the origin is aligned to the MCU boundary
+        int x0 = 0;
+        int y0 = 0;
+        int x1 = source.width;
+        int y1 = source.height;
+
+        if (options.crop_width > 0 && options.crop_height > 0)
+        {
+            if (options.crop_x >= source.width || options.crop_y >= source.height)
+            {
+                status.setError("[JPEGTranscode] Crop rectangle is outside of the image.");
+                return status;
+            }
+
+            x0 = std::clamp(options.crop_x, 0, source.width) / mcu_width * mcu_width;
+            y0 = std::clamp(options.crop_y, 0, source.height) / mcu_height * mcu_height;
+            x1 = std::clamp(options.crop_x + options.crop_width, 0, source.width);
+            y1 = std::clamp(options.crop_y + options.crop_height, 0, source.height);
+        }
+
+        int width = x1 - x0;
+        int height = y1 - y0;
+
+        // a dimension smaller than one MCU is not mirrored; the partial MCU is left untouched
+        const bool mirror_x = isMirrorX(transform) && width >= mcu_width;
+        const bool mirror_y = isMirrorY(transform) && height >= mcu_height;
+
+        // the partial MCU cannot be mirrored losslessly; it is trimmed away
+        if (mirror_x)
+        {
+            width = width / mcu_width * mcu_width;
+        }
+
+        if (mirror_y)
+        {
+            height = height / mcu_height * mcu_height;
+        }
+
+        if (width <= 0 || height <= 0)
+        {
+            status.setError("[JPEGTranscode] Empty crop rectangle.");
+            return status;
+        }
+
+        dest.width = transpose ? height : width;
+        dest.height = transpose ? width : height;
+        dest.components = source.components;
+        std::memcpy(dest.qtable, source.qtable, sizeof(source.qtable));
+
+        dest.metadata.reset();
+        dest.metadata.append(source.metadata.data(), source.metadata.size());
+
+        const int dest_hmax = transpose ? vmax : hmax;
+        const int dest_vmax = transpose ? hmax : vmax;
+        const int horizontal_mcus = div_ceil(dest.width, dest_hmax * 8);
+        const int vertical_mcus = div_ceil(dest.height, dest_vmax * 8);
+
+        for (int c = 0; c < source.components; ++c)
+        {
+            const JPEGCoefficients::Component& s = source.component[c];
+            JPEGCoefficients::Component& d = dest.component[c];
+
+            d.id = s.id;
+            d.hsf = transpose ? s.vsf : s.hsf;
+            d.vsf = transpose ? s.hsf : s.vsf;
+            d.tq = s.tq;
+            d.width = horizontal_mcus * d.hsf;
+            d.height = vertical_mcus * d.vsf;
+            d.data.resize(size_t(d.width) * d.height * 64);
+
+            // source region in blocks
+            const int bx0 = x0 / mcu_width * s.hsf;
+            const int by0 = y0 / mcu_height * s.vsf;
+            const int bw = div_ceil(div_ceil(width * s.hsf, hmax), 8);
+            const int bh = div_ceil(div_ceil(height * s.vsf, vmax), 8);
+
+            // blocks which cover the destination image
+            const int dw = transpose ? bh : bw;
+            const int dh = transpose ? bw : bh;
+
+            for (int y = 0; y < d.height; ++y)
+            {
+                // the MCU padding repeats the edge blocks
+                const int dy = std::min(y, dh - 1);
+
+                for (int x = 0; x < d.width; ++x)
+                {
+                    const int dx = std::min(x, dw - 1);
+
+                    int sx = transpose ? dy : dx;
+                    int sy = transpose ? dx : dy;
+
+                    if (mirror_x)
+                    {
+                        sx = bw - 1 - sx;
+                    }
+
+                    if (mirror_y)
+                    {
+                        sy = bh - 1 - sy;
+                    }
+
+                    const s16* block = s.block(bx0 + sx, by0 + sy);
+                    bool mirror_u = transpose ? mirror_y : mirror_x;
+                    bool mirror_v = transpose ? mirror_x : mirror_y;
+                    transformBlock(d.block(x, y), block, transpose, mirror_u, mirror_v);
+                }
+            }
+        }
+
+        return status;
+    }
+
+    ImageEncodeStatus encodeJPEGCoefficients(Stream& stream, const JPEGCoefficients& coefficients, const JPEGTranscodeOptions& options)
+    {
+        return jpeg::encodeCoefficients(stream, coefficients, options);
+    }
+
+    ImageEncodeStatus transcodeJPEG(Stream& stream, ConstMemory memory, const JPEGTranscodeOptions& options)
+    {
+        ImageEncodeStatus status;
+
+        JPEGCoefficients source;
+
+        ImageDecodeStatus decode_status = decodeJPEGCoefficients(source, memory);
+        if (!decode_status)
+        {
+            status.setError(decode_status.info);
+            return status;
+        }
+
+        const bool crop = options.crop_width > 0 && options.crop_height > 0;
+
+        if (options.transform == JPEGTransform::NONE && !crop)
+        {
+            return encodeJPEGCoefficients(stream, source, options);
+        }
+
+        JPEGCoefficients dest;
+
+        decode_status = transformJPEGCoefficients(dest, source, options);
+        if (!decode_status)
+        {
+            status.setError(decode_status.info);
+            return status;
+        }
+
+        return encodeJPEGCoefficients(stream, dest, options);
+    }
+
+} // namespace mango::image